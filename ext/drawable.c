@@ -77,6 +77,8 @@ say_drawable *ray_rb2drawable(VALUE obj) {
     return ray_rb2polygon(obj)->drawable;
   else if (RAY_IS_A(obj, rb_path2class("Ray::Sprite")))
     return ray_rb2sprite(obj)->drawable;
+  else if (RAY_IS_A(obj, rb_path2class("Ray::TiledImage")))
+    return ray_rb2tiled_image(obj)->drawable;
   else if (RAY_IS_A(obj, rb_path2class("Ray::Text")))
     return ray_rb2text(obj)->drawable;
   else {
@@ -402,6 +404,27 @@ VALUE ray_drawable_set_textured(VALUE self, VALUE val) {
   return self;
 }
 
+/*
+  @return [true, false] true if only the alpha channel of the texture is used,
+    the color coming from the vertices.
+*/
+static
+VALUE ray_drawable_is_alpha_only(VALUE self) {
+  return say_drawable_is_alpha_only(ray_rb2drawable(self)) ? Qtrue : Qfalse;
+}
+
+/*
+  @overload alpha_only=(val)
+    Sets whether the drawable only uses the alpha channel of its texture, like
+    text does. This lets it be drawn with a simpler shader.
+    @param [true, false] val
+*/
+static
+VALUE ray_drawable_set_alpha_only(VALUE self, VALUE val) {
+  say_drawable_set_alpha_only(ray_rb2drawable(self), RTEST(val));
+  return val;
+}
+
 void Init_ray_drawable() {
   ray_cDrawable = rb_define_class_under(ray_mRay, "Drawable", rb_cObject);
   rb_define_alloc_func(ray_cDrawable, ray_drawable_alloc);
@@ -443,4 +466,7 @@ void Init_ray_drawable() {
 
   rb_define_method(ray_cDrawable, "textured=", ray_drawable_set_textured, 1);
   rb_define_method(ray_cDrawable, "textured?", ray_drawable_is_textured, 0);
+  rb_define_method(ray_cDrawable, "alpha_only=", ray_drawable_set_alpha_only,
+                   1);
+  rb_define_method(ray_cDrawable, "alpha_only?", ray_drawable_is_alpha_only, 0);
 }
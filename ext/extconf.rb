@@ -77,6 +77,9 @@ else
   have_header "X11/extensions/Xrandr.h"
   have_library "Xrandr"
 
+  # Optional, used to render without an X server
+  have_library "EGL" and have_header "EGL/egl.h"
+
   deps = %w[X11 GL GLEW openal sndfile]
 
   if deps.all? { |dep| have_library dep }
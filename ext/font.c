@@ -29,7 +29,8 @@ VALUE ray_font_default(VALUE self) {
 
 /*
   @overload initialize(filename)
-    @param [String] filename Name of the file to load the font from.
+    @param [String] filename Name of the file to load the font from. Files
+      ending in .fnt are loaded as bitmap fonts (see #load_bitmap).
   @overload initialize(io)
     @param [#read] io IO object to read the font from.
 */
@@ -45,7 +46,14 @@ VALUE ray_font_init(VALUE self, VALUE arg) {
     }
   }
   else if (rb_respond_to(arg, RAY_METH("to_str"))) {
-    if (!say_font_load_from_file(font, StringValuePtr(arg))) {
+    const char *filename = StringValuePtr(arg);
+    size_t len = strlen(filename);
+
+    if (len >= 4 && strcmp(filename + len - 4, ".fnt") == 0) {
+      if (!say_font_load_bitmap(font, filename))
+        rb_raise(rb_eRuntimeError, "%s", say_error_get_last());
+    }
+    else if (!say_font_load_from_file(font, filename)) {
       rb_raise(rb_eRuntimeError, "%s", say_error_get_last());
     }
   }
@@ -69,12 +77,42 @@ VALUE ray_font_init(VALUE self, VALUE arg) {
 static
 VALUE ray_font_kerning(VALUE self, VALUE size, VALUE a, VALUE b) {
   say_font *font = ray_rb2font(self);
-  size_t kern = say_font_get_kerning(font, NUM2ULONG(a), NUM2ULONG(b),
-                                     NUM2ULONG(size));
+  int kern = say_font_get_kerning(font, NUM2ULONG(a), NUM2ULONG(b),
+                                  NUM2ULONG(size));
 
   return INT2FIX(kern);
 }
 
+/*
+  @overload glyph_advance(size, codepoint)
+    @param [Integer] size Size of the font
+    @param [Integer] codepoint Codepoint of the character
+    @return [Integer] Distance between the origin of the character and the one
+      of the next character
+*/
+static
+VALUE ray_font_glyph_advance(VALUE self, VALUE size, VALUE codepoint) {
+  say_glyph *glyph = say_font_get_glyph(ray_rb2font(self),
+                                        NUM2ULONG(codepoint), NUM2ULONG(size),
+                                        false);
+  return INT2FIX(glyph->offset);
+}
+
+/*
+  @overload glyph_rect(size, codepoint)
+    @param [Integer] size Size of the font
+    @param [Integer] codepoint Codepoint of the character
+    @return [Ray::Rect] Part of the image of the font the character is drawn
+      from
+*/
+static
+VALUE ray_font_glyph_rect(VALUE self, VALUE size, VALUE codepoint) {
+  say_glyph *glyph = say_font_get_glyph(ray_rb2font(self),
+                                        NUM2ULONG(codepoint), NUM2ULONG(size),
+                                        false);
+  return ray_rect2rb(glyph->sub_rect);
+}
+
 /*
   @overload line_height(size)
     @param [Integer] size Size of the font
@@ -85,6 +123,129 @@ VALUE ray_font_line_height(VALUE self, VALUE size) {
   return INT2FIX(say_font_get_line_height(ray_rb2font(self), NUM2ULONG(size)));
 }
 
+/*
+  @overload load_bitmap(filename)
+    Loads glyphs, metrics, and kerning pairs from a bitmap font previously
+    written with #write_bitmap. Glyphs found there are never rasterized again.
+
+    @param [String] filename Descriptor of the bitmap font
+*/
+static
+VALUE ray_font_load_bitmap(VALUE self, VALUE filename) {
+  if (!say_font_load_bitmap(ray_rb2font(self), StringValuePtr(filename)))
+    rb_raise(rb_eRuntimeError, "%s", say_error_get_last());
+  return self;
+}
+
+/*
+  @overload write_bitmap(filename)
+    Saves every glyph loaded so far to a bitmap font. Each character size is
+    stored as a PNG atlas next to the descriptor.
+
+    @param [String] filename Descriptor of the bitmap font
+*/
+static
+VALUE ray_font_write_bitmap(VALUE self, VALUE filename) {
+  if (!say_font_write_bitmap(ray_rb2font(self), StringValuePtr(filename)))
+    rb_raise(rb_eRuntimeError, "%s", say_error_get_last());
+  return self;
+}
+
+static
+VALUE ray_font_preload_basic(VALUE self, VALUE size, VALUE str, VALUE bold) {
+  say_font_preload(ray_rb2font(self), (uint32_t*)StringValuePtr(str),
+                   RSTRING_LEN(str) / 4, NUM2ULONG(size), RTEST(bold));
+  return self;
+}
+
+/*
+  @return [Integer] Maximum amount of memory used by the FreeType cache, in
+    bytes. 0 when the cache is disabled.
+*/
+static
+VALUE ray_font_cache_size(VALUE self) {
+  return ULONG2NUM(say_font_get_cache_size());
+}
+
+/*
+  @overload cache_size=(bytes)
+    Faces are always shared between fonts loaded from the same file or the
+    same data. Setting a cache size makes FreeType close faces and sizes that
+    aren't used when they take more memory than that, and reopen them on
+    demand. Setting it to 0 disables the cache.
+
+    @param [Integer] bytes Maximum amount of memory used by the cache
+*/
+static
+VALUE ray_font_set_cache_size(VALUE self, VALUE bytes) {
+  say_font_set_cache_size(NUM2ULONG(bytes));
+  return bytes;
+}
+
+/*
+  @return [Integer] Amount of threads used to rasterize glyphs
+*/
+static
+VALUE ray_font_worker_count(VALUE self) {
+  return ULONG2NUM(say_font_get_worker_count());
+}
+
+/*
+  @overload worker_count=(count)
+    When a text needs many glyphs that haven't been loaded yet, they are
+    rasterized in parallel, using up to that many threads. Defaults to the
+    amount of processors. Setting it to 1 disables parallel loading.
+
+    @param [Integer] count Amount of threads, 0 to use one per processor
+*/
+static
+VALUE ray_font_set_worker_count(VALUE self, VALUE count) {
+  say_font_set_worker_count(NUM2ULONG(count));
+  return count;
+}
+
+/*
+  @return [true, false] True if glyphs are loaded in the background
+*/
+static
+VALUE ray_font_async_loading(VALUE self) {
+  return say_font_is_async_loading() ? Qtrue : Qfalse;
+}
+
+/*
+  @overload async_loading=(val)
+    When enabled, drawing a text doesn't wait for its missing glyphs to be
+    rasterized. They are replaced by placeholders until they are available,
+    at which point texts using them are updated.
+
+    @param [true, false] val True to load glyphs in the background
+*/
+static
+VALUE ray_font_set_async_loading(VALUE self, VALUE val) {
+  say_font_set_async_loading(RTEST(val));
+  return val;
+}
+
+/*
+  @return [true, false] True if glyphs that are still loading are shown as
+    blocks.
+*/
+static
+VALUE ray_font_placeholders(VALUE self) {
+  return say_font_has_placeholders() ? Qtrue : Qfalse;
+}
+
+/*
+  @overload placeholders=(val)
+    @param [true, false] val True to show glyphs that are still loading as
+      blocks, false to leave blank space instead.
+*/
+static
+VALUE ray_font_set_placeholders(VALUE self, VALUE val) {
+  say_font_set_placeholders(RTEST(val));
+  return val;
+}
+
 void Init_ray_font() {
   ray_cFont = rb_define_class_under(ray_mRay, "Font", rb_cObject);
   rb_define_alloc_func(ray_cFont, ray_font_alloc);
@@ -92,6 +253,30 @@ void Init_ray_font() {
 
   rb_define_singleton_method(ray_cFont, "default", ray_font_default, 0);
 
+  rb_define_singleton_method(ray_cFont, "cache_size", ray_font_cache_size, 0);
+  rb_define_singleton_method(ray_cFont, "cache_size=", ray_font_set_cache_size,
+                             1);
+
+  rb_define_singleton_method(ray_cFont, "worker_count", ray_font_worker_count,
+                             0);
+  rb_define_singleton_method(ray_cFont, "worker_count=",
+                             ray_font_set_worker_count, 1);
+  rb_define_singleton_method(ray_cFont, "async_loading?",
+                             ray_font_async_loading, 0);
+  rb_define_singleton_method(ray_cFont, "async_loading=",
+                             ray_font_set_async_loading, 1);
+  rb_define_singleton_method(ray_cFont, "placeholders?",
+                             ray_font_placeholders, 0);
+  rb_define_singleton_method(ray_cFont, "placeholders=",
+                             ray_font_set_placeholders, 1);
+
   rb_define_method(ray_cFont, "kerning", ray_font_kerning, 3);
+  rb_define_method(ray_cFont, "glyph_advance", ray_font_glyph_advance, 2);
+  rb_define_method(ray_cFont, "glyph_rect", ray_font_glyph_rect, 2);
   rb_define_method(ray_cFont, "line_height", ray_font_line_height, 1);
+
+  rb_define_method(ray_cFont, "load_bitmap", ray_font_load_bitmap, 1);
+  rb_define_method(ray_cFont, "write_bitmap", ray_font_write_bitmap, 1);
+  rb_define_private_method(ray_cFont, "preload_basic", ray_font_preload_basic,
+                           3);
 }
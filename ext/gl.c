@@ -17,8 +17,8 @@ static
 VALUE ray_gl_draw_arrays(VALUE self, VALUE primitive, VALUE first,
                          VALUE count) {
 
-  glDrawArrays(NUM2INT(rb_hash_aref(ray_gl_primitives, primitive)),
-               NUM2ULONG(first), NUM2ULONG(count));
+  say_draw_arrays(NUM2INT(rb_hash_aref(ray_gl_primitives, primitive)),
+                  NUM2ULONG(first), NUM2ULONG(count));
   return Qnil;
 }
 
@@ -31,9 +31,8 @@ VALUE ray_gl_draw_arrays(VALUE self, VALUE primitive, VALUE first,
 static
 VALUE ray_gl_draw_elements(VALUE self, VALUE primitive, VALUE count,
                            VALUE index) {
-  glDrawElements(NUM2INT(rb_hash_aref(ray_gl_primitives, primitive)),
-                 NUM2ULONG(count),
-                 GL_UNSIGNED_INT, (void*)NUM2ULONG(index));
+  say_draw_elements(NUM2INT(rb_hash_aref(ray_gl_primitives, primitive)),
+                    NUM2ULONG(count), NUM2ULONG(index));
   return Qnil;
 }
 
@@ -86,6 +85,41 @@ VALUE ray_gl_multi_draw_elements(VALUE self, VALUE primitive, VALUE rb_count,
   return Qnil;
 }
 
+/*
+  @return [Integer] Amount of times a different OpenGL context was made
+    current. Drawing on windows and image targets doesn't require to switch
+    contexts, so this only grows when several threads draw.
+*/
+static
+VALUE ray_gl_context_switch_count(VALUE self) {
+  return ULONG2NUM(say_context_get_switch_count());
+}
+
+/*
+  @return [Integer] Amount of bindings and states changed through Ray, since
+    the counts were last reset.
+*/
+static
+VALUE ray_gl_bind_count(VALUE self) {
+  return ULONG2NUM(say_gl_get_bind_count());
+}
+
+/*
+  @return [Integer] Amount of bindings and states that were left alone because
+    they were already set, since the counts were last reset.
+*/
+static
+VALUE ray_gl_redundant_bind_count(VALUE self) {
+  return ULONG2NUM(say_gl_get_redundant_bind_count());
+}
+
+/* Resets bind_count and redundant_bind_count to 0. */
+static
+VALUE ray_gl_reset_bind_counts(VALUE self) {
+  say_gl_reset_bind_counts();
+  return Qnil;
+}
+
 void Init_ray_gl() {
   ray_mGL = rb_define_module_under(ray_mRay, "GL");
 
@@ -111,4 +145,13 @@ void Init_ray_gl() {
                             ray_gl_multi_draw_arrays, 3);
   rb_define_module_function(ray_mGL, "multi_draw_elements",
                             ray_gl_multi_draw_elements, 3);
+
+  rb_define_module_function(ray_mGL, "context_switch_count",
+                            ray_gl_context_switch_count, 0);
+
+  rb_define_module_function(ray_mGL, "bind_count", ray_gl_bind_count, 0);
+  rb_define_module_function(ray_mGL, "redundant_bind_count",
+                            ray_gl_redundant_bind_count, 0);
+  rb_define_module_function(ray_mGL, "reset_bind_counts",
+                            ray_gl_reset_bind_counts, 0);
 }
@@ -11,6 +11,10 @@ say_image *ray_rb2image(VALUE obj) {
   say_image *img = NULL;
   Data_Get_Struct(obj, say_image, img);
 
+  /* Images of pooled targets can't be used once the target is released */
+  if (!img)
+    rb_raise(rb_eRuntimeError, "image was released to the pool");
+
   return img;
 }
 
@@ -59,6 +63,62 @@ VALUE ray_image_init(VALUE self, VALUE arg) {
   return self;
 }
 
+static
+say_image_format ray_rb2image_format(VALUE format) {
+  if (format == RAY_SYM("rgba8"))
+    return SAY_IMAGE_RGBA8;
+  else if (format == RAY_SYM("dxt1"))
+    return SAY_IMAGE_DXT1;
+  else if (format == RAY_SYM("dxt5"))
+    return SAY_IMAGE_DXT5;
+  else if (format == RAY_SYM("rgtc1"))
+    return SAY_IMAGE_RGTC1;
+  else {
+    rb_raise(rb_eArgError, "unknown image format: %s",
+             RSTRING_PTR(rb_inspect(format)));
+  }
+
+  return SAY_IMAGE_RGBA8;
+}
+
+/*
+  @overload load_compressed(filename, format)
+    Loads an image from a file, and stores it as a compressed texture. The
+    compressed data is cached in a file next to the original one (e.g.
+    sprites.png.dxt5), which is used instead of decoding and compressing the
+    image again as long as the original file doesn't change.
+
+    When the format isn't supported, the image is loaded uncompressed.
+
+    @param [String] filename Name of the file to load the image from
+    @param [Symbol] format (see #compress)
+
+    @return [Ray::Image] The loaded image
+*/
+static
+VALUE ray_image_load_compressed(VALUE self, VALUE filename, VALUE format) {
+  VALUE obj = ray_image_alloc(self);
+
+  if (!say_image_load_file_compressed(ray_rb2image(obj),
+                                      StringValueCStr(filename),
+                                      ray_rb2image_format(format))) {
+    rb_raise(rb_eRuntimeError, "%s", say_error_get_last());
+  }
+
+  return obj;
+}
+
+/*
+  @overload compression_supported?(format)
+    @param [Symbol] format (see #compress)
+    @return [true, false] True if textures can be compressed using that format
+*/
+static
+VALUE ray_image_compression_supported(VALUE self, VALUE format) {
+  return say_image_format_is_supported(ray_rb2image_format(format)) ?
+    Qtrue : Qfalse;
+}
+
 static
 VALUE ray_image_init_copy(VALUE self, VALUE other) {
   say_image *orig = ray_rb2image(other);
@@ -229,6 +289,365 @@ VALUE ray_image_set_smooth(VALUE self, VALUE val) {
   return val;
 }
 
+/*
+  @overload compress(format)
+    Changes the format of the texture used by the image. Compressed textures
+    use 4 to 8 times less memory, at the cost of some quality. Modifying the
+    image makes it uncompressed again.
+
+    @param [Symbol] format One of :dxt1 (RGB), :dxt5 (RGBA), :rgtc1 (red
+      channel only, for masks and other single-channel data), or :rgba8
+      (uncompressed).
+*/
+static
+VALUE ray_image_compress(VALUE self, VALUE format) {
+  rb_check_frozen(self);
+
+  if (!say_image_compress(ray_rb2image(self), ray_rb2image_format(format)))
+    rb_raise(rb_eRuntimeError, "%s", say_error_get_last());
+
+  return self;
+}
+
+/* @return [Symbol] Format of the texture (see #compress) */
+static
+VALUE ray_image_format(VALUE self) {
+  return RAY_SYM(say_image_format_get_name(
+                   say_image_get_format(ray_rb2image(self))));
+}
+
+/*
+  Frees the copy of the pixels kept in memory, once they have been uploaded
+  to the GPU. They will be read back from the texture if they are needed
+  again (e.g. by #[] or #write).
+*/
+static
+VALUE ray_image_discard_pixels(VALUE self) {
+  rb_check_frozen(self);
+  say_image_discard_pixels(ray_rb2image(self));
+  return self;
+}
+
+/* @return [true, false] True if a copy of the pixels is kept in memory */
+static
+VALUE ray_image_has_pixels(VALUE self) {
+  return say_image_has_pixels(ray_rb2image(self)) ? Qtrue : Qfalse;
+}
+
+/*
+  @return [true, false] True if the copy of the pixels is kept in memory after
+    each upload.
+*/
+static
+VALUE ray_image_keep_pixels(VALUE self) {
+  return say_image_get_keep_pixels(ray_rb2image(self)) ? Qtrue : Qfalse;
+}
+
+/*
+  @overload keep_pixels=(val)
+    @param [true, false] val False to discard pixels after each upload
+*/
+static
+VALUE ray_image_set_keep_pixels(VALUE self, VALUE val) {
+  rb_check_frozen(self);
+  say_image_set_keep_pixels(ray_rb2image(self), RTEST(val));
+  return val;
+}
+
+/*
+  @return [true, false] Whether images created from now on keep their pixels
+    in memory.
+*/
+static
+VALUE ray_image_default_keep_pixels(VALUE self) {
+  return say_image_get_default_keep_pixels() ? Qtrue : Qfalse;
+}
+
+/*
+  @overload keep_pixels=(val)
+    Images that are only drawn don't need a copy of their pixels in memory.
+    Setting this to false makes images created afterwards discard it once
+    it's been uploaded (see Ray::Image#discard_pixels!).
+
+    @param [true, false] val Default value of Ray::Image#keep_pixels?
+*/
+static
+VALUE ray_image_set_default_keep_pixels(VALUE self, VALUE val) {
+  say_image_set_default_keep_pixels(RTEST(val));
+  return val;
+}
+
+/*
+  Only the parts of an image that changed since it was last used are sent to
+  the GPU.
+
+  @return [Integer] Amount of bytes uploaded to image textures during the last
+    frame (i.e. between the last two calls to Ray::Window#update).
+*/
+static
+VALUE ray_image_uploaded_bytes(VALUE self) {
+  return ULONG2NUM(say_image_get_uploaded_bytes());
+}
+
+/*
+  @return [Integer] Largest width or height of a texture. Larger images can't
+    be drawn directly, but can be split with Ray::TiledImage.
+*/
+static
+VALUE ray_image_max_texture_size(VALUE self) {
+  return ULONG2NUM(say_image_get_max_texture_size());
+}
+
+/*
+  @return [Integer] Amount of bytes uploaded to image textures since the
+    program started.
+*/
+static
+VALUE ray_image_total_uploaded_bytes(VALUE self) {
+  return ULONG2NUM(say_image_get_total_uploaded_bytes());
+}
+
+/*
+  @overload blit(src, pos, opts = {})
+    Copies part of another image into this one.
+
+    @param [Ray::Image] src Image to copy pixels from
+    @param [Ray::Vector2, #to_vector2] pos Where the pixels are copied in this
+      image
+    @option opts [Ray::Rect, #to_rect] :rect (whole image) Part of src to copy
+    @option opts [true, false] :blend (true) False to replace pixels instead of
+      blending them using the alpha channel of src.
+*/
+static
+VALUE ray_image_blit(int argc, VALUE *argv, VALUE self) {
+  rb_check_frozen(self);
+
+  VALUE src, pos, opts = Qnil;
+  rb_scan_args(argc, argv, "21", &src, &pos, &opts);
+
+  say_image *src_img = ray_rb2image(src);
+
+  say_rect rect = say_make_rect(0, 0, say_image_get_width(src_img),
+                                say_image_get_height(src_img));
+  bool blend = true;
+
+  if (!NIL_P(opts)) {
+    VALUE rb_rect = rb_hash_aref(opts, RAY_SYM("rect"));
+    if (!NIL_P(rb_rect))
+      rect = ray_convert_to_rect(rb_rect);
+
+    VALUE rb_blend = rb_hash_aref(opts, RAY_SYM("blend"));
+    if (!NIL_P(rb_blend))
+      blend = RTEST(rb_blend);
+  }
+
+  say_image_blit(ray_rb2image(self), src_img, rect,
+                 ray_convert_to_vector2(pos), blend);
+  return self;
+}
+
+/*
+  @overload fill_rect(rect, color)
+    Sets the color of every pixel in a rect, without blending.
+
+    @param [Ray::Rect, #to_rect] rect Part of the image to fill
+    @param [Ray::Color] color New color of the pixels
+*/
+static
+VALUE ray_image_fill_rect(VALUE self, VALUE rect, VALUE color) {
+  rb_check_frozen(self);
+  say_image_fill_rect(ray_rb2image(self), ray_convert_to_rect(rect),
+                      ray_rb2col(color));
+  return self;
+}
+
+/*
+  @overload color_matrix!(matrix)
+    Transforms the color of every pixel using a 4x5 matrix. Each row computes
+    a channel (red, green, blue and alpha) of the new color:
+      r * m[0] + g * m[1] + b * m[2] + a * m[3] + m[4]
+
+    @param [Array<Float>] matrix Either 20 numbers, or 4 rows of 5 numbers.
+      Offsets are in the same 0..255 range as colors.
+    @example Inverting colors
+      img.color_matrix! [[-1,  0,  0, 0, 255],
+                         [ 0, -1,  0, 0, 255],
+                         [ 0,  0, -1, 0, 255],
+                         [ 0,  0,  0, 1,   0]]
+*/
+static
+VALUE ray_image_color_matrix(VALUE self, VALUE matrix) {
+  rb_check_frozen(self);
+
+  matrix = rb_funcall(rb_Array(matrix), RAY_METH("flatten"), 0);
+  if (RARRAY_LEN(matrix) != SAY_COLOR_MATRIX_SIZE) {
+    rb_raise(rb_eArgError, "color matrix needs %d values (got %ld)",
+             SAY_COLOR_MATRIX_SIZE, (long)RARRAY_LEN(matrix));
+  }
+
+  float content[SAY_COLOR_MATRIX_SIZE];
+  for (size_t i = 0; i < SAY_COLOR_MATRIX_SIZE; i++)
+    content[i] = NUM2DBL(RARRAY_PTR(matrix)[i]);
+
+  say_image_color_matrix(ray_rb2image(self), content);
+  return self;
+}
+
+/* Multiplies the color channels of every pixel by its alpha channel */
+static
+VALUE ray_image_premultiply(VALUE self) {
+  rb_check_frozen(self);
+  say_image_premultiply(ray_rb2image(self));
+  return self;
+}
+
+/* Divides the color channels of every pixel by its alpha channel */
+static
+VALUE ray_image_unpremultiply(VALUE self) {
+  rb_check_frozen(self);
+  say_image_unpremultiply(ray_rb2image(self));
+  return self;
+}
+
+/* Replaces the color of every pixel by its luma, keeping alpha unchanged */
+static
+VALUE ray_image_grayscale(VALUE self) {
+  rb_check_frozen(self);
+  say_image_grayscale(ray_rb2image(self));
+  return self;
+}
+
+/* Flips the image horizontally */
+static
+VALUE ray_image_flip_x(VALUE self) {
+  rb_check_frozen(self);
+  say_image_flip(ray_rb2image(self), true, false);
+  return self;
+}
+
+/* Flips the image vertically */
+static
+VALUE ray_image_flip_y(VALUE self) {
+  rb_check_frozen(self);
+  say_image_flip(ray_rb2image(self), false, true);
+  return self;
+}
+
+/*
+  @overload rotate90!(clockwise = true)
+    Rotates the image by 90 degrees. Its width and height are swapped.
+
+    @param [true, false] clockwise False to rotate counterclockwise
+*/
+static
+VALUE ray_image_rotate90(int argc, VALUE *argv, VALUE self) {
+  rb_check_frozen(self);
+
+  VALUE clockwise = Qtrue;
+  rb_scan_args(argc, argv, "01", &clockwise);
+
+  say_image_rotate(ray_rb2image(self), NIL_P(clockwise) || RTEST(clockwise));
+  return self;
+}
+
+/*
+ * Sizes coming from Ruby are floats: they are only used once checked to be
+ * positive integers whose pixels can be counted in a size_t.
+ */
+static
+void ray_image_check_size(VALUE rb_size, size_t *w, size_t *h) {
+  say_vector2 size = ray_convert_to_vector2(rb_size);
+
+  if (!(size.x >= 1 && size.y >= 1) ||
+      size.x != floorf(size.x) || size.y != floorf(size.y)) {
+    rb_raise(rb_eArgError, "invalid image size: %s",
+             RSTRING_PTR(rb_inspect(rb_size)));
+  }
+
+  if (size.x >= (float)SIZE_MAX || size.y >= (float)SIZE_MAX ||
+      (size_t)size.x > SIZE_MAX / sizeof(say_color) / (size_t)size.y) {
+    rb_raise(rb_eArgError, "image size is too large: %s",
+             RSTRING_PTR(rb_inspect(rb_size)));
+  }
+
+  *w = size.x;
+  *h = size.y;
+}
+
+/*
+  @overload scale(size, filter = :bilinear)
+    @param [Ray::Vector2, #to_vector2] size Size of the new image
+    @param [Symbol] filter :nearest, :bilinear, or :box (which averages every
+      pixel covered by the new one, for good quality downscaling).
+    @return [Ray::Image] A scaled copy of the image
+*/
+static
+VALUE ray_image_scale(int argc, VALUE *argv, VALUE self) {
+  VALUE rb_size, rb_filter = Qnil;
+  rb_scan_args(argc, argv, "11", &rb_size, &rb_filter);
+
+  say_image_filter filter = SAY_FILTER_BILINEAR;
+  if (rb_filter == RAY_SYM("nearest"))
+    filter = SAY_FILTER_NEAREST;
+  else if (rb_filter == RAY_SYM("box"))
+    filter = SAY_FILTER_BOX;
+  else if (!NIL_P(rb_filter) && rb_filter != RAY_SYM("bilinear")) {
+    rb_raise(rb_eArgError, "unknown filter: %s",
+             RSTRING_PTR(rb_inspect(rb_filter)));
+  }
+
+  size_t w, h;
+  ray_image_check_size(rb_size, &w, &h);
+
+  VALUE obj = ray_image_alloc(ray_cImage);
+  if (!say_image_scale(ray_rb2image(obj), ray_rb2image(self),
+                       w, h, filter)) {
+    rb_raise(rb_eRuntimeError, "%s", say_error_get_last());
+  }
+
+  return obj;
+}
+
+/*
+  @return [String] The pixels of the image, as RGBA bytes from top to bottom
+  @see Ray::Image.from_packed
+*/
+static
+VALUE ray_image_to_packed(VALUE self) {
+  say_image *img = ray_rb2image(self);
+
+  return rb_str_new((const char*)say_image_get_buffer(img),
+                    sizeof(say_color) * say_image_get_width(img) *
+                    say_image_get_height(img));
+}
+
+/*
+  @overload from_packed(string, size)
+    @param [String] string RGBA bytes, from top to bottom (e.g. returned by
+      Ray::Image#to_packed)
+    @param [Ray::Vector2, #to_vector2] size Size of the image
+    @return [Ray::Image] An image with those pixels
+*/
+static
+VALUE ray_image_from_packed(VALUE self, VALUE string, VALUE rb_size) {
+  size_t w, h;
+  ray_image_check_size(rb_size, &w, &h);
+
+  StringValue(string);
+  if ((size_t)RSTRING_LEN(string) != sizeof(say_color) * w * h) {
+    rb_raise(rb_eArgError, "expected %zu bytes, got %ld",
+             sizeof(say_color) * w * h, (long)RSTRING_LEN(string));
+  }
+
+  VALUE obj = ray_image_alloc(self);
+  if (!say_image_load_raw(ray_rb2image(obj), w, h,
+                          (say_color*)RSTRING_PTR(string))) {
+    rb_raise(rb_eRuntimeError, "%s", say_error_get_last());
+  }
+
+  return obj;
+}
+
 /*
   Document-class: Ray::Image
 
@@ -242,6 +661,23 @@ void Init_ray_image() {
   rb_define_method(ray_cImage, "initialize", ray_image_init, 1);
   rb_define_method(ray_cImage, "initialize_copy", ray_image_init_copy, 1);
 
+  rb_define_singleton_method(ray_cImage, "load_compressed",
+                             ray_image_load_compressed, 2);
+  rb_define_singleton_method(ray_cImage, "compression_supported?",
+                             ray_image_compression_supported, 1);
+
+  rb_define_singleton_method(ray_cImage, "keep_pixels",
+                             ray_image_default_keep_pixels, 0);
+  rb_define_singleton_method(ray_cImage, "keep_pixels=",
+                             ray_image_set_default_keep_pixels, 1);
+
+  rb_define_singleton_method(ray_cImage, "max_texture_size",
+                             ray_image_max_texture_size, 0);
+  rb_define_singleton_method(ray_cImage, "uploaded_bytes",
+                             ray_image_uploaded_bytes, 0);
+  rb_define_singleton_method(ray_cImage, "total_uploaded_bytes",
+                             ray_image_total_uploaded_bytes, 0);
+
   rb_define_method(ray_cImage, "write_bmp", ray_image_write_bmp, 1);
   rb_define_method(ray_cImage, "write_png", ray_image_write_png, 1);
   rb_define_method(ray_cImage, "write_tga", ray_image_write_tga, 1);
@@ -260,4 +696,27 @@ void Init_ray_image() {
   rb_define_method(ray_cImage, "tex_rect", ray_image_tex_rect, 1);
 
   rb_define_method(ray_cImage, "bind", ray_image_bind, 0);
+
+  rb_define_method(ray_cImage, "compress", ray_image_compress, 1);
+  rb_define_method(ray_cImage, "format", ray_image_format, 0);
+
+  rb_define_method(ray_cImage, "discard_pixels!", ray_image_discard_pixels, 0);
+  rb_define_method(ray_cImage, "has_pixels?", ray_image_has_pixels, 0);
+  rb_define_method(ray_cImage, "keep_pixels?", ray_image_keep_pixels, 0);
+  rb_define_method(ray_cImage, "keep_pixels=", ray_image_set_keep_pixels, 1);
+
+  rb_define_method(ray_cImage, "blit", ray_image_blit, -1);
+  rb_define_method(ray_cImage, "fill_rect", ray_image_fill_rect, 2);
+  rb_define_method(ray_cImage, "color_matrix!", ray_image_color_matrix, 1);
+  rb_define_method(ray_cImage, "premultiply!", ray_image_premultiply, 0);
+  rb_define_method(ray_cImage, "unpremultiply!", ray_image_unpremultiply, 0);
+  rb_define_method(ray_cImage, "grayscale!", ray_image_grayscale, 0);
+  rb_define_method(ray_cImage, "flip_x!", ray_image_flip_x, 0);
+  rb_define_method(ray_cImage, "flip_y!", ray_image_flip_y, 0);
+  rb_define_method(ray_cImage, "rotate90!", ray_image_rotate90, -1);
+  rb_define_method(ray_cImage, "scale", ray_image_scale, -1);
+
+  rb_define_method(ray_cImage, "to_packed", ray_image_to_packed, 0);
+  rb_define_singleton_method(ray_cImage, "from_packed",
+                             ray_image_from_packed, 2);
 }
@@ -11,6 +11,9 @@ say_image_target *ray_rb2image_target(VALUE obj) {
   say_image_target *ret = NULL;
   Data_Get_Struct(obj, say_image_target, ret);
 
+  if (!ret)
+    rb_raise(rb_eRuntimeError, "image target was released to the pool");
+
   return ret;
 }
 
@@ -26,6 +29,10 @@ VALUE ray_image_target_alloc(VALUE self) {
 /* @overload image=(img) */
 VALUE ray_image_target_set_image(VALUE self, VALUE img) {
   rb_check_frozen(self);
+
+  if (say_image_target_is_pooled(ray_rb2image_target(self)))
+    rb_raise(rb_eRuntimeError, "can't change the image of a pooled target");
+
   say_image_target_set_image(ray_rb2image_target(self), ray_rb2image(img));
   rb_iv_set(self, "@image", img);
   return img;
@@ -42,6 +49,31 @@ VALUE ray_image_target_update(VALUE self) {
   return self;
 }
 
+/*
+  @return [true, false] True if pixels are read back asynchronously after each
+    update.
+*/
+VALUE ray_image_target_prefetch(VALUE self) {
+  return say_image_target_get_prefetch(ray_rb2image_target(self)) ?
+    Qtrue : Qfalse;
+}
+
+/*
+  @overload prefetch=(val)
+    By default, the pixels of the image are only read back from the GPU when
+    they are accessed (e.g. through Ray::Image#[]), so that images that are
+    only drawn don't cause any transfer. Enabling prefetch starts an
+    asynchronous transfer on each update, so that accessing pixels later
+    doesn't stall.
+
+    @param [true, false] val True to enable prefetch
+*/
+VALUE ray_image_target_set_prefetch(VALUE self, VALUE val) {
+  rb_check_frozen(self);
+  say_image_target_set_prefetch(ray_rb2image_target(self), RTEST(val));
+  return val;
+}
+
 /* Binds an image target to draw directly on it */
 VALUE ray_image_target_bind(VALUE self) {
   say_image_target_bind(ray_rb2image_target(self));
@@ -69,6 +101,115 @@ VALUE ray_image_target_available(VALUE self) {
   return say_image_target_is_available() ? Qtrue : Qfalse;
 }
 
+/*
+  @return [true, false] True if a depth buffer is attached to the target
+*/
+VALUE ray_image_target_has_depth(VALUE self) {
+  return say_image_target_has_depth(ray_rb2image_target(self)) ?
+    Qtrue : Qfalse;
+}
+
+/*
+  @overload depth=(val)
+    Targets only used for 2D drawing don't need a depth buffer.
+
+    @param [true, false] val False to detach the depth buffer
+*/
+VALUE ray_image_target_set_depth(VALUE self, VALUE val) {
+  rb_check_frozen(self);
+  say_image_target_set_depth(ray_rb2image_target(self), RTEST(val));
+  return val;
+}
+
+/*
+  @overload acquire_target(width, height, depth)
+    @see Ray::ImageTarget.acquire
+*/
+static
+VALUE ray_image_target_acquire(VALUE self, VALUE w, VALUE h, VALUE depth) {
+  if (!say_image_target_is_available())
+    rb_raise(rb_eRuntimeError, "Ray::ImageTarget is not supported here");
+
+  say_image_target *target = say_image_target_acquire(NUM2ULONG(w),
+                                                      NUM2ULONG(h),
+                                                      RTEST(depth));
+  if (!target)
+    rb_raise(rb_eRuntimeError, "%s", say_error_get_last());
+
+  /*
+   * Both belong to the pool, the objects only refer to them. Each holds a
+   * reference on the target, so that it only goes back to the pool once both
+   * are released or garbage collected.
+   */
+  VALUE obj = Data_Wrap_Struct(ray_cImageTarget, NULL,
+                               say_image_target_release, target);
+
+  say_image_target_retain(target);
+  VALUE img = Data_Wrap_Struct(ray_cImage, NULL,
+                               say_image_target_release_image,
+                               say_image_target_get_image(target));
+
+  rb_iv_set(obj, "@image", img);
+  return obj;
+}
+
+/*
+  Gives a target obtained from Ray::ImageTarget.acquire back to the pool.
+  Neither the target nor its image can be used afterward.
+*/
+VALUE ray_image_target_release(VALUE self) {
+  say_image_target *target = ray_rb2image_target(self);
+  if (!say_image_target_is_pooled(target))
+    rb_raise(rb_eRuntimeError, "only pooled image targets can be released");
+
+  VALUE img = rb_iv_get(self, "@image");
+  if (DATA_PTR(img)) {
+    say_image_target_release(target);
+    DATA_PTR(img) = NULL;
+  }
+
+  say_image_target_release(target);
+  DATA_PTR(self) = NULL;
+
+  return Qnil;
+}
+
+/* @return [true, false] True if the target was obtained from the pool */
+VALUE ray_image_target_is_pooled(VALUE self) {
+  return say_image_target_is_pooled(ray_rb2image_target(self)) ?
+    Qtrue : Qfalse;
+}
+
+/* @return [Integer] Amount of targets in the pool, in use or not */
+VALUE ray_image_target_pool_size(VALUE self) {
+  return ULONG2NUM(say_image_target_get_pool_size());
+}
+
+/*
+  @return [Integer] Amount of frames after which unused targets are removed
+    from the pool.
+*/
+VALUE ray_image_target_pool_max_age(VALUE self) {
+  return ULONG2NUM(say_image_target_get_pool_max_age());
+}
+
+/*
+  @overload pool_max_age=(frames)
+    @param [Integer] frames Amount of frames after which unused targets are
+      removed from the pool. They are checked for on each Ray::Window#update.
+*/
+VALUE ray_image_target_set_pool_max_age(VALUE self, VALUE frames) {
+  say_image_target_set_pool_max_age(NUM2ULONG(frames));
+  return frames;
+}
+
+/* Frees every target of the pool that isn't in use */
+VALUE ray_image_target_clear_pool(VALUE self) {
+  if (say_image_target_get_pool_size() != 0)
+    say_image_target_trim_pool(0);
+  return Qnil;
+}
+
 void Init_ray_image_target() {
   ray_cImageTarget = rb_define_class_under(ray_mRay, "ImageTarget", ray_cTarget);
   rb_define_alloc_func(ray_cImageTarget, ray_image_target_alloc);
@@ -81,4 +222,25 @@ void Init_ray_image_target() {
 
   rb_define_method(ray_cImageTarget, "bind", ray_image_target_bind, 0);
   rb_define_method(ray_cImageTarget, "update", ray_image_target_update, 0);
+
+  rb_define_method(ray_cImageTarget, "prefetch?", ray_image_target_prefetch, 0);
+  rb_define_method(ray_cImageTarget, "prefetch=", ray_image_target_set_prefetch,
+                   1);
+
+  rb_define_method(ray_cImageTarget, "depth?", ray_image_target_has_depth, 0);
+  rb_define_method(ray_cImageTarget, "depth=", ray_image_target_set_depth, 1);
+
+  rb_define_private_method(rb_singleton_class(ray_cImageTarget),
+                           "acquire_target", ray_image_target_acquire, 3);
+  rb_define_method(ray_cImageTarget, "release", ray_image_target_release, 0);
+  rb_define_method(ray_cImageTarget, "pooled?", ray_image_target_is_pooled, 0);
+
+  rb_define_singleton_method(ray_cImageTarget, "pool_size",
+                             ray_image_target_pool_size, 0);
+  rb_define_singleton_method(ray_cImageTarget, "pool_max_age",
+                             ray_image_target_pool_max_age, 0);
+  rb_define_singleton_method(ray_cImageTarget, "pool_max_age=",
+                             ray_image_target_set_pool_max_age, 1);
+  rb_define_singleton_method(ray_cImageTarget, "clear_pool",
+                             ray_image_target_clear_pool, 0);
 }
@@ -15,7 +15,70 @@ VALUE ray_screen_size(VALUE self) {
                                             say_imp_screen_get_height()));
 }
 
+/*
+ * @overload headless=(val)
+ *   Chooses whether OpenGL contexts should be created without any display
+ *   server. Only image targets can be drawn on in that mode, and it can't be
+ *   changed once something was rendered.
+ *
+ *   @param [true, false] val
+ */
+static
+VALUE ray_set_headless(VALUE self, VALUE val) {
+  if (!say_context_set_headless(RTEST(val)))
+    rb_raise(rb_eRuntimeError, "%s", say_error_get_last());
+  return val;
+}
+
+/*
+ * @return [true, false] True if contexts are created without a display
+ *   server. This is the default when RAY_HEADLESS is set or when no display
+ *   can be used.
+ */
+static
+VALUE ray_is_headless(VALUE self) {
+  return say_context_is_headless() ? Qtrue : Qfalse;
+}
+
+/* @return [true, false] True if headless contexts are supported */
+static
+VALUE ray_headless_available(VALUE self) {
+  return say_context_headless_available() ? Qtrue : Qfalse;
+}
+
+/*
+ * @overload backend=(val)
+ *   Chooses how image targets created afterwards are drawn. The software
+ *   backend doesn't need OpenGL, but ignores custom shaders and can only draw
+ *   triangles.
+ *
+ *   @param [Symbol] val Either :opengl or :software.
+ */
+static
+VALUE ray_set_backend(VALUE self, VALUE val) {
+  if (val == RAY_SYM("opengl"))
+    say_backend_set(SAY_BACKEND_OPENGL);
+  else if (val == RAY_SYM("software"))
+    say_backend_set(SAY_BACKEND_SOFTWARE);
+  else
+    rb_raise(rb_eArgError, "unknown backend");
+
+  return val;
+}
+
+/*
+ * @return [Symbol] Backend used by new image targets, :software when
+ *   RAY_BACKEND is set to "software", :opengl otherwise.
+ */
+static
+VALUE ray_backend(VALUE self) {
+  return say_backend_get() == SAY_BACKEND_SOFTWARE ?
+    RAY_SYM("software") : RAY_SYM("opengl");
+}
+
 void Init_ray_ext() {
+  say_init();
+
 #ifdef SAY_OSX
   say_osx_flip_pool();
 #endif
@@ -27,6 +90,14 @@ void Init_ray_ext() {
 
   rb_define_module_function(ray_mRay, "screen_size", ray_screen_size, 0);
 
+  rb_define_module_function(ray_mRay, "headless=", ray_set_headless, 1);
+  rb_define_module_function(ray_mRay, "headless?", ray_is_headless, 0);
+  rb_define_module_function(ray_mRay, "headless_available?",
+                            ray_headless_available, 0);
+
+  rb_define_module_function(ray_mRay, "backend=", ray_set_backend, 1);
+  rb_define_module_function(ray_mRay, "backend", ray_backend, 0);
+
   Init_ray_vector();
   Init_ray_rect();
   Init_ray_matrix();
@@ -44,6 +115,7 @@ void Init_ray_ext() {
   Init_ray_drawable();
   Init_ray_polygon();
   Init_ray_sprite();
+  Init_ray_tiled_image();
   Init_ray_text();
   Init_ray_buffer_renderer();
   Init_ray_target();
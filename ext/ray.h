@@ -39,6 +39,7 @@ extern VALUE ray_cView;
 extern VALUE ray_cDrawable;
 extern VALUE ray_cPolygon;
 extern VALUE ray_cSprite;
+extern VALUE ray_cTiledImage;
 extern VALUE ray_cText;
 extern VALUE ray_cBufferRenderer;
 extern VALUE ray_cTarget;
@@ -81,6 +82,7 @@ void Init_ray_view();
 void Init_ray_drawable();
 void Init_ray_polygon();
 void Init_ray_sprite();
+void Init_ray_tiled_image();
 void Init_ray_text();
 void Init_ray_buffer_renderer();
 void Init_ray_target();
@@ -131,6 +133,7 @@ say_shader *ray_rb2shader(VALUE obj);
 say_drawable *ray_rb2drawable(VALUE obj);
 say_polygon *ray_rb2polygon(VALUE obj);
 say_sprite *ray_rb2sprite(VALUE obj);
+say_tiled_image *ray_rb2tiled_image(VALUE obj);
 say_text *ray_rb2text(VALUE obj);
 
 say_target *ray_rb2target(VALUE obj);
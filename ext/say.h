@@ -6,9 +6,15 @@
 #include "say_table.h"
 #include "say_thread.h"
 #include "say_matrix.h"
+#include "say_image_compress.h"
 #include "say_image.h"
+#include "say_image_ops.h"
+#include "say_uniform_cache.h"
+#include "say_shader_cache.h"
 #include "say_shader.h"
+#include "say_gl_state.h"
 #include "say_context.h"
+#include "say_uniform_stream.h"
 #include "say_vertex_type.h"
 #include "say_buffer.h"
 #include "say_buffer_slice.h"
@@ -16,15 +22,18 @@
 #include "say_index_buffer_slice.h"
 #include "say_drawable.h"
 #include "say_view.h"
+#include "say_raster.h"
 #include "say_buffer_renderer.h"
 #include "say_renderer.h"
 #include "say_target.h"
+#include "say_capture.h"
 #include "say_event.h"
 #include "say_window.h"
 #include "say_image_target.h"
 #include "say_audio.h"
 #include "say_polygon.h"
 #include "say_sprite.h"
+#include "say_tiled_image.h"
 #include "say_font.h"
 #include "say_text.h"
 
@@ -26,6 +26,7 @@
 #include FT_GLYPH_H
 #include FT_OUTLINE_H
 #include FT_BITMAP_H
+#include FT_CACHE_H
 
 /* Audio */
 #ifdef SAY_OSX
@@ -42,6 +43,10 @@
 # define HAVE_XRANDR 1
 #endif
 
+#ifdef HAVE_EGL_EGL_H
+# define HAVE_EGL 1
+#endif
+
 /* Windowing */
 
 #ifdef SAY_OSX
@@ -58,7 +63,8 @@
 
 #include "say_imp.h"
 
-/* Clean up */
+/* Initialization, before any other function is called, and clean up */
+void say_init();
 void say_clean_up();
 
 /* String manipulations */
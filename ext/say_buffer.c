@@ -5,80 +5,23 @@ static bool say_has_vao() {
     __GLEW_APPLE_vertex_array_object;
 }
 
-static GLuint say_current_vbo = 0;
-static say_context *say_vbo_last_context = NULL;
-
-static void say_vbo_make_current(GLuint vbo) {
-  say_context *context = say_context_current();
-
-  if (context != say_vbo_last_context ||
-      vbo != say_current_vbo) {
-    say_current_vbo      = vbo;
-    say_vbo_last_context = context;
-
-    glBindBufferARB(GL_ARRAY_BUFFER_ARB, vbo);
-  }
-}
-
-static GLuint say_current_vao = 0;
-static say_context *say_vao_last_context = NULL;
-
 typedef struct {
   GLuint vao;
   say_context *context;
 } say_vao_pair;
 
-static void say_vao_make_current(GLuint vao) {
-  say_context *context = say_context_current();
-
-  if (context != say_vao_last_context ||
-      vao != say_current_vao) {
-    say_current_vao      = vao;
-    say_vao_last_context = context;
-
-    glBindVertexArray(vao);
-  }
-}
-
-static say_buffer  *say_current_buffer      = NULL;
-static say_context *say_buffer_last_context = NULL;
-
-static void say_buffer_setup_pointer(say_buffer *buf);
-
-static void say_buffer_make_current(say_buffer *buf) {
-  say_context *context = say_context_current();
-
-  if (context != say_buffer_last_context ||
-      buf != say_current_buffer) {
-    say_current_buffer      = buf;
-    say_buffer_last_context = context;
-
-    say_buffer_setup_pointer(buf);
-  }
-}
-
-static void say_vbo_will_delete(GLuint vbo) {
-  if (vbo == say_current_vbo)
-    say_current_vbo = 0;
-}
-
-static void say_buffer_will_delete(say_buffer *buf) {
-  if (buf == say_current_buffer)
-    say_current_buffer = NULL;
-}
-
 static void say_buffer_delete_vao_pair(say_vao_pair *pair) {
   /* TODO: finding out if the context is still alive, to avoid leaks */
-  if (say_vao_last_context == pair->context && say_current_vao == pair->vao) {
-    say_current_vao = 0;
+  if (say_context_current() == pair->context) {
+    say_gl_forget_vao(pair->vao);
     glDeleteVertexArrays(1, &pair->vao);
   }
 
   free(pair);
 }
 
-static void say_buffer_setup_pointer(say_buffer *buf) {
-  say_vbo_make_current(buf->vbo);
+static void say_buffer_setup_pointer(say_buffer *buf, say_gl_state *gl) {
+  say_gl_state_bind_vbo(gl, buf->vbo);
 
   say_vertex_type *type = say_get_vertex_type(buf->vtype);
 
@@ -86,9 +29,9 @@ static void say_buffer_setup_pointer(say_buffer *buf) {
   size_t stride = say_vertex_type_get_size(type);
 
   size_t offset = 0;
+  uint32_t attribs = 0;
 
-  size_t i = 0;
-  for (; i < count; i++) {
+  for (size_t i = 0; i < count; i++) {
     say_vertex_elem_type t = say_vertex_type_get_type(type, i);
 
     switch (t) {
@@ -127,32 +70,30 @@ static void say_buffer_setup_pointer(say_buffer *buf) {
       break;
     }
 
-    glEnableVertexAttribArrayARB(i);
+    if (i < SAY_GL_STATE_MAX_ATTRIBS)
+      attribs |= 1u << i;
   }
 
   /*
-   * Say will always use all the attribs. Disable all of them until
-   * finding one that is already disabled.
+   * Enabled attribs are part of the state of the VAO, which starts with all of
+   * them disabled. Without VAOs, the state tracker knows which ones to toggle.
    */
-  for (; i < GL_MAX_VERTEX_ATTRIBS_ARB; i++) {
-    GLint enabled;
-    glGetVertexAttribivARB(i, GL_VERTEX_ATTRIB_ARRAY_ENABLED_ARB, &enabled);
-
-    if (enabled)
-      glDisableVertexAttribArrayARB(i);
-    else
-      break;
+  if (say_has_vao()) {
+    for (size_t i = 0; i < count; i++)
+      glEnableVertexAttribArrayARB(i);
   }
+  else
+    say_gl_state_set_attribs(gl, attribs);
 }
 
-static void say_buffer_build_vao(say_buffer *buf, GLuint vao) {
-  say_vao_make_current(vao);
-  glBindBufferARB(GL_ARRAY_BUFFER_ARB, buf->vbo); /* forcefully bind */
-  say_buffer_setup_pointer(buf);
+static void say_buffer_build_vao(say_buffer *buf, GLuint vao,
+                                 say_gl_state *gl) {
+  say_gl_state_bind_vao(gl, vao);
+  say_buffer_setup_pointer(buf, gl);
 }
 
-static GLuint say_buffer_get_vao(say_buffer *buf) {
-  say_context *ctxt = say_context_current();
+static GLuint say_buffer_get_vao(say_buffer *buf, say_render_ctx *ctx) {
+  say_context *ctxt = ctx->context;
   uint32_t count = ctxt->count;
 
   say_vao_pair *pair = say_table_get(buf->vaos, count);
@@ -164,7 +105,7 @@ static GLuint say_buffer_get_vao(say_buffer *buf) {
     pair->context = ctxt;
 
     glGenVertexArrays(1, &pair->vao);
-    say_buffer_build_vao(buf, pair->vao);
+    say_buffer_build_vao(buf, pair->vao, ctx->gl);
 
     return pair->vao;
   }
@@ -186,7 +127,7 @@ say_buffer *say_buffer_create(size_t vtype, GLenum type, size_t size) {
   buf->vtype = vtype;
 
   glGenBuffersARB(1, &buf->vbo);
-  say_vbo_make_current(buf->vbo);
+  say_gl_bind_vbo(buf->vbo);
 
   buf->type = type;
 
@@ -205,9 +146,9 @@ void say_buffer_free(say_buffer *buf) {
   if (buf->vaos)
     say_table_free(buf->vaos);
   else
-    say_buffer_will_delete(buf);
+    say_gl_forget_buffer(buf);
 
-  say_vbo_will_delete(buf->vbo);
+  say_gl_forget_vbo(buf->vbo);
   glDeleteBuffersARB(1, &(buf->vbo));
 
   say_array_free(buf->buffer);
@@ -219,29 +160,25 @@ void *say_buffer_get_vertex(say_buffer *buf, size_t id) {
 }
 
 void say_buffer_bind(say_buffer *buf) {
-  say_context_ensure();
+  say_render_ctx ctx = say_render_ctx_current();
+  say_buffer_bind_ctx(buf, &ctx);
+}
 
+void say_buffer_bind_ctx(say_buffer *buf, say_render_ctx *ctx) {
   if (say_has_vao())
-    say_vao_make_current(say_buffer_get_vao(buf));
-  else
-    say_buffer_make_current(buf);
+    say_gl_state_bind_vao(ctx->gl, say_buffer_get_vao(buf, ctx));
+  else if (say_gl_state_set_buffer(ctx->gl, buf))
+    say_buffer_setup_pointer(buf, ctx->gl);
 }
 
 void say_buffer_unbind() {
-  say_vbo_make_current(0);
+  say_gl_bind_vbo(0);
 
   if (say_has_vao())
-    say_vao_make_current(0);
-  else { /* disable vertex attribs */
-    for (size_t i = 0; i < GL_MAX_VERTEX_ATTRIBS_ARB; i++) {
-      GLint enabled;
-      glGetVertexAttribivARB(i, GL_VERTEX_ATTRIB_ARRAY_ENABLED_ARB, &enabled);
-
-      if (enabled)
-        glDisableVertexAttribArrayARB(i);
-      else
-        break;
-    }
+    say_gl_bind_vao(0);
+  else {
+    say_gl_set_buffer(NULL);
+    say_gl_set_attribs(0);
   }
 }
 
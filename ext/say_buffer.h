@@ -4,6 +4,7 @@
 #include "say_basic_type.h"
 #include "say_array.h"
 #include "say_table.h"
+#include "say_context.h"
 
 #define SAY_STATIC  GL_STATIC_DRAW_ARB
 #define SAY_STREAM  GL_STREAM_DRAW_ARB
@@ -26,6 +27,7 @@ void say_buffer_free(say_buffer *buf);
 void *say_buffer_get_vertex(say_buffer *buf, size_t id);
 
 void say_buffer_bind(say_buffer *buf);
+void say_buffer_bind_ctx(say_buffer *buf, say_render_ctx *ctx);
 void say_buffer_unbind();
 
 void say_buffer_update_part(say_buffer *buf, size_t index, size_t size);
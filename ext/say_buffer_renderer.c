@@ -81,41 +81,72 @@ void say_buffer_renderer_update(say_buffer_renderer *renderer) {
 }
 
 void say_buffer_renderer_render(say_buffer_renderer *renderer,
-                                say_shader *shader) {
-  say_buffer_bind(renderer->buffer);
+                                say_shader *shader, say_render_ctx *ctx) {
+  say_buffer_bind_ctx(renderer->buffer, ctx);
+
+  /* Like say_renderer_push, unless the code of shader was changed */
+  bool use_variants = say_shader_is_shared(shader);
 
   int using_texture = 0;
-  say_shader_set_int_id(shader, SAY_TEXTURE_ENABLED_LOC_ID, 0);
+  if (!use_variants)
+    say_shader_set_int_id(shader, SAY_TEXTURE_ENABLED_LOC_ID, 0, ctx);
+
+  /* Model-view matrices of every drawable are uploaded at once */
+  say_uniform_stream *stream = NULL;
+  if (say_shader_uses_uniform_blocks()) {
+    size_t count = say_array_get_size(renderer->drawables);
+    say_matrix **matrices = malloc(sizeof(say_matrix*) * (count + 1));
+
+    for (size_t i = 0; i < count; i++) {
+      say_drawable **e = say_array_get(renderer->drawables, i);
+      matrices[i] = say_drawable_get_matrix(*e);
+    }
+
+    stream = say_uniform_stream_get();
+    say_uniform_stream_begin_batch(stream, matrices, count, ctx);
+
+    free(matrices);
+  }
 
   size_t current_vertex = 0, current_index = 0;
   for (size_t i = 0; i < say_array_get_size(renderer->drawables); i++) {
     say_drawable **e = say_array_get(renderer->drawables, i);
     say_drawable *drawable = *e;
 
-    if (!drawable->shader &&
-        using_texture != say_drawable_is_textured(drawable)) {
-      using_texture = !using_texture;
-      say_shader_set_int_id(shader, SAY_TEXTURE_ENABLED_LOC_ID, using_texture);
+    say_shader *custom = say_drawable_get_custom_shader(drawable);
+    say_shader *used_shader = shader;
+
+    if (custom) {
+      say_shader_set_projection(custom, renderer->matrix, ctx);
     }
+    else if (use_variants) {
+      uint8_t features = say_drawable_get_shader_features(drawable);
+      used_shader = say_shader_get_default_variant(features);
 
-    if (drawable->shader) {
-      say_shader_set_matrix_id(drawable->shader,
-                               SAY_PROJECTION_LOC_ID,
-                               renderer->matrix);
+      say_shader_set_projection(used_shader, renderer->matrix, ctx);
+    }
+    else if (using_texture != say_drawable_is_textured(drawable)) {
+      using_texture = !using_texture;
+      say_shader_set_int_id(shader, SAY_TEXTURE_ENABLED_LOC_ID, using_texture,
+                            ctx);
     }
 
     size_t next_vertex = current_vertex +
       say_drawable_get_vertex_count(drawable);
     if (next_vertex > say_buffer_get_size(renderer->buffer))
-      return;
+      break;
 
     size_t next_index = current_index + say_drawable_get_index_count(drawable);
     if (next_index > say_index_buffer_get_size(renderer->index_buffer))
-      return;
+      break;
 
-    say_drawable_draw_at(drawable, current_vertex, current_index, shader);
+    say_drawable_draw_at(drawable, current_vertex, current_index, used_shader,
+                         ctx);
 
     current_vertex = next_vertex;
     current_index  = next_index;
   }
+
+  if (stream)
+    say_uniform_stream_end_batch(stream);
 }
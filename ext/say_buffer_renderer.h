@@ -28,6 +28,6 @@ bool say_buffer_renderer_push(say_buffer_renderer *renderer,
 void say_buffer_renderer_update(say_buffer_renderer *renderer);
 
 void say_buffer_renderer_render(say_buffer_renderer *renderer,
-                                say_shader *shader);
+                                say_shader *shader, say_render_ctx *ctx);
 
 #endif
@@ -239,6 +239,11 @@ void say_buffer_slice_bind(say_buffer_slice *slice) {
   say_buffer_bind(say_global_buffer_at(slice->vtype, slice->buf_id)->buf);
 }
 
+void say_buffer_slice_bind_ctx(say_buffer_slice *slice, say_render_ctx *ctx) {
+  say_buffer_bind_ctx(say_global_buffer_at(slice->vtype, slice->buf_id)->buf,
+                      ctx);
+}
+
 void say_buffer_slice_clean_up() {
   if (say_global_buffers) {
     say_array_free(say_global_buffers);
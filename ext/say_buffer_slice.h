@@ -2,6 +2,7 @@
 #define SAY_BUFFER_SLICE_H_
 
 #include "say_basic_type.h"
+#include "say_context.h"
 
 typedef struct {
   size_t buf_id;
@@ -23,6 +24,7 @@ void *say_buffer_slice_get_vertex(say_buffer_slice *slice, size_t id);
 
 void say_buffer_slice_update(say_buffer_slice *slice);
 void say_buffer_slice_bind(say_buffer_slice *slice);
+void say_buffer_slice_bind_ctx(say_buffer_slice *slice, say_render_ctx *ctx);
 
 void say_buffer_slice_clean_up();
 
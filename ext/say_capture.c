@@ -0,0 +1,341 @@
+#include "say.h"
+
+#include "stb_image_write.h"
+
+/*
+ * Frames are read into a ring of pixel pack buffers, which are only mapped once
+ * their fence has been signaled, a few frames later. Their content is then
+ * queued for a writer thread that converts and writes it. When that thread
+ * falls behind and the queue is full, new frames are dropped rather than
+ * stalling the game.
+ */
+
+static void say_capture_write_y4m(say_capture *capture, say_color *frame,
+                                  uint8_t *planes) {
+  size_t count = capture->width * capture->height;
+
+  uint8_t *y_plane = planes;
+  uint8_t *u_plane = planes + count;
+  uint8_t *v_plane = planes + 2 * count;
+
+  /* BT.601, studio range */
+  for (size_t i = 0; i < count; i++) {
+    int r = frame[i].r, g = frame[i].g, b = frame[i].b;
+
+    y_plane[i] = (( 66 * r + 129 * g +  25 * b + 128) >> 8) + 16;
+    u_plane[i] = ((-38 * r -  74 * g + 112 * b + 128) >> 8) + 128;
+    v_plane[i] = ((112 * r -  94 * g -  18 * b + 128) >> 8) + 128;
+  }
+
+  fputs("FRAME\n", capture->file);
+  fwrite(planes, 1, 3 * count, capture->file);
+}
+
+static void say_capture_write_png(say_capture *capture, say_color *frame,
+                                  size_t index) {
+  size_t len = strlen(capture->path) + 32;
+  char *filename = malloc(len);
+
+  snprintf(filename, len, "%s%06zu.png", capture->path, index);
+  stbi_write_png(filename, capture->width, capture->height, 4, frame, 0);
+
+  free(filename);
+}
+
+static void *say_capture_run(void *data) {
+  say_capture *capture = data;
+
+  uint8_t *planes = NULL;
+  if (capture->format == SAY_CAPTURE_Y4M)
+    planes = malloc(3 * capture->width * capture->height);
+
+  for (size_t index = 0; ; index++) {
+    say_mutex_lock(capture->mutex);
+
+    while (capture->queue_count == 0 && !capture->stop)
+      say_cond_wait(capture->cond, capture->mutex);
+
+    if (capture->queue_count == 0) {
+      say_mutex_unlock(capture->mutex);
+      break;
+    }
+
+    say_color *frame = capture->queue[capture->queue_start];
+    capture->queue_start = (capture->queue_start + 1) % SAY_CAPTURE_QUEUE_SIZE;
+    capture->queue_count--;
+
+    say_mutex_unlock(capture->mutex);
+
+    switch (capture->format) {
+    case SAY_CAPTURE_Y4M:
+      say_capture_write_y4m(capture, frame, planes);
+      break;
+    case SAY_CAPTURE_RAW_RGBA:
+      fwrite(frame, sizeof(say_color), capture->width * capture->height,
+             capture->file);
+      break;
+    case SAY_CAPTURE_PNG_SEQUENCE:
+      say_capture_write_png(capture, frame, index);
+      break;
+    }
+
+    say_mutex_lock(capture->mutex);
+    say_array_push(capture->free_frames, &frame);
+    capture->written_count++;
+    say_mutex_unlock(capture->mutex);
+  }
+
+  if (planes)
+    free(planes);
+
+  return NULL;
+}
+
+say_capture *say_capture_create(say_target *target, const char *path,
+                                say_capture_format format, size_t fps) {
+  say_vector2 size = say_target_get_size(target);
+  if (size.x < 1 || size.y < 1) {
+    say_error_set("can't capture an empty target");
+    return NULL;
+  }
+
+  if (!__GLEW_ARB_pixel_buffer_object || !__GLEW_ARB_sync) {
+    say_error_set("capture needs pixel buffer objects and sync objects");
+    return NULL;
+  }
+
+  FILE *file = NULL;
+  if (format != SAY_CAPTURE_PNG_SEQUENCE) {
+    if (!(file = fopen(path, "wb"))) {
+      say_error_set("could not open capture file");
+      return NULL;
+    }
+  }
+
+  say_capture *capture = malloc(sizeof(say_capture));
+
+  capture->target = target;
+  capture->format = format;
+  capture->file   = file;
+  capture->width  = size.x;
+  capture->height = size.y;
+  capture->fps    = fps ? fps : 60;
+
+  capture->path = malloc(strlen(path) + 1);
+  strcpy(capture->path, path);
+
+  if (format == SAY_CAPTURE_Y4M) {
+    fprintf(file, "YUV4MPEG2 W%zu H%zu F%zu:1 Ip A1:1 C444\n",
+            capture->width, capture->height, capture->fps);
+  }
+
+  for (size_t i = 0; i < SAY_CAPTURE_PBO_COUNT; i++) {
+    capture->pbos[i]   = 0;
+    capture->fences[i] = NULL;
+  }
+
+  capture->pbo_start = capture->pbo_count = 0;
+
+  capture->queue_start = capture->queue_count = 0;
+  capture->free_frames = say_array_create(sizeof(say_color*), NULL, NULL);
+
+  capture->frame_count   = 0;
+  capture->dropped_count = 0;
+  capture->written_count = 0;
+
+  capture->stop    = false;
+  capture->running = true;
+  capture->mutex   = say_mutex_create();
+  capture->cond   = say_cond_create();
+  capture->thread = say_thread_create(capture, say_capture_run);
+
+  return capture;
+}
+
+/* Returns false if the oldest frame isn't available yet */
+static bool say_capture_collect(say_capture *capture, bool wait) {
+  size_t index = capture->pbo_start;
+  GLsync fence = capture->fences[index];
+
+  if (wait) {
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                            1000000000) == GL_TIMEOUT_EXPIRED);
+  }
+  else {
+    GLint status = GL_UNSIGNALED;
+    glGetSynciv(fence, GL_SYNC_STATUS, sizeof(status), NULL, &status);
+
+    if (status != GL_SIGNALED)
+      return false;
+  }
+
+  glDeleteSync(fence);
+  capture->fences[index] = NULL;
+
+  capture->pbo_start = (capture->pbo_start + 1) % SAY_CAPTURE_PBO_COUNT;
+  capture->pbo_count--;
+
+  say_color *frame = NULL;
+
+  say_mutex_lock(capture->mutex);
+  if (capture->queue_count == SAY_CAPTURE_QUEUE_SIZE)
+    capture->dropped_count++;
+  else if (say_array_get_size(capture->free_frames) != 0) {
+    size_t last = say_array_get_size(capture->free_frames) - 1;
+    frame = *(say_color**)say_array_get(capture->free_frames, last);
+    say_array_resize(capture->free_frames, last);
+  }
+  else
+    frame = malloc(sizeof(say_color) * capture->width * capture->height);
+  say_mutex_unlock(capture->mutex);
+
+  if (!frame)
+    return true;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->pbos[index]);
+  say_color *pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+  if (pixels) {
+    /* GL reads from bottom to top */
+    size_t w = capture->width, h = capture->height;
+    for (size_t i = 0; i < h; i++)
+      memcpy(&frame[w * i], &pixels[w * (h - i - 1)], sizeof(say_color) * w);
+
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  say_mutex_lock(capture->mutex);
+  if (pixels) {
+    size_t slot = (capture->queue_start + capture->queue_count) %
+      SAY_CAPTURE_QUEUE_SIZE;
+    capture->queue[slot] = frame;
+    capture->queue_count++;
+
+    say_cond_signal(capture->cond);
+  }
+  else {
+    say_array_push(capture->free_frames, &frame);
+    capture->dropped_count++;
+  }
+  say_mutex_unlock(capture->mutex);
+
+  return true;
+}
+
+void say_capture_frame(say_capture *capture) {
+  if (!capture->running || !say_target_make_current(capture->target))
+    return;
+
+  capture->frame_count++;
+
+  while (capture->pbo_count != 0 && say_capture_collect(capture, false));
+
+  say_vector2 size = say_target_get_size(capture->target);
+  if ((size_t)size.x != capture->width || (size_t)size.y != capture->height) {
+    /* Frames of a different size can't be part of the stream */
+    say_mutex_lock(capture->mutex);
+    capture->dropped_count++;
+    say_mutex_unlock(capture->mutex);
+
+    return;
+  }
+
+  if (capture->pbo_count == SAY_CAPTURE_PBO_COUNT)
+    say_capture_collect(capture, true);
+
+  size_t index = (capture->pbo_start + capture->pbo_count) %
+    SAY_CAPTURE_PBO_COUNT;
+
+  if (!capture->pbos[index]) {
+    glGenBuffers(1, &capture->pbos[index]);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->pbos[index]);
+    glBufferData(GL_PIXEL_PACK_BUFFER,
+                 sizeof(say_color) * capture->width * capture->height, NULL,
+                 GL_STREAM_READ);
+  }
+  else
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->pbos[index]);
+
+  glReadPixels(0, 0, capture->width, capture->height, GL_RGBA,
+               GL_UNSIGNED_BYTE, NULL);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  capture->fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  capture->pbo_count++;
+}
+
+void say_capture_stop(say_capture *capture) {
+  if (!capture->running)
+    return;
+
+  capture->running = false;
+
+  bool has_context = say_target_make_current(capture->target);
+
+  if (has_context) {
+    while (capture->pbo_count != 0)
+      say_capture_collect(capture, true);
+  }
+
+  say_mutex_lock(capture->mutex);
+  capture->stop = true;
+  say_cond_signal(capture->cond);
+  say_mutex_unlock(capture->mutex);
+
+  say_thread_join(capture->thread);
+  say_thread_free(capture->thread);
+
+  for (size_t i = 0; i < say_array_get_size(capture->free_frames); i++)
+    free(*(say_color**)say_array_get(capture->free_frames, i));
+  say_array_resize(capture->free_frames, 0);
+
+  if (has_context) {
+    for (size_t i = 0; i < SAY_CAPTURE_PBO_COUNT; i++) {
+      if (capture->fences[i])
+        glDeleteSync(capture->fences[i]);
+      if (capture->pbos[i])
+        glDeleteBuffers(1, &capture->pbos[i]);
+    }
+  }
+
+  if (capture->file) {
+    fclose(capture->file);
+    capture->file = NULL;
+  }
+}
+
+bool say_capture_is_running(say_capture *capture) {
+  return capture->running;
+}
+
+void say_capture_free(say_capture *capture) {
+  say_capture_stop(capture);
+
+  say_cond_free(capture->cond);
+  say_mutex_free(capture->mutex);
+
+  say_array_free(capture->free_frames);
+
+  free(capture->path);
+  free(capture);
+}
+
+size_t say_capture_get_frame_count(say_capture *capture) {
+  return capture->frame_count;
+}
+
+size_t say_capture_get_dropped_count(say_capture *capture) {
+  say_mutex_lock(capture->mutex);
+  size_t count = capture->dropped_count;
+  say_mutex_unlock(capture->mutex);
+
+  return count;
+}
+
+size_t say_capture_get_written_count(say_capture *capture) {
+  say_mutex_lock(capture->mutex);
+  size_t count = capture->written_count;
+  say_mutex_unlock(capture->mutex);
+
+  return count;
+}
@@ -0,0 +1,61 @@
+#ifndef SAY_CAPTURE_H_
+#define SAY_CAPTURE_H_
+
+#include "say_target.h"
+
+typedef enum {
+  SAY_CAPTURE_Y4M,
+  SAY_CAPTURE_RAW_RGBA,
+  SAY_CAPTURE_PNG_SEQUENCE
+} say_capture_format;
+
+#define SAY_CAPTURE_PBO_COUNT   3
+#define SAY_CAPTURE_QUEUE_SIZE  8
+
+typedef struct {
+  say_target *target;
+
+  say_capture_format format;
+  char *path;
+  FILE *file;
+
+  size_t width, height;
+  size_t fps;
+
+  GLuint pbos[SAY_CAPTURE_PBO_COUNT];
+  GLsync fences[SAY_CAPTURE_PBO_COUNT];
+  size_t pbo_start, pbo_count;
+
+  /* Frames waiting for the writer thread, top to bottom RGBA */
+  say_color *queue[SAY_CAPTURE_QUEUE_SIZE];
+  size_t queue_start, queue_count;
+
+  say_array *free_frames;
+
+  say_thread *thread;
+  say_mutex *mutex;
+  say_cond *cond;
+  bool stop;
+
+  bool running; /* False once stopped, counts are kept until it is freed */
+
+  size_t frame_count;
+  size_t dropped_count;
+  size_t written_count;
+} say_capture;
+
+say_capture *say_capture_create(say_target *target, const char *path,
+                                say_capture_format format, size_t fps);
+void say_capture_free(say_capture *capture);
+
+/* Writes every pending frame and closes the file */
+void say_capture_stop(say_capture *capture);
+bool say_capture_is_running(say_capture *capture);
+
+void say_capture_frame(say_capture *capture);
+
+size_t say_capture_get_frame_count(say_capture *capture);
+size_t say_capture_get_dropped_count(say_capture *capture);
+size_t say_capture_get_written_count(say_capture *capture);
+
+#endif
@@ -1,5 +1,9 @@
 #include "say.h"
 
+void say_init() {
+  say_gl_state_global_init();
+}
+
 void say_clean_up() {
   say_audio_context_clean_up();
   say_buffer_slice_clean_up();
@@ -14,16 +14,38 @@
 
 static say_context *say_shared_context = NULL;
 
+/*
+ * The ensured context still needs a thread variable, so it can be freed when
+ * its thread exits.
+ */
+#ifdef SAY_THREAD_LOCAL
+static SAY_THREAD_LOCAL say_context *say_current_context = NULL;
+#else
 static say_thread_variable *say_current_context = NULL;
+#endif
+
 static say_thread_variable *say_ensured_context = NULL;
 
-static void say_context_create_initial();
-static void say_context_setup(say_context *context);
-static void say_context_setup_states(say_context *context);
-static void say_context_glew_init();
+static bool say_context_create_initial();
+static bool say_context_setup(say_context *context);
+static bool say_context_setup_states(say_context *context);
+static bool say_context_glew_init();
 
 static uint32_t say_context_count = 0;
+static size_t say_context_switch_count = 0;
+
+/* -1 until it is either set or detected */
+static int say_context_headless = -1;
+
+#ifdef SAY_THREAD_LOCAL
+say_context *say_context_current() {
+  return say_current_context;
+}
 
+static void say_context_set_current(say_context *context) {
+  say_current_context = context;
+}
+#else
 say_context *say_context_current() {
   if (!say_current_context) {
     say_current_context = say_thread_variable_create(NULL);
@@ -32,7 +54,13 @@ say_context *say_context_current() {
   return (say_context*)say_thread_variable_get(say_current_context);
 }
 
-void say_context_ensure() {
+static void say_context_set_current(say_context *context) {
+  say_context_current(); /* creates the variable if needed */
+  say_thread_variable_set(say_current_context, context);
+}
+#endif
+
+bool say_context_ensure() {
   if (!say_ensured_context) {
     say_ensured_context =
       say_thread_variable_create((say_destructor)say_context_free);
@@ -42,34 +70,45 @@ void say_context_ensure() {
     say_context *context = say_thread_variable_get(say_ensured_context);
 
     if (!context) {
-      context = say_context_create();
+      if (!(context = say_context_create()))
+        return false;
+
       say_thread_variable_set(say_ensured_context, context);
     }
 
-    say_context_make_current(context);
+    return say_context_make_current(context);
   }
+
+  return true;
 }
 
 say_context *say_context_create() {
+  if (!say_shared_context && !say_context_create_initial())
+    return NULL;
+
   say_context *context = (say_context*)malloc(sizeof(say_context));
   context->count = ++say_context_count;
 
-  if (!say_shared_context)
-    say_context_create_initial();
+  if (!say_context_setup(context)) {
+    free(context);
+    return NULL;
+  }
 
-  say_context_setup(context);
-  say_context_setup_states(context);
+  if (!say_context_setup_states(context)) {
+    say_context_free(context);
+    return NULL;
+  }
 
   return context;
 }
 
 say_context *say_context_create_for_window(say_window *window) {
+  if (!say_shared_context && !say_context_create_initial())
+    return NULL;
+
   say_context *context = (say_context*)malloc(sizeof(say_context));
   context->count = ++say_context_count;
 
-  if (!say_shared_context)
-    say_context_create_initial();
-
   say_imp_context shared = say_shared_context->context;
   context->context = say_imp_context_create_for_window(shared,
                                                        window->win);
@@ -80,33 +119,118 @@ say_context *say_context_create_for_window(say_window *window) {
 
 void say_context_free(say_context *context) {
   if (say_context_current() == context) {
-    say_thread_variable_set(say_current_context, NULL);
+    say_context_set_current(NULL);
   }
 
   say_imp_context_free(context->context);
+  say_gl_state_release(&context->gl);
 
   free(context);
 }
 
-void say_context_make_current(say_context *context) {
+bool say_context_make_current(say_context *context) {
   if (say_context_current() != context) {
-    say_imp_context_make_current(context->context);
-    say_thread_variable_set(say_current_context, context);
+    if (!say_imp_context_make_current(context->context)) {
+      say_error_set("could not make context current");
+      return false;
+    }
+
+    say_context_set_current(context);
+    say_context_switch_count++;
+  }
+
+  return true;
+}
+
+bool say_context_headless_available() {
+  return say_imp_context_headless_available();
+}
+
+bool say_context_set_headless(bool headless) {
+  if (say_shared_context) {
+    if (say_context_is_headless() == headless)
+      return true;
+
+    say_error_set("contexts were already created");
+    return false;
+  }
+
+  if (headless && !say_context_headless_available()) {
+    say_error_set("headless contexts are not supported");
+    return false;
+  }
+
+  say_context_headless = headless;
+  return true;
+}
+
+bool say_context_is_headless() {
+  if (say_context_headless == -1) {
+    const char *env = getenv("RAY_HEADLESS");
+
+#ifdef SAY_X11
+    bool no_display = !getenv("DISPLAY");
+#else
+    bool no_display = false;
+#endif
+
+    bool wanted = (env && *env && strcmp(env, "0") != 0) || no_display;
+    say_context_headless = wanted && say_context_headless_available();
   }
+
+  return say_context_headless;
+}
+
+size_t say_context_get_switch_count() {
+  return say_context_switch_count;
+}
+
+say_render_ctx say_render_ctx_current() {
+  say_context_ensure();
+
+  say_render_ctx ctx;
+  ctx.context = say_context_current();
+  ctx.gl      = &ctx.context->gl;
+
+  return ctx;
+}
+
+say_render_ctx say_render_ctx_for(say_context *context) {
+  say_render_ctx ctx = {context, &context->gl};
+  return ctx;
 }
 
 void say_context_update(say_context *context) {
   say_imp_context_update(context->context);
 }
 
-static void say_context_create_initial() {
-  say_shared_context = (say_context*)malloc(sizeof(say_context));
+static bool say_context_create_initial() {
+  say_context *shared = (say_context*)malloc(sizeof(say_context));
+  shared->count = ++say_context_count;
 
-  say_context_setup(say_shared_context);
-  say_context_setup_states(say_shared_context);
+  say_shared_context = shared;
 
-  say_context_make_current(say_shared_context);
-  say_context_glew_init();
+  if (!say_context_setup(shared)) {
+    free(shared);
+    say_shared_context = NULL;
+    return false;
+  }
+
+  /* GL functions must be loaded before any state is set */
+  if (!say_imp_context_make_current(shared->context)) {
+    say_error_set("could not make context current");
+    say_imp_context_free(shared->context);
+    free(shared);
+    say_shared_context = NULL;
+    return false;
+  }
+
+  if (!say_context_glew_init() || !say_context_setup_states(shared)) {
+    say_context_set_current(NULL);
+    say_context_free(shared);
+    say_shared_context = NULL;
+    return false;
+  }
 
   /* Identify GLSL version to be used */
   const GLubyte *str = glGetString(GL_SHADING_LANGUAGE_VERSION);
@@ -117,42 +241,68 @@ static void say_context_create_initial() {
       say_shader_enable_new_glsl();
     }
   }
+
+  return true;
 }
 
-static void say_context_setup(say_context *context) {
+static bool say_context_setup(say_context *context) {
   if (say_shared_context == context)
     context->context = say_imp_context_create();
   else {
     context->context =
       say_imp_context_create_shared(say_shared_context->context);
   }
+
+  return context->context != NULL;
 }
 
-static void say_context_setup_states(say_context *context) {
-  say_context_make_current(context);
+static bool say_context_setup_states(say_context *context) {
+  say_gl_state_init(&context->gl);
+  if (!say_context_make_current(context))
+    return false;
 
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  say_gl_set_blend(true);
+  say_gl_set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-  glEnable(GL_DEPTH_TEST);
-  glDepthFunc(GL_LEQUAL);
+  say_gl_set_depth_test(true);
+  say_gl_set_depth_func(GL_LEQUAL);
 
   glReadBuffer(GL_FRONT);
+  return true;
 }
 
 void say_context_clean_up() {
+#ifdef SAY_THREAD_LOCAL
+  say_current_context = NULL;
+#else
   if (say_current_context)
     say_thread_variable_free(say_current_context);
 
+  say_current_context = NULL;
+#endif
+
   if (say_ensured_context)
     say_thread_variable_free(say_ensured_context);
 
-  say_current_context = NULL;
   say_ensured_context = NULL;
 }
 
-static void say_context_glew_init() {
-  glewInit();
+static bool say_context_glew_init() {
+  GLenum err = glewInit();
+
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+  /*
+   * GLEW built for GLX loads GL functions, and then fails to find the GLX
+   * extensions of EGL contexts. Those aren't needed without windows.
+   */
+  if (err == GLEW_ERROR_NO_GLX_DISPLAY && say_context_is_headless())
+    err = GLEW_OK;
+#endif
+
+  if (err != GLEW_OK) {
+    say_error_set((const char*)glewGetErrorString(err));
+    return false;
+  }
 
   if (__GLEW_APPLE_vertex_array_object &&
       !__GLEW_ARB_vertex_array_object) {
@@ -2,25 +2,54 @@
 #define SAY_CONTEXT_H_
 
 #include "say_basic_type.h"
+#include "say_gl_state.h"
 
 struct say_window;
 
 typedef struct {
   uint32_t count;
   say_imp_context context;
+
+  say_gl_state gl;
 } say_context;
 
-void say_context_ensure();
+/* False if no context could be created, with the error set */
+bool say_context_ensure();
 
 say_context *say_context_current();
 
 say_context *say_context_create_for_window(struct say_window *window);
+/* NULL if the context couldn't be created */
 say_context *say_context_create();
 void say_context_free(say_context *context);
 
-void say_context_make_current(say_context *context);
+bool say_context_make_current(say_context *context);
 void say_context_update(say_context *context);
 
+/*
+ * Headless contexts can only render to image targets, but don't need a display
+ * server. They are used by default if RAY_HEADLESS is set, or if no display is
+ * available. This can only be changed before the first context is created.
+ */
+bool say_context_set_headless(bool headless);
+bool say_context_is_headless();
+bool say_context_headless_available();
+
+/* Amount of times a different context was made current */
+size_t say_context_get_switch_count();
+
 void say_context_clean_up();
 
+/*
+ * A context and its state, looked up once and passed to the functions that
+ * draw, so they don't need to find the current context again.
+ */
+typedef struct {
+  say_context *context;
+  say_gl_state *gl;
+} say_render_ctx;
+
+say_render_ctx say_render_ctx_current();
+say_render_ctx say_render_ctx_for(say_context *context);
+
 #endif
@@ -42,6 +42,7 @@ say_drawable *say_drawable_create(size_t vtype) {
   drawable->matrix_updated = false;
   drawable->custom_matrix  = false;
   drawable->use_texture    = false;
+  drawable->alpha_only     = false;
   drawable->has_changed    = true;
 
   drawable->origin  = say_make_vector2(0, 0);
@@ -74,6 +75,7 @@ void say_drawable_copy(say_drawable *drawable, say_drawable *other) {
   drawable->angle   = other->angle;
 
   drawable->use_texture = other->use_texture;
+  drawable->alpha_only  = other->alpha_only;
 
   drawable->matrix_updated = false;
   drawable->has_changed    = true;
@@ -202,25 +204,31 @@ void say_drawable_fill_own_index_buffer(say_drawable *drawable) {
 
 void say_drawable_draw_at(say_drawable *drawable,
                           size_t vertex_id, size_t id,
-                          say_shader *shader) {
+                          say_shader *shader, say_render_ctx *ctx) {
   if (!drawable->matrix_updated)
     say_drawable_update_matrix(drawable);
 
-  say_shader *used_shader = drawable->shader ? drawable->shader : shader;
-  say_shader_set_matrix_id(used_shader, SAY_MODEL_VIEW_LOC_ID,
-                           drawable->matrix);
+  say_shader *custom = say_drawable_get_custom_shader(drawable);
+  say_shader *used_shader = custom ? custom : shader;
+
+  /* Nothing is drawn with programs that failed to build */
+  if (!say_shader_bind_ctx(used_shader, ctx))
+    return;
+
+  say_shader_set_model_view(used_shader, drawable->matrix, ctx);
 
   if (drawable->render_proc) {
-    if (drawable->shader) {
-      say_shader_set_int_id(drawable->shader, SAY_TEXTURE_ENABLED_LOC_ID,
-                            drawable->use_texture);
+    if (custom) {
+      say_shader_set_int_id(custom, SAY_TEXTURE_ENABLED_LOC_ID,
+                            drawable->use_texture, ctx);
     }
 
     drawable->render_proc(drawable->data, vertex_id, id, shader);
   }
 }
 
-void say_drawable_draw(say_drawable *drawable, say_shader *shader) {
+void say_drawable_draw(say_drawable *drawable, say_shader *shader,
+                       say_render_ctx *ctx) {
   if (drawable->has_changed) {
     say_drawable_fill_own_buffer(drawable);
     say_drawable_fill_own_index_buffer(drawable);
@@ -232,21 +240,26 @@ void say_drawable_draw(say_drawable *drawable, say_shader *shader) {
     say_drawable_update_matrix(drawable);
 
   /* NB: the current shader is always bound because we set a variable in it. */
-  say_shader *used_shader = drawable->shader ? drawable->shader : shader;
-  say_shader_set_matrix_id(used_shader, SAY_MODEL_VIEW_LOC_ID,
-                           drawable->matrix);
+  say_shader *custom = say_drawable_get_custom_shader(drawable);
+  say_shader *used_shader = custom ? custom : shader;
+
+  /* Nothing is drawn with programs that failed to build */
+  if (!say_shader_bind_ctx(used_shader, ctx))
+    return;
+
+  say_shader_set_model_view(used_shader, drawable->matrix, ctx);
 
   if (drawable->render_proc) {
-    if (drawable->shader) {
-      say_shader_set_int_id(drawable->shader, SAY_TEXTURE_ENABLED_LOC_ID,
-                            drawable->use_texture);
+    if (custom) {
+      say_shader_set_int_id(custom, SAY_TEXTURE_ENABLED_LOC_ID,
+                            drawable->use_texture, ctx);
     }
 
     if (drawable->vertex_count != 0)
-      say_buffer_slice_bind(drawable->slice);
+      say_buffer_slice_bind_ctx(drawable->slice, ctx);
 
     if (drawable->index_count != 0)
-      say_index_buffer_slice_bind(drawable->index_slice);
+      say_index_buffer_slice_bind_ctx(drawable->index_slice, ctx);
 
     drawable->render_proc(drawable->data,
                           say_buffer_slice_get_loc(drawable->slice),
@@ -271,6 +284,42 @@ uint8_t say_drawable_is_textured(say_drawable *drawable) {
   return drawable->use_texture;
 }
 
+void say_drawable_set_alpha_only(say_drawable *drawable, bool val) {
+  drawable->alpha_only = val;
+}
+
+bool say_drawable_is_alpha_only(say_drawable *drawable) {
+  return drawable->alpha_only;
+}
+
+uint8_t say_drawable_get_shader_features(say_drawable *drawable) {
+  if (!drawable->use_texture)
+    return 0;
+
+  return SAY_SHADER_TEXTURED |
+    (drawable->alpha_only ? SAY_SHADER_ALPHA_ONLY : 0);
+}
+
+void say_draw_arrays(GLenum mode, size_t first, size_t count) {
+  say_raster *raster = say_raster_current();
+
+  if (raster)
+    say_raster_draw_arrays(raster, mode, first, count);
+  else
+    glDrawArrays(mode, first, count);
+}
+
+void say_draw_elements(GLenum mode, size_t count, size_t index) {
+  say_raster *raster = say_raster_current();
+
+  if (raster)
+    say_raster_draw_elements(raster, mode, count, index);
+  else {
+    glDrawElements(mode, count, GL_UNSIGNED_INT,
+                   (void*)(index * sizeof(GLuint)));
+  }
+}
+
 say_shader *say_drawable_get_shader(say_drawable *drawable) {
   return drawable->shader;
 }
@@ -279,6 +328,13 @@ void say_drawable_set_shader(say_drawable *drawable, say_shader *shader) {
   drawable->shader = shader;
 }
 
+say_shader *say_drawable_get_custom_shader(say_drawable *drawable) {
+  if (drawable->shader && !say_shader_is_shared(drawable->shader))
+    return drawable->shader;
+  else
+    return NULL;
+}
+
 void say_drawable_set_origin(say_drawable *drawable, say_vector2 origin) {
   drawable->matrix_updated = 0;
   drawable->origin = origin;
@@ -334,7 +390,7 @@ say_matrix *say_drawable_get_matrix(say_drawable *drawable) {
 void say_drawable_set_matrix(say_drawable *drawable, say_matrix *matrix) {
   if (matrix) {
     drawable->custom_matrix = true;
-    memcpy(drawable->matrix->content, matrix->content, sizeof(float) * 16);
+    say_matrix_set_content(drawable->matrix, matrix->content);
   }
   else {
     drawable->custom_matrix  = false;
@@ -36,6 +36,7 @@ typedef struct {
   float       angle;
 
   bool use_texture;
+  bool alpha_only;
   bool matrix_updated;
   bool custom_matrix;
   bool has_changed;
@@ -69,8 +70,9 @@ void say_drawable_fill_index_buffer(say_drawable *drawable, GLuint *indices,
 void say_drawable_fill_own_index_buffer(say_drawable *drawable);
 
 void say_drawable_draw_at(say_drawable *drawable, size_t vertex, size_t id,
-                          say_shader *shader);
-void say_drawable_draw(say_drawable *drawable, say_shader *shader);
+                          say_shader *shader, say_render_ctx *ctx);
+void say_drawable_draw(say_drawable *drawable, say_shader *shader,
+                       say_render_ctx *ctx);
 
 void say_drawable_set_changed(say_drawable *drawable);
 uint8_t say_drawable_has_changed(say_drawable *drawable);
@@ -78,9 +80,30 @@ uint8_t say_drawable_has_changed(say_drawable *drawable);
 void say_drawable_set_textured(say_drawable *drawable, uint8_t val);
 uint8_t say_drawable_is_textured(say_drawable *drawable);
 
+/* Only use the alpha channel of the texture, e.g. for glyphs */
+void say_drawable_set_alpha_only(say_drawable *drawable, bool val);
+bool say_drawable_is_alpha_only(say_drawable *drawable);
+
+/* Features of the default shader variant the drawable is drawn with */
+uint8_t say_drawable_get_shader_features(say_drawable *drawable);
+
+/*
+ * Used by render procs instead of glDrawArrays and glDrawElements, so that
+ * drawables can also be drawn by the software rasterizer. index is counted in
+ * elements of the index buffer.
+ */
+void say_draw_arrays(GLenum mode, size_t first, size_t count);
+void say_draw_elements(GLenum mode, size_t count, size_t index);
+
 say_shader *say_drawable_get_shader(say_drawable *drawable);
 void say_drawable_set_shader(say_drawable *drawable, say_shader *shader);
 
+/*
+ * Returns the shader of the drawable if it has its own code, NULL if the
+ * default program is used.
+ */
+say_shader *say_drawable_get_custom_shader(say_drawable *drawable);
+
 void say_drawable_set_origin(say_drawable *drawable, say_vector2 origin);
 void say_drawable_set_scale(say_drawable *drawable, say_vector2 scale);
 void say_drawable_set_pos(say_drawable *drawable, say_vector2 pos);
@@ -1,6 +1,6 @@
 #include "say.h"
 
-static say_font_page *say_page_create() {
+static say_font_page *say_page_alloc() {
   say_font_page *page = malloc(sizeof(say_font_page));
 
   page->glyphs = say_table_create(free);
@@ -10,8 +10,20 @@ static say_font_page *say_page_create() {
 
   page->current_height = 2;
 
+  page->line_height = 0;
+  page->kernings    = NULL;
+
+  page->opaque = say_make_rect(0, 0, 0, 0);
+
   page->image = say_image_create();
   say_image_set_smooth(page->image, 1);
+  say_image_set_keep_pixels(page->image, true); /* Glyphs are added later */
+
+  return page;
+}
+
+static say_font_page *say_page_create() {
+  say_font_page *page = say_page_alloc();
   say_image_create_with_size(page->image, 128, 128);
 
   for (int y = 0; y < 128; y++) {
@@ -26,6 +38,8 @@ static say_font_page *say_page_create() {
     }
   }
 
+  page->opaque = say_make_rect(0, 0, 2, 2);
+
   return page;
 }
 
@@ -35,6 +49,9 @@ static void say_page_free(say_font_page *page) {
   say_array_free(page->rows);
   say_table_free(page->glyphs);
 
+  if (page->kernings)
+    say_array_free(page->kernings);
+
   free(page);
 }
 
@@ -85,54 +102,302 @@ static say_rect say_page_find_rect(say_font_page *page, size_t width, size_t hei
   return rect;
 }
 
-static size_t say_font_get_size(say_font *font) {
-  return font->face->size->metrics.x_ppem;
+static FT_Library    say_ft_library    = NULL;
+static FTC_Manager   say_ft_manager    = NULL;
+static size_t        say_ft_cache_size = 0;
+static say_mutex    *say_font_mutex    = NULL;
+static say_array    *say_font_faces    = NULL;
+
+/*
+ * Creates the FreeType library shared by every font. Fonts are only created
+ * from the main thread, so this doesn't need to be protected.
+ */
+static FT_Library say_font_library() {
+  if (!say_ft_library) {
+    if (FT_Init_FreeType(&say_ft_library) != 0) {
+      say_ft_library = NULL;
+      say_error_set("could not initialize freetype library");
+      return NULL;
+    }
+
+    say_font_mutex = say_mutex_create();
+    say_font_faces = say_array_create(sizeof(say_font_face*), NULL, NULL);
+  }
+
+  return say_ft_library;
 }
 
-static int say_font_set_size(say_font *font, size_t size) {
-  if (say_font_get_size(font) != size) {
-    int err = FT_Set_Pixel_Sizes(font->face, 0, size);
-    if (err) {
-      say_error_set("could not set font size");
-      return 0;
-    }
+/* Doesn't report errors, so it can be used from worker threads */
+static FT_Error say_font_face_open_raw(say_font_face *shared, FT_Face *face,
+                                       bool *bad_charmap) {
+  FT_Error err;
+
+  if (shared->filename)
+    err = FT_New_Face(say_ft_library, shared->filename, 0, face);
+  else {
+    err = FT_New_Memory_Face(say_ft_library, shared->buffer,
+                             shared->buffer_size, 0, face);
   }
 
-  int err = FT_Select_Charmap(font->face, FT_ENCODING_UNICODE);
+  *bad_charmap = false;
+
+  if (err)
+    return err;
+
+  err = FT_Select_Charmap(*face, FT_ENCODING_UNICODE);
   if (err) {
-    say_error_set("could not select unicode charmap");
-    return 0;
+    FT_Done_Face(*face);
+    *bad_charmap = true;
   }
 
-  return 1;
+  return err;
 }
 
-static say_glyph *say_font_load_glyph(say_font *font, say_font_page *page,
-                                      uint32_t codepoint, uint8_t bold,
-                                      size_t size) {
-  uint32_t bold_codepoint = ((bold ? 1 : 0) << 31) | codepoint;
+static FT_Error say_font_face_open(say_font_face *shared, FT_Face *face) {
+  bool bad_charmap;
+  FT_Error err = say_font_face_open_raw(shared, face, &bad_charmap);
 
-  say_glyph *glyph = malloc(sizeof(say_glyph));
-  say_table_set(page->glyphs, bold_codepoint, glyph);
+  if (err) {
+    say_error_set(bad_charmap ? "could not select unicode charmap" :
+                  "could not create face");
+  }
 
-  glyph->offset   = 0;
-  glyph->bounds   = say_make_rect(2, 0, 2, 2);
-  glyph->sub_rect = say_make_rect(2, 0, 2, 2);
+  return err;
+}
 
-  if (!(font->face && say_font_set_size(font, size)))
-    return glyph;
+static FT_Error say_font_face_requester(FTC_FaceID id, FT_Library library,
+                                        FT_Pointer data, FT_Face *face) {
+  return say_font_face_open((say_font_face*)id, face);
+}
 
-  if (FT_Load_Char(font->face, codepoint, FT_LOAD_TARGET_NORMAL) != 0)
-    return glyph;
+/* Must be called with the font mutex locked */
+static FT_Face say_font_face_lookup(say_font_face *shared) {
+  if (say_ft_manager) {
+    FT_Face face = NULL;
+    if (FTC_Manager_LookupFace(say_ft_manager, (FTC_FaceID)shared, &face))
+      return NULL;
+
+    return face;
+  }
+
+  if (!shared->face && say_font_face_open(shared, &shared->face) != 0)
+    shared->face = NULL;
+
+  return shared->face;
+}
+
+static uint64_t say_font_hash(const uint8_t *buf, size_t size) {
+  /* FNV-1a */
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= buf[i];
+    hash *= 1099511628211ULL;
+  }
+
+  return hash;
+}
+
+static bool say_font_face_matches(say_font_face *shared, const char *filename,
+                                  void *buf, size_t size, uint64_t hash) {
+  if (filename)
+    return shared->filename && strcmp(shared->filename, filename) == 0;
+  else {
+    return !shared->filename &&
+      shared->hash == hash && shared->buffer_size == size &&
+      (shared->buffer == buf || memcmp(shared->buffer, buf, size) == 0);
+  }
+}
+
+static say_font_face *say_font_face_acquire(const char *filename,
+                                            void *buf, size_t size,
+                                            bool copy) {
+  if (!say_font_library())
+    return NULL;
+
+  uint64_t hash = filename ? 0 : say_font_hash(buf, size);
+
+  say_mutex_lock(say_font_mutex);
+
+  for (size_t i = 0; i < say_array_get_size(say_font_faces); i++) {
+    say_font_face *shared = *(say_font_face**)say_array_get(say_font_faces, i);
+
+    if (say_font_face_matches(shared, filename, buf, size, hash)) {
+      shared->ref_count++;
+      say_mutex_unlock(say_font_mutex);
+
+      return shared;
+    }
+  }
+
+  say_font_face *shared = malloc(sizeof(say_font_face));
+
+  shared->filename    = filename ? say_strdup(filename) : NULL;
+  shared->buffer_size = size;
+  shared->hash        = hash;
+  shared->owns_buffer = !filename && copy;
+  shared->face        = NULL;
+  shared->ref_count   = 1;
+
+  if (shared->owns_buffer) {
+    shared->buffer = malloc(size);
+    memcpy(shared->buffer, buf, size);
+  }
+  else
+    shared->buffer = buf;
+
+  if (!say_font_face_lookup(shared)) {
+    say_mutex_unlock(say_font_mutex);
+
+    if (shared->owns_buffer) free(shared->buffer);
+    if (shared->filename)    free(shared->filename);
+    free(shared);
+
+    return NULL;
+  }
+
+  shared->pages      = say_table_create((say_destructor)say_page_free);
+  shared->batches    = say_array_create(sizeof(struct say_glyph_batch*),
+                                        NULL, NULL);
+  shared->generation = 0;
+
+  say_array_push(say_font_faces, &shared);
+
+  say_mutex_unlock(say_font_mutex);
+
+  return shared;
+}
+
+static void say_font_face_wait(say_font_face *shared, bool keep_results);
+
+static void say_font_face_release(say_font_face *shared) {
+  say_mutex_lock(say_font_mutex);
+
+  if (--shared->ref_count != 0) {
+    say_mutex_unlock(say_font_mutex);
+    return;
+  }
+
+  say_mutex_unlock(say_font_mutex);
+
+  /* Workers use the face data, they must be done before it is freed */
+  say_font_face_wait(shared, false);
+  say_array_free(shared->batches);
+
+  say_mutex_lock(say_font_mutex);
+
+  for (size_t i = 0; i < say_array_get_size(say_font_faces); i++) {
+    if (*(say_font_face**)say_array_get(say_font_faces, i) == shared) {
+      say_array_delete(say_font_faces, i);
+      break;
+    }
+  }
+
+  if (say_ft_manager)
+    FTC_Manager_RemoveFaceID(say_ft_manager, (FTC_FaceID)shared);
+
+  if (shared->face)
+    FT_Done_Face(shared->face);
+
+  say_mutex_unlock(say_font_mutex);
+
+  say_table_free(shared->pages);
+
+  if (shared->owns_buffer) free(shared->buffer);
+  if (shared->filename)    free(shared->filename);
+  free(shared);
+}
+
+static bool say_font_has_face_kerning(say_font *font) {
+  if (!font->shared)
+    return false;
+
+  say_mutex_lock(say_font_mutex);
+  FT_Face face = say_font_face_lookup(font->shared);
+  bool ret = face && FT_HAS_KERNING(face);
+  say_mutex_unlock(say_font_mutex);
+
+  return ret;
+}
+
+/*
+ * Returns the face of a font, using the right character size. The cache may
+ * close or resize the face once the font mutex is unlocked, so it must be held
+ * for as long as the face is used.
+ */
+static FT_Face say_font_get_sized_face(say_font *font, size_t size) {
+  if (!font->shared)
+    return NULL;
+
+  FT_Face face = NULL;
+
+  if (say_ft_manager) {
+    FTC_ScalerRec scaler;
+    scaler.face_id = (FTC_FaceID)font->shared;
+    scaler.width   = 0;
+    scaler.height  = size;
+    scaler.pixel   = 1;
+    scaler.x_res   = 0;
+    scaler.y_res   = 0;
+
+    FT_Size ft_size;
+    if (FTC_Manager_LookupSize(say_ft_manager, &scaler, &ft_size) == 0)
+      face = ft_size->face;
+    else
+      say_error_set("could not set font size");
+  }
+  else if ((face = say_font_face_lookup(font->shared))) {
+    if (face->size->metrics.x_ppem != size &&
+        FT_Set_Pixel_Sizes(face, 0, size) != 0) {
+      say_error_set("could not set font size");
+      face = NULL;
+    }
+  }
+
+  return face;
+}
+
+/*
+ * Glyphs are loaded in two steps: they are first rasterized (which may happen
+ * on a worker thread), and then copied to the page of the font (which must
+ * happen on the thread that uses the font).
+ */
+typedef struct {
+  uint32_t codepoint;
+  size_t   size;
+  uint8_t  bold;
+
+  int offset;
+  int left, top;
+  int width, height;
+  uint8_t *alpha; /* width * height coverage values */
+} say_glyph_job;
+
+/*
+ * Workers rasterize with faces of their own, without holding the font mutex.
+ * It is still needed around calls that use the library itself.
+ */
+static void say_glyph_rasterize(FT_Face face, say_glyph_job *job,
+                                bool locked) {
+  job->offset = 0;
+  job->left   = job->top    = 0;
+  job->width  = job->height = 0;
+  job->alpha  = NULL;
+
+  if (face->size->metrics.x_ppem != job->size &&
+      FT_Set_Pixel_Sizes(face, 0, job->size) != 0)
+    return;
+
+  if (FT_Load_Char(face, job->codepoint, FT_LOAD_TARGET_NORMAL) != 0)
+    return;
 
   FT_Glyph ft_glyph;
-  if (FT_Get_Glyph(font->face->glyph, &ft_glyph) != 0)
-    return glyph;
+  if (FT_Get_Glyph(face->glyph, &ft_glyph) != 0)
+    return;
 
   FT_Pos weight = 1 << 6;
   uint8_t outline = ft_glyph->format == FT_GLYPH_FORMAT_OUTLINE;
 
-  if (bold && outline) {
+  if (job->bold && outline) {
     FT_OutlineGlyph outline_glyph = (FT_OutlineGlyph)ft_glyph;
     FT_Outline_Embolden(&outline_glyph->outline, weight);
   }
@@ -141,83 +406,320 @@ static say_glyph *say_font_load_glyph(say_font *font, say_font_page *page,
   FT_BitmapGlyph bitmap_glyph = (FT_BitmapGlyph)ft_glyph;
   FT_Bitmap *bitmap = &bitmap_glyph->bitmap;
 
-  if (bold && !outline) {
-    FT_Bitmap_Embolden(font->library, bitmap, weight, weight);
+  if (job->bold && !outline) {
+    if (!locked) say_mutex_lock(say_font_mutex);
+    FT_Bitmap_Embolden(say_ft_library, bitmap, weight, weight);
+    if (!locked) say_mutex_unlock(say_font_mutex);
   }
 
-  glyph->offset = ft_glyph->advance.x >> 16;
-  if (bold)
-    glyph->offset += weight >> 6;
+  job->offset = ft_glyph->advance.x >> 16;
+  if (job->bold)
+    job->offset += weight >> 6;
+
+  job->left = bitmap_glyph->left;
+  job->top  = bitmap_glyph->top;
 
   int width  = bitmap->width;
   int height = bitmap->rows;
 
   if (width > 0 && height > 0) {
+    job->width  = width;
+    job->height = height;
+    job->alpha  = malloc(width * height);
+
+    uint8_t *pixels = bitmap->buffer;
+    uint8_t *alpha  = job->alpha;
+
+    for (int y = 0; y < height; y++) {
+      if (bitmap->pixel_mode == FT_PIXEL_MODE_MONO) {
+        for (int x = 0; x < width; x++)
+          alpha[x] = ((pixels[x / 8]) & (1 << (7 - (x % 8)))) ? 255 : 0;
+      }
+      else
+        memcpy(alpha, pixels, width);
+
+      pixels += bitmap->pitch;
+      alpha  += width;
+    }
+  }
+
+  FT_Done_Glyph(ft_glyph);
+}
+
+static say_glyph *say_glyph_create(say_font_page *page, uint32_t codepoint,
+                                   uint8_t bold) {
+  uint32_t bold_codepoint = ((bold ? 1 : 0) << 31) | codepoint;
+
+  say_glyph *glyph = malloc(sizeof(say_glyph));
+
+  say_table_del(page->glyphs, bold_codepoint); /* Placeholders */
+  say_table_set(page->glyphs, bold_codepoint, glyph);
+
+  glyph->offset   = 0;
+  glyph->bounds   = say_make_rect(2, 0, 2, 2);
+  glyph->sub_rect = say_make_rect(2, 0, 2, 2);
+
+  return glyph;
+}
+
+static say_glyph *say_font_insert_glyph(say_font_page *page,
+                                        say_glyph_job *job) {
+  say_glyph *glyph = say_glyph_create(page, job->codepoint, job->bold);
+  glyph->offset = job->offset;
+
+  if (job->alpha) {
     static const int padding = 1;
     glyph->sub_rect = say_page_find_rect(page,
-                                         width  + (2 * padding),
-                                         height + (2 * padding));
+                                         job->width  + (2 * padding),
+                                         job->height + (2 * padding));
+
+    glyph->bounds.x = +job->left - padding;
+    glyph->bounds.y = -job->top - padding;
+    glyph->bounds.w = job->width  + (2 * padding);
+    glyph->bounds.h = job->height + (2 * padding);
+
+    int start_x = glyph->sub_rect.x + padding;
+    int start_y = glyph->sub_rect.y + padding;
+
+    uint8_t *alpha = job->alpha;
+    for (int y = 0; y < job->height; y++) {
+      for (int x = 0; x < job->width; x++) {
+        say_image_set(page->image, start_x + x, start_y + y,
+                      say_make_color(255, 255, 255, alpha[x]));
+      }
 
-    glyph->bounds.x = +bitmap_glyph->left - padding;
-    glyph->bounds.y = -bitmap_glyph->top - padding;
-    glyph->bounds.w = width   + (2 * padding);
-    glyph->bounds.h = height  + (2 * padding);
+      alpha += job->width;
+    }
 
-    say_rect actual_rect = glyph->sub_rect;
-    actual_rect.x += padding;
-    actual_rect.y += padding;
-    actual_rect.w -= 2 * padding;
-    actual_rect.h -= 2 * padding;
+    free(job->alpha);
+    job->alpha = NULL;
+  }
 
-    uint8_t *pixels = bitmap->buffer;
+  return glyph;
+}
 
-    if (bitmap->pixel_mode == FT_PIXEL_MODE_MONO) {
-      for (int y = actual_rect.y; y < actual_rect.y + actual_rect.h; y++) {
-        for (int x = actual_rect.x; x < actual_rect.x + actual_rect.w; x++) {
-          int pixel_x = x - actual_rect.x;
-          uint8_t alpha = ((pixels[pixel_x / 8]) &
-                           (1 << (7 - (pixel_x % 8)))) ? 255 : 0;
-          say_image_set(page->image, x, y,
-                        say_make_color(255, 255, 255, alpha));
-        }
+static say_glyph *say_font_load_glyph(say_font *font, say_font_page *page,
+                                      uint32_t codepoint, uint8_t bold,
+                                      size_t size) {
+  say_glyph_job job = {codepoint, size, bold, 0, 0, 0, 0, 0, NULL};
 
-        pixels += bitmap->pitch;
-      }
+  if (font->shared) {
+    say_mutex_lock(say_font_mutex);
+
+    FT_Face face = say_font_get_sized_face(font, size);
+    if (face)
+      say_glyph_rasterize(face, &job, true);
+
+    say_mutex_unlock(say_font_mutex);
+  }
+
+  return say_font_insert_glyph(page, &job);
+}
+
+/*
+ * Batches of missing glyphs are split between worker threads, each of which
+ * opens its own face: FreeType faces can't be used from several threads.
+ */
+
+#define SAY_FONT_BATCH_THRESHOLD  16
+#define SAY_FONT_GLYPHS_PER_WORKER 8
+
+static size_t say_font_worker_count = 0; /* 0 means one per CPU */
+static bool   say_font_async        = false;
+static bool   say_font_placeholders = false;
+
+struct say_glyph_worker;
+
+typedef struct say_glyph_batch {
+  say_font_face *shared;
+  say_table *pages; /* Where glyphs are inserted once rasterized */
+
+  say_glyph_job *jobs;
+  size_t job_count;
+
+  struct say_glyph_worker *workers;
+  size_t worker_count;
+
+  size_t done_count; /* protected by the font mutex */
+} say_glyph_batch;
+
+typedef struct say_glyph_worker {
+  say_glyph_batch *batch;
+  say_thread *thread;
+
+  size_t first, count;
+} say_glyph_worker;
+
+static void *say_glyph_worker_run(void *data) {
+  say_glyph_worker *worker = data;
+  say_glyph_batch  *batch  = worker->batch;
+
+  FT_Face face;
+  bool bad_charmap;
+
+  say_mutex_lock(say_font_mutex);
+  FT_Error err = say_font_face_open_raw(batch->shared, &face, &bad_charmap);
+  say_mutex_unlock(say_font_mutex);
+
+  if (!err) {
+    for (size_t i = worker->first; i < worker->first + worker->count; i++)
+      say_glyph_rasterize(face, &batch->jobs[i], false);
+  }
+  else {
+    for (size_t i = worker->first; i < worker->first + worker->count; i++) {
+      say_glyph_job *job = &batch->jobs[i];
+      job->offset = job->width = job->height = 0;
+      job->alpha  = NULL;
     }
-    else {
-      for (int y = actual_rect.y; y < actual_rect.y + actual_rect.h;
-           y++) {
-        for (int x = actual_rect.x; x < actual_rect.x + actual_rect.w;
-             x++) {
-          int pixel_x = x - actual_rect.x;
-          say_image_set(page->image, x, y,
-                        say_make_color(255, 255, 255, pixels[pixel_x]));
-        }
+  }
 
-        pixels += bitmap->pitch;
-      }
+  say_mutex_lock(say_font_mutex);
+  if (!err)
+    FT_Done_Face(face);
+  batch->done_count++;
+  say_mutex_unlock(say_font_mutex);
+
+  return NULL;
+}
+
+static say_glyph_batch *say_glyph_batch_start(say_font_face *shared,
+                                              say_table *pages,
+                                              uint32_t *codepoints,
+                                              size_t count, size_t size,
+                                              uint8_t bold) {
+  say_glyph_batch *batch = malloc(sizeof(say_glyph_batch));
+
+  batch->shared     = shared;
+  batch->pages      = pages;
+  batch->job_count  = count;
+  batch->jobs       = malloc(sizeof(say_glyph_job) * count);
+  batch->done_count = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    say_glyph_job job = {codepoints[i], size, bold, 0, 0, 0, 0, 0, NULL};
+    batch->jobs[i] = job;
+  }
+
+  size_t worker_count = say_font_get_worker_count();
+  size_t max_workers  = (count + SAY_FONT_GLYPHS_PER_WORKER - 1) /
+    SAY_FONT_GLYPHS_PER_WORKER;
+  if (worker_count > max_workers)
+    worker_count = max_workers;
+  if (worker_count == 0)
+    worker_count = 1;
+
+  batch->worker_count = worker_count;
+  batch->workers      = malloc(sizeof(say_glyph_worker) * worker_count);
+
+  size_t first = 0;
+  for (size_t i = 0; i < worker_count; i++) {
+    say_glyph_worker *worker = &batch->workers[i];
+
+    worker->batch = batch;
+    worker->first = first;
+    worker->count = count / worker_count + (i < count % worker_count ? 1 : 0);
+
+    first += worker->count;
+  }
+
+  for (size_t i = 0; i < worker_count; i++) {
+    batch->workers[i].thread = say_thread_create(&batch->workers[i],
+                                                 say_glyph_worker_run);
+  }
+
+  return batch;
+}
+
+static bool say_glyph_batch_is_done(say_glyph_batch *batch) {
+  say_mutex_lock(say_font_mutex);
+  bool done = batch->done_count == batch->worker_count;
+  say_mutex_unlock(say_font_mutex);
+
+  return done;
+}
+
+static void say_glyph_batch_finish(say_glyph_batch *batch, bool keep_results) {
+  for (size_t i = 0; i < batch->worker_count; i++) {
+    say_thread_join(batch->workers[i].thread);
+    say_thread_free(batch->workers[i].thread);
+  }
+
+  for (size_t i = 0; i < batch->job_count; i++) {
+    say_glyph_job *job = &batch->jobs[i];
+
+    if (keep_results) {
+      say_font_page *page = say_table_get(batch->pages, job->size);
+      if (page)
+        say_font_insert_glyph(page, job);
     }
+
+    if (job->alpha)
+      free(job->alpha);
   }
 
-  FT_Done_Glyph(ft_glyph);
+  if (keep_results)
+    batch->shared->generation++;
 
-  return glyph;
+  free(batch->workers);
+  free(batch->jobs);
+  free(batch);
 }
 
-say_font *say_font_create() {
-  say_font *font = malloc(sizeof(say_font));
+static void say_font_face_wait(say_font_face *shared, bool keep_results) {
+  for (size_t i = 0; i < say_array_get_size(shared->batches); i++) {
+    say_glyph_batch *batch =
+      *(say_glyph_batch**)say_array_get(shared->batches, i);
+    say_glyph_batch_finish(batch, keep_results);
+  }
 
-  int err = FT_Init_FreeType(&font->library);
-  if (err) {
-    free(font);
+  say_array_resize(shared->batches, 0);
+}
 
-    say_error_set("could not initialize freetype library");
-    return NULL;
+/*
+ * Pages created for a face start with opaque pixels at their top left corner.
+ * Pages loaded from bitmap fonts may not have any, so some are added to them
+ * the first time they are needed.
+ */
+static say_rect say_page_get_opaque_rect(say_font_page *page) {
+  if (page->opaque.w == 0) {
+    page->opaque = say_page_find_rect(page, 2, 2);
+
+    for (int y = 0; y < 2; y++) {
+      for (int x = 0; x < 2; x++) {
+        say_image_set(page->image, page->opaque.x + x, page->opaque.y + y,
+                      say_make_color(255, 255, 255, 255));
+      }
+    }
+  }
+
+  return page->opaque;
+}
+
+static void say_glyph_set_placeholder(say_font_page *page, uint32_t codepoint,
+                                      uint8_t bold, size_t size) {
+  say_glyph *glyph = say_glyph_create(page, codepoint, bold);
+  glyph->offset = size / 2;
+
+  if (say_font_placeholders) {
+    /* Only samples between the centers of the opaque pixels */
+    say_rect opaque = say_page_get_opaque_rect(page);
+
+    glyph->bounds   = say_make_rect(0, -(size * 0.7f), size * 0.4f,
+                                    size * 0.7f);
+    glyph->sub_rect = say_make_rect(opaque.x + 0.5, opaque.y + 0.5, 0.5, 0.5);
   }
+}
 
-  font->face = NULL;
+static int say_codepoint_cmp(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
 
-  font->pages = say_table_create((say_destructor)say_page_free);
+say_font *say_font_create() {
+  say_font *font = malloc(sizeof(say_font));
+
+  font->shared = NULL;
+  font->pages  = say_table_create((say_destructor)say_page_free);
 
   return font;
 }
@@ -225,51 +727,54 @@ say_font *say_font_create() {
 static say_font *say_default_font = NULL;
 #include "say_arial.h"
 
+static int say_font_load(say_font *font, const char *filename,
+                         void *buf, size_t size, bool copy);
+
 say_font *say_font_default() {
   if (!say_default_font) {
     say_default_font = say_font_create();
-    say_font_load_from_memory(say_default_font, say_arial_content,
-                              sizeof(say_arial_content));
+
+    /* The embedded font is never freed, no need to copy it */
+    say_font_load(say_default_font, NULL, say_arial_content,
+                  sizeof(say_arial_content), false);
   }
 
   return say_default_font;
 }
 
-void say_font_free(say_font *font) {
-  if (font->face)
-    FT_Done_Face(font->face);
+static void say_font_release_pages(say_font *font) {
+  if (!font->shared || font->pages != font->shared->pages)
+    say_table_free(font->pages);
 
-  if (font->library)
-    FT_Done_FreeType(font->library);
+  if (font->shared)
+    say_font_face_release(font->shared);
+}
 
-  say_table_free(font->pages);
+void say_font_free(say_font *font) {
+  say_font_release_pages(font);
   free(font);
 }
 
-int say_font_load_from_file(say_font *font, const char *file) {
-  int err = FT_New_Face(font->library, file, 0, &font->face);
-  if (err) {
-    say_error_set("could not create face");
+static int say_font_load(say_font *font, const char *filename,
+                         void *buf, size_t size, bool copy) {
+  say_font_face *shared = say_font_face_acquire(filename, buf, size, copy);
+  if (!shared)
     return 0;
-  }
+
+  say_font_release_pages(font);
+
+  font->shared = shared;
+  font->pages  = shared->pages;
 
   return 1;
 }
 
-int say_font_load_from_memory(say_font *font, void *buf, size_t size) {
-  int err = FT_New_Memory_Face(font->library, buf, size, 0, &font->face);
-  if (err) {
-    say_error_set("could not create face");
-    return 0;
-  }
-
-  err = FT_Select_Charmap(font->face, FT_ENCODING_UNICODE);
-  if (err) {
-    say_error_set("could not select unicode charmap");
-    return 0;
-  }
+int say_font_load_from_file(say_font *font, const char *file) {
+  return say_font_load(font, file, NULL, 0, false);
+}
 
-  return 1;
+int say_font_load_from_memory(say_font *font, void *buf, size_t size) {
+  return say_font_load(font, NULL, buf, size, true);
 }
 
 say_font_page *say_font_get_page(say_font *font, size_t size) {
@@ -296,31 +801,78 @@ say_glyph *say_font_get_glyph(say_font *font, uint32_t codepoint, size_t size, u
   }
 }
 
-size_t say_font_get_kerning(say_font *font, uint32_t first, uint32_t second,
-                            size_t size) {
+static int say_kerning_cmp(const void *a, const void *b) {
+  const say_font_kerning *x = a, *y = b;
+
+  if (x->first != y->first)
+    return x->first < y->first ? -1 : 1;
+  else if (x->second != y->second)
+    return x->second < y->second ? -1 : 1;
+  else
+    return 0;
+}
+
+int say_font_get_kerning(say_font *font, uint32_t first, uint32_t second,
+                         size_t size) {
   if (first == 0 || second == 0)
     return 0;
 
-  if (font->face && FT_HAS_KERNING(font->face) &&
-      say_font_set_size(font, size)) {
-    size_t first_index = FT_Get_Char_Index(font->face, first);
-    size_t sec_index   = FT_Get_Char_Index(font->face, second);
+  say_font_page *page = say_table_get(font->pages, size);
+  if (page && page->kernings) {
+    size_t count = say_array_get_size(page->kernings);
+    if (count == 0)
+      return 0;
+
+    say_font_kerning key = {first, second, 0};
+    say_font_kerning *found = bsearch(&key, say_array_get(page->kernings, 0),
+                                      count, sizeof(say_font_kerning),
+                                      say_kerning_cmp);
+
+    return found ? found->amount : 0;
+  }
+
+  if (!font->shared)
+    return 0;
+
+  int ret = 0;
+
+  say_mutex_lock(say_font_mutex);
+
+  FT_Face face = say_font_get_sized_face(font, size);
+  if (face && FT_HAS_KERNING(face)) {
+    size_t first_index = FT_Get_Char_Index(face, first);
+    size_t sec_index   = FT_Get_Char_Index(face, second);
 
     FT_Vector kerning;
-    FT_Get_Kerning(font->face, first_index, sec_index, FT_KERNING_DEFAULT,
+    FT_Get_Kerning(face, first_index, sec_index, FT_KERNING_DEFAULT,
                    &kerning);
 
-    return kerning.x >> 6;
+    ret = kerning.x >> 6;
   }
 
-  return 0;
+  say_mutex_unlock(say_font_mutex);
+
+  return ret;
 }
 
 size_t say_font_get_line_height(say_font *font, size_t size) {
-  if (font->face && say_font_set_size(font, size))
-    return font->face->size->metrics.height >> 6;
+  say_font_page *page = say_table_get(font->pages, size);
+  if (page && page->kernings)
+    return page->line_height;
+
+  size_t ret = 0;
 
-  return 0;
+  if (font->shared) {
+    say_mutex_lock(say_font_mutex);
+
+    FT_Face face = say_font_get_sized_face(font, size);
+    if (face)
+      ret = face->size->metrics.height >> 6;
+
+    say_mutex_unlock(say_font_mutex);
+  }
+
+  return ret;
 }
 
 say_image *say_font_get_image(say_font *font, size_t size) {
@@ -328,8 +880,515 @@ say_image *say_font_get_image(say_font *font, size_t size) {
   return page->image;
 }
 
+static void say_font_load_glyphs_with(say_font *font, uint32_t *codepoints,
+                                      size_t count, size_t size, uint8_t bold,
+                                      bool async) {
+  if (!font->shared || count == 0)
+    return;
+
+  /* Batches outlive fonts, they can only insert glyphs in shared pages */
+  if (font->pages != font->shared->pages)
+    async = false;
+
+  say_font_page *page = say_font_get_page(font, size);
+  uint32_t bold_flag  = (bold ? 1 : 0) << 31;
+
+  uint32_t *missing = malloc(sizeof(uint32_t) * count);
+  memcpy(missing, codepoints, sizeof(uint32_t) * count);
+  qsort(missing, count, sizeof(uint32_t), say_codepoint_cmp);
+
+  size_t missing_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint32_t c = missing[i];
+
+    if ((i != 0 && c == missing[i - 1]) ||
+        c == L'\n' || c == L'\t' || c == L'\v' ||
+        say_table_get(page->glyphs, bold_flag | c))
+      continue;
+
+    missing[missing_count++] = c;
+  }
+
+  if (missing_count < SAY_FONT_BATCH_THRESHOLD ||
+      (!async && say_font_get_worker_count() < 2)) {
+    for (size_t i = 0; i < missing_count; i++)
+      say_font_load_glyph(font, page, missing[i], bold, size);
+  }
+  else {
+    say_glyph_batch *batch = say_glyph_batch_start(font->shared, font->pages,
+                                                   missing, missing_count,
+                                                   size, bold);
+
+    if (async) {
+      for (size_t i = 0; i < missing_count; i++)
+        say_glyph_set_placeholder(page, missing[i], bold, size);
+
+      say_array_push(font->shared->batches, &batch);
+    }
+    else
+      say_glyph_batch_finish(batch, true);
+  }
+
+  free(missing);
+}
+
+void say_font_load_glyphs(say_font *font, uint32_t *codepoints, size_t count,
+                          size_t size, uint8_t bold) {
+  say_font_update(font);
+  say_font_load_glyphs_with(font, codepoints, count, size, bold,
+                            say_font_async);
+}
+
+void say_font_preload(say_font *font, uint32_t *codepoints, size_t count,
+                      size_t size, uint8_t bold) {
+  /* Placeholders must not be mistaken for loaded glyphs */
+  if (font->shared)
+    say_font_face_wait(font->shared, true);
+
+  say_font_load_glyphs_with(font, codepoints, count, size, bold, false);
+}
+
+void say_font_update(say_font *font) {
+  if (!font->shared || say_array_get_size(font->shared->batches) == 0)
+    return;
+
+  say_array *batches = font->shared->batches;
+
+  for (size_t i = 0; i < say_array_get_size(batches);) {
+    say_glyph_batch *batch = *(say_glyph_batch**)say_array_get(batches, i);
+
+    if (say_glyph_batch_is_done(batch)) {
+      say_glyph_batch_finish(batch, true);
+      say_array_delete(batches, i);
+    }
+    else
+      i++;
+  }
+}
+
+uint32_t say_font_get_generation(say_font *font) {
+  return font->shared ? font->shared->generation : 0;
+}
+
+void say_font_set_worker_count(size_t count) {
+  say_font_worker_count = count;
+}
+
+size_t say_font_get_worker_count() {
+  if (say_font_worker_count == 0)
+    return say_thread_get_cpu_count();
+
+  return say_font_worker_count;
+}
+
+void say_font_set_async_loading(bool val) {
+  say_font_async = val;
+}
+
+bool say_font_is_async_loading() {
+  return say_font_async;
+}
+
+void say_font_set_placeholders(bool val) {
+  say_font_placeholders = val;
+}
+
+bool say_font_has_placeholders() {
+  return say_font_placeholders;
+}
+
+/*
+ * Bitmap fonts are stored using a BMFont-like text format: a descriptor file
+ * lists every page (one per character size) with its glyph metrics and
+ * kerning pairs, and each page atlas is saved as a PNG file next to it.
+ *
+ *   info face="Arial" pages=1
+ *   page id=0 size=30 lineHeight=34 top=52 file="arial_30.png"
+ *   char id=65 page=0 bold=0 x=2 y=2 width=22 height=24 xoffset=-1 ...
+ *   kerning page=0 first=65 second=86 amount=-2
+ */
+
+static bool say_bitmap_font_get_int(const char *line, const char *key,
+                                    long *out) {
+  size_t len = strlen(key);
+
+  for (const char *it = strstr(line, key); it; it = strstr(it + 1, key)) {
+    if (it != line && it[-1] == ' ' && it[len] == '=') {
+      *out = strtol(it + len + 1, NULL, 10);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static bool say_bitmap_font_get_string(const char *line, const char *key,
+                                       char *out, size_t max_size) {
+  size_t len = strlen(key);
+
+  for (const char *it = strstr(line, key); it; it = strstr(it + 1, key)) {
+    if (it != line && it[-1] == ' ' && it[len] == '=' && it[len + 1] == '"') {
+      const char *start = it + len + 2;
+      const char *end   = strchr(start, '"');
+
+      if (!end || (size_t)(end - start) >= max_size)
+        return false;
+
+      memcpy(out, start, end - start);
+      out[end - start] = '\0';
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static const char *say_bitmap_font_basename(const char *file) {
+  const char *base = file;
+
+  for (const char *it = file; *it; it++) {
+    if (*it == '/' || *it == '\\')
+      base = it + 1;
+  }
+
+  return base;
+}
+
+/* Path to a file stored in the same directory as another one */
+static char *say_bitmap_font_sibling(const char *file, const char *name) {
+  size_t dir_len = say_bitmap_font_basename(file) - file;
+
+  char *ret = malloc(dir_len + strlen(name) + 1);
+  memcpy(ret, file, dir_len);
+  strcpy(ret + dir_len, name);
+
+  return ret;
+}
+
+typedef struct {
+  size_t size;
+  say_font_page *page;
+} say_bitmap_font_page;
+
+/*
+ * Pages are only added to the font once the whole file was read, so that a
+ * font is left unchanged when loading fails.
+ */
+static void say_font_commit_bitmap_pages(say_font *font, say_array *pages) {
+  /*
+   * Other fonts loaded from the same face must not see the pages of the
+   * bitmap font, so the font stops sharing the pages of its face.
+   */
+  if (font->shared && font->pages == font->shared->pages)
+    font->pages = say_table_create((say_destructor)say_page_free);
+
+  for (size_t i = 0; i < say_array_get_size(pages); i++) {
+    say_bitmap_font_page *entry = say_array_get(pages, i);
+
+    say_font_kerning *kernings = say_array_get(entry->page->kernings, 0);
+    size_t count = say_array_get_size(entry->page->kernings);
+    if (count != 0)
+      qsort(kernings, count, sizeof(say_font_kerning), say_kerning_cmp);
+
+    say_table_del(font->pages, entry->size);
+    say_table_set(font->pages, entry->size, entry->page);
+  }
+}
+
+int say_font_load_bitmap(say_font *font, const char *file) {
+  FILE *in = fopen(file, "r");
+  if (!in) {
+    say_error_set("could not open bitmap font");
+    return 0;
+  }
+
+  say_array *pages = say_array_create(sizeof(say_bitmap_font_page), NULL,
+                                      NULL);
+
+  char line[4096];
+  char page_file[2048];
+  int ret = 1;
+
+  while (fgets(line, sizeof(line), in)) {
+    long id = 0, page_id = 0;
+
+    if (strncmp(line, "page ", 5) == 0) {
+      long size = 0, line_height = 0, top = 0;
+
+      if (!say_bitmap_font_get_int(line, "id", &id) ||
+          !say_bitmap_font_get_int(line, "size", &size) ||
+          !say_bitmap_font_get_int(line, "lineHeight", &line_height) ||
+          !say_bitmap_font_get_int(line, "top", &top) ||
+          !say_bitmap_font_get_string(line, "file", page_file,
+                                      sizeof(page_file)) ||
+          (size_t)id != say_array_get_size(pages)) {
+        say_error_set("invalid page in bitmap font");
+        ret = 0;
+        break;
+      }
+
+      say_font_page *page = say_page_alloc();
+      page->current_height = top;
+      page->line_height    = line_height;
+      page->kernings       = say_array_create(sizeof(say_font_kerning),
+                                              NULL, NULL);
+
+      char *path = say_bitmap_font_sibling(file, page_file);
+      bool loaded = say_image_load_file(page->image, path);
+      free(path);
+
+      if (!loaded) {
+        say_page_free(page);
+
+        say_error_set("could not load bitmap font page");
+        ret = 0;
+        break;
+      }
+
+      say_bitmap_font_page entry = {size, page};
+      say_array_push(pages, &entry);
+    }
+    else if (strncmp(line, "char ", 5) == 0) {
+      long bold = 0, x = 0, y = 0, w = 0, h = 0;
+      long x_offset = 0, y_offset = 0, x_advance = 0;
+
+      if (!say_bitmap_font_get_int(line, "id", &id) ||
+          !say_bitmap_font_get_int(line, "page", &page_id) ||
+          !say_bitmap_font_get_int(line, "x", &x) ||
+          !say_bitmap_font_get_int(line, "y", &y) ||
+          !say_bitmap_font_get_int(line, "width", &w) ||
+          !say_bitmap_font_get_int(line, "height", &h) ||
+          !say_bitmap_font_get_int(line, "xoffset", &x_offset) ||
+          !say_bitmap_font_get_int(line, "yoffset", &y_offset) ||
+          !say_bitmap_font_get_int(line, "xadvance", &x_advance) ||
+          page_id < 0 || (size_t)page_id >= say_array_get_size(pages)) {
+        say_error_set("invalid character in bitmap font");
+        ret = 0;
+        break;
+      }
+
+      say_bitmap_font_get_int(line, "bold", &bold);
+
+      say_font_page *page =
+        ((say_bitmap_font_page*)say_array_get(pages, page_id))->page;
+      uint32_t bold_codepoint = ((bold ? 1 : 0) << 31) | (uint32_t)id;
+
+      say_glyph *glyph = malloc(sizeof(say_glyph));
+      glyph->offset   = x_advance;
+      glyph->bounds   = say_make_rect(x_offset, y_offset, w, h);
+      glyph->sub_rect = say_make_rect(x, y, w, h);
+
+      say_table_del(page->glyphs, bold_codepoint);
+      say_table_set(page->glyphs, bold_codepoint, glyph);
+    }
+    else if (strncmp(line, "kerning ", 8) == 0) {
+      long first = 0, second = 0, amount = 0;
+
+      if (!say_bitmap_font_get_int(line, "page", &page_id) ||
+          !say_bitmap_font_get_int(line, "first", &first) ||
+          !say_bitmap_font_get_int(line, "second", &second) ||
+          !say_bitmap_font_get_int(line, "amount", &amount) ||
+          page_id < 0 || (size_t)page_id >= say_array_get_size(pages)) {
+        say_error_set("invalid kerning pair in bitmap font");
+        ret = 0;
+        break;
+      }
+
+      say_font_page *page =
+        ((say_bitmap_font_page*)say_array_get(pages, page_id))->page;
+
+      say_font_kerning kerning = {first, second, amount};
+      say_array_push(page->kernings, &kerning);
+    }
+  }
+
+  if (ret)
+    say_font_commit_bitmap_pages(font, pages);
+  else {
+    for (size_t i = 0; i < say_array_get_size(pages); i++)
+      say_page_free(((say_bitmap_font_page*)say_array_get(pages, i))->page);
+  }
+
+  say_array_free(pages);
+  fclose(in);
+
+  return ret;
+}
+
+static void say_font_write_kernings(say_font *font, FILE *out,
+                                    say_font_page *page, size_t page_id,
+                                    size_t size) {
+  if (page->kernings) {
+    for (size_t i = 0; i < say_array_get_size(page->kernings); i++) {
+      say_font_kerning *kerning = say_array_get(page->kernings, i);
+      fprintf(out, "kerning page=%zu first=%u second=%u amount=%d\n",
+              page_id, kerning->first, kerning->second, kerning->amount);
+    }
+  }
+  else if (say_font_has_face_kerning(font)) {
+    say_table *glyphs = page->glyphs;
+
+    for (size_t i = 0; i < glyphs->size; i++) {
+      uint32_t first = glyphs->pairs[i].key;
+      if (!glyphs->pairs[i].value || (first >> 31))
+        continue;
+
+      for (size_t j = 0; j < glyphs->size; j++) {
+        uint32_t second = glyphs->pairs[j].key;
+        if (!glyphs->pairs[j].value || (second >> 31))
+          continue;
+
+        int amount = say_font_get_kerning(font, first, second, size);
+        if (amount != 0) {
+          fprintf(out, "kerning page=%zu first=%u second=%u amount=%d\n",
+                  page_id, first, second, amount);
+        }
+      }
+    }
+  }
+}
+
+int say_font_write_bitmap(say_font *font, const char *file) {
+  FILE *out = fopen(file, "w");
+  if (!out) {
+    say_error_set("could not open bitmap font for writing");
+    return 0;
+  }
+
+  /* Page files are named after the descriptor, without its extension */
+  const char *base = say_bitmap_font_basename(file);
+  const char *ext  = strrchr(base, '.');
+  size_t stem_len  = ext ? (size_t)(ext - base) : strlen(base);
+
+  size_t page_count = 0;
+  for (size_t i = 0; i < font->pages->size; i++) {
+    if (font->pages->pairs[i].value)
+      page_count++;
+  }
+
+  char face_name[256] = "";
+  if (font->shared) {
+    say_mutex_lock(say_font_mutex);
+
+    FT_Face face = say_font_face_lookup(font->shared);
+    if (face && face->family_name)
+      snprintf(face_name, sizeof(face_name), "%s", face->family_name);
+
+    say_mutex_unlock(say_font_mutex);
+  }
+
+  fprintf(out, "info face=\"%s\" pages=%zu\n", face_name, page_count);
+
+  size_t page_id = 0;
+  int ret = 1;
+
+  for (size_t i = 0; i < font->pages->size && ret; i++) {
+    say_font_page *page = font->pages->pairs[i].value;
+    if (!page)
+      continue;
+
+    size_t size = font->pages->pairs[i].key;
+
+    char page_file[2048];
+    snprintf(page_file, sizeof(page_file), "%.*s_%zu.png",
+             (int)stem_len, base, size);
+
+    char *path = say_bitmap_font_sibling(file, page_file);
+    ret = say_image_write_png(page->image, path);
+    free(path);
+
+    if (!ret)
+      break;
+
+    fprintf(out, "page id=%zu size=%zu lineHeight=%zu top=%zu file=\"%s\"\n",
+            page_id, size, say_font_get_line_height(font, size),
+            page->current_height, page_file);
+
+    for (size_t j = 0; j < page->glyphs->size; j++) {
+      say_glyph *glyph = page->glyphs->pairs[j].value;
+      if (!glyph)
+        continue;
+
+      uint32_t key = page->glyphs->pairs[j].key;
+
+      fprintf(out, "char id=%u page=%zu bold=%d x=%d y=%d width=%d height=%d "
+              "xoffset=%d yoffset=%d xadvance=%d\n",
+              key & ~(1u << 31), page_id, (int)(key >> 31),
+              (int)glyph->sub_rect.x, (int)glyph->sub_rect.y,
+              (int)glyph->sub_rect.w, (int)glyph->sub_rect.h,
+              (int)glyph->bounds.x, (int)glyph->bounds.y,
+              glyph->offset);
+    }
+
+    say_font_write_kernings(font, out, page, page_id, size);
+
+    page_id++;
+  }
+
+  fclose(out);
+  return ret;
+}
+
+void say_font_set_cache_size(size_t max_bytes) {
+  if (!say_font_library() || max_bytes == say_ft_cache_size)
+    return;
+
+  say_mutex_lock(say_font_mutex);
+
+  if (say_ft_manager) {
+    FTC_Manager_Done(say_ft_manager);
+    say_ft_manager = NULL;
+  }
+
+  if (max_bytes != 0) {
+    if (FTC_Manager_New(say_ft_library, 0, 0, max_bytes,
+                        say_font_face_requester, NULL, &say_ft_manager) != 0) {
+      say_ft_manager = NULL;
+      say_error_set("could not create font cache");
+    }
+    else {
+      /* Faces will be reopened through the cache when needed */
+      for (size_t i = 0; i < say_array_get_size(say_font_faces); i++) {
+        say_font_face *shared =
+          *(say_font_face**)say_array_get(say_font_faces, i);
+
+        if (shared->face) {
+          FT_Done_Face(shared->face);
+          shared->face = NULL;
+        }
+      }
+    }
+  }
+
+  say_ft_cache_size = say_ft_manager ? max_bytes : 0;
+
+  say_mutex_unlock(say_font_mutex);
+}
+
+size_t say_font_get_cache_size() {
+  return say_ft_cache_size;
+}
+
 void say_font_clean_up() {
   if (say_default_font)
     say_font_free(say_default_font);
   say_default_font = NULL;
+
+  /* Fonts may still be alive; the library is only released once unused. */
+  if (say_ft_library && say_array_get_size(say_font_faces) == 0) {
+    if (say_ft_manager)
+      FTC_Manager_Done(say_ft_manager);
+    say_ft_manager    = NULL;
+    say_ft_cache_size = 0;
+
+    FT_Done_FreeType(say_ft_library);
+    say_ft_library = NULL;
+
+    say_array_free(say_font_faces);
+    say_font_faces = NULL;
+
+    say_mutex_free(say_font_mutex);
+    say_font_mutex = NULL;
+  }
 }
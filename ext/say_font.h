@@ -15,6 +15,11 @@ typedef struct {
   size_t current_width, height, y;
 } say_font_row;
 
+typedef struct {
+  uint32_t first, second;
+  int amount;
+} say_font_kerning;
+
 typedef struct {
   say_table *glyphs;
   say_array *rows;
@@ -22,12 +27,46 @@ typedef struct {
   say_image *image;
 
   size_t current_height;
+
+  /* Only set for pages loaded from a bitmap font */
+  size_t line_height;
+  say_array *kernings;
+
+  /* 2x2 opaque pixels drawn by placeholders, empty until reserved */
+  say_rect opaque;
 } say_font_page;
 
+struct say_glyph_batch;
+
+/*
+ * Faces are shared by every font loaded from the same file (or the same data),
+ * along with their glyph pages.
+ */
 typedef struct {
-  FT_Library library;
-  FT_Face face;
+  char *filename;
 
+  void *buffer;
+  size_t buffer_size;
+  uint64_t hash;
+  bool owns_buffer;
+
+  FT_Face face; /* NULL when faces are managed by the cache */
+  say_table *pages;
+
+  /* Glyphs being rasterized in the background */
+  say_array *batches;
+  uint32_t generation;
+
+  size_t ref_count;
+} say_font_face;
+
+typedef struct {
+  say_font_face *shared;
+
+  /*
+   * Pages of the shared face, or owned by the font when it has no face or
+   * when bitmap pages were loaded into it.
+   */
   say_table *pages;
 } say_font;
 
@@ -39,13 +78,36 @@ say_font *say_font_default();
 int say_font_load_from_file(say_font *font, const char *file);
 int say_font_load_from_memory(say_font *font, void *buf, size_t size);
 
+int say_font_load_bitmap(say_font *font, const char *file);
+int say_font_write_bitmap(say_font *font, const char *file);
+
+void say_font_preload(say_font *font, uint32_t *codepoints, size_t count,
+                      size_t size, uint8_t bold);
+
+void say_font_load_glyphs(say_font *font, uint32_t *codepoints, size_t count,
+                          size_t size, uint8_t bold);
+void say_font_update(say_font *font);
+uint32_t say_font_get_generation(say_font *font);
+
 say_glyph *say_font_get_glyph(say_font *font, uint32_t codepoint, size_t size,
                               uint8_t bold);
-size_t say_font_get_kerning(say_font *font, uint32_t first, uint32_t second,
-                            size_t size);
+int say_font_get_kerning(say_font *font, uint32_t first, uint32_t second,
+                         size_t size);
 size_t say_font_get_line_height(say_font *font, size_t size);
 say_image *say_font_get_image(say_font *font, size_t size);
 
+void say_font_set_worker_count(size_t count);
+size_t say_font_get_worker_count();
+
+void say_font_set_async_loading(bool val);
+bool say_font_is_async_loading();
+
+void say_font_set_placeholders(bool val);
+bool say_font_has_placeholders();
+
+void say_font_set_cache_size(size_t max_bytes);
+size_t say_font_get_cache_size();
+
 void say_font_clean_up();
 
 #endif
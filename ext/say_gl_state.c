@@ -0,0 +1,399 @@
+#include "say.h"
+
+/* Every live state, so deleted objects can be forgotten by all of them */
+static say_array *say_gl_states      = NULL;
+static say_mutex *say_gl_states_lock = NULL;
+
+static size_t say_gl_bind_count           = 0;
+static size_t say_gl_redundant_bind_count = 0;
+
+/*
+ * Contexts, and so their states, can be created from any thread: the list of
+ * states and its lock are created beforehand, from say_init.
+ */
+void say_gl_state_global_init() {
+  if (say_gl_states)
+    return;
+
+  say_gl_states      = say_array_create(sizeof(say_gl_state*), NULL, NULL);
+  say_gl_states_lock = say_mutex_create();
+}
+
+void say_gl_state_init(say_gl_state *state) {
+  /* Initial values as defined by OpenGL */
+  state->vbo     = state->ibo = state->vao = 0;
+  state->texture = state->program = 0;
+  state->fbo     = state->rbo = 0;
+  state->ubo     = 0;
+
+  for (size_t i = 0; i < SAY_GL_STATE_MAX_UBO_BINDINGS; i++) {
+    state->ubo_ranges[i].buffer = 0;
+    state->ubo_ranges[i].offset = 0;
+    state->ubo_ranges[i].size   = 0;
+  }
+
+  state->buffer  = NULL;
+  state->attribs = 0;
+
+  state->active_texture = GL_TEXTURE0;
+
+  state->blend      = false;
+  state->depth_test = false;
+  state->blend_src  = GL_ONE;
+  state->blend_dst  = GL_ZERO;
+  state->depth_func = GL_LESS;
+
+  say_mutex_lock(say_gl_states_lock);
+  say_array_push(say_gl_states, &state);
+  say_mutex_unlock(say_gl_states_lock);
+}
+
+void say_gl_state_release(say_gl_state *state) {
+  say_mutex_lock(say_gl_states_lock);
+
+  size_t count = say_array_get_size(say_gl_states);
+  for (size_t i = 0; i < count; i++) {
+    say_gl_state **it = say_array_get(say_gl_states, i);
+
+    if (*it == state) {
+      *it = *(say_gl_state**)say_array_get(say_gl_states, count - 1);
+      say_array_resize(say_gl_states, count - 1);
+      break;
+    }
+  }
+
+  say_mutex_unlock(say_gl_states_lock);
+}
+
+say_gl_state *say_gl_state_current() {
+  say_context_ensure();
+  return &say_context_current()->gl;
+}
+
+/*
+ * Stores val in *field, returning true if OpenGL needs to be called because it
+ * was different.
+ */
+static bool say_gl_state_change(GLuint *field, GLuint val) {
+  if (*field == val) {
+    say_gl_redundant_bind_count++;
+    return false;
+  }
+
+  *field = val;
+  say_gl_bind_count++;
+
+  return true;
+}
+
+void say_gl_state_bind_vbo(say_gl_state *state, GLuint vbo) {
+  if (say_gl_state_change(&state->vbo, vbo))
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, vbo);
+}
+
+void say_gl_bind_vbo(GLuint vbo) {
+  say_gl_state_bind_vbo(say_gl_state_current(), vbo);
+}
+
+void say_gl_state_bind_ibo(say_gl_state *state, GLuint ibo) {
+  if (say_gl_state_change(&state->ibo, ibo))
+    glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, ibo);
+}
+
+void say_gl_bind_ibo(GLuint ibo) {
+  say_gl_state_bind_ibo(say_gl_state_current(), ibo);
+}
+
+void say_gl_state_bind_vao(say_gl_state *state, GLuint vao) {
+  if (say_gl_state_change(&state->vao, vao)) {
+    glBindVertexArray(vao);
+
+    /* The element array binding is part of the state of the VAO */
+    state->ibo = SAY_GL_STATE_UNKNOWN;
+  }
+}
+
+void say_gl_bind_vao(GLuint vao) {
+  say_gl_state_bind_vao(say_gl_state_current(), vao);
+}
+
+void say_gl_state_bind_texture(say_gl_state *state, GLuint texture) {
+  if (say_gl_state_change(&state->texture, texture))
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void say_gl_bind_texture(GLuint texture) {
+  say_gl_state_bind_texture(say_gl_state_current(), texture);
+}
+
+void say_gl_state_use_program(say_gl_state *state, GLuint program) {
+  if (say_gl_state_change(&state->program, program))
+    glUseProgramObjectARB(program);
+}
+
+void say_gl_use_program(GLuint program) {
+  say_gl_state_use_program(say_gl_state_current(), program);
+}
+
+void say_gl_state_bind_ubo(say_gl_state *state, GLuint ubo) {
+  if (say_gl_state_change(&state->ubo, ubo))
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+}
+
+void say_gl_state_bind_ubo_range(say_gl_state *state, GLuint index,
+                                 GLuint ubo, size_t offset, size_t size) {
+  say_gl_buffer_range *range = &state->ubo_ranges[index];
+
+  if (range->buffer == ubo && range->offset == offset && range->size == size) {
+    say_gl_redundant_bind_count++;
+    return;
+  }
+
+  range->buffer = ubo;
+  range->offset = offset;
+  range->size   = size;
+  say_gl_bind_count++;
+
+  glBindBufferRange(GL_UNIFORM_BUFFER, index, ubo, offset, size);
+
+  /* Also binds the buffer to the generic binding point */
+  state->ubo = ubo;
+}
+
+void say_gl_bind_fbo(GLuint fbo) {
+  if (say_gl_state_change(&say_gl_state_current()->fbo, fbo))
+    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, fbo);
+}
+
+void say_gl_bind_rbo(GLuint rbo) {
+  if (say_gl_state_change(&say_gl_state_current()->rbo, rbo))
+    glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, rbo);
+}
+
+bool say_gl_state_set_buffer(say_gl_state *state, void *buf) {
+  if (state->buffer == buf) {
+    say_gl_redundant_bind_count++;
+    return false;
+  }
+
+  state->buffer = buf;
+  say_gl_bind_count++;
+
+  return true;
+}
+
+bool say_gl_set_buffer(void *buf) {
+  return say_gl_state_set_buffer(say_gl_state_current(), buf);
+}
+
+void say_gl_state_set_attribs(say_gl_state *state, uint32_t attribs) {
+  uint32_t changed = state->attribs ^ attribs;
+  if (!changed) {
+    say_gl_redundant_bind_count++;
+    return;
+  }
+
+  for (size_t i = 0; i < SAY_GL_STATE_MAX_ATTRIBS; i++) {
+    if (!(changed & (1u << i)))
+      continue;
+
+    if (attribs & (1u << i))
+      glEnableVertexAttribArrayARB(i);
+    else
+      glDisableVertexAttribArrayARB(i);
+
+    say_gl_bind_count++;
+  }
+
+  state->attribs = attribs;
+}
+
+void say_gl_set_attribs(uint32_t attribs) {
+  say_gl_state_set_attribs(say_gl_state_current(), attribs);
+}
+
+void say_gl_set_active_texture(GLenum unit) {
+  if (say_gl_state_change(&say_gl_state_current()->active_texture, unit))
+    glActiveTextureARB(unit);
+}
+
+void say_gl_set_blend(bool enabled) {
+  say_gl_state *state = say_gl_state_current();
+
+  if (state->blend == enabled) {
+    say_gl_redundant_bind_count++;
+    return;
+  }
+
+  state->blend = enabled;
+  say_gl_bind_count++;
+
+  if (enabled)
+    glEnable(GL_BLEND);
+  else
+    glDisable(GL_BLEND);
+}
+
+void say_gl_set_blend_func(GLenum src, GLenum dst) {
+  say_gl_state *state = say_gl_state_current();
+
+  if (state->blend_src == src && state->blend_dst == dst) {
+    say_gl_redundant_bind_count++;
+    return;
+  }
+
+  state->blend_src = src;
+  state->blend_dst = dst;
+  say_gl_bind_count++;
+
+  glBlendFunc(src, dst);
+}
+
+void say_gl_set_depth_test(bool enabled) {
+  say_gl_state *state = say_gl_state_current();
+
+  if (state->depth_test == enabled) {
+    say_gl_redundant_bind_count++;
+    return;
+  }
+
+  state->depth_test = enabled;
+  say_gl_bind_count++;
+
+  if (enabled)
+    glEnable(GL_DEPTH_TEST);
+  else
+    glDisable(GL_DEPTH_TEST);
+}
+
+void say_gl_set_depth_func(GLenum func) {
+  if (say_gl_state_change(&say_gl_state_current()->depth_func, func))
+    glDepthFunc(func);
+}
+
+/*
+ * Calls forget on every live state. Deleting an object only unbinds it in the
+ * current context: other contexts still have it bound, and must not skip
+ * binding 0 or a new object that reuses its name.
+ */
+static void say_gl_forget_all(void (*forget)(say_gl_state *state, void *obj,
+                                             GLuint reset),
+                              void *obj) {
+  if (!say_gl_states)
+    return;
+
+  say_context *context = say_context_current();
+  say_gl_state *current = context ? &context->gl : NULL;
+
+  say_mutex_lock(say_gl_states_lock);
+
+  for (size_t i = 0; i < say_array_get_size(say_gl_states); i++) {
+    say_gl_state *state = *(say_gl_state**)say_array_get(say_gl_states, i);
+    forget(state, obj, state == current ? 0 : SAY_GL_STATE_UNKNOWN);
+  }
+
+  say_mutex_unlock(say_gl_states_lock);
+}
+
+static void say_gl_state_forget_vbo(say_gl_state *state, void *obj,
+                                    GLuint reset) {
+  if (state->vbo == *(GLuint*)obj)
+    state->vbo = reset;
+}
+
+static void say_gl_state_forget_ibo(say_gl_state *state, void *obj,
+                                    GLuint reset) {
+  if (state->ibo == *(GLuint*)obj)
+    state->ibo = reset;
+}
+
+static void say_gl_state_forget_texture(say_gl_state *state, void *obj,
+                                        GLuint reset) {
+  if (state->texture == *(GLuint*)obj)
+    state->texture = reset;
+}
+
+static void say_gl_state_forget_program(say_gl_state *state, void *obj,
+                                        GLuint reset) {
+  if (state->program == *(GLuint*)obj)
+    state->program = reset;
+}
+
+static void say_gl_state_forget_rbo(say_gl_state *state, void *obj,
+                                    GLuint reset) {
+  if (state->rbo == *(GLuint*)obj)
+    state->rbo = reset;
+}
+
+static void say_gl_state_forget_ubo(say_gl_state *state, void *obj,
+                                    GLuint reset) {
+  GLuint ubo = *(GLuint*)obj;
+
+  if (state->ubo == ubo)
+    state->ubo = reset;
+
+  for (size_t i = 0; i < SAY_GL_STATE_MAX_UBO_BINDINGS; i++) {
+    if (state->ubo_ranges[i].buffer == ubo)
+      state->ubo_ranges[i].buffer = reset;
+  }
+}
+
+/* NULL is never the buffer being set up, so it works for every context */
+static void say_gl_state_forget_buffer(say_gl_state *state, void *obj,
+                                       GLuint reset) {
+  if (state->buffer == obj)
+    state->buffer = NULL;
+}
+
+void say_gl_forget_vbo(GLuint vbo) {
+  say_gl_forget_all(say_gl_state_forget_vbo, &vbo);
+}
+
+void say_gl_forget_ibo(GLuint ibo) {
+  say_gl_forget_all(say_gl_state_forget_ibo, &ibo);
+}
+
+void say_gl_forget_vao(GLuint vao) {
+  say_gl_state *state = say_gl_state_current();
+  if (state->vao == vao)
+    state->vao = 0;
+}
+
+void say_gl_forget_texture(GLuint texture) {
+  say_gl_forget_all(say_gl_state_forget_texture, &texture);
+}
+
+void say_gl_forget_program(GLuint program) {
+  say_gl_forget_all(say_gl_state_forget_program, &program);
+}
+
+void say_gl_forget_fbo(GLuint fbo) {
+  say_gl_state *state = say_gl_state_current();
+  if (state->fbo == fbo)
+    state->fbo = 0;
+}
+
+void say_gl_forget_rbo(GLuint rbo) {
+  say_gl_forget_all(say_gl_state_forget_rbo, &rbo);
+}
+
+void say_gl_forget_ubo(GLuint ubo) {
+  say_gl_forget_all(say_gl_state_forget_ubo, &ubo);
+}
+
+void say_gl_forget_buffer(void *buf) {
+  say_gl_forget_all(say_gl_state_forget_buffer, buf);
+}
+
+size_t say_gl_get_bind_count() {
+  return say_gl_bind_count;
+}
+
+size_t say_gl_get_redundant_bind_count() {
+  return say_gl_redundant_bind_count;
+}
+
+void say_gl_reset_bind_counts() {
+  say_gl_bind_count           = 0;
+  say_gl_redundant_bind_count = 0;
+}
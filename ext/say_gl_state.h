@@ -0,0 +1,110 @@
+#ifndef SAY_GL_STATE_H_
+#define SAY_GL_STATE_H_
+
+#include "say_basic_type.h"
+
+/* Value of a binding that must be set again before being relied upon */
+#define SAY_GL_STATE_UNKNOWN ((GLuint)-1)
+
+/* Amount of vertex attribs whose state is tracked */
+#define SAY_GL_STATE_MAX_ATTRIBS 32
+
+/* Amount of indexed uniform buffer bindings whose state is tracked */
+#define SAY_GL_STATE_MAX_UBO_BINDINGS 2
+
+typedef struct {
+  GLuint buffer;
+  size_t offset, size;
+} say_gl_buffer_range;
+
+/*
+ * OpenGL state of a context, as last set by say. Binding an object that is
+ * already bound, or setting a state to its current value, doesn't call OpenGL.
+ */
+typedef struct {
+  GLuint vbo, ibo, vao;
+  GLuint texture, program;
+  GLuint fbo, rbo;
+
+  GLuint ubo;
+  say_gl_buffer_range ubo_ranges[SAY_GL_STATE_MAX_UBO_BINDINGS];
+
+  /* Buffer whose vertex pointers are set, when VAOs aren't available */
+  void *buffer;
+
+  /* Enabled vertex attribs, when VAOs aren't available */
+  uint32_t attribs;
+
+  GLenum active_texture;
+
+  bool blend, depth_test;
+  GLenum blend_src, blend_dst;
+  GLenum depth_func;
+} say_gl_state;
+
+void say_gl_state_global_init();
+void say_gl_state_init(say_gl_state *state);
+
+/* Must be called once the context of the state doesn't exist anymore */
+void say_gl_state_release(say_gl_state *state);
+
+say_gl_state *say_gl_state_current();
+
+/*
+ * Functions taking a state can be used when it was already looked up, e.g.
+ * through a say_render_ctx. The others use the state of the current context.
+ */
+void say_gl_state_bind_vbo(say_gl_state *state, GLuint vbo);
+void say_gl_state_bind_ibo(say_gl_state *state, GLuint ibo);
+void say_gl_state_bind_vao(say_gl_state *state, GLuint vao);
+void say_gl_state_bind_texture(say_gl_state *state, GLuint texture);
+void say_gl_state_use_program(say_gl_state *state, GLuint program);
+void say_gl_state_bind_ubo(say_gl_state *state, GLuint ubo);
+void say_gl_state_bind_ubo_range(say_gl_state *state, GLuint index,
+                                 GLuint ubo, size_t offset, size_t size);
+bool say_gl_state_set_buffer(say_gl_state *state, void *buf);
+void say_gl_state_set_attribs(say_gl_state *state, uint32_t attribs);
+
+void say_gl_bind_vbo(GLuint vbo);
+void say_gl_bind_ibo(GLuint ibo);
+void say_gl_bind_vao(GLuint vao);
+void say_gl_bind_texture(GLuint texture);
+void say_gl_use_program(GLuint program);
+void say_gl_bind_fbo(GLuint fbo);
+void say_gl_bind_rbo(GLuint rbo);
+
+/*
+ * Returns true if buf was not the buffer whose pointers are set, in which case
+ * the caller has to set them.
+ */
+bool say_gl_set_buffer(void *buf);
+
+void say_gl_set_attribs(uint32_t attribs);
+void say_gl_set_active_texture(GLenum unit);
+
+void say_gl_set_blend(bool enabled);
+void say_gl_set_blend_func(GLenum src, GLenum dst);
+void say_gl_set_depth_test(bool enabled);
+void say_gl_set_depth_func(GLenum func);
+
+/*
+ * Objects shared between contexts are forgotten by every state, so that a new
+ * object using the same name is bound again. VAOs and FBOs only exist in the
+ * current context.
+ */
+void say_gl_forget_vbo(GLuint vbo);
+void say_gl_forget_ibo(GLuint ibo);
+void say_gl_forget_vao(GLuint vao);
+void say_gl_forget_texture(GLuint texture);
+void say_gl_forget_program(GLuint program);
+void say_gl_forget_fbo(GLuint fbo);
+void say_gl_forget_rbo(GLuint rbo);
+void say_gl_forget_ubo(GLuint ubo);
+void say_gl_forget_buffer(void *buf);
+
+/* Amount of OpenGL calls issued and skipped through the state tracker */
+size_t say_gl_get_bind_count();
+size_t say_gl_get_redundant_bind_count();
+void say_gl_reset_bind_counts();
+
+#endif
@@ -1,59 +1,173 @@
 #include "say.h"
 
+#include <sys/stat.h>
+
 #include "stb_image.h"
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION 1
 #include "stb_image_write.h"
 
-static GLuint say_current_texture = 0;
-static say_context *say_texture_last_context = NULL;
+/*
+ * Adding a separate dirty rect is only worth it if growing an existing one
+ * would upload more than this many pixels that didn't change.
+ */
+#define SAY_IMAGE_DIRTY_SLACK 256
+
+static bool say_image_default_keep_pixels = true;
 
-static void say_texture_make_current(GLuint texture) {
-  say_context *context = say_context_current();
+static size_t say_image_frame_bytes = 0;
+static size_t say_image_last_frame_bytes = 0;
+static size_t say_image_total_bytes = 0;
 
-  if (texture != say_current_texture ||
-      context != say_texture_last_context) {
-    say_texture_last_context = context;
-    say_current_texture = texture;
+static void say_image_count_upload(size_t bytes) {
+  say_image_frame_bytes += bytes;
+  say_image_total_bytes += bytes;
+}
+
+static size_t say_dirty_rect_area(say_image_dirty_rect *rect) {
+  return (rect->x1 - rect->x0) * (rect->y1 - rect->y0);
+}
+
+static say_image_dirty_rect say_dirty_rect_union(say_image_dirty_rect *a,
+                                                 say_image_dirty_rect *b) {
+  say_image_dirty_rect ret;
+
+  ret.x0 = a->x0 < b->x0 ? a->x0 : b->x0;
+  ret.y0 = a->y0 < b->y0 ? a->y0 : b->y0;
+  ret.x1 = a->x1 > b->x1 ? a->x1 : b->x1;
+  ret.y1 = a->y1 > b->y1 ? a->y1 : b->y1;
+
+  return ret;
+}
+
+static void say_image_add_dirty_rect(say_image *img,
+                                     say_image_dirty_rect rect) {
+  img->texture_updated = 0;
+
+  size_t best      = 0;
+  size_t best_cost = SIZE_MAX;
+
+  for (size_t i = 0; i < img->dirty_count; i++) {
+    say_image_dirty_rect merged = say_dirty_rect_union(&img->dirty[i], &rect);
+    size_t cost = say_dirty_rect_area(&merged) -
+      say_dirty_rect_area(&img->dirty[i]);
+
+    if (cost == 0) /* Already dirty */
+      return;
+
+    if (cost < best_cost) {
+      best      = i;
+      best_cost = cost;
+    }
+  }
 
-    glBindTexture(GL_TEXTURE_2D, texture);
+  if (img->dirty_count == 0 ||
+      (img->dirty_count < SAY_IMAGE_MAX_DIRTY_RECTS &&
+       best_cost > say_dirty_rect_area(&rect) + SAY_IMAGE_DIRTY_SLACK)) {
+    img->dirty[img->dirty_count++] = rect;
   }
+  else
+    img->dirty[best] = say_dirty_rect_union(&img->dirty[best], &rect);
 }
 
-static void say_texture_will_delete(GLuint texture) {
-  if (say_current_texture == texture)
-    say_current_texture = 0;
+/* Expects the texture to be bound */
+static void say_image_upload_compressed(say_image *img) {
+  size_t size = say_image_format_get_size(img->format, img->width,
+                                          img->height);
+
+  glCompressedTexImage2D(GL_TEXTURE_2D, 0,
+                         say_image_format_get_gl_format(img->format),
+                         img->width, img->height, 0, size, img->compressed);
+  say_image_count_upload(size);
+
+  free(img->compressed);
+  img->compressed = NULL;
 }
 
-say_image *say_image_create() {
+/*
+ * The texture is only created when the image is first used by OpenGL, so that
+ * images can be created and processed without any context (e.g. by tools, or
+ * by loader threads).
+ */
+static void say_image_ensure_texture(say_image *img) {
+  if (img->texture)
+    return;
+
   say_context_ensure();
 
+  glGenTextures(1, &(img->texture));
+  say_gl_bind_texture(img->texture);
+
+  GLenum interp = img->smooth ? GL_LINEAR : GL_NEAREST;
+
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, interp);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, interp);
+
+  if (img->width == 0 || img->height == 0)
+    return;
+
+  /* Everything is uploaded at once, there's no need for dirty rects */
+  if (img->compressed)
+    say_image_upload_compressed(img);
+  else {
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, img->width, img->height, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, img->pixels);
+
+    if (img->pixels)
+      say_image_count_upload(sizeof(say_color) * img->width * img->height);
+  }
+
+  img->dirty_count     = 0;
+  img->texture_updated = 1;
+
+  if (!img->keep_pixels)
+    say_image_discard_pixels(img);
+}
+
+say_image *say_image_create() {
   say_image *img = (say_image*)malloc(sizeof(say_image));
 
   img->texture = 0;
-  glGenTextures(1, &(img->texture));
 
   img->pixels          = NULL;
   img->texture_updated = 1;
+  img->dirty_count     = 0;
+
+  img->pixels_outdated = 0;
+  img->pack_buffer     = 0;
+  img->pack_fence      = NULL;
+  img->keep_pixels     = say_image_default_keep_pixels;
 
   img->width  = 0;
   img->height = 0;
 
-  img->smooth = 1;
-  say_image_set_smooth(img, 0);
+  img->smooth = 0;
+
+  img->format     = SAY_IMAGE_RGBA8;
+  img->compressed = NULL;
 
   return img;
 }
 
 void say_image_free(say_image *img) {
-  say_context_ensure();
+  if (img->texture) {
+    say_context_ensure();
+
+    say_gl_forget_texture(img->texture);
+    glDeleteTextures(1, &(img->texture));
 
-  say_texture_will_delete(img->texture);
-  glDeleteTextures(1, &(img->texture));
+    if (img->pack_fence)
+      glDeleteSync(img->pack_fence);
+    if (img->pack_buffer)
+      glDeleteBuffers(1, &img->pack_buffer);
+  }
 
   if (img->pixels)
     free(img->pixels);
 
+  if (img->compressed)
+    free(img->compressed);
+
   free(img);
 }
 
@@ -66,6 +180,69 @@ bool say_image_load_raw(say_image *img, size_t width, size_t height,
   return true;
 }
 
+/*
+ * Makes the image use a buffer allocated with malloc as its pixel store.
+ * Decoded images don't need to be copied around, and are uploaded in a single
+ * call (right away if the texture exists, when it is created otherwise).
+ */
+static void say_image_drop_compression(say_image *img) {
+  img->format = SAY_IMAGE_RGBA8;
+
+  if (img->compressed) {
+    free(img->compressed);
+    img->compressed = NULL;
+  }
+}
+
+static bool say_image_adopt_pixels(say_image *img, size_t w, size_t h,
+                                   say_color *pixels) {
+  if (w == 0 || h == 0) {
+    free(pixels);
+    say_error_set("can't create empty image");
+    return false;
+  }
+
+  if (img->texture) {
+    say_context_ensure();
+    say_gl_bind_texture(img->texture);
+
+    glGetError(); /* Ignore potential previous errors */
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    if (glGetError()) {
+      free(pixels);
+      say_error_set("could not create texture");
+      return false;
+    }
+
+    say_image_count_upload(sizeof(say_color) * w * h);
+
+    if (img->pack_fence) {
+      glDeleteSync(img->pack_fence);
+      img->pack_fence = NULL;
+    }
+  }
+
+  if (img->pixels) free(img->pixels);
+  img->pixels = pixels;
+
+  img->width  = w;
+  img->height = h;
+
+  say_image_drop_compression(img);
+
+  img->pixels_outdated = 0;
+
+  img->dirty_count     = 0;
+  img->texture_updated = 1;
+
+  if (img->texture && !img->keep_pixels)
+    say_image_discard_pixels(img);
+
+  return true;
+}
+
 bool say_image_load_file(say_image *img, const char *filename) {
   int width, height, comp = 4;
 
@@ -73,11 +250,8 @@ bool say_image_load_file(say_image *img, const char *filename) {
   if (!buf)
     return false;
 
-  if (!say_image_load_raw(img, width, height, (say_color*)buf))
-    return false;
-  stbi_image_free(buf);
-
-  return true;
+  /* stbi_image_free is just free */
+  return say_image_adopt_pixels(img, width, height, (say_color*)buf);
 }
 
 bool say_image_load_from_memory(say_image *img, size_t size,
@@ -89,11 +263,7 @@ bool say_image_load_from_memory(say_image *img, size_t size,
   if (!buf)
     return false;
 
-  if (!say_image_load_raw(img, width, height, (say_color*)buf))
-    return false;
-  stbi_image_free(buf);
-
-  return true;
+  return say_image_adopt_pixels(img, width, height, (say_color*)buf);
 }
 
 bool say_image_create_with_size(say_image *img, size_t w, size_t h) {
@@ -102,25 +272,40 @@ bool say_image_create_with_size(say_image *img, size_t w, size_t h) {
     return false;
   }
 
-  if (img->width != w || img->height != h) {
+  /* Compressed textures can't be partially updated */
+  bool was_compressed = img->format != SAY_IMAGE_RGBA8;
+  say_image_drop_compression(img);
+
+  if (img->width != w || img->height != h || !img->pixels || was_compressed) {
     if (img->pixels) free(img->pixels);
     img->pixels = malloc(sizeof(say_color) * w * h);
 
-    say_texture_make_current(img->texture);
-    glGetError(); /* Ignore potential previous errors */
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0,
-                 GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    if (img->texture) {
+      say_context_ensure();
+      say_gl_bind_texture(img->texture);
 
-    if (glGetError()) {
-      say_error_set("could not create texture");
-      return false;
+      glGetError(); /* Ignore potential previous errors */
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0,
+                   GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+      if (glGetError()) {
+        say_error_set("could not create texture");
+        return false;
+      }
     }
   }
 
   img->width  = w;
   img->height = h;
 
-  img->texture_updated = 0;
+  img->pixels_outdated = 0;
+  if (img->pack_fence) {
+    glDeleteSync(img->pack_fence);
+    img->pack_fence = NULL;
+  }
+
+  img->dirty_count = 0;
+  say_image_mark_dirty(img, 0, 0, w, h);
 
   return true;
 }
@@ -138,6 +323,8 @@ bool say_image_write_bmp(say_image *img, const char *filename) {
   if (!say_image_assert_non_empty(img))
     return false;
 
+  say_image_fetch_pixels(img);
+
   stbi_write_bmp(filename, img->width, img->height, 4, img->pixels);
 
   return true;
@@ -147,6 +334,8 @@ bool say_image_write_png(say_image *img, const char *filename) {
   if (!say_image_assert_non_empty(img))
     return false;
 
+  say_image_fetch_pixels(img);
+
   stbi_write_png(filename, img->width, img->height, 4, img->pixels, 0);
 
   return true;
@@ -156,6 +345,8 @@ bool say_image_write_tga(say_image *img, const char *filename) {
   if (!say_image_assert_non_empty(img))
     return false;
 
+  say_image_fetch_pixels(img);
+
   stbi_write_tga(filename, img->width, img->height, 4, img->pixels);
 
   return true;
@@ -194,6 +385,8 @@ say_vector2 say_image_get_size(say_image *img) {
 bool say_image_resize(say_image *img, size_t w, size_t h) {
   size_t old_w = img->width, old_h = img->height;
 
+  say_image_fetch_pixels(img);
+
   say_color *cpy = malloc(sizeof(say_color) * img->width * img->height);
   memcpy(cpy, img->pixels, sizeof(say_color) * img->width * img->height);
 
@@ -226,8 +419,12 @@ void say_image_set_smooth(say_image *img, uint8_t val) {
   if (img->smooth != val) {
     img->smooth = val;
 
+    /* Applied when the texture is created */
+    if (!img->texture)
+      return;
+
     say_context_ensure();
-    say_texture_make_current(img->texture);
+    say_gl_bind_texture(img->texture);
 
     GLenum interp = val ? GL_LINEAR : GL_NEAREST;
 
@@ -245,39 +442,449 @@ say_rect say_image_get_tex_rect(say_image *img, say_rect rect) {
 }
 
 say_color *say_image_get_buffer(say_image *img) {
+  say_image_fetch_pixels(img);
   return img->pixels;
 }
 
 say_color say_image_get(say_image *img, size_t x, size_t y) {
+  say_image_fetch_pixels(img);
   return img->pixels[y * img->width + x];
 }
 
 void say_image_set(say_image *img, size_t x, size_t y, say_color color) {
+  say_image_fetch_pixels(img);
   img->pixels[y * img->width + x] = color;
-  img->texture_updated = 0;
+  say_image_mark_dirty(img, x, y, 1, 1);
+}
+
+void say_image_mark_dirty(say_image *img, size_t x, size_t y,
+                          size_t w, size_t h) {
+  if (w == 0 || h == 0)
+    return;
+
+  /* Modified pixels are uploaded with the rest of the uncompressed image */
+  if (img->format != SAY_IMAGE_RGBA8) {
+    say_image_compress(img, SAY_IMAGE_RGBA8);
+    return;
+  }
+
+  say_image_dirty_rect rect = {x, y, x + w, y + h};
+  say_image_add_dirty_rect(img, rect);
+}
+
+GLuint say_image_get_texture(say_image *img) {
+  say_image_ensure_texture(img);
+  return img->texture;
 }
 
 void say_image_bind(say_image *img) {
+  /* The software rasterizer reads pixels, no texture is needed */
+  say_raster *raster = say_raster_current();
+  if (raster) {
+    say_raster_bind_texture(raster, img);
+    return;
+  }
+
   say_context_ensure();
-  say_texture_make_current(img->texture);
+  say_image_ensure_texture(img);
+  say_gl_bind_texture(img->texture);
 
   if (!img->texture_updated)
     say_image_update_texture(img);
 }
 
 void say_image_update_texture(say_image *img) {
+  if (!img->texture) {
+    say_image_ensure_texture(img);
+    return;
+  }
+
+  if (!img->pixels || img->format != SAY_IMAGE_RGBA8)
+    return;
+
+  /* Explicit updates upload the whole image */
+  if (img->dirty_count == 0) {
+    img->dirty[0].x0 = img->dirty[0].y0 = 0;
+    img->dirty[0].x1 = img->width;
+    img->dirty[0].y1 = img->height;
+
+    img->dirty_count = 1;
+  }
+
+  say_gl_bind_texture(img->texture);
+
+  /* Rows of each region are width pixels apart in the buffer */
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, img->width);
+
+  for (size_t i = 0; i < img->dirty_count; i++) {
+    say_image_dirty_rect *rect = &img->dirty[i];
+
+    size_t w = rect->x1 - rect->x0;
+    size_t h = rect->y1 - rect->y0;
+
+    glTexSubImage2D(GL_TEXTURE_2D, 0,
+                    rect->x0, rect->y0,
+                    w, h,
+                    GL_RGBA, GL_UNSIGNED_BYTE,
+                    &img->pixels[rect->y0 * img->width + rect->x0]);
+
+    say_image_count_upload(w * h * sizeof(say_color));
+  }
+
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+  img->dirty_count     = 0;
+  img->texture_updated = 1;
+
+  if (!img->keep_pixels)
+    say_image_discard_pixels(img);
+}
+
+void say_image_invalidate_pixels(say_image *img) {
+  /* The texture holds the actual content, nothing must overwrite it */
+  img->dirty_count     = 0;
+  img->texture_updated = 1;
+
+  img->pixels_outdated = 1;
+
+  if (img->pack_fence) {
+    glDeleteSync(img->pack_fence);
+    img->pack_fence = NULL;
+  }
+
+  /* Nothing to keep, the pixels no longer match the texture anyway */
+  if (!img->keep_pixels && img->pixels) {
+    free(img->pixels);
+    img->pixels = NULL;
+  }
+}
+
+void say_image_prefetch_pixels(say_image *img) {
+  say_image_invalidate_pixels(img);
+
+  if (img->width == 0 || !img->texture ||
+      !__GLEW_ARB_pixel_buffer_object || !__GLEW_ARB_sync)
+    return;
+
+  say_context_ensure();
+
+  if (!img->pack_buffer)
+    glGenBuffers(1, &img->pack_buffer);
+
+  say_gl_bind_texture(img->texture);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, img->pack_buffer);
+  glBufferData(GL_PIXEL_PACK_BUFFER,
+               sizeof(say_color) * img->width * img->height, NULL,
+               GL_STREAM_READ);
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  img->pack_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void say_image_fetch_pixels(say_image *img) {
+  if (!img->pixels_outdated)
+    return;
+
+  img->pixels_outdated = 0;
+
+  if (!img->pixels)
+    img->pixels = malloc(sizeof(say_color) * img->width * img->height);
+
+  say_context_ensure();
+  say_image_ensure_texture(img);
+
+  if (img->pack_fence) {
+    while (glClientWaitSync(img->pack_fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                            1000000000) == GL_TIMEOUT_EXPIRED);
+    glDeleteSync(img->pack_fence);
+    img->pack_fence = NULL;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, img->pack_buffer);
+    say_color *pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    if (pixels) {
+      memcpy(img->pixels, pixels,
+             sizeof(say_color) * img->width * img->height);
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (pixels)
+      return;
+  }
+
+  say_gl_bind_texture(img->texture);
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, img->pixels);
+}
+
+void say_image_discard_pixels(say_image *img) {
   if (!img->pixels)
     return;
 
-  say_texture_make_current(img->texture);
-  glTexSubImage2D(GL_TEXTURE_2D, 0,
-                  0, 0,
-                  img->width, img->height,
-                  GL_RGBA, GL_UNSIGNED_BYTE, img->pixels);
+  /* Changes that weren't uploaded yet would be lost */
+  if (!img->texture || !img->texture_updated) {
+    say_context_ensure();
+    say_image_update_texture(img);
+
+    if (!img->pixels) /* Already discarded by the update */
+      return;
+  }
+
+  free(img->pixels);
+  img->pixels = NULL;
+
+  img->pixels_outdated = 1;
+}
+
+/* Takes ownership of the blocks */
+static void say_image_set_compressed(say_image *img, say_image_format format,
+                                     uint8_t *blocks) {
+  if (img->compressed)
+    free(img->compressed);
+
+  img->format     = format;
+  img->compressed = blocks;
 
+  img->dirty_count     = 0;
   img->texture_updated = 1;
+
+  if (img->texture) {
+    say_context_ensure();
+    say_gl_bind_texture(img->texture);
+    say_image_upload_compressed(img);
+
+    if (img->pack_fence) {
+      glDeleteSync(img->pack_fence);
+      img->pack_fence = NULL;
+    }
+
+    if (!img->keep_pixels)
+      say_image_discard_pixels(img);
+  }
+}
+
+static uint8_t *say_image_encode(say_image *img, say_image_format format) {
+  say_image_fetch_pixels(img);
+
+  uint8_t *blocks = malloc(say_image_format_get_size(format, img->width,
+                                                     img->height));
+  say_image_compress_blocks(format, img->pixels, img->width, img->height,
+                            blocks);
+
+  return blocks;
+}
+
+bool say_image_compress(say_image *img, say_image_format format) {
+  if (img->width == 0 || img->height == 0) {
+    say_error_set("can't compress empty image");
+    return false;
+  }
+
+  if (format == img->format)
+    return true;
+
+  if (format == SAY_IMAGE_RGBA8) {
+    /* Pixels are read back, decompressed, from the texture */
+    say_image_fetch_pixels(img);
+    say_image_drop_compression(img);
+
+    if (img->texture) {
+      say_context_ensure();
+      say_gl_bind_texture(img->texture);
+
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, img->width, img->height, 0,
+                   GL_RGBA, GL_UNSIGNED_BYTE, img->pixels);
+      say_image_count_upload(sizeof(say_color) * img->width * img->height);
+    }
+
+    img->dirty_count     = 0;
+    img->texture_updated = 1;
+
+    return true;
+  }
+
+  if (!say_image_format_is_supported(format)) {
+    say_error_set("compressed format not supported");
+    return false;
+  }
+
+  say_image_set_compressed(img, format, say_image_encode(img, format));
+  return true;
+}
+
+say_image_format say_image_get_format(say_image *img) {
+  return img->format;
+}
+
+/*
+ * Compressed blocks are cached next to the source file, so that it doesn't
+ * need to be decoded and compressed again. The cache is only used while the
+ * size and modification time of the source match the ones it was created
+ * from. It is written in native byte order, as it is only a local cache.
+ */
+
+#define SAY_IMAGE_CACHE_MAGIC   0x43594153 /* "SAYC" */
+#define SAY_IMAGE_CACHE_VERSION 1
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t format;
+  uint32_t width, height;
+  uint64_t source_size;
+  int64_t  source_mtime;
+} say_image_cache_header;
+
+static char *say_image_cache_path(const char *filename,
+                                  say_image_format format) {
+  const char *ext = say_image_format_get_name(format);
+
+  char *path = malloc(strlen(filename) + strlen(ext) + 2);
+  sprintf(path, "%s.%s", filename, ext);
+
+  return path;
+}
+
+static bool say_image_read_cache(say_image *img, const char *path,
+                                 say_image_format format,
+                                 struct stat *source) {
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return false;
+
+  say_image_cache_header header;
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      header.magic != SAY_IMAGE_CACHE_MAGIC ||
+      header.version != SAY_IMAGE_CACHE_VERSION ||
+      header.format != (uint32_t)format ||
+      header.width == 0 || header.height == 0 ||
+      header.source_size != (uint64_t)source->st_size ||
+      header.source_mtime != (int64_t)source->st_mtime) {
+    fclose(file);
+    return false;
+  }
+
+  size_t size = say_image_format_get_size(format, header.width, header.height);
+  uint8_t *blocks = malloc(size);
+
+  if (fread(blocks, 1, size, file) != size) {
+    free(blocks);
+    fclose(file);
+    return false;
+  }
+
+  fclose(file);
+
+  /* Pixels are never decoded, they can be read back from the texture */
+  if (img->pixels) {
+    free(img->pixels);
+    img->pixels = NULL;
+  }
+
+  img->width           = header.width;
+  img->height          = header.height;
+  img->pixels_outdated = 1;
+
+  say_image_set_compressed(img, format, blocks);
+  return true;
+}
+
+static void say_image_write_cache(const char *path, say_image_format format,
+                                  struct stat *source, size_t w, size_t h,
+                                  uint8_t *blocks) {
+  FILE *file = fopen(path, "wb");
+  if (!file)
+    return; /* Not being able to cache isn't an error */
+
+  say_image_cache_header header = {
+    SAY_IMAGE_CACHE_MAGIC, SAY_IMAGE_CACHE_VERSION, format, w, h,
+    source->st_size, source->st_mtime
+  };
+
+  size_t size = say_image_format_get_size(format, w, h);
+
+  if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+      fwrite(blocks, 1, size, file) != size) {
+    fclose(file);
+    remove(path);
+    return;
+  }
+
+  fclose(file);
+}
+
+bool say_image_load_file_compressed(say_image *img, const char *filename,
+                                    say_image_format format) {
+  struct stat source;
+
+  if (format == SAY_IMAGE_RGBA8 || !say_image_format_is_supported(format) ||
+      stat(filename, &source) != 0)
+    return say_image_load_file(img, filename);
+
+  char *path = say_image_cache_path(filename, format);
+
+  if (say_image_read_cache(img, path, format, &source)) {
+    free(path);
+    return true;
+  }
+
+  if (!say_image_load_file(img, filename)) {
+    free(path);
+    return false;
+  }
+
+  uint8_t *blocks = say_image_encode(img, format);
+  say_image_write_cache(path, format, &source, img->width, img->height,
+                        blocks);
+  free(path);
+
+  say_image_set_compressed(img, format, blocks);
+  return true;
+}
+
+bool say_image_has_pixels(say_image *img) {
+  return img->pixels != NULL;
+}
+
+void say_image_set_keep_pixels(say_image *img, bool val) {
+  img->keep_pixels = val;
+}
+
+bool say_image_get_keep_pixels(say_image *img) {
+  return img->keep_pixels;
+}
+
+void say_image_set_default_keep_pixels(bool val) {
+  say_image_default_keep_pixels = val;
+}
+
+bool say_image_get_default_keep_pixels() {
+  return say_image_default_keep_pixels;
+}
+
+size_t say_image_get_uploaded_bytes() {
+  return say_image_last_frame_bytes;
+}
+
+size_t say_image_get_total_uploaded_bytes() {
+  return say_image_total_bytes;
+}
+
+void say_image_end_frame() {
+  say_image_last_frame_bytes = say_image_frame_bytes;
+  say_image_frame_bytes      = 0;
 }
 
 void say_image_unbind() {
-  say_texture_make_current(0);
+  say_gl_bind_texture(0);
+}
+
+size_t say_image_get_max_texture_size() {
+  static GLint size = 0;
+
+  if (size == 0 && say_context_ensure())
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &size);
+
+  return size;
 }
@@ -2,6 +2,15 @@
 #define SAY_IMAGE_H_
 
 #include "say_basic_type.h"
+#include "say_image_compress.h"
+
+#define SAY_IMAGE_MAX_DIRTY_RECTS 4
+
+/* Region of the pixel buffer that hasn't been uploaded yet, x1/y1 excluded */
+typedef struct {
+  size_t x0, y0;
+  size_t x1, y1;
+} say_image_dirty_rect;
 
 typedef struct say_image {
   GLuint texture;
@@ -9,9 +18,25 @@ typedef struct say_image {
   say_color *pixels;
   uint8_t texture_updated;
 
+  say_image_dirty_rect dirty[SAY_IMAGE_MAX_DIRTY_RECTS];
+  size_t dirty_count;
+
+  /*
+   * Set when the texture was drawn on or the pixels were discarded, they are
+   * fetched back lazily.
+   */
+  uint8_t pixels_outdated;
+  bool keep_pixels;
+  GLuint pack_buffer;
+  GLsync pack_fence;
+
   size_t width, height;
 
   uint8_t smooth;
+
+  /* Compressed blocks, only kept until they are uploaded */
+  say_image_format format;
+  uint8_t *compressed;
 } say_image;
 
 say_image *say_image_create();
@@ -29,6 +54,11 @@ bool say_image_load_file(say_image *img, const char *filename);
 bool say_image_load_from_memory(say_image *img, size_t size, const char *buffer);
 bool say_image_create_with_size(say_image *img, size_t w, size_t h);
 
+bool say_image_compress(say_image *img, say_image_format format);
+say_image_format say_image_get_format(say_image *img);
+bool say_image_load_file_compressed(say_image *img, const char *filename,
+                                    say_image_format format);
+
 bool say_image_write_bmp(say_image *img, const char *filename);
 bool say_image_write_png(say_image *img, const char *filename);
 bool say_image_write_tga(say_image *img, const char *filename);
@@ -44,9 +74,34 @@ say_rect say_image_get_tex_rect(say_image *img, say_rect rect);
 
 say_color *say_image_get_buffer(say_image *img);
 
+GLuint say_image_get_texture(say_image *img);
+
 void say_image_bind(say_image *img);
 void say_image_unbind();
 
+/* 0 when no context could be created to query it */
+size_t say_image_get_max_texture_size();
+
 void say_image_update_texture(say_image *img);
 
+void say_image_mark_dirty(say_image *img, size_t x, size_t y,
+                          size_t w, size_t h);
+
+void say_image_invalidate_pixels(say_image *img);
+void say_image_prefetch_pixels(say_image *img);
+void say_image_fetch_pixels(say_image *img);
+
+void say_image_discard_pixels(say_image *img);
+bool say_image_has_pixels(say_image *img);
+
+void say_image_set_keep_pixels(say_image *img, bool val);
+bool say_image_get_keep_pixels(say_image *img);
+
+void say_image_set_default_keep_pixels(bool val);
+bool say_image_get_default_keep_pixels();
+
+size_t say_image_get_uploaded_bytes();
+size_t say_image_get_total_uploaded_bytes();
+void say_image_end_frame();
+
 #endif
@@ -0,0 +1,232 @@
+#include "say.h"
+
+/*
+ * Block compression encoders. Every format splits the image in 4x4 blocks
+ * (edge blocks repeat their last row and column) and stores two endpoints
+ * per block, each pixel being replaced by the index of the closest value
+ * interpolated between them. Endpoints are simply the bounds of the block,
+ * which is fast and good enough for sprites.
+ */
+
+const char *say_image_format_get_name(say_image_format format) {
+  switch (format) {
+  case SAY_IMAGE_DXT1:  return "dxt1";
+  case SAY_IMAGE_DXT5:  return "dxt5";
+  case SAY_IMAGE_RGTC1: return "rgtc1";
+  default:              return "rgba8";
+  }
+}
+
+GLenum say_image_format_get_gl_format(say_image_format format) {
+  switch (format) {
+  case SAY_IMAGE_DXT1:  return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+  case SAY_IMAGE_DXT5:  return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+  case SAY_IMAGE_RGTC1: return GL_COMPRESSED_RED_RGTC1;
+  default:              return GL_RGBA8;
+  }
+}
+
+bool say_image_format_is_supported(say_image_format format) {
+  say_context_ensure();
+
+  switch (format) {
+  case SAY_IMAGE_DXT1:
+  case SAY_IMAGE_DXT5:
+    return __GLEW_EXT_texture_compression_s3tc != 0;
+  case SAY_IMAGE_RGTC1:
+    return __GLEW_ARB_texture_compression_rgtc != 0 ||
+      __GLEW_EXT_texture_compression_rgtc != 0;
+  default:
+    return true;
+  }
+}
+
+static size_t say_image_format_get_block_size(say_image_format format) {
+  switch (format) {
+  case SAY_IMAGE_DXT5: return 16;
+  default:             return 8;
+  }
+}
+
+size_t say_image_format_get_size(say_image_format format, size_t w, size_t h) {
+  if (format == SAY_IMAGE_RGBA8)
+    return sizeof(say_color) * w * h;
+
+  return ((w + 3) / 4) * ((h + 3) / 4) *
+    say_image_format_get_block_size(format);
+}
+
+static void say_block_fetch(say_color *pixels, size_t w, size_t h,
+                            size_t bx, size_t by, say_color *block) {
+  for (size_t y = 0; y < 4; y++) {
+    size_t py = by + y < h ? by + y : h - 1;
+
+    for (size_t x = 0; x < 4; x++) {
+      size_t px = bx + x < w ? bx + x : w - 1;
+      block[y * 4 + x] = pixels[py * w + px];
+    }
+  }
+}
+
+static uint16_t say_rgb565_pack(int r, int g, int b) {
+  return (((r * 31 + 127) / 255) << 11) |
+    (((g * 63 + 127) / 255) << 5) |
+    ((b * 31 + 127) / 255);
+}
+
+static void say_rgb565_unpack(uint16_t c, int *rgb) {
+  int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+
+  rgb[0] = (r << 3) | (r >> 2);
+  rgb[1] = (g << 2) | (g >> 4);
+  rgb[2] = (b << 3) | (b >> 2);
+}
+
+static void say_compress_color_block(say_color *block, uint8_t *out) {
+  int min[3] = {255, 255, 255}, max[3] = {0, 0, 0};
+
+  for (size_t i = 0; i < 16; i++) {
+    int rgb[3] = {block[i].r, block[i].g, block[i].b};
+
+    for (size_t c = 0; c < 3; c++) {
+      if (rgb[c] < min[c]) min[c] = rgb[c];
+      if (rgb[c] > max[c]) max[c] = rgb[c];
+    }
+  }
+
+  /* Insetting the bounds reduces the error of the interpolated colors */
+  for (size_t c = 0; c < 3; c++) {
+    int inset = (max[c] - min[c]) / 16;
+    min[c] += inset;
+    max[c] -= inset;
+  }
+
+  uint16_t c0 = say_rgb565_pack(max[0], max[1], max[2]);
+  uint16_t c1 = say_rgb565_pack(min[0], min[1], min[2]);
+
+  /* c0 > c1 selects the four colors mode */
+  if (c0 < c1) {
+    uint16_t tmp = c0;
+    c0 = c1;
+    c1 = tmp;
+  }
+
+  int palette[4][3];
+  say_rgb565_unpack(c0, palette[0]);
+  say_rgb565_unpack(c1, palette[1]);
+
+  for (size_t c = 0; c < 3; c++) {
+    palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+    palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+  }
+
+  uint32_t indices = 0;
+
+  if (c0 != c1) {
+    for (size_t i = 0; i < 16; i++) {
+      int rgb[3] = {block[i].r, block[i].g, block[i].b};
+
+      uint32_t best = 0;
+      int best_dist = INT32_MAX;
+
+      for (uint32_t j = 0; j < 4; j++) {
+        int dist = 0;
+        for (size_t c = 0; c < 3; c++)
+          dist += (rgb[c] - palette[j][c]) * (rgb[c] - palette[j][c]);
+
+        if (dist < best_dist) {
+          best      = j;
+          best_dist = dist;
+        }
+      }
+
+      indices |= best << (2 * i);
+    }
+  }
+
+  out[0] = c0 & 0xff;
+  out[1] = c0 >> 8;
+  out[2] = c1 & 0xff;
+  out[3] = c1 >> 8;
+
+  for (size_t i = 0; i < 4; i++)
+    out[4 + i] = (indices >> (8 * i)) & 0xff;
+}
+
+/* Used for DXT5 alpha and RGTC1 */
+static void say_compress_channel_block(uint8_t *values, uint8_t *out) {
+  int min = 255, max = 0;
+
+  for (size_t i = 0; i < 16; i++) {
+    if (values[i] < min) min = values[i];
+    if (values[i] > max) max = values[i];
+  }
+
+  /* a0 > a1 selects the eight values mode */
+  int palette[8] = {max, min};
+  for (int i = 1; i < 7; i++)
+    palette[i + 1] = ((7 - i) * max + i * min) / 7;
+
+  uint64_t indices = 0;
+
+  if (max != min) {
+    for (size_t i = 0; i < 16; i++) {
+      uint64_t best = 0;
+      int best_dist = 256;
+
+      for (uint64_t j = 0; j < 8; j++) {
+        int dist = abs(values[i] - palette[j]);
+
+        if (dist < best_dist) {
+          best      = j;
+          best_dist = dist;
+        }
+      }
+
+      indices |= best << (3 * i);
+    }
+  }
+
+  out[0] = max;
+  out[1] = min;
+
+  for (size_t i = 0; i < 6; i++)
+    out[2 + i] = (indices >> (8 * i)) & 0xff;
+}
+
+void say_image_compress_blocks(say_image_format format, say_color *pixels,
+                               size_t w, size_t h, uint8_t *out) {
+  size_t block_size = say_image_format_get_block_size(format);
+
+  say_color block[16];
+  uint8_t channel[16];
+
+  for (size_t by = 0; by < h; by += 4) {
+    for (size_t bx = 0; bx < w; bx += 4) {
+      say_block_fetch(pixels, w, h, bx, by, block);
+
+      switch (format) {
+      case SAY_IMAGE_DXT1:
+        say_compress_color_block(block, out);
+        break;
+      case SAY_IMAGE_DXT5:
+        for (size_t i = 0; i < 16; i++)
+          channel[i] = block[i].a;
+
+        say_compress_channel_block(channel, out);
+        say_compress_color_block(block, out + 8);
+        break;
+      case SAY_IMAGE_RGTC1:
+        for (size_t i = 0; i < 16; i++)
+          channel[i] = block[i].r;
+
+        say_compress_channel_block(channel, out);
+        break;
+      default:
+        break;
+      }
+
+      out += block_size;
+    }
+  }
+}
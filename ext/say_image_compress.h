@@ -0,0 +1,22 @@
+#ifndef SAY_IMAGE_COMPRESS_H_
+#define SAY_IMAGE_COMPRESS_H_
+
+#include "say_basic_type.h"
+
+typedef enum {
+  SAY_IMAGE_RGBA8 = 0,
+  SAY_IMAGE_DXT1,  /* RGB, 4 bits per pixel */
+  SAY_IMAGE_DXT5,  /* RGBA, 8 bits per pixel */
+  SAY_IMAGE_RGTC1  /* Red channel only, 4 bits per pixel */
+} say_image_format;
+
+const char *say_image_format_get_name(say_image_format format);
+GLenum say_image_format_get_gl_format(say_image_format format);
+bool say_image_format_is_supported(say_image_format format);
+
+size_t say_image_format_get_size(say_image_format format, size_t w, size_t h);
+
+void say_image_compress_blocks(say_image_format format, say_color *pixels,
+                               size_t w, size_t h, uint8_t *out);
+
+#endif
@@ -0,0 +1,604 @@
+#include "say.h"
+
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+/*
+ * Bulk pixel operations. Large images are split in bands of rows that are
+ * processed on separate threads. Blending and premultiplication, which are
+ * the most common ones, process four pixels at a time with SSE2 when it is
+ * available. Every operation rounds like GL does, dividing by 255 rather
+ * than shifting.
+ */
+
+#define SAY_IMAGE_OPS_MAX_THREADS   16
+#define SAY_IMAGE_OPS_THREAD_PIXELS (128 * 1024)
+
+typedef void (*say_image_row_proc)(void *data, size_t first, size_t last);
+
+typedef struct {
+  say_image_row_proc proc;
+  void *data;
+  size_t first, last;
+} say_image_row_job;
+
+static void *say_image_row_job_run(void *data) {
+  say_image_row_job *job = data;
+  job->proc(job->data, job->first, job->last);
+
+  return NULL;
+}
+
+static void say_image_for_rows(size_t rows, size_t width,
+                               say_image_row_proc proc, void *data) {
+  size_t count = say_thread_get_cpu_count();
+  size_t max   = (rows * width) / SAY_IMAGE_OPS_THREAD_PIXELS;
+
+  if (count > max) count = max;
+  if (count > rows) count = rows;
+  if (count > SAY_IMAGE_OPS_MAX_THREADS) count = SAY_IMAGE_OPS_MAX_THREADS;
+
+  if (count <= 1) {
+    proc(data, 0, rows);
+    return;
+  }
+
+  say_image_row_job jobs[SAY_IMAGE_OPS_MAX_THREADS];
+  say_thread *threads[SAY_IMAGE_OPS_MAX_THREADS];
+
+  for (size_t i = 0; i < count; i++) {
+    jobs[i].proc  = proc;
+    jobs[i].data  = data;
+    jobs[i].first = (rows * i) / count;
+    jobs[i].last  = (rows * (i + 1)) / count;
+  }
+
+  /* The calling thread takes the last band */
+  for (size_t i = 0; i < count - 1; i++)
+    threads[i] = say_thread_create(&jobs[i], say_image_row_job_run);
+
+  say_image_row_job_run(&jobs[count - 1]);
+
+  for (size_t i = 0; i < count - 1; i++) {
+    say_thread_join(threads[i]);
+    say_thread_free(threads[i]);
+  }
+}
+
+/* Compressed images are edited through their uncompressed pixels */
+static say_color *say_image_begin_edit(say_image *img) {
+  if (say_image_get_format(img) != SAY_IMAGE_RGBA8)
+    say_image_compress(img, SAY_IMAGE_RGBA8);
+
+  return say_image_get_buffer(img);
+}
+
+static uint8_t say_div255(int x) {
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+static uint8_t say_clamp_byte(int x) {
+  return x < 0 ? 0 : (x > 255 ? 255 : x);
+}
+
+#ifdef __SSE2__
+/* Exact rounded division by 255 of products of two bytes */
+static __m128i say_div255_epi16(__m128i x) {
+  x = _mm_add_epi16(x, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+/*
+ * Broadcasts the alpha of the two pixels in x to their color channels. Their
+ * alpha channel is set to 255, so that multiplying by it leaves it unchanged.
+ */
+static __m128i say_alpha_epi16(__m128i x) {
+  __m128i alpha_mask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+
+  x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+  x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+
+  return _mm_or_si128(_mm_andnot_si128(alpha_mask, x),
+                      _mm_and_si128(alpha_mask, _mm_set1_epi16(255)));
+}
+#endif
+
+/*
+ * Blending
+ */
+
+typedef struct {
+  say_color *dst, *src;
+  size_t dst_stride, src_stride;
+  size_t width;
+  bool blend;
+} say_blit_op;
+
+/*
+ * Source over destination: colors are blended like glBlendFunc(GL_SRC_ALPHA,
+ * GL_ONE_MINUS_SRC_ALPHA) does, but alpha values are added up so that drawing
+ * on an opaque image leaves it opaque.
+ */
+static void say_blend_row(say_color *dst, const say_color *src, size_t count) {
+  size_t i = 0;
+
+#ifdef __SSE2__
+  __m128i zero = _mm_setzero_si128();
+  __m128i full = _mm_set1_epi16(255);
+
+  for (; i + 4 <= count; i += 4) {
+    __m128i s = _mm_loadu_si128((const __m128i*)&src[i]);
+    __m128i d = _mm_loadu_si128((const __m128i*)&dst[i]);
+
+    __m128i s_lo = _mm_unpacklo_epi8(s, zero);
+    __m128i s_hi = _mm_unpackhi_epi8(s, zero);
+    __m128i d_lo = _mm_unpacklo_epi8(d, zero);
+    __m128i d_hi = _mm_unpackhi_epi8(d, zero);
+
+    __m128i a_lo = say_alpha_epi16(s_lo), a_hi = say_alpha_epi16(s_hi);
+
+    /* The destination is weighted by 255 - alpha on every channel */
+    __m128i inv_lo = _mm_sub_epi16(full, _mm_shufflehi_epi16(
+                                     _mm_shufflelo_epi16(s_lo, 0xff), 0xff));
+    __m128i inv_hi = _mm_sub_epi16(full, _mm_shufflehi_epi16(
+                                     _mm_shufflelo_epi16(s_hi, 0xff), 0xff));
+
+    __m128i r_lo = _mm_add_epi16(_mm_mullo_epi16(s_lo, a_lo),
+                                 _mm_mullo_epi16(d_lo, inv_lo));
+    __m128i r_hi = _mm_add_epi16(_mm_mullo_epi16(s_hi, a_hi),
+                                 _mm_mullo_epi16(d_hi, inv_hi));
+
+    _mm_storeu_si128((__m128i*)&dst[i],
+                     _mm_packus_epi16(say_div255_epi16(r_lo),
+                                      say_div255_epi16(r_hi)));
+  }
+#endif
+
+  for (; i < count; i++) {
+    int a = src[i].a, inv = 255 - a;
+
+    dst[i].r = say_div255(src[i].r * a + dst[i].r * inv);
+    dst[i].g = say_div255(src[i].g * a + dst[i].g * inv);
+    dst[i].b = say_div255(src[i].b * a + dst[i].b * inv);
+    dst[i].a = say_div255(255 * a + dst[i].a * inv);
+  }
+}
+
+static void say_blit_rows(void *data, size_t first, size_t last) {
+  say_blit_op *op = data;
+
+  for (size_t y = first; y < last; y++) {
+    say_color *dst = &op->dst[y * op->dst_stride];
+    say_color *src = &op->src[y * op->src_stride];
+
+    if (op->blend)
+      say_blend_row(dst, src, op->width);
+    else
+      memcpy(dst, src, sizeof(say_color) * op->width);
+  }
+}
+
+void say_image_blit(say_image *dst, say_image *src, say_rect rect,
+                    say_vector2 pos, bool blend) {
+  long src_w = say_image_get_width(src), src_h = say_image_get_height(src);
+  long dst_w = say_image_get_width(dst), dst_h = say_image_get_height(dst);
+
+  long sx = rect.x, sy = rect.y, w = rect.w, h = rect.h;
+  long dx = pos.x, dy = pos.y;
+
+  /* Clip against both images */
+  if (sx < 0) { w += sx; dx -= sx; sx = 0; }
+  if (sy < 0) { h += sy; dy -= sy; sy = 0; }
+  if (dx < 0) { w += dx; sx -= dx; dx = 0; }
+  if (dy < 0) { h += dy; sy -= dy; dy = 0; }
+
+  if (sx + w > src_w) w = src_w - sx;
+  if (sy + h > src_h) h = src_h - sy;
+  if (dx + w > dst_w) w = dst_w - dx;
+  if (dy + h > dst_h) h = dst_h - dy;
+
+  if (w <= 0 || h <= 0)
+    return;
+
+  say_color *src_pixels = say_image_get_buffer(src);
+  say_color *copy = NULL;
+
+  /* Overlapping regions of the same image are read from a copy */
+  if (src == dst) {
+    copy = malloc(sizeof(say_color) * w * h);
+    for (long y = 0; y < h; y++) {
+      memcpy(&copy[y * w], &src_pixels[(sy + y) * src_w + sx],
+             sizeof(say_color) * w);
+    }
+  }
+
+  say_color *dst_pixels = say_image_begin_edit(dst);
+
+  say_blit_op op;
+  op.dst        = &dst_pixels[dy * dst_w + dx];
+  op.dst_stride = dst_w;
+  op.src        = copy ? copy : &src_pixels[sy * src_w + sx];
+  op.src_stride = copy ? (size_t)w : (size_t)src_w;
+  op.width      = w;
+  op.blend      = blend;
+
+  say_image_for_rows(h, w, say_blit_rows, &op);
+
+  if (copy)
+    free(copy);
+
+  say_image_mark_dirty(dst, dx, dy, w, h);
+}
+
+typedef struct {
+  say_color *pixels;
+  size_t stride, width;
+  say_color color;
+} say_fill_op;
+
+static void say_fill_rows(void *data, size_t first, size_t last) {
+  say_fill_op *op = data;
+
+  for (size_t y = first; y < last; y++) {
+    say_color *row = &op->pixels[y * op->stride];
+    size_t x = 0;
+
+#ifdef __SSE2__
+    uint32_t value;
+    memcpy(&value, &op->color, sizeof(value));
+
+    __m128i fill = _mm_set1_epi32(value);
+    for (; x + 4 <= op->width; x += 4)
+      _mm_storeu_si128((__m128i*)&row[x], fill);
+#endif
+
+    for (; x < op->width; x++)
+      row[x] = op->color;
+  }
+}
+
+void say_image_fill_rect(say_image *img, say_rect rect, say_color color) {
+  long img_w = say_image_get_width(img), img_h = say_image_get_height(img);
+  long x = rect.x, y = rect.y, w = rect.w, h = rect.h;
+
+  if (x < 0) { w += x; x = 0; }
+  if (y < 0) { h += y; y = 0; }
+  if (x + w > img_w) w = img_w - x;
+  if (y + h > img_h) h = img_h - y;
+
+  if (w <= 0 || h <= 0)
+    return;
+
+  say_color *pixels = say_image_begin_edit(img);
+
+  say_fill_op op = {&pixels[y * img_w + x], img_w, w, color};
+  say_image_for_rows(h, w, say_fill_rows, &op);
+
+  say_image_mark_dirty(img, x, y, w, h);
+}
+
+/*
+ * Per-pixel operations
+ */
+
+typedef void (*say_pixel_proc)(void *data, say_color *pixels, size_t count);
+
+typedef struct {
+  say_pixel_proc proc;
+  void *data;
+  say_color *pixels;
+  size_t width;
+} say_pixel_op;
+
+static void say_pixel_rows(void *data, size_t first, size_t last) {
+  say_pixel_op *op = data;
+  op->proc(op->data, &op->pixels[first * op->width],
+           (last - first) * op->width);
+}
+
+static void say_image_for_pixels(say_image *img, say_pixel_proc proc,
+                                 void *data) {
+  size_t w = say_image_get_width(img), h = say_image_get_height(img);
+  if (w == 0 || h == 0)
+    return;
+
+  say_pixel_op op = {proc, data, say_image_begin_edit(img), w};
+  say_image_for_rows(h, w, say_pixel_rows, &op);
+
+  say_image_mark_dirty(img, 0, 0, w, h);
+}
+
+static void say_color_matrix_pixels(void *data, say_color *pixels,
+                                    size_t count) {
+  /* 16.16 fixed point coefficients */
+  const int32_t *m = data;
+
+  for (size_t i = 0; i < count; i++) {
+    int32_t in[4] = {pixels[i].r, pixels[i].g, pixels[i].b, pixels[i].a};
+    uint8_t out[4];
+
+    for (size_t c = 0; c < 4; c++) {
+      const int32_t *row = &m[c * 5];
+      int64_t sum = (int64_t)row[0] * in[0] + (int64_t)row[1] * in[1] +
+        (int64_t)row[2] * in[2] + (int64_t)row[3] * in[3] + row[4];
+
+      out[c] = say_clamp_byte((sum + 32768) >> 16);
+    }
+
+    pixels[i] = say_make_color(out[0], out[1], out[2], out[3]);
+  }
+}
+
+void say_image_color_matrix(say_image *img, const float *matrix) {
+  int32_t fixed[SAY_COLOR_MATRIX_SIZE];
+  for (size_t i = 0; i < SAY_COLOR_MATRIX_SIZE; i++)
+    fixed[i] = lrintf(matrix[i] * 65536.0f);
+
+  say_image_for_pixels(img, say_color_matrix_pixels, fixed);
+}
+
+static void say_premultiply_pixels(void *data, say_color *pixels,
+                                   size_t count) {
+  size_t i = 0;
+
+#ifdef __SSE2__
+  __m128i zero = _mm_setzero_si128();
+
+  for (; i + 4 <= count; i += 4) {
+    __m128i p = _mm_loadu_si128((const __m128i*)&pixels[i]);
+
+    __m128i lo = _mm_unpacklo_epi8(p, zero), hi = _mm_unpackhi_epi8(p, zero);
+
+    lo = say_div255_epi16(_mm_mullo_epi16(lo, say_alpha_epi16(lo)));
+    hi = say_div255_epi16(_mm_mullo_epi16(hi, say_alpha_epi16(hi)));
+
+    _mm_storeu_si128((__m128i*)&pixels[i], _mm_packus_epi16(lo, hi));
+  }
+#endif
+
+  for (; i < count; i++) {
+    int a = pixels[i].a;
+
+    pixels[i].r = say_div255(pixels[i].r * a);
+    pixels[i].g = say_div255(pixels[i].g * a);
+    pixels[i].b = say_div255(pixels[i].b * a);
+  }
+}
+
+void say_image_premultiply(say_image *img) {
+  say_image_for_pixels(img, say_premultiply_pixels, NULL);
+}
+
+static void say_unpremultiply_pixels(void *data, say_color *pixels,
+                                     size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    int a = pixels[i].a;
+    if (a == 0 || a == 255)
+      continue;
+
+    pixels[i].r = say_clamp_byte((pixels[i].r * 255 + a / 2) / a);
+    pixels[i].g = say_clamp_byte((pixels[i].g * 255 + a / 2) / a);
+    pixels[i].b = say_clamp_byte((pixels[i].b * 255 + a / 2) / a);
+  }
+}
+
+void say_image_unpremultiply(say_image *img) {
+  say_image_for_pixels(img, say_unpremultiply_pixels, NULL);
+}
+
+static void say_grayscale_pixels(void *data, say_color *pixels, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    /* BT.601 luma */
+    uint8_t luma = (77 * pixels[i].r + 150 * pixels[i].g + 29 * pixels[i].b +
+                    128) >> 8;
+    pixels[i].r = pixels[i].g = pixels[i].b = luma;
+  }
+}
+
+void say_image_grayscale(say_image *img) {
+  say_image_for_pixels(img, say_grayscale_pixels, NULL);
+}
+
+/*
+ * Geometric operations
+ */
+
+void say_image_flip(say_image *img, bool flip_x, bool flip_y) {
+  size_t w = say_image_get_width(img), h = say_image_get_height(img);
+  if (w == 0 || h == 0 || (!flip_x && !flip_y))
+    return;
+
+  say_color *pixels = say_image_begin_edit(img);
+
+  if (flip_x) {
+    for (size_t y = 0; y < h; y++) {
+      say_color *row = &pixels[y * w];
+
+      for (size_t x = 0; x < w / 2; x++) {
+        say_color tmp  = row[x];
+        row[x]         = row[w - x - 1];
+        row[w - x - 1] = tmp;
+      }
+    }
+  }
+
+  if (flip_y) {
+    say_color *tmp = malloc(sizeof(say_color) * w);
+
+    for (size_t y = 0; y < h / 2; y++) {
+      memcpy(tmp, &pixels[y * w], sizeof(say_color) * w);
+      memcpy(&pixels[y * w], &pixels[(h - y - 1) * w], sizeof(say_color) * w);
+      memcpy(&pixels[(h - y - 1) * w], tmp, sizeof(say_color) * w);
+    }
+
+    free(tmp);
+  }
+
+  say_image_mark_dirty(img, 0, 0, w, h);
+}
+
+typedef struct {
+  say_color *dst, *src;
+  size_t src_w, src_h;
+  bool clockwise;
+} say_rotate_op;
+
+static void say_rotate_rows(void *data, size_t first, size_t last) {
+  say_rotate_op *op = data;
+
+  /* The destination is src_h wide and src_w high */
+  for (size_t y = first; y < last; y++) {
+    say_color *row = &op->dst[y * op->src_h];
+
+    for (size_t x = 0; x < op->src_h; x++) {
+      size_t sx = op->clockwise ? y : op->src_w - y - 1;
+      size_t sy = op->clockwise ? op->src_h - x - 1 : x;
+
+      row[x] = op->src[sy * op->src_w + sx];
+    }
+  }
+}
+
+void say_image_rotate(say_image *img, bool clockwise) {
+  size_t w = say_image_get_width(img), h = say_image_get_height(img);
+  if (w == 0 || h == 0)
+    return;
+
+  say_color *copy = malloc(sizeof(say_color) * w * h);
+  memcpy(copy, say_image_begin_edit(img), sizeof(say_color) * w * h);
+
+  if (!say_image_create_with_size(img, h, w)) {
+    free(copy);
+    return;
+  }
+
+  say_rotate_op op = {say_image_get_buffer(img), copy, w, h, clockwise};
+  say_image_for_rows(w, h, say_rotate_rows, &op);
+
+  free(copy);
+}
+
+typedef struct {
+  say_color *dst, *src;
+  size_t dst_w, dst_h;
+  size_t src_w, src_h;
+  say_image_filter filter;
+} say_scale_op;
+
+static void say_scale_nearest(say_scale_op *op, size_t y, say_color *row) {
+  size_t sy = ((2 * y + 1) * op->src_h) / (2 * op->dst_h);
+  say_color *src = &op->src[sy * op->src_w];
+
+  for (size_t x = 0; x < op->dst_w; x++)
+    row[x] = src[((2 * x + 1) * op->src_w) / (2 * op->dst_w)];
+}
+
+/* Pixel centers are aligned, and edges are clamped */
+static void say_scale_coord(size_t i, size_t dst, size_t src,
+                            size_t *first, size_t *second, int *weight) {
+  float pos = ((i + 0.5f) * src) / dst - 0.5f;
+  if (pos < 0) pos = 0;
+
+  *first  = (size_t)pos;
+  *second = *first + 1 < src ? *first + 1 : *first;
+  *weight = (int)((pos - *first) * 256);
+}
+
+static void say_scale_bilinear(say_scale_op *op, size_t y, say_color *row) {
+  size_t y0, y1;
+  int wy;
+  say_scale_coord(y, op->dst_h, op->src_h, &y0, &y1, &wy);
+
+  say_color *top    = &op->src[y0 * op->src_w];
+  say_color *bottom = &op->src[y1 * op->src_w];
+
+  for (size_t x = 0; x < op->dst_w; x++) {
+    size_t x0, x1;
+    int wx;
+    say_scale_coord(x, op->dst_w, op->src_w, &x0, &x1, &wx);
+
+    uint8_t *a = (uint8_t*)&top[x0],    *b = (uint8_t*)&top[x1];
+    uint8_t *c = (uint8_t*)&bottom[x0], *d = (uint8_t*)&bottom[x1];
+    uint8_t *out = (uint8_t*)&row[x];
+
+    for (size_t i = 0; i < 4; i++) {
+      int upper = a[i] * (256 - wx) + b[i] * wx;
+      int lower = c[i] * (256 - wx) + d[i] * wx;
+
+      out[i] = (upper * (256 - wy) + lower * wy + 32768) >> 16;
+    }
+  }
+}
+
+/* Averages every source pixel covered by the destination one */
+static void say_scale_box(say_scale_op *op, size_t y, say_color *row) {
+  size_t y0 = (y * op->src_h) / op->dst_h;
+  size_t y1 = ((y + 1) * op->src_h) / op->dst_h;
+  if (y1 <= y0) y1 = y0 + 1;
+
+  for (size_t x = 0; x < op->dst_w; x++) {
+    size_t x0 = (x * op->src_w) / op->dst_w;
+    size_t x1 = ((x + 1) * op->src_w) / op->dst_w;
+    if (x1 <= x0) x1 = x0 + 1;
+
+    uint32_t sum[4] = {0, 0, 0, 0};
+    for (size_t sy = y0; sy < y1; sy++) {
+      uint8_t *src = (uint8_t*)&op->src[sy * op->src_w + x0];
+
+      for (size_t sx = x0; sx < x1; sx++, src += 4) {
+        sum[0] += src[0];
+        sum[1] += src[1];
+        sum[2] += src[2];
+        sum[3] += src[3];
+      }
+    }
+
+    uint32_t count = (x1 - x0) * (y1 - y0);
+    uint8_t *out   = (uint8_t*)&row[x];
+
+    for (size_t i = 0; i < 4; i++)
+      out[i] = (sum[i] + count / 2) / count;
+  }
+}
+
+static void say_scale_rows(void *data, size_t first, size_t last) {
+  say_scale_op *op = data;
+
+  for (size_t y = first; y < last; y++) {
+    say_color *row = &op->dst[y * op->dst_w];
+
+    switch (op->filter) {
+    case SAY_FILTER_BILINEAR: say_scale_bilinear(op, y, row); break;
+    case SAY_FILTER_BOX:      say_scale_box(op, y, row);      break;
+    default:                  say_scale_nearest(op, y, row);  break;
+    }
+  }
+}
+
+bool say_image_scale(say_image *dst, say_image *src, size_t w, size_t h,
+                     say_image_filter filter) {
+  size_t src_w = say_image_get_width(src), src_h = say_image_get_height(src);
+  if (src_w == 0 || src_h == 0) {
+    say_error_set("can't scale empty image");
+    return false;
+  }
+
+  if (dst == src) {
+    say_error_set("can't scale an image into itself");
+    return false;
+  }
+
+  say_color *src_pixels = say_image_get_buffer(src);
+
+  if (!say_image_create_with_size(dst, w, h))
+    return false;
+
+  say_scale_op op = {
+    say_image_get_buffer(dst), src_pixels, w, h, src_w, src_h, filter
+  };
+
+  say_image_for_rows(h, w, say_scale_rows, &op);
+  return true;
+}
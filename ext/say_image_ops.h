@@ -0,0 +1,33 @@
+#ifndef SAY_IMAGE_OPS_H_
+#define SAY_IMAGE_OPS_H_
+
+#include "say_image.h"
+
+typedef enum {
+  SAY_FILTER_NEAREST = 0,
+  SAY_FILTER_BILINEAR,
+  SAY_FILTER_BOX
+} say_image_filter;
+
+/*
+ * Each output channel is m[0] * r + m[1] * g + m[2] * b + m[3] * a + m[4] for
+ * the corresponding row of the matrix. Offsets are in 0..255 color units.
+ */
+#define SAY_COLOR_MATRIX_SIZE 20
+
+void say_image_blit(say_image *dst, say_image *src, say_rect rect,
+                    say_vector2 pos, bool blend);
+void say_image_fill_rect(say_image *img, say_rect rect, say_color color);
+
+void say_image_color_matrix(say_image *img, const float *matrix);
+void say_image_premultiply(say_image *img);
+void say_image_unpremultiply(say_image *img);
+void say_image_grayscale(say_image *img);
+
+void say_image_flip(say_image *img, bool flip_x, bool flip_y);
+void say_image_rotate(say_image *img, bool clockwise);
+
+bool say_image_scale(say_image *dst, say_image *src, size_t w, size_t h,
+                     say_image_filter filter);
+
+#endif
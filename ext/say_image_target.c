@@ -1,110 +1,272 @@
 #include "say.h"
 
-static say_context *say_image_target_make_context(void *data) {
-  return say_context_create();
-}
-
-static GLuint say_current_fbo = 0;
-static say_context *say_fbo_last_context = NULL;
+/*
+ * Depth buffers only need to match the size of the image, and are cleared
+ * every time a target is bound. Pooled targets of the same size can thus use
+ * the same one.
+ */
+
+typedef struct {
+  GLuint rbo;
+  size_t w, h;
+  size_t refs;
+} say_depth_buffer;
+
+static say_array *say_depth_buffers = NULL;
+
+static GLuint say_depth_buffer_acquire(size_t w, size_t h) {
+  if (!say_depth_buffers)
+    say_depth_buffers = say_array_create(sizeof(say_depth_buffer), NULL, NULL);
+
+  for (size_t i = 0; i < say_array_get_size(say_depth_buffers); i++) {
+    say_depth_buffer *buf = say_array_get(say_depth_buffers, i);
+
+    if (buf->w == w && buf->h == h) {
+      buf->refs++;
+      return buf->rbo;
+    }
+  }
 
-void say_fbo_make_current(GLuint fbo) {
-  say_context *context = say_context_current();
+  say_depth_buffer buf = {0, w, h, 1};
 
-  if (context != say_fbo_last_context ||
-      fbo != say_current_fbo) {
-    say_current_fbo = fbo;
-    say_fbo_last_context = context;
+  glGenRenderbuffersEXT(1, &buf.rbo);
+  say_gl_bind_rbo(buf.rbo);
+  glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_DEPTH_COMPONENT, w, h);
 
-    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, fbo);
-  }
+  say_array_push(say_depth_buffers, &buf);
+  return buf.rbo;
 }
 
-static GLuint say_current_rbo = 0;
-static say_context *say_rbo_last_context = NULL;
+static void say_depth_buffer_release(GLuint rbo) {
+  size_t count = say_array_get_size(say_depth_buffers);
 
-void say_rbo_make_current(GLuint rbo) {
-  say_context *context = say_context_current();
+  for (size_t i = 0; i < count; i++) {
+    say_depth_buffer *buf = say_array_get(say_depth_buffers, i);
+    if (buf->rbo != rbo)
+      continue;
 
-  if (context != say_rbo_last_context ||
-      rbo != say_current_rbo) {
-    say_current_rbo = rbo;
-    say_rbo_last_context = context;
+    if (--buf->refs == 0) {
+      say_gl_forget_rbo(rbo);
+      glDeleteRenderbuffersEXT(1, &rbo);
 
-    glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, rbo);
+      *buf = *(say_depth_buffer*)say_array_get(say_depth_buffers, count - 1);
+      say_array_resize(say_depth_buffers, count - 1);
+    }
+
+    return;
   }
 }
 
-void say_image_target_will_delete(GLuint fbo, GLuint rbo) {
-  if (say_current_fbo == fbo)
-    say_current_fbo = 0;
+bool say_image_target_is_available() {
+  if (say_backend_get() == SAY_BACKEND_SOFTWARE)
+    return true;
 
-  if (say_current_rbo == rbo)
-    say_current_rbo = 0;
-}
+  if (!say_context_ensure())
+    return false;
 
-bool say_image_target_is_available() {
-  say_context_ensure();
   return __GLEW_EXT_framebuffer_object != 0;
 }
 
 say_image_target *say_image_target_create() {
-  say_context_ensure();
   say_image_target *target = malloc(sizeof(say_image_target));
 
-  target->target = say_target_create();
-  target->img    = NULL;
+  target->software = say_backend_get() == SAY_BACKEND_SOFTWARE;
+
+  if (target->software)
+    target->target = say_target_create_software();
+  else {
+    say_context_ensure();
+    target->target = say_target_create();
+  }
+
+  target->img      = NULL;
+  target->prefetch = false;
+
+  /* Framebuffers are created for each context the target is drawn on */
+  target->fbos       = say_array_create(sizeof(say_image_target_fbo),
+                                        NULL, NULL);
+  target->generation = 1;
 
-  glGenFramebuffersEXT(1, &(target->fbo));
-  glGenRenderbuffersEXT(1, &(target->rbo));
+  /* The depth buffer is created along with its storage */
+  target->rbo          = 0;
+  target->rbo_w        = target->rbo_h = 0;
+  target->depth        = true;
+  target->shared_depth = false;
+
+  target->pooled    = false;
+  target->refs      = 0;
+  target->last_used = 0;
 
   return target;
 }
 
+static void say_image_target_drop_depth(say_image_target *target) {
+  if (!target->rbo)
+    return;
+
+  if (target->shared_depth)
+    say_depth_buffer_release(target->rbo);
+  else {
+    say_gl_forget_rbo(target->rbo);
+    glDeleteRenderbuffersEXT(1, &(target->rbo));
+  }
+
+  target->rbo   = 0;
+  target->rbo_w = target->rbo_h = 0;
+}
+
 void say_image_target_free(say_image_target *target) {
+  /* Pending reads must be dropped while the framebuffer still exists */
+  say_target_free(target->target);
+
+  if (target->software) {
+    say_array_free(target->fbos);
+
+    if (target->pooled && target->img)
+      say_image_free(target->img);
+
+    free(target);
+    return;
+  }
+
   say_context_ensure();
-  say_image_target_will_delete(target->fbo, target->rbo);
+  say_context *context = say_context_current();
+
+  /*
+   * Framebuffers of other contexts can't be deleted from this one. They are
+   * released along with their context.
+   */
+  for (size_t i = 0; i < say_array_get_size(target->fbos); i++) {
+    say_image_target_fbo *entry = say_array_get(target->fbos, i);
+
+    if (entry->context == context->count) {
+      say_gl_forget_fbo(entry->fbo);
+      glDeleteFramebuffersEXT(1, &entry->fbo);
+    }
+  }
 
-  glDeleteRenderbuffersEXT(1, &(target->rbo));
-  glDeleteFramebuffersEXT(1, &(target->fbo));
+  say_array_free(target->fbos);
+
+  say_image_target_drop_depth(target);
+
+  if (target->pooled && target->img)
+    say_image_free(target->img);
 
-  say_target_free(target->target);
   free(target);
 }
 
-void say_image_target_set_image(say_image_target *target, say_image *image) {
-  say_context_ensure();
+/* Storage is only reallocated when the size changes */
+static void say_image_target_update_depth(say_image_target *target,
+                                          size_t w, size_t h) {
+  if (!target->depth) {
+    say_image_target_drop_depth(target);
+    return;
+  }
+
+  if (target->rbo && (target->rbo_w != w || target->rbo_h != h))
+    say_image_target_drop_depth(target);
+
+  if (!target->rbo) {
+    if (target->shared_depth)
+      target->rbo = say_depth_buffer_acquire(w, h);
+    else {
+      glGenRenderbuffersEXT(1, &(target->rbo));
+      say_gl_bind_rbo(target->rbo);
+      glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_DEPTH_COMPONENT, w, h);
+    }
+
+    target->rbo_w = w;
+    target->rbo_h = h;
+  }
+}
+
+static void say_image_target_reset_view(say_image_target *target) {
+  say_vector2 size = say_image_get_size(target->img);
+
+  say_target_set_size(target->target, size);
+  say_view_set_size(target->target->view, size);
+  say_view_set_center(target->target->view, say_make_vector2(size.x / 2.0,
+                                                             size.y / 2.0));
+  say_view_flip_y(target->target->view, 0);
+}
+
+/* The view is set up like for framebuffers, drawing isn't flipped */
+static void say_image_target_set_software_image(say_image_target *target,
+                                                say_image *image) {
   target->img = image;
+  say_target_set_raster_image(target->target, image);
 
-  if (target->img) {
-    say_target_set_custom_data(target->target, target);
-    //say_target_need_own_contxt(target->target, 0);
-    say_target_set_context_proc(target->target, say_image_target_make_context);
-    say_target_set_bind_hook(target->target, (say_bind_hook)say_image_target_bind);
+  if (!image)
+    return;
+
+  say_image_target_reset_view(target);
+}
+
+/*
+ * Binds the framebuffer of the target for the current context, creating it
+ * or updating its attachments if needed. Textures and renderbuffers are shared
+ * between contexts, so every framebuffer uses the same ones.
+ */
+static void say_image_target_bind_fbo(say_image_target *target) {
+  say_context *context = say_context_current();
+  say_image_target_fbo *entry = NULL;
 
-    say_vector2 size = say_image_get_size(image);
+  for (size_t i = 0; i < say_array_get_size(target->fbos); i++) {
+    say_image_target_fbo *fbo = say_array_get(target->fbos, i);
 
-    say_target_set_size(target->target, size);
-    say_view_set_size(target->target->view, size);
-    say_view_set_center(target->target->view, say_make_vector2(size.x / 2.0,
-                                                               size.y / 2.0));
-    say_view_flip_y(target->target->view, 0);
+    if (fbo->context == context->count) {
+      entry = fbo;
+      break;
+    }
+  }
 
-    say_fbo_make_current(target->fbo);
+  if (!entry) {
+    say_image_target_fbo fbo = {context->count, 0, 0};
+    glGenFramebuffersEXT(1, &fbo.fbo);
 
-    say_image_bind(image);
-    glGenerateMipmapEXT(GL_TEXTURE_2D);
+    say_array_push(target->fbos, &fbo);
+    entry = say_array_get(target->fbos, say_array_get_size(target->fbos) - 1);
+  }
 
-    glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT,
-                              GL_TEXTURE_2D, image->texture, 0);
+  say_gl_bind_fbo(entry->fbo);
 
-    say_rbo_make_current(target->rbo);
-    glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_DEPTH_COMPONENT,
-                             say_image_get_width(image),
-                             say_image_get_height(image));
+  if (entry->generation != target->generation) {
+    entry->generation = target->generation;
 
+    /* Images don't use mipmaps, so the texture is complete without them */
+    glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT,
+                              GL_TEXTURE_2D,
+                              say_image_get_texture(target->img), 0);
     glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT,
                                  GL_RENDERBUFFER_EXT, target->rbo);
+  }
+}
 
+void say_image_target_set_image(say_image_target *target, say_image *image) {
+  if (target->software) {
+    say_image_target_set_software_image(target, image);
+    return;
+  }
+
+  say_context_ensure();
+  target->img = image;
+
+  if (target->img) {
+    say_target_set_custom_data(target->target, target);
+
+    /* The framebuffer is bound on whatever context is current */
+    say_target_need_own_contxt(target->target, 0);
+    say_target_set_bind_hook(target->target, (say_bind_hook)say_image_target_bind);
+
+    say_image_target_reset_view(target);
+
+    /* Compressed textures can't be rendered to */
+    if (say_image_get_format(image) != SAY_IMAGE_RGBA8)
+      say_image_compress(image, SAY_IMAGE_RGBA8);
+
+    say_image_target_update_depth(target, say_image_get_width(image),
+                                  say_image_get_height(image));
+    target->generation++;
   }
 }
 
@@ -116,19 +278,190 @@ void say_image_target_update(say_image_target *target) {
   if (target->img) {
     say_target_update(target->target);
 
-    say_image_bind(target->img);
-    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-                  say_image_get_buffer(target->img));
+    /* Pixels were drawn in place */
+    if (target->software)
+      return;
+
+    /* Pixels are only read back when they are accessed */
+    if (target->prefetch)
+      say_image_prefetch_pixels(target->img);
+    else
+      say_image_invalidate_pixels(target->img);
+  }
+}
+
+void say_image_target_set_prefetch(say_image_target *target, bool val) {
+  target->prefetch = val;
+}
+
+bool say_image_target_get_prefetch(say_image_target *target) {
+  return target->prefetch;
+}
+
+void say_image_target_set_depth(say_image_target *target, bool val) {
+  if (target->depth == val)
+    return;
+
+  target->depth = val;
+
+  if (target->img && !target->software) {
+    say_context_ensure();
+    say_image_target_update_depth(target, say_image_get_width(target->img),
+                                  say_image_get_height(target->img));
+    target->generation++;
   }
 }
 
+bool say_image_target_has_depth(say_image_target *target) {
+  return target->depth;
+}
+
 void say_image_target_bind(say_image_target *target) {
   say_context_ensure();
-  say_fbo_make_current(target->fbo);
-  glClear(GL_DEPTH_BUFFER_BIT);
+  say_image_target_bind_fbo(target);
+
+  if (target->rbo)
+    glClear(GL_DEPTH_BUFFER_BIT);
 }
 
 void say_image_target_unbind() {
-  if (say_image_target_is_available())
-    say_fbo_make_current(0);
+  /* Nothing is bound if no context was created, e.g. by software targets */
+  if (say_context_current() && __GLEW_EXT_framebuffer_object)
+    say_gl_bind_fbo(0);
+}
+
+/*
+ * Pool of targets for temporary drawing. Released targets are kept along with
+ * their framebuffer, depth buffer and texture, and handed out again when a
+ * target of the same size is needed. Those that haven't been used for a while
+ * are freed at the end of each frame.
+ */
+
+static say_array *say_image_target_pool = NULL;
+static size_t say_image_target_pool_frame = 0;
+static size_t say_image_target_pool_max_age = SAY_IMAGE_TARGET_POOL_MAX_AGE;
+
+/*
+ * Acquired targets start with the default view, no prefetching, and a
+ * transparent image, whether they are new or reused from an earlier user.
+ */
+static void say_image_target_reset(say_image_target *target) {
+  say_image_target_reset_view(target);
+  target->prefetch = false;
+
+  say_target_clear(target->target, say_make_color(0, 0, 0, 0));
+  say_image_target_update(target);
+}
+
+say_image_target *say_image_target_acquire(size_t w, size_t h, bool depth) {
+  if (!say_image_target_pool) {
+    say_image_target_pool = say_array_create(sizeof(say_image_target*),
+                                             NULL, NULL);
+  }
+
+  bool software = say_backend_get() == SAY_BACKEND_SOFTWARE;
+
+  for (size_t i = 0; i < say_array_get_size(say_image_target_pool); i++) {
+    say_image_target *target =
+      *(say_image_target**)say_array_get(say_image_target_pool, i);
+
+    if (target->refs == 0 && target->depth == depth &&
+        target->software == software &&
+        say_image_get_width(target->img) == w &&
+        say_image_get_height(target->img) == h) {
+      target->refs = 1;
+      say_image_target_reset(target);
+      return target;
+    }
+  }
+
+  say_image *img = say_image_create();
+  if (!say_image_create_with_size(img, w, h)) {
+    say_image_free(img);
+    return NULL;
+  }
+
+  say_image_target *target = say_image_target_create();
+
+  target->pooled       = true;
+  target->refs         = 1;
+  target->depth        = depth;
+  target->shared_depth = true;
+
+  say_image_target_set_image(target, img);
+  say_image_target_reset(target);
+
+  say_array_push(say_image_target_pool, &target);
+  return target;
+}
+
+void say_image_target_retain(say_image_target *target) {
+  target->refs++;
+}
+
+void say_image_target_release(say_image_target *target) {
+  if (--target->refs == 0)
+    target->last_used = say_image_target_pool_frame;
+}
+
+/* Releases the reference held through the image of a pooled target */
+void say_image_target_release_image(say_image *img) {
+  for (size_t i = 0; i < say_image_target_get_pool_size(); i++) {
+    say_image_target *target =
+      *(say_image_target**)say_array_get(say_image_target_pool, i);
+
+    if (target->img == img) {
+      say_image_target_release(target);
+      return;
+    }
+  }
+}
+
+bool say_image_target_is_pooled(say_image_target *target) {
+  return target->pooled;
+}
+
+size_t say_image_target_get_pool_size() {
+  if (!say_image_target_pool)
+    return 0;
+
+  return say_array_get_size(say_image_target_pool);
+}
+
+size_t say_image_target_get_pool_max_age() {
+  return say_image_target_pool_max_age;
+}
+
+void say_image_target_set_pool_max_age(size_t frames) {
+  say_image_target_pool_max_age = frames;
+}
+
+/* Frees the released targets that haven't been used for max_age frames */
+void say_image_target_trim_pool(size_t max_age) {
+  if (!say_image_target_pool)
+    return;
+
+  size_t i = 0;
+  while (i < say_array_get_size(say_image_target_pool)) {
+    say_image_target *target =
+      *(say_image_target**)say_array_get(say_image_target_pool, i);
+
+    if (target->refs != 0 ||
+        say_image_target_pool_frame - target->last_used < max_age) {
+      i++;
+      continue;
+    }
+
+    say_image_target_free(target);
+
+    size_t last = say_array_get_size(say_image_target_pool) - 1;
+    *(say_image_target**)say_array_get(say_image_target_pool, i) =
+      *(say_image_target**)say_array_get(say_image_target_pool, last);
+    say_array_resize(say_image_target_pool, last);
+  }
+}
+
+void say_image_target_end_frame() {
+  say_image_target_pool_frame++;
+  say_image_target_trim_pool(say_image_target_pool_max_age);
 }
@@ -4,10 +4,40 @@
 #include "say_target.h"
 #include "say_image.h"
 
+#define SAY_IMAGE_TARGET_POOL_MAX_AGE 60
+
+/* Framebuffers aren't shared between contexts */
+typedef struct {
+  uint32_t context; /* Count of the context, addresses may be reused */
+  GLuint fbo;
+  size_t generation;
+} say_image_target_fbo;
+
 typedef struct {
-  GLuint fbo, rbo;
+  say_array *fbos;
+  size_t generation; /* Incremented when attachments change */
+
+  GLuint rbo;
+  size_t rbo_w, rbo_h;
+
+  bool depth;
+  bool shared_depth; /* rbo belongs to the depth buffers shared by size */
+
   say_image *img;
   say_target *target;
+
+  bool prefetch;
+
+  /* Drawn by the software rasterizer, without any framebuffer */
+  bool software;
+
+  /*
+   * Pooled targets own their image, and are reused once every reference to
+   * them was released.
+   */
+  bool pooled;
+  size_t refs;
+  size_t last_used;
 } say_image_target;
 
 bool say_image_target_is_available();
@@ -19,7 +49,25 @@ void say_image_target_set_image(say_image_target *target, say_image *image);
 say_image *say_image_target_get_image(say_image_target *target);
 void say_image_target_update(say_image_target *taget);
 
+void say_image_target_set_prefetch(say_image_target *target, bool val);
+bool say_image_target_get_prefetch(say_image_target *target);
+
+void say_image_target_set_depth(say_image_target *target, bool val);
+bool say_image_target_has_depth(say_image_target *target);
+
 void say_image_target_bind(say_image_target *target);
 void say_image_target_unbind();
 
+say_image_target *say_image_target_acquire(size_t w, size_t h, bool depth);
+void say_image_target_retain(say_image_target *target);
+void say_image_target_release(say_image_target *target);
+void say_image_target_release_image(say_image *img);
+bool say_image_target_is_pooled(say_image_target *target);
+
+size_t say_image_target_get_pool_size();
+size_t say_image_target_get_pool_max_age();
+void say_image_target_set_pool_max_age(size_t frames);
+void say_image_target_trim_pool(size_t max_age);
+void say_image_target_end_frame();
+
 #endif
@@ -59,12 +59,15 @@ void say_imp_window_wait_event(say_imp_window win, struct say_event *ev,
 
 void say_imp_context_free(say_imp_context ctxt);
 
+/* True if contexts can be created without any display server */
+bool say_imp_context_headless_available();
+
 say_imp_context say_imp_context_create();
 say_imp_context say_imp_context_create_shared(say_imp_context shared);
 say_imp_context  say_imp_context_create_for_window(say_imp_context shared,
                                                    say_imp_window  win);
 
-void say_imp_context_make_current(say_imp_context ctxt);
+bool say_imp_context_make_current(say_imp_context ctxt);
 void say_imp_context_update(say_imp_context ctxt);
 
 #endif
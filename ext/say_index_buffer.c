@@ -1,26 +1,5 @@
 #include "say.h"
 
-static GLuint       say_current_ibo      = 0;
-static say_context *say_ibo_last_context = NULL;
-
-static void say_ibo_make_current(GLuint ibo) {
-  say_context *context = say_context_current();
-
-  if (context != say_ibo_last_context ||
-      ibo != say_current_ibo) {
-    say_current_ibo      = ibo;
-    say_ibo_last_context = context;
-
-    glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, ibo);
-  }
-}
-
-static void say_ibo_will_delete(GLuint ibo) {
-  if (ibo == say_current_ibo) {
-    say_current_ibo = 0;
-  }
-}
-
 say_index_buffer *say_index_buffer_create(GLenum type, size_t size) {
   say_context_ensure();
 
@@ -32,7 +11,7 @@ say_index_buffer *say_index_buffer_create(GLenum type, size_t size) {
   buf->buffer = say_array_create(sizeof(GLuint), NULL, NULL);
   say_array_resize(buf->buffer, size);
 
-  say_ibo_make_current(buf->ibo);
+  say_gl_bind_ibo(buf->ibo);
   glBufferDataARB(GL_ELEMENT_ARRAY_BUFFER_ARB, size * sizeof(GLuint),
                   NULL, type);
 
@@ -42,7 +21,7 @@ say_index_buffer *say_index_buffer_create(GLenum type, size_t size) {
 void say_index_buffer_free(say_index_buffer *buf) {
   say_context_ensure();
 
-  say_ibo_will_delete(buf->ibo);
+  say_gl_forget_ibo(buf->ibo);
   glDeleteBuffersARB(1, &buf->ibo);
   say_array_free(buf->buffer);
   free(buf);
@@ -50,12 +29,16 @@ void say_index_buffer_free(say_index_buffer *buf) {
 
 void say_index_buffer_bind(say_index_buffer *buf) {
   say_context_ensure();
-  say_ibo_make_current(buf->ibo);
+  say_gl_bind_ibo(buf->ibo);
+}
+
+void say_index_buffer_bind_ctx(say_index_buffer *buf, say_render_ctx *ctx) {
+  say_gl_state_bind_ibo(ctx->gl, buf->ibo);
 }
 
 void say_index_buffer_unbind(say_index_buffer *buf) {
   say_context_ensure();
-  say_ibo_make_current(0);
+  say_gl_bind_ibo(0);
 }
 
 void say_index_buffer_update_part(say_index_buffer *buf, size_t index,
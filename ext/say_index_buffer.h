@@ -3,6 +3,7 @@
 
 #include "say_basic_type.h"
 #include "say_array.h"
+#include "say_context.h"
 
 typedef struct {
   GLuint ibo;
@@ -15,6 +16,7 @@ say_index_buffer *say_index_buffer_create(GLenum type, size_t size);
 void say_index_buffer_free(say_index_buffer *buf);
 
 void say_index_buffer_bind(say_index_buffer *buf);
+void say_index_buffer_bind_ctx(say_index_buffer *buf, say_render_ctx *ctx);
 void say_index_buffer_unbind();
 
 void say_index_buffer_update_part(say_index_buffer *buf, size_t index,
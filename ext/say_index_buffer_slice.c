@@ -219,6 +219,11 @@ void say_index_buffer_slice_bind(say_index_buffer_slice *slice) {
   say_index_buffer_bind(say_ibo_at(slice->buf_id));
 }
 
+void say_index_buffer_slice_bind_ctx(say_index_buffer_slice *slice,
+                                     say_render_ctx *ctx) {
+  say_index_buffer_bind_ctx(say_ibo_at(slice->buf_id), ctx);
+}
+
 void say_index_buffer_slice_clean_up() {
   if (say_index_buffers) {
     say_array_free(say_index_buffers);
@@ -2,6 +2,7 @@
 #define SAY_INDEX_BUFFER_SLICE_H_
 
 #include "say_basic_type.h"
+#include "say_context.h"
 
 typedef struct {
   size_t buf_id;
@@ -22,6 +23,8 @@ GLuint *say_index_buffer_slice_get(say_index_buffer_slice *slice, size_t id);
 
 void say_index_buffer_slice_update(say_index_buffer_slice *slice);
 void say_index_buffer_slice_bind(say_index_buffer_slice *slice);
+void say_index_buffer_slice_bind_ctx(say_index_buffer_slice *slice,
+                                     say_render_ctx *ctx);
 
 void say_index_buffer_slice_clean_up();
 
@@ -141,8 +141,11 @@ say_matrix *say_matrix_looking_at(float eye_x, float eye_y, float eye_z,
   return matrix;
 }
 
+static uint64_t say_matrix_version_count = 0;
+
 void say_matrix_set(say_matrix *matrix, int x, int y, float value) {
   matrix->content[y * 4 + x] = value;
+  matrix->version = ++say_matrix_version_count;
 }
 
 float say_matrix_get(say_matrix *matrix, int x, int y) {
@@ -230,12 +233,17 @@ say_matrix *say_matrix_inverse(say_matrix *matrix) {
 
 void say_matrix_set_content(say_matrix *matrix, float *content) {
   memcpy(matrix->content, content, sizeof(float) * 16);
+  matrix->version = ++say_matrix_version_count;
 }
 
 float *say_matrix_get_content(say_matrix *matrix) {
   return matrix->content;
 }
 
+uint64_t say_matrix_get_version(say_matrix *matrix) {
+  return matrix->version;
+}
+
 void say_matrix_reset(say_matrix *matrix) {
   for (int y = 0; y < 4; y++) {
     for (int x = 0; x < 4; x++) {
@@ -5,6 +5,9 @@
 
 typedef struct {
   float content[16];
+
+  /* Changes every time the content is modified, unique across matrices */
+  uint64_t version;
 } say_matrix;
 
 say_matrix *say_matrix_identity();
@@ -33,6 +36,7 @@ say_matrix *say_matrix_inverse(say_matrix *matrix);
 
 void say_matrix_set_content(say_matrix *matrix, float *content);
 float *say_matrix_get_content(say_matrix *matrix);
+uint64_t say_matrix_get_version(say_matrix *matrix);
 
 void say_matrix_reset(say_matrix *matrix);
 
@@ -74,6 +74,10 @@ void say_imp_context_free(say_imp_context ctxt) {
   [ctxt release];
 }
 
+bool say_imp_context_headless_available() {
+  return false;
+}
+
 say_imp_context say_imp_context_create() {
   return [[SayContext alloc] initWithShared:nil];
 }
@@ -89,8 +93,9 @@ say_imp_context say_imp_context_create_for_window(say_imp_context shared,
   return ctxt;
 }
 
-void say_imp_context_make_current(say_imp_context ctxt) {
+bool say_imp_context_make_current(say_imp_context ctxt) {
   [ctxt makeCurrent];
+  return true;
 }
 
 void say_imp_context_update(say_imp_context ctxt) {
@@ -124,17 +124,18 @@ static void say_polygon_draw(void *data, size_t first, size_t index,
 
   if (polygon->filled) {
     if (polygon->point_count <= 4) {
-      glDrawArrays(GL_TRIANGLE_FAN, current, polygon->point_count);
+      say_draw_arrays(GL_TRIANGLE_FAN, current, polygon->point_count);
       current += polygon->point_count;
     }
     else {
-      glDrawArrays(GL_TRIANGLE_FAN, current, polygon->point_count + 2);
+      say_draw_arrays(GL_TRIANGLE_FAN, current, polygon->point_count + 2);
       current += polygon->point_count + 2;
     }
   }
 
   if (polygon->outlined) {
-    glDrawArrays(GL_TRIANGLE_STRIP, current, polygon->point_count * 2 + 2);
+    say_draw_arrays(GL_TRIANGLE_STRIP, current,
+                    polygon->point_count * 2 + 2);
   }
 }
 
@@ -0,0 +1,700 @@
+#include "say.h"
+
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+/*
+ * Triangles are set up in window coordinates with 4 bits of sub-pixel
+ * precision, and covered pixels are found using edge functions, sampled at
+ * the center of pixels. Pixels on edges shared by two triangles are only
+ * drawn once.
+ *
+ * The part of the target covered by a batch of triangles is split in tiles,
+ * which are drawn on separate threads when there are enough pixels. Each tile
+ * draws every triangle in order, so blending stays correct.
+ */
+
+#define SAY_RASTER_SUBPIXEL_BITS 4
+#define SAY_RASTER_SUBPIXEL      (1 << SAY_RASTER_SUBPIXEL_BITS)
+
+/* Keeps products of coordinates in 64 bits */
+#define SAY_RASTER_MAX_COORD     (1 << 22)
+
+#define SAY_RASTER_TILE_SIZE     64
+#define SAY_RASTER_MAX_THREADS   16
+#define SAY_RASTER_THREAD_PIXELS (64 * 1024)
+
+typedef struct {
+  say_raster_vertex v;
+  bool valid;
+} say_raster_point;
+
+static int say_backend_current = -1;
+
+#ifdef SAY_THREAD_LOCAL
+static SAY_THREAD_LOCAL say_raster *say_raster_current_raster = NULL;
+#else
+static say_raster *say_raster_current_raster = NULL;
+#endif
+
+void say_backend_set(say_backend backend) {
+  say_backend_current = backend;
+}
+
+say_backend say_backend_get() {
+  if (say_backend_current == -1) {
+    const char *env = getenv("RAY_BACKEND");
+
+    if (env && strcmp(env, "software") == 0)
+      say_backend_current = SAY_BACKEND_SOFTWARE;
+    else
+      say_backend_current = SAY_BACKEND_OPENGL;
+  }
+
+  return say_backend_current;
+}
+
+say_raster *say_raster_create() {
+  say_raster *raster = malloc(sizeof(say_raster));
+
+  raster->img        = NULL;
+  raster->projection = NULL;
+  raster->viewport   = say_make_rect(0, 0, 0, 0);
+
+  raster->vertices   = say_array_create(sizeof(say_raster_point), NULL, NULL);
+  raster->indices    = say_array_create(sizeof(GLuint), NULL, NULL);
+  raster->texture    = NULL;
+  raster->textured   = false;
+  raster->alpha_only = false;
+
+  raster->triangles = say_array_create(sizeof(say_raster_triangle),
+                                       NULL, NULL);
+
+  return raster;
+}
+
+void say_raster_free(say_raster *raster) {
+  say_array_free(raster->vertices);
+  say_array_free(raster->indices);
+  say_array_free(raster->triangles);
+
+  free(raster);
+}
+
+void say_raster_set_image(say_raster *raster, say_image *img) {
+  say_raster_flush(raster);
+  raster->img = img;
+}
+
+say_image *say_raster_get_image(say_raster *raster) {
+  return raster->img;
+}
+
+void say_raster_set_view(say_raster *raster, say_matrix *projection,
+                         say_rect viewport) {
+  raster->projection = projection;
+  raster->viewport   = viewport;
+}
+
+say_raster *say_raster_current() {
+  return say_raster_current_raster;
+}
+
+/* Compressed images are drawn on and sampled through their pixels */
+static say_color *say_raster_image_pixels(say_image *img) {
+  if (say_image_get_format(img) != SAY_IMAGE_RGBA8)
+    say_image_compress(img, SAY_IMAGE_RGBA8);
+
+  return say_image_get_buffer(img);
+}
+
+void say_raster_clear(say_raster *raster, say_color color) {
+  if (!raster->img)
+    return;
+
+  say_raster_flush(raster);
+
+  say_image *img = raster->img;
+
+  /* Like glClear, the viewport doesn't matter */
+  say_rect rect = say_make_rect(0, 0, say_image_get_width(img),
+                                say_image_get_height(img));
+  say_image_fill_rect(img, rect, color);
+}
+
+/*
+ * Vertex processing
+ */
+
+static void say_raster_transform(say_raster *raster, say_matrix *model_view,
+                                 say_vertex *in, say_raster_point *out) {
+  const float *mv = model_view->content;
+  const float *p  = raster->projection->content;
+
+  float x = in->pos.x, y = in->pos.y;
+
+  float eye[4] = {
+    mv[0]  * x + mv[1]  * y + mv[3],
+    mv[4]  * x + mv[5]  * y + mv[7],
+    mv[8]  * x + mv[9]  * y + mv[11],
+    mv[12] * x + mv[13] * y + mv[15]
+  };
+
+  float clip[4];
+  for (int i = 0; i < 4; i++) {
+    clip[i] = p[i * 4 + 0] * eye[0] + p[i * 4 + 1] * eye[1] +
+      p[i * 4 + 2] * eye[2] + p[i * 4 + 3] * eye[3];
+  }
+
+  /* Without clipping, vertices behind the eye can't be drawn */
+  out->valid = clip[3] > 0;
+  if (!out->valid)
+    return;
+
+  say_rect vp = raster->viewport;
+  float wx = vp.x + (clip[0] / clip[3] + 1) * vp.w / 2;
+  float wy = vp.y + (clip[1] / clip[3] + 1) * vp.h / 2;
+
+  if (fabsf(wx) >= SAY_RASTER_MAX_COORD ||
+      fabsf(wy) >= SAY_RASTER_MAX_COORD) {
+    out->valid = false;
+    return;
+  }
+
+  out->v.x = lrintf(wx * SAY_RASTER_SUBPIXEL);
+  out->v.y = lrintf(wy * SAY_RASTER_SUBPIXEL);
+
+  out->v.attr[0] = in->col.r / 255.0f;
+  out->v.attr[1] = in->col.g / 255.0f;
+  out->v.attr[2] = in->col.b / 255.0f;
+  out->v.attr[3] = in->col.a / 255.0f;
+  out->v.attr[4] = in->tex.x;
+  out->v.attr[5] = in->tex.y;
+}
+
+void say_raster_draw(say_raster *raster, say_drawable *drawable) {
+  if (!raster->img || !raster->projection || !drawable->render_proc)
+    return;
+
+  /* Only the default vertex layout is known */
+  if (say_drawable_get_vertex_type(drawable) != 0)
+    return;
+
+  size_t vertex_count = say_drawable_get_vertex_count(drawable);
+  size_t index_count  = say_drawable_get_index_count(drawable);
+
+  say_vertex *vertices = malloc(sizeof(say_vertex) * (vertex_count + 1));
+  say_drawable_fill_buffer(drawable, vertices);
+
+  say_matrix *model_view = say_drawable_get_matrix(drawable);
+
+  say_array_resize(raster->vertices, vertex_count);
+  for (size_t i = 0; i < vertex_count; i++) {
+    say_raster_transform(raster, model_view, &vertices[i],
+                         say_array_get(raster->vertices, i));
+  }
+
+  free(vertices);
+
+  say_array_resize(raster->indices, index_count);
+  if (index_count != 0) {
+    say_drawable_fill_index_buffer(drawable,
+                                   say_array_get(raster->indices, 0), 0);
+  }
+
+  raster->texture    = NULL;
+  raster->textured   = say_drawable_is_textured(drawable);
+  raster->alpha_only = say_drawable_is_alpha_only(drawable);
+
+  say_raster *previous = say_raster_current_raster;
+  say_raster_current_raster = raster;
+
+  drawable->render_proc(drawable->data, 0, 0, NULL);
+
+  say_raster_current_raster = previous;
+}
+
+void say_raster_bind_texture(say_raster *raster, say_image *img) {
+  raster->texture = img;
+}
+
+/*
+ * Primitive assembly
+ */
+
+static int say_raster_floor_div(int32_t a, int32_t b) {
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static void say_raster_push_triangle(say_raster *raster, size_t a, size_t b,
+                                     size_t c) {
+  size_t count = say_array_get_size(raster->vertices);
+  if (a >= count || b >= count || c >= count)
+    return;
+
+  say_raster_point *pa = say_array_get(raster->vertices, a);
+  say_raster_point *pb = say_array_get(raster->vertices, b);
+  say_raster_point *pc = say_array_get(raster->vertices, c);
+
+  if (!pa->valid || !pb->valid || !pc->valid)
+    return;
+
+  say_raster_triangle tri;
+  tri.v[0] = pa->v;
+  tri.v[1] = pb->v;
+  tri.v[2] = pc->v;
+
+  tri.area = (int64_t)(tri.v[1].x - tri.v[0].x) * (tri.v[2].y - tri.v[0].y) -
+    (int64_t)(tri.v[1].y - tri.v[0].y) * (tri.v[2].x - tri.v[0].x);
+
+  if (tri.area == 0)
+    return;
+
+  /* Both windings are drawn, edge functions expect a positive area */
+  if (tri.area < 0) {
+    say_raster_vertex tmp = tri.v[1];
+    tri.v[1] = tri.v[2];
+    tri.v[2] = tmp;
+
+    tri.area = -tri.area;
+  }
+
+  int32_t min_x = tri.v[0].x, max_x = tri.v[0].x;
+  int32_t min_y = tri.v[0].y, max_y = tri.v[0].y;
+
+  for (int i = 1; i < 3; i++) {
+    if (tri.v[i].x < min_x) min_x = tri.v[i].x;
+    if (tri.v[i].x > max_x) max_x = tri.v[i].x;
+    if (tri.v[i].y < min_y) min_y = tri.v[i].y;
+    if (tri.v[i].y > max_y) max_y = tri.v[i].y;
+  }
+
+  /* Pixels whose center is within the bounds of the triangle */
+  int half = SAY_RASTER_SUBPIXEL / 2;
+  tri.x0 = say_raster_floor_div(min_x - half - 1, SAY_RASTER_SUBPIXEL) + 1;
+  tri.y0 = say_raster_floor_div(min_y - half - 1, SAY_RASTER_SUBPIXEL) + 1;
+  tri.x1 = say_raster_floor_div(max_x - half, SAY_RASTER_SUBPIXEL) + 1;
+  tri.y1 = say_raster_floor_div(max_y - half, SAY_RASTER_SUBPIXEL) + 1;
+
+  /* Rendering is limited to the viewport, as clipping would */
+  say_rect vp = raster->viewport;
+  int clip_x0 = vp.x, clip_y0 = vp.y;
+  int clip_x1 = vp.x + vp.w, clip_y1 = vp.y + vp.h;
+
+  if (clip_x0 < 0) clip_x0 = 0;
+  if (clip_y0 < 0) clip_y0 = 0;
+  if (clip_x1 > (int)say_image_get_width(raster->img))
+    clip_x1 = say_image_get_width(raster->img);
+  if (clip_y1 > (int)say_image_get_height(raster->img))
+    clip_y1 = say_image_get_height(raster->img);
+
+  if (tri.x0 < clip_x0) tri.x0 = clip_x0;
+  if (tri.y0 < clip_y0) tri.y0 = clip_y0;
+  if (tri.x1 > clip_x1) tri.x1 = clip_x1;
+  if (tri.y1 > clip_y1) tri.y1 = clip_y1;
+
+  if (tri.x0 >= tri.x1 || tri.y0 >= tri.y1)
+    return;
+
+  tri.texture    = raster->textured ? raster->texture : NULL;
+  tri.alpha_only = raster->alpha_only;
+  tri.texels     = NULL;
+
+  say_array_push(raster->triangles, &tri);
+}
+
+static size_t say_raster_index(const GLuint *indices, size_t first,
+                               size_t i) {
+  return indices ? indices[i] : first + i;
+}
+
+/* Vertices are numbered by indices if it isn't NULL, from first otherwise */
+static void say_raster_assemble(say_raster *raster, GLenum mode,
+                                size_t count, const GLuint *indices,
+                                size_t first) {
+  switch (mode) {
+  case GL_TRIANGLES:
+    for (size_t i = 0; i + 3 <= count; i += 3) {
+      say_raster_push_triangle(raster,
+                               say_raster_index(indices, first, i),
+                               say_raster_index(indices, first, i + 1),
+                               say_raster_index(indices, first, i + 2));
+    }
+    break;
+  case GL_TRIANGLE_STRIP:
+    for (size_t i = 0; i + 3 <= count; i++) {
+      say_raster_push_triangle(raster,
+                               say_raster_index(indices, first, i),
+                               say_raster_index(indices, first, i + 1),
+                               say_raster_index(indices, first, i + 2));
+    }
+    break;
+  case GL_TRIANGLE_FAN:
+    for (size_t i = 1; i + 2 <= count; i++) {
+      say_raster_push_triangle(raster,
+                               say_raster_index(indices, first, 0),
+                               say_raster_index(indices, first, i),
+                               say_raster_index(indices, first, i + 1));
+    }
+    break;
+  default: /* Points and lines aren't drawn */
+    break;
+  }
+}
+
+void say_raster_draw_arrays(say_raster *raster, GLenum mode, size_t first,
+                            size_t count) {
+  say_raster_assemble(raster, mode, count, NULL, first);
+}
+
+void say_raster_draw_elements(say_raster *raster, GLenum mode, size_t count,
+                              size_t index) {
+  size_t size = say_array_get_size(raster->indices);
+  if (index >= size)
+    return;
+
+  if (count > size - index)
+    count = size - index;
+
+  GLuint *indices = say_array_get(raster->indices, index);
+  say_raster_assemble(raster, mode, count, indices, 0);
+}
+
+/*
+ * Fragment processing
+ */
+
+static uint8_t say_raster_div255(int x) {
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+static uint8_t say_raster_to_byte(float x) {
+  if (x <= 0) return 0;
+  if (x >= 1) return 255;
+  return (uint8_t)(x * 255 + 0.5f);
+}
+
+#ifdef __SSE2__
+/* Exact rounded division by 255 of products of two bytes */
+static __m128i say_raster_div255_epi16(__m128i x) {
+  x = _mm_add_epi16(x, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+#endif
+
+/*
+ * Unlike say_image_blit, the alpha channel is weighted like the other ones,
+ * since that is what glBlendFunc does.
+ */
+static void say_raster_blend_span(say_color *dst, const say_color *src,
+                                  size_t count) {
+  size_t i = 0;
+
+#ifdef __SSE2__
+  __m128i zero = _mm_setzero_si128();
+  __m128i full = _mm_set1_epi16(255);
+
+  for (; i + 4 <= count; i += 4) {
+    __m128i s = _mm_loadu_si128((const __m128i*)&src[i]);
+    __m128i d = _mm_loadu_si128((const __m128i*)&dst[i]);
+
+    __m128i s_lo = _mm_unpacklo_epi8(s, zero);
+    __m128i s_hi = _mm_unpackhi_epi8(s, zero);
+    __m128i d_lo = _mm_unpacklo_epi8(d, zero);
+    __m128i d_hi = _mm_unpackhi_epi8(d, zero);
+
+    __m128i a_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_lo, 0xff), 0xff);
+    __m128i a_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_hi, 0xff), 0xff);
+
+    __m128i r_lo = _mm_add_epi16(_mm_mullo_epi16(s_lo, a_lo),
+                                 _mm_mullo_epi16(d_lo,
+                                                 _mm_sub_epi16(full, a_lo)));
+    __m128i r_hi = _mm_add_epi16(_mm_mullo_epi16(s_hi, a_hi),
+                                 _mm_mullo_epi16(d_hi,
+                                                 _mm_sub_epi16(full, a_hi)));
+
+    _mm_storeu_si128((__m128i*)&dst[i],
+                     _mm_packus_epi16(say_raster_div255_epi16(r_lo),
+                                      say_raster_div255_epi16(r_hi)));
+  }
+#endif
+
+  for (; i < count; i++) {
+    int a = src[i].a, inv = 255 - a;
+
+    dst[i].r = say_raster_div255(src[i].r * a + dst[i].r * inv);
+    dst[i].g = say_raster_div255(src[i].g * a + dst[i].g * inv);
+    dst[i].b = say_raster_div255(src[i].b * a + dst[i].b * inv);
+    dst[i].a = say_raster_div255(src[i].a * a + dst[i].a * inv);
+  }
+}
+
+/* Textures repeat, like the default wrap mode of OpenGL */
+static size_t say_raster_wrap(long x, size_t size) {
+  long ret = x % (long)size;
+  return ret < 0 ? ret + (long)size : ret;
+}
+
+static void say_raster_sample(const say_raster_triangle *tri, float u, float v,
+                              float *out) {
+  if (!tri->smooth) {
+    say_color c = tri->texels[
+      say_raster_wrap(floorf(v * tri->tex_h), tri->tex_h) * tri->tex_w +
+      say_raster_wrap(floorf(u * tri->tex_w), tri->tex_w)];
+
+    out[0] = c.r / 255.0f;
+    out[1] = c.g / 255.0f;
+    out[2] = c.b / 255.0f;
+    out[3] = c.a / 255.0f;
+
+    return;
+  }
+
+  float fx = u * tri->tex_w - 0.5f, fy = v * tri->tex_h - 0.5f;
+  float ix = floorf(fx), iy = floorf(fy);
+  float ax = fx - ix, ay = fy - iy;
+
+  size_t x0 = say_raster_wrap(ix, tri->tex_w);
+  size_t x1 = say_raster_wrap(ix + 1, tri->tex_w);
+  size_t y0 = say_raster_wrap(iy, tri->tex_h) * tri->tex_w;
+  size_t y1 = say_raster_wrap(iy + 1, tri->tex_h) * tri->tex_w;
+
+  const say_color *c00 = &tri->texels[y0 + x0], *c10 = &tri->texels[y0 + x1];
+  const say_color *c01 = &tri->texels[y1 + x0], *c11 = &tri->texels[y1 + x1];
+
+  float w00 = (1 - ax) * (1 - ay), w10 = ax * (1 - ay);
+  float w01 = (1 - ax) * ay,       w11 = ax * ay;
+
+  out[0] = (c00->r * w00 + c10->r * w10 + c01->r * w01 + c11->r * w11) / 255;
+  out[1] = (c00->g * w00 + c10->g * w10 + c01->g * w01 + c11->g * w11) / 255;
+  out[2] = (c00->b * w00 + c10->b * w10 + c01->b * w01 + c11->b * w11) / 255;
+  out[3] = (c00->a * w00 + c10->a * w10 + c01->a * w01 + c11->a * w11) / 255;
+}
+
+static say_color say_raster_shade(const say_raster_triangle *tri,
+                                  const float *attr) {
+  float col[4] = {attr[0], attr[1], attr[2], attr[3]};
+
+  if (tri->texels) {
+    float texel[4];
+    say_raster_sample(tri, attr[4], attr[5], texel);
+
+    if (tri->alpha_only)
+      col[3] *= texel[3];
+    else {
+      for (int i = 0; i < 4; i++)
+        col[i] *= texel[i];
+    }
+  }
+
+  return say_make_color(say_raster_to_byte(col[0]), say_raster_to_byte(col[1]),
+                        say_raster_to_byte(col[2]), say_raster_to_byte(col[3]));
+}
+
+/* Draws the part of the triangle within the rect, x1/y1 excluded */
+static void say_raster_draw_triangle(const say_raster_triangle *tri,
+                                     say_color *pixels, size_t width,
+                                     int x0, int y0, int x1, int y1) {
+  if (tri->x0 > x0) x0 = tri->x0;
+  if (tri->y0 > y0) y0 = tri->y0;
+  if (tri->x1 < x1) x1 = tri->x1;
+  if (tri->y1 < y1) y1 = tri->y1;
+
+  if (x0 >= x1 || y0 >= y1)
+    return;
+
+  const say_raster_vertex *v = tri->v;
+
+  /* Edge i is opposite to vertex i, its function is its barycentric weight */
+  int64_t step_x[3], step_y[3], row[3];
+  int bias[3];
+
+  int64_t px = (int64_t)x0 * SAY_RASTER_SUBPIXEL + SAY_RASTER_SUBPIXEL / 2;
+  int64_t py = (int64_t)y0 * SAY_RASTER_SUBPIXEL + SAY_RASTER_SUBPIXEL / 2;
+
+  for (int i = 0; i < 3; i++) {
+    const say_raster_vertex *a = &v[(i + 1) % 3], *b = &v[(i + 2) % 3];
+    int64_t dx = b->x - a->x, dy = b->y - a->y;
+
+    step_x[i] = -dy * SAY_RASTER_SUBPIXEL;
+    step_y[i] = dx * SAY_RASTER_SUBPIXEL;
+    row[i]    = dx * (py - a->y) - dy * (px - a->x);
+
+    /*
+     * Pixels exactly on an edge belong to one of the two triangles sharing
+     * it, which see the edge in opposite directions.
+     */
+    bias[i] = (dy > 0 || (dy == 0 && dx < 0)) ? 1 : 0;
+  }
+
+  float inv_area = 1.0f / tri->area;
+
+  float d1[6], d2[6];
+  for (int k = 0; k < 6; k++) {
+    d1[k] = v[1].attr[k] - v[0].attr[k];
+    d2[k] = v[2].attr[k] - v[0].attr[k];
+  }
+
+  say_color span[SAY_RASTER_TILE_SIZE];
+
+  for (int y = y0; y < y1; y++) {
+    int64_t w[3] = {row[0], row[1], row[2]};
+    say_color *line = &pixels[y * width];
+
+    int start = -1;
+    size_t count = 0;
+
+    for (int x = x0; x < x1; x++) {
+      if (w[0] + bias[0] > 0 && w[1] + bias[1] > 0 && w[2] + bias[2] > 0) {
+        float b1 = w[1] * inv_area, b2 = w[2] * inv_area;
+
+        float attr[6];
+        for (int k = 0; k < 6; k++)
+          attr[k] = v[0].attr[k] + b1 * d1[k] + b2 * d2[k];
+
+        if (start < 0)
+          start = x;
+        span[count++] = say_raster_shade(tri, attr);
+      }
+      else if (start >= 0)
+        break; /* Triangles are convex, the rest of the row is outside */
+
+      for (int i = 0; i < 3; i++)
+        w[i] += step_x[i];
+    }
+
+    if (count != 0)
+      say_raster_blend_span(&line[start], span, count);
+
+    for (int i = 0; i < 3; i++)
+      row[i] += step_y[i];
+  }
+}
+
+/*
+ * Tiled drawing
+ */
+
+typedef struct {
+  say_raster_triangle *triangles;
+  size_t count;
+
+  say_color *pixels;
+  size_t width;
+
+  int x0, y0, x1, y1;
+  size_t tiles_x, tile_count;
+
+  size_t first, step;
+} say_raster_job;
+
+static void *say_raster_job_run(void *data) {
+  say_raster_job *job = data;
+
+  for (size_t t = job->first; t < job->tile_count; t += job->step) {
+    int x0 = job->x0 + (t % job->tiles_x) * SAY_RASTER_TILE_SIZE;
+    int y0 = job->y0 + (t / job->tiles_x) * SAY_RASTER_TILE_SIZE;
+    int x1 = x0 + SAY_RASTER_TILE_SIZE, y1 = y0 + SAY_RASTER_TILE_SIZE;
+
+    if (x1 > job->x1) x1 = job->x1;
+    if (y1 > job->y1) y1 = job->y1;
+
+    for (size_t i = 0; i < job->count; i++) {
+      say_raster_draw_triangle(&job->triangles[i], job->pixels, job->width,
+                               x0, y0, x1, y1);
+    }
+  }
+
+  return NULL;
+}
+
+void say_raster_flush(say_raster *raster) {
+  size_t count = say_array_get_size(raster->triangles);
+  if (count == 0)
+    return;
+
+  if (!raster->img) {
+    say_array_resize(raster->triangles, 0);
+    return;
+  }
+
+  say_raster_triangle *triangles = say_array_get(raster->triangles, 0);
+
+  int x0 = triangles[0].x0, y0 = triangles[0].y0;
+  int x1 = triangles[0].x1, y1 = triangles[0].y1;
+  size_t pixel_count = 0;
+
+  /* Textures are only read by the threads, their pixels are fetched here */
+  for (size_t i = 0; i < count; i++) {
+    say_raster_triangle *tri = &triangles[i];
+
+    if (tri->texture && say_image_get_width(tri->texture) != 0) {
+      tri->texels = say_raster_image_pixels(tri->texture);
+      tri->tex_w  = say_image_get_width(tri->texture);
+      tri->tex_h  = say_image_get_height(tri->texture);
+      tri->smooth = say_image_is_smooth(tri->texture);
+    }
+
+    if (tri->x0 < x0) x0 = tri->x0;
+    if (tri->y0 < y0) y0 = tri->y0;
+    if (tri->x1 > x1) x1 = tri->x1;
+    if (tri->y1 > y1) y1 = tri->y1;
+
+    pixel_count += (size_t)(tri->x1 - tri->x0) * (tri->y1 - tri->y0);
+  }
+
+  say_raster_job job;
+  job.triangles  = triangles;
+  job.count      = count;
+  job.pixels     = say_raster_image_pixels(raster->img);
+  job.width      = say_image_get_width(raster->img);
+  job.x0         = x0;
+  job.y0         = y0;
+  job.x1         = x1;
+  job.y1         = y1;
+  job.tiles_x    = (x1 - x0 + SAY_RASTER_TILE_SIZE - 1) / SAY_RASTER_TILE_SIZE;
+  job.tile_count = job.tiles_x *
+    ((y1 - y0 + SAY_RASTER_TILE_SIZE - 1) / SAY_RASTER_TILE_SIZE);
+
+  size_t thread_count = say_thread_get_cpu_count();
+  size_t max = pixel_count / SAY_RASTER_THREAD_PIXELS;
+
+  if (thread_count > max) thread_count = max;
+  if (thread_count > job.tile_count) thread_count = job.tile_count;
+  if (thread_count > SAY_RASTER_MAX_THREADS)
+    thread_count = SAY_RASTER_MAX_THREADS;
+
+  if (thread_count <= 1) {
+    job.first = 0;
+    job.step  = 1;
+
+    say_raster_job_run(&job);
+  }
+  else {
+    say_raster_job jobs[SAY_RASTER_MAX_THREADS];
+    say_thread *threads[SAY_RASTER_MAX_THREADS];
+
+    /* Tiles are interleaved, so that every thread gets some of the busy ones */
+    for (size_t i = 0; i < thread_count; i++) {
+      jobs[i] = job;
+      jobs[i].first = i;
+      jobs[i].step  = thread_count;
+    }
+
+    /* The calling thread takes the last job */
+    for (size_t i = 0; i < thread_count - 1; i++)
+      threads[i] = say_thread_create(&jobs[i], say_raster_job_run);
+
+    say_raster_job_run(&jobs[thread_count - 1]);
+
+    for (size_t i = 0; i < thread_count - 1; i++) {
+      say_thread_join(threads[i]);
+      say_thread_free(threads[i]);
+    }
+  }
+
+  say_image_mark_dirty(raster->img, x0, y0, x1 - x0, y1 - y0);
+  say_array_resize(raster->triangles, 0);
+}
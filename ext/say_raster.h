@@ -0,0 +1,92 @@
+#ifndef SAY_RASTER_H_
+#define SAY_RASTER_H_
+
+#include "say_image.h"
+#include "say_drawable.h"
+
+/*
+ * Software rasterizer, used by image targets instead of OpenGL when the
+ * software backend is selected. It draws the vertices produced by the fill
+ * procs of drawables, which render procs draw through say_draw_arrays and
+ * say_draw_elements.
+ *
+ * Only triangles (lists, strips and fans) of the default vertex type are
+ * supported. They are drawn with the default shading, and blended like
+ * glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA) does. Custom shaders,
+ * points, lines and the depth buffer are ignored.
+ */
+
+typedef enum {
+  SAY_BACKEND_OPENGL = 0,
+  SAY_BACKEND_SOFTWARE
+} say_backend;
+
+/*
+ * Backend used by image targets created afterwards. Defaults to software if
+ * RAY_BACKEND is set to "software".
+ */
+void say_backend_set(say_backend backend);
+say_backend say_backend_get();
+
+typedef struct {
+  int32_t x, y; /* Window coordinates, in 1/16th of a pixel */
+  float attr[6]; /* Color and texture coordinates */
+} say_raster_vertex;
+
+typedef struct {
+  say_raster_vertex v[3];
+  int64_t area;
+
+  /* Pixels covered by the triangle, x1/y1 excluded */
+  int x0, y0, x1, y1;
+
+  say_image *texture;
+  bool alpha_only;
+
+  /* Resolved before the triangles are drawn */
+  say_color *texels;
+  size_t tex_w, tex_h;
+  bool smooth;
+} say_raster_triangle;
+
+typedef struct {
+  say_image *img;
+
+  say_matrix *projection;
+  say_rect viewport; /* In window coordinates, from the bottom */
+
+  /* Vertices of the drawable being drawn */
+  say_array *vertices;
+  say_array *indices;
+  say_image *texture;
+  bool textured, alpha_only;
+
+  /* Triangles drawn by the next flush */
+  say_array *triangles;
+} say_raster;
+
+say_raster *say_raster_create();
+void say_raster_free(say_raster *raster);
+
+void say_raster_set_image(say_raster *raster, say_image *img);
+say_image *say_raster_get_image(say_raster *raster);
+
+void say_raster_set_view(say_raster *raster, say_matrix *projection,
+                         say_rect viewport);
+
+void say_raster_clear(say_raster *raster, say_color color);
+
+/* Queues the triangles of the drawable, which are drawn by say_raster_flush */
+void say_raster_draw(say_raster *raster, say_drawable *drawable);
+void say_raster_flush(say_raster *raster);
+
+/* Raster the drawable being drawn uses, NULL when it is drawn by OpenGL */
+say_raster *say_raster_current();
+
+void say_raster_bind_texture(say_raster *raster, say_image *img);
+void say_raster_draw_arrays(say_raster *raster, GLenum mode, size_t first,
+                            size_t count);
+void say_raster_draw_elements(say_raster *raster, GLenum mode, size_t count,
+                              size_t index);
+
+#endif
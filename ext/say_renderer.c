@@ -2,13 +2,25 @@
 
 say_renderer *say_renderer_create() {
   say_renderer *renderer = (say_renderer*)malloc(sizeof(say_renderer));
-  renderer->shader = say_shader_create();
-  say_renderer_reset_states(renderer);
+  renderer->shader     = say_shader_create();
+  renderer->projection = NULL;
+
+  renderer->block         = 0;
+  renderer->block_version = 0;
+
+  say_render_ctx ctx = say_render_ctx_current();
+  say_renderer_reset_states(renderer, &ctx);
 
   return renderer;
 }
 
 void say_renderer_free(say_renderer *renderer) {
+  if (renderer->block) {
+    say_context_ensure();
+    say_gl_forget_ubo(renderer->block);
+    glDeleteBuffers(1, &renderer->block);
+  }
+
   say_shader_free(renderer->shader);
   free(renderer);
 }
@@ -17,26 +29,74 @@ say_shader *say_renderer_get_shader(say_renderer *renderer) {
   return renderer->shader;
 }
 
-void say_renderer_reset_states(say_renderer *renderer) {
+void say_renderer_set_projection(say_renderer *renderer, say_matrix *matrix) {
+  renderer->projection = matrix;
+}
+
+void say_renderer_bind_block(say_renderer *renderer, say_render_ctx *ctx) {
+  if (!renderer->projection || !say_shader_uses_uniform_blocks())
+    return;
+
+  size_t size = 16 * sizeof(float);
+
+  if (!renderer->block) {
+    glGenBuffers(1, &renderer->block);
+    say_gl_state_bind_ubo(ctx->gl, renderer->block);
+    glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+  }
+
+  if (renderer->block_version != renderer->projection->version) {
+    say_gl_state_bind_ubo(ctx->gl, renderer->block);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size, renderer->projection->content);
+
+    renderer->block_version = renderer->projection->version;
+  }
+
+  say_gl_state_bind_ubo_range(ctx->gl, SAY_TARGET_BLOCK_BINDING,
+                              renderer->block, 0, size);
+}
+
+void say_renderer_reset_states(say_renderer *renderer, say_render_ctx *ctx) {
   renderer->using_texture = 0;
-  say_shader_set_int_id(renderer->shader, SAY_TEXTURE_ENABLED_LOC_ID, 0);
+  say_shader_set_int_id(renderer->shader, SAY_TEXTURE_ENABLED_LOC_ID, 0, ctx);
+}
 
+/*
+ * Unless the code of the target's shader was changed, drawables without their
+ * own shader are drawn with the variant of the default program matching their
+ * features, so no uniform needs to be toggled between them.
+ */
+static bool say_renderer_uses_variants(say_renderer *renderer) {
+  return say_shader_is_shared(renderer->shader) && renderer->projection;
 }
-void say_renderer_push(say_renderer *renderer, say_drawable *drawable) {
-  if (!drawable->shader &&
+
+void say_renderer_push(say_renderer *renderer, say_drawable *drawable,
+                       say_render_ctx *ctx) {
+  say_shader *custom = say_drawable_get_custom_shader(drawable);
+
+  if (!custom && say_renderer_uses_variants(renderer)) {
+    uint8_t features = say_drawable_get_shader_features(drawable);
+    say_shader *variant = say_shader_get_default_variant(features);
+
+    say_shader_set_projection(variant, renderer->projection, ctx);
+    say_drawable_draw(drawable, variant, ctx);
+    return;
+  }
+
+  if (!custom &&
       renderer->using_texture != say_drawable_is_textured(drawable)) {
-    renderer->using_texture = !(renderer->using_texture);
+    renderer->using_texture = say_drawable_is_textured(drawable);
     say_shader_set_int_id(renderer->shader, SAY_TEXTURE_ENABLED_LOC_ID,
-                          renderer->using_texture);
+                          renderer->using_texture, ctx);
   }
 
-  say_drawable_draw(drawable, renderer->shader);
+  say_drawable_draw(drawable, renderer->shader, ctx);
 }
 
 void say_renderer_push_buffer(say_renderer *renderer,
-                              say_buffer_renderer *buf) {
-  say_buffer_renderer_render(buf, renderer->shader);
+                              say_buffer_renderer *buf, say_render_ctx *ctx) {
+  say_buffer_renderer_render(buf, renderer->shader, ctx);
 
   renderer->using_texture = 0;
-  say_shader_set_int_id(renderer->shader, SAY_TEXTURE_ENABLED_LOC_ID, 0);
+  say_shader_set_int_id(renderer->shader, SAY_TEXTURE_ENABLED_LOC_ID, 0, ctx);
 }
@@ -7,6 +7,13 @@
 typedef struct {
   say_shader *shader;
   uint8_t using_texture;
+
+  /* Projection of the target, used by the default shader variants */
+  say_matrix *projection;
+
+  /* Uniform buffer for the target block, and version of the matrix in it */
+  GLuint block;
+  uint64_t block_version;
 } say_renderer;
 
 say_renderer *say_renderer_create();
@@ -14,9 +21,18 @@ void say_renderer_free(say_renderer *renderer);
 
 say_shader *say_renderer_get_shader(say_renderer *renderer);
 
-void say_renderer_reset_states(say_renderer *renderer);
-void say_renderer_push(say_renderer *renderer, say_drawable *drawable);
+void say_renderer_set_projection(say_renderer *renderer, say_matrix *matrix);
+
+/*
+ * Binds the target block, uploading the projection first if it changed. Does
+ * nothing if uniform blocks aren't available.
+ */
+void say_renderer_bind_block(say_renderer *renderer, say_render_ctx *ctx);
+
+void say_renderer_reset_states(say_renderer *renderer, say_render_ctx *ctx);
+void say_renderer_push(say_renderer *renderer, say_drawable *drawable,
+                       say_render_ctx *ctx);
 void say_renderer_push_buffer(say_renderer *renderer,
-                              say_buffer_renderer *buf);
+                              say_buffer_renderer *buf, say_render_ctx *ctx);
 
 #endif
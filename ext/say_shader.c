@@ -1,26 +1,36 @@
 #include "say.h"
 
-static GLuint say_current_program = 0;
-static say_context *say_shader_last_context = NULL;
-
-static void say_shader_make_current(GLuint program) {
-  say_context *context = say_context_current();
-
-  if (context != say_shader_last_context ||
-      program != say_current_program) {
-    say_current_program     = program;
-    say_shader_last_context = context;
-
-    glUseProgramObjectARB(program);
-  }
+#ifndef SAY_WIN
+# include <sys/time.h>
+#endif
+
+static double say_shader_compile_time = 0;
+static size_t say_shader_link_count   = 0;
+
+static double say_shader_now() {
+#ifdef SAY_WIN
+  LARGE_INTEGER freq, count;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&count);
+
+  return (double)count.QuadPart / freq.QuadPart;
+#else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+#endif
 }
 
-static int say_shader_create_shader(GLuint shader, const char *src) {
+/* Sends the code of a shader object to the driver, without waiting for it */
+static void say_shader_source(GLuint shader, const char *src) {
   GLint length = strlen(src);
   glShaderSourceARB(shader, 1, &src, &length);
 
   glCompileShaderARB(shader);
+}
 
+static int say_shader_check_compile(GLuint shader) {
   GLint worked = 0;
   glGetObjectParameterivARB(shader, GL_OBJECT_COMPILE_STATUS_ARB, &worked);
 
@@ -41,6 +51,38 @@ static int say_shader_create_shader(GLuint shader, const char *src) {
   return worked;
 }
 
+static int say_shader_create_shader(GLuint shader, const char *src) {
+  double start = say_shader_now();
+
+  say_shader_source(shader, src);
+  int worked = say_shader_check_compile(shader);
+
+  say_shader_compile_time += say_shader_now() - start;
+
+  return worked;
+}
+
+static int say_shader_check_link(GLuint program) {
+  GLint worked = 0;
+  glGetObjectParameterivARB(program, GL_OBJECT_LINK_STATUS_ARB, &worked);
+
+  if (!worked) {
+    GLint error_length = 0;
+    glGetObjectParameterivARB(program, GL_OBJECT_INFO_LOG_LENGTH_ARB,
+                              &error_length);
+
+    char *error = malloc((error_length + 1) * sizeof(char));
+    memset(error, '\0', (error_length + 1) * sizeof(char));
+
+    glGetInfoLogARB(program, error_length, &error_length, error);
+    say_error_set(error);
+
+    free(error);
+  }
+
+  return worked;
+}
+
 static void say_shader_find_locations(say_shader *shader) {
   shader->locations[SAY_PROJECTION_LOC_ID] =
     glGetUniformLocationARB(shader->program, SAY_PROJECTION_ATTR);
@@ -51,6 +93,22 @@ static void say_shader_find_locations(say_shader *shader) {
     glGetUniformLocationARB(shader->program, SAY_TEXTURE_ATTR);
   shader->locations[SAY_TEXTURE_ENABLED_LOC_ID] =
     glGetUniformLocationARB(shader->program, SAY_TEXTURE_ENABLED_ATTR);
+
+  shader->blocks = 0;
+  if (say_shader_uses_uniform_blocks()) {
+    GLuint index = glGetUniformBlockIndex(shader->program, SAY_TARGET_BLOCK);
+    if (index != GL_INVALID_INDEX) {
+      glUniformBlockBinding(shader->program, index, SAY_TARGET_BLOCK_BINDING);
+      shader->blocks |= SAY_SHADER_TARGET_BLOCK;
+    }
+
+    index = glGetUniformBlockIndex(shader->program, SAY_DRAWABLE_BLOCK);
+    if (index != GL_INVALID_INDEX) {
+      glUniformBlockBinding(shader->program, index,
+                            SAY_DRAWABLE_BLOCK_BINDING);
+      shader->blocks |= SAY_SHADER_DRAWABLE_BLOCK;
+    }
+  }
 }
 
 static const char *say_default_frag_shader =
@@ -63,10 +121,19 @@ static const char *say_default_frag_shader =
   "varying vec2 var_TexCoord;\n"
   "\n"
   "void main() {\n"
+  "#if defined(SAY_TEXTURED) && defined(SAY_ALPHA_ONLY)\n"
+  "  float alpha = texture2D(in_Texture, var_TexCoord).a;\n"
+  "  gl_FragColor = vec4(var_Color.rgb, var_Color.a * alpha);\n"
+  "#elif defined(SAY_TEXTURED)\n"
+  "  gl_FragColor = texture2D(in_Texture, var_TexCoord) * var_Color;\n"
+  "#elif defined(SAY_COLOR_ONLY)\n"
+  "  gl_FragColor = var_Color;\n"
+  "#else\n"
   "  if (in_TextureEnabled)\n"
   "    gl_FragColor = texture2D(in_Texture, var_TexCoord) * var_Color;\n"
   "  else\n"
   "    gl_FragColor = var_Color;\n"
+  "#endif\n"
   "}\n";
 
 static const char *say_default_vertex_shader =
@@ -100,10 +167,19 @@ static const char *say_new_default_frag_shader =
   "out vec4 out_FragColor;\n"
   "\n"
   "void main() {\n"
+  "#if defined(SAY_TEXTURED) && defined(SAY_ALPHA_ONLY)\n"
+  "  float alpha = texture2D(in_Texture, var_TexCoord).a;\n"
+  "  out_FragColor = vec4(var_Color.rgb, var_Color.a * alpha);\n"
+  "#elif defined(SAY_TEXTURED)\n"
+  "  out_FragColor = texture2D(in_Texture, var_TexCoord) * var_Color;\n"
+  "#elif defined(SAY_COLOR_ONLY)\n"
+  "  out_FragColor = var_Color;\n"
+  "#else\n"
   "  if (in_TextureEnabled)\n"
   "    out_FragColor = texture2D(in_Texture, var_TexCoord) * var_Color;\n"
   "  else\n"
   "    out_FragColor = var_Color;\n"
+  "#endif\n"
   "}\n";
 
 static const char *say_new_default_vertex_shader =
@@ -113,8 +189,18 @@ static const char *say_new_default_vertex_shader =
   "in vec4 in_Color;\n"
   "in vec2 in_TexCoord;\n"
   "\n"
+  "#ifdef SAY_UNIFORM_BLOCKS\n"
+  "layout(std140) uniform in_TargetBlock {\n"
+  "  mat4 in_Projection;\n"
+  "};\n"
+  "\n"
+  "layout(std140) uniform in_DrawableBlock {\n"
+  "  mat4 in_ModelView;\n"
+  "};\n"
+  "#else\n"
   "uniform mat4 in_ModelView;\n"
   "uniform mat4 in_Projection;\n"
+  "#endif\n"
   "\n"
   "out vec4 var_Color;\n"
   "out vec2 var_TexCoord;\n"
@@ -142,22 +228,106 @@ bool say_shader_is_geometry_available() {
   return __GLEW_ARB_geometry_shader4 != 0;
 }
 
-say_shader *say_shader_create() {
+static const char *say_shader_default_frag() {
+  return say_shader_use_new ? say_new_default_frag_shader :
+    say_default_frag_shader;
+}
+
+static char *say_shader_add_defines(const char *src, const char *defines);
+
+bool say_shader_uses_uniform_blocks() {
   say_context_ensure();
+  return say_shader_use_new && __GLEW_ARB_uniform_buffer_object;
+}
+
+static const char *say_shader_default_vertex() {
+  if (!say_shader_use_new)
+    return say_default_vertex_shader;
+
+  /* Matrices are read from uniform blocks when they're available */
+  static char *block_vertex_shader = NULL;
+  if (say_shader_uses_uniform_blocks()) {
+    if (!block_vertex_shader) {
+      block_vertex_shader =
+        say_shader_add_defines(say_new_default_vertex_shader,
+                               "#define SAY_UNIFORM_BLOCKS\n");
+    }
+
+    return block_vertex_shader;
+  }
+
+  return say_new_default_vertex_shader;
+}
+
+/*
+ * Returns a copy of src where defines are inserted right after the #version
+ * directive, which must stay the first statement of the source.
+ */
+static char *say_shader_add_defines(const char *src, const char *defines) {
+  size_t header = 0;
+  bool need_eol = false;
+
+  const char *version = strstr(src, "#version");
+  if (version) {
+    const char *eol = strchr(version, '\n');
+    if (eol)
+      header = eol - src + 1;
+    else {
+      header   = strlen(src);
+      need_eol = true;
+    }
+  }
+
+  size_t defines_size = strlen(defines);
+  size_t size = strlen(src) + defines_size + (need_eol ? 1 : 0);
+
+  char *ret = malloc(size + 1);
+  char *it  = ret;
+
+  memcpy(it, src, header);
+  it += header;
+
+  if (need_eol)
+    *(it++) = '\n';
 
-  say_shader *shader = (say_shader*)malloc(sizeof(say_shader));
+  memcpy(it, defines, defines_size);
+  it += defines_size;
 
+  strcpy(it, src + header);
+
+  return ret;
+}
+
+/* Replaces the source remembered in *field, so variants can be built from it */
+static void say_shader_store_source(char **field, const char *src) {
+  free(*field);
+  *field = src ? say_strdup(src) : NULL;
+}
+
+/*
+ * Creates the program objects of a shader, using the default code, with the
+ * given #define lines if defines isn't NULL. The program is linked, but its
+ * uniforms aren't set.
+ */
+static void say_shader_build_default(say_shader *shader, const char *defines) {
   shader->frag_shader     = glCreateShaderObjectARB(GL_FRAGMENT_SHADER_ARB);
   shader->vertex_shader   = glCreateShaderObjectARB(GL_VERTEX_SHADER_ARB);
   shader->geometry_shader = 0;
 
-  if (!say_shader_use_new) {
-    say_shader_compile_frag(shader, say_default_frag_shader);
-    say_shader_compile_vertex(shader, say_default_vertex_shader);
+  if (defines) {
+    char *frag   = say_shader_add_defines(say_shader_default_frag(), defines);
+    char *vertex = say_shader_add_defines(say_shader_default_vertex(), defines);
+
+    say_shader_create_shader(shader->frag_shader, frag);
+    say_shader_create_shader(shader->vertex_shader, vertex);
+
+    free(frag);
+    free(vertex);
   }
   else {
-    say_shader_compile_frag(shader, say_new_default_frag_shader);
-    say_shader_compile_vertex(shader, say_new_default_vertex_shader);
+    say_shader_create_shader(shader->frag_shader, say_shader_default_frag());
+    say_shader_create_shader(shader->vertex_shader,
+                             say_shader_default_vertex());
   }
 
   shader->program = glCreateProgramObjectARB();
@@ -165,16 +335,26 @@ say_shader *say_shader_create() {
   glAttachObjectARB(shader->program, shader->frag_shader);
   glAttachObjectARB(shader->program, shader->vertex_shader);
 
-  say_shader_apply_vertex_type(shader, 0);
+  say_vertex_type *type = say_get_vertex_type(0);
+  for (size_t i = 0; i < say_vertex_type_get_elem_count(type); i++) {
+    glBindAttribLocationARB(shader->program, i,
+                            say_vertex_type_get_name(type, i));
+  }
 
   if (say_shader_use_new) {
     glBindFragDataLocationEXT(shader->program, 0, SAY_FRAG_COLOR);
   }
 
+  double start = say_shader_now();
   glLinkProgramARB(shader->program);
+  say_shader_compile_time += say_shader_now() - start;
+  say_shader_link_count++;
 
+  shader->uniforms = say_uniform_cache_create();
   say_shader_find_locations(shader);
+}
 
+static void say_shader_init_uniforms(say_shader *shader) {
   say_matrix *identity = say_matrix_identity();
   say_shader_set_matrix(shader, SAY_MODEL_VIEW_ATTR, identity);
   say_shader_set_matrix(shader, SAY_PROJECTION_ATTR, identity);
@@ -183,31 +363,173 @@ say_shader *say_shader_create() {
   say_shader_set_current_texture(shader, SAY_TEXTURE_ATTR);
 
   /* Weirldy, setting this avoid errors when setting uniforms */
-  say_shader_make_current(0);
+  say_gl_use_program(0);
+}
+
+static say_shader *say_shader_alloc() {
+  say_shader *shader = malloc(sizeof(say_shader));
+
+  shader->frag_src     = NULL;
+  shader->vertex_src   = NULL;
+  shader->geometry_src = NULL;
+  shader->vtype        = 0;
+  shader->variants     = NULL;
+
+  shader->blocks    = 0;
+  shader->status    = SAY_SHADER_LINKED;
+  shader->error     = NULL;
+  shader->cache_key = 0;
+  shader->stale     = false;
+  shader->unchecked = false;
 
   return shader;
 }
 
-void say_shader_free(say_shader *shader) {
+/* Builds a program from the default code that is never freed */
+static say_shader *say_shader_build_static(const char *defines) {
+  say_shader *shader = say_shader_alloc();
+  shader->shared = false;
+
+  say_shader_build_default(shader, defines);
+  say_shader_init_uniforms(shader);
+
+  return shader;
+}
+
+/*
+ * Every context shares its objects with the others, so the default program
+ * only needs to be compiled once. It lives as long as the process; each target
+ * sets the uniforms it needs when it is bound.
+ */
+static say_shader *say_default_shader = NULL;
+
+static say_shader *say_shader_get_default() {
+  if (!say_default_shader)
+    say_default_shader = say_shader_build_static(NULL);
+
+  return say_default_shader;
+}
+
+/*
+ * Specializations of the default program, which don't need to check whether
+ * a texture is used for each fragment. Like the default program, they are
+ * built once, when first needed.
+ */
+static say_shader *say_default_variants[SAY_SHADER_FEATURE_COUNT] = {NULL};
+
+say_shader *say_shader_get_default_variant(uint8_t features) {
+  if (!(features & SAY_SHADER_TEXTURED))
+    features = 0;
+
+  if (!say_default_variants[features]) {
+    say_context_ensure();
+
+    const char *defines;
+    if (!(features & SAY_SHADER_TEXTURED))
+      defines = "#define SAY_COLOR_ONLY\n";
+    else if (features & SAY_SHADER_ALPHA_ONLY)
+      defines = "#define SAY_TEXTURED\n#define SAY_ALPHA_ONLY\n";
+    else
+      defines = "#define SAY_TEXTURED\n";
+
+    say_default_variants[features] = say_shader_build_static(defines);
+  }
+
+  return say_default_variants[features];
+}
+
+/* Gives its own program to a shader before its code is changed */
+static void say_shader_make_own(say_shader *shader) {
+  if (!shader->shared)
+    return;
+
+  shader->shared = false;
+
+  say_shader_build_default(shader, NULL);
+  say_shader_init_uniforms(shader);
+}
+
+say_shader *say_shader_create() {
   say_context_ensure();
 
-  glDeleteObjectARB(shader->frag_shader);
-  glDeleteObjectARB(shader->vertex_shader);
+  say_shader *shader = say_shader_alloc();
+  say_shader *default_shader = say_shader_get_default();
+
+  shader->program         = default_shader->program;
+  shader->frag_shader     = default_shader->frag_shader;
+  shader->vertex_shader   = default_shader->vertex_shader;
+  shader->geometry_shader = default_shader->geometry_shader;
+  shader->uniforms        = default_shader->uniforms;
+  shader->blocks          = default_shader->blocks;
+
+  memcpy(shader->locations, default_shader->locations,
+         sizeof(shader->locations));
+
+  shader->shared = true;
+
+  return shader;
+}
+
+bool say_shader_is_shared(say_shader *shader) {
+  return shader->shared;
+}
+
+void say_shader_free(say_shader *shader) {
+  if (shader->variants) {
+    for (size_t i = 0; i < say_array_get_size(shader->variants); i++) {
+      say_shader_variant *variant = say_array_get(shader->variants, i);
+      free(variant->defines);
+      say_shader_free(variant->shader);
+    }
+
+    say_array_free(shader->variants);
+  }
+
+  if (!shader->shared) {
+    say_context_ensure();
 
-  say_shader_detach_geometry(shader);
+    glDeleteObjectARB(shader->frag_shader);
+    glDeleteObjectARB(shader->vertex_shader);
+
+    say_shader_detach_geometry(shader);
+
+    say_gl_forget_program(shader->program);
+    glDeleteObjectARB(shader->program);
+
+    say_uniform_cache_free(shader->uniforms);
+  }
 
-  glDeleteObjectARB(shader->program);
+  free(shader->frag_src);
+  free(shader->vertex_src);
+  free(shader->geometry_src);
+  free(shader->error);
 
   free(shader);
 }
 
+double say_shader_get_compile_time() {
+  return say_shader_compile_time;
+}
+
+size_t say_shader_get_link_count() {
+  return say_shader_link_count;
+}
+
+size_t say_shader_get_elided_upload_count() {
+  return say_uniform_cache_get_elided_count();
+}
+
 bool say_shader_compile_frag(say_shader *shader, const char *src) {
   say_context_ensure();
+  say_shader_make_own(shader);
+  say_shader_store_source(&shader->frag_src, src);
   return say_shader_create_shader(shader->frag_shader, src);
 }
 
 bool say_shader_compile_vertex(say_shader *shader, const char *src) {
   say_context_ensure();
+  say_shader_make_own(shader);
+  say_shader_store_source(&shader->vertex_src, src);
   return say_shader_create_shader(shader->vertex_shader, src);
 }
 
@@ -218,6 +540,9 @@ bool say_shader_compile_geometry(say_shader *shader, const char *src) {
     return false;
   }
 
+  say_shader_make_own(shader);
+  say_shader_store_source(&shader->geometry_src, src);
+
   shader->geometry_shader = glCreateShaderObjectARB(GL_GEOMETRY_SHADER_ARB);
   glAttachObjectARB(shader->program, shader->geometry_shader);
   return say_shader_create_shader(shader->geometry_shader, src);
@@ -230,11 +555,15 @@ void say_shader_detach_geometry(say_shader *shader) {
     glDeleteObjectARB(shader->geometry_shader);
     shader->geometry_shader = 0;
   }
+
+  say_shader_store_source(&shader->geometry_src, NULL);
 }
 
 void say_shader_apply_vertex_type(say_shader *shader, size_t vtype) {
   say_context_ensure();
+  say_shader_make_own(shader);
 
+  shader->vtype = vtype;
   say_vertex_type *type = say_get_vertex_type(vtype);
 
   for (size_t i = 0; i < say_vertex_type_get_elem_count(type); i++) {
@@ -243,105 +572,460 @@ void say_shader_apply_vertex_type(say_shader *shader, size_t vtype) {
   }
 }
 
+static bool say_shader_rebuild_variants(say_shader *shader);
+
+/*
+ * Sends the code last given for each stage to its shader object. Compile
+ * errors are only checked by say_shader_check_stages.
+ */
+static void say_shader_compile_stages(say_shader *shader) {
+  say_shader_source(shader->vertex_shader, shader->vertex_src ?
+                    shader->vertex_src : say_shader_default_vertex());
+  say_shader_source(shader->frag_shader, shader->frag_src ?
+                    shader->frag_src : say_shader_default_frag());
+
+  if (shader->geometry_src) {
+    if (!shader->geometry_shader) {
+      shader->geometry_shader = glCreateShaderObjectARB(GL_GEOMETRY_SHADER_ARB);
+      glAttachObjectARB(shader->program, shader->geometry_shader);
+    }
+
+    say_shader_source(shader->geometry_shader, shader->geometry_src);
+  }
+
+  shader->stale = false;
+}
+
+static bool say_shader_check_stages(say_shader *shader) {
+  return say_shader_check_compile(shader->vertex_shader) &&
+    say_shader_check_compile(shader->frag_shader) &&
+    (!shader->geometry_shader ||
+     say_shader_check_compile(shader->geometry_shader));
+}
+
+/* Keeps the error that was just reported, for when the shader is bound */
+static void say_shader_set_status(say_shader *shader,
+                                  say_shader_status status) {
+  shader->status = status;
+
+  free(shader->error);
+  shader->error = NULL;
+
+  if (status != SAY_SHADER_LINKED && status != SAY_SHADER_PENDING) {
+    const char *error = say_error_get_last();
+    shader->error = say_strdup(error ? error : "could not build shader");
+  }
+}
+
+/* Called once the program was linked successfully */
+static bool say_shader_linked(say_shader *shader) {
+  say_shader_find_locations(shader);
+
+  if (shader->variants)
+    return say_shader_rebuild_variants(shader);
+
+  return true;
+}
+
 int say_shader_link(say_shader *shader) {
   say_context_ensure();
+  say_shader_make_own(shader);
+
+  /* The program was loaded from the cache: its shader objects are outdated */
+  if (shader->stale) {
+    say_shader_compile_stages(shader);
+    if (!say_shader_check_stages(shader)) {
+      say_shader_set_status(shader, SAY_SHADER_COMPILE_FAILED);
+      return 0;
+    }
+  }
+
+  double start = say_shader_now();
   glLinkProgram(shader->program);
+  say_shader_compile_time += say_shader_now() - start;
+  say_shader_link_count++;
 
-  GLint worked = 0;
-  glGetObjectParameterivARB(shader->program, GL_OBJECT_LINK_STATUS_ARB, &worked);
+  /* Linking resets uniforms, and may move them */
+  say_uniform_cache_clear(shader->uniforms);
 
-  if (!worked) {
-    GLint error_length = 0;
-    glGetObjectParameterivARB(shader->program, GL_OBJECT_INFO_LOG_LENGTH_ARB,
-                              &error_length);
+  int worked = say_shader_check_link(shader->program);
+  if (worked)
+    worked = say_shader_linked(shader);
 
-    char *error = malloc((error_length + 1) * sizeof(char));
-    memset(error, '\0', (error_length + 1) * sizeof(char));
+  say_shader_set_status(shader, worked ? SAY_SHADER_LINKED :
+                        SAY_SHADER_LINK_FAILED);
+  return worked;
+}
 
-    glGetInfoLogARB(shader->program, error_length, &error_length, error);
-    say_error_set(error);
+/* Stages and attributes of the program, as used to look it up in the cache */
+static uint64_t say_shader_cache_key_of(say_shader *shader) {
+  say_vertex_type *type = say_get_vertex_type(shader->vtype);
+  size_t attr_count = say_vertex_type_get_elem_count(type);
 
-    free(error);
+  size_t count = 4 + attr_count;
+  const char **sources = malloc(sizeof(const char*) * count);
+
+  sources[0] = say_shader_use_new ? "glsl 140" : "glsl 110";
+  sources[1] = shader->vertex_src ? shader->vertex_src :
+    say_shader_default_vertex();
+  sources[2] = shader->frag_src ? shader->frag_src : say_shader_default_frag();
+  sources[3] = shader->geometry_src;
+
+  for (size_t i = 0; i < attr_count; i++)
+    sources[4 + i] = say_vertex_type_get_name(type, i);
+
+  uint64_t key = say_shader_cache_key(sources, count);
+  free(sources);
+
+  return key;
+}
+
+say_shader_status say_shader_build(say_shader *shader, const char *vertex,
+                                   const char *frag, const char *geometry,
+                                   bool async) {
+  say_context_ensure();
+  if (geometry && !__GLEW_ARB_geometry_shader4) {
+    say_error_set("geometry shaders aren't available");
+    return SAY_SHADER_COMPILE_FAILED;
+  }
+
+  say_shader_make_own(shader);
+
+  if (vertex)
+    say_shader_store_source(&shader->vertex_src, vertex);
+  if (frag)
+    say_shader_store_source(&shader->frag_src, frag);
+  if (geometry)
+    say_shader_store_source(&shader->geometry_src, geometry);
+
+  double start = say_shader_now();
+
+  say_uniform_cache_clear(shader->uniforms);
+
+  shader->cache_key = say_shader_cache_key_of(shader);
+  say_shader_set_status(shader, SAY_SHADER_PENDING);
+
+  if (say_shader_cache_load(shader->cache_key, shader->program)) {
+    /* Only compiled if the program needs to be linked again */
+    shader->stale     = true;
+    shader->unchecked = false;
+    async = false;
+  }
+  else {
+#ifdef GL_KHR_parallel_shader_compile
+    if (async && __GLEW_KHR_parallel_shader_compile)
+      glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+#endif
+
+    say_shader_compile_stages(shader);
+
+    say_shader_cache_prepare(shader->program);
+    glLinkProgram(shader->program);
+    say_shader_link_count++;
+
+    shader->unchecked = true;
+  }
+
+  say_shader_compile_time += say_shader_now() - start;
+
+  return async ? SAY_SHADER_PENDING : say_shader_wait(shader);
+}
+
+bool say_shader_is_ready(say_shader *shader) {
+  if (shader->status != SAY_SHADER_PENDING)
+    return true;
+
+#ifdef GL_KHR_parallel_shader_compile
+  if (__GLEW_KHR_parallel_shader_compile) {
+    say_context_ensure();
+
+    GLint done = GL_FALSE;
+    glGetProgramiv(shader->program, GL_COMPLETION_STATUS_KHR, &done);
+
+    return done == GL_TRUE;
+  }
+#endif
+
+  /* There is no way to know without waiting */
+  return true;
+}
+
+say_shader_status say_shader_wait(say_shader *shader) {
+  if (shader->status != SAY_SHADER_PENDING)
+    return shader->status;
+
+  say_context_ensure();
+
+  double start = say_shader_now();
+
+  if (shader->unchecked) {
+    shader->unchecked = false;
+
+    if (!say_shader_check_stages(shader))
+      say_shader_set_status(shader, SAY_SHADER_COMPILE_FAILED);
+    else if (!say_shader_check_link(shader->program))
+      say_shader_set_status(shader, SAY_SHADER_LINK_FAILED);
+    else
+      say_shader_cache_store(shader->cache_key, shader->program);
+  }
+
+  if (shader->status == SAY_SHADER_PENDING) {
+    say_shader_set_status(shader, say_shader_linked(shader) ?
+                          SAY_SHADER_LINKED : SAY_SHADER_COMPILE_FAILED);
+  }
+
+  say_shader_compile_time += say_shader_now() - start;
+
+  return shader->status;
+}
+
+say_shader_status say_shader_get_status(say_shader *shader) {
+  return shader->status;
+}
+
+/*
+ * Builds variant from the code of shader, with the given #define lines. The
+ * default code is used for the stages shader has no code for.
+ */
+static bool say_shader_build_variant(say_shader *variant, say_shader *shader,
+                                     const char *defines) {
+  const char *frag = shader->frag_src ? shader->frag_src :
+    say_shader_default_frag();
+  const char *vertex = shader->vertex_src ? shader->vertex_src :
+    say_shader_default_vertex();
+
+  char *src = say_shader_add_defines(frag, defines);
+  bool worked = say_shader_compile_frag(variant, src);
+  free(src);
+
+  if (worked) {
+    src = say_shader_add_defines(vertex, defines);
+    worked = say_shader_compile_vertex(variant, src);
+    free(src);
+  }
+
+  say_shader_detach_geometry(variant);
+  if (worked && shader->geometry_src) {
+    src = say_shader_add_defines(shader->geometry_src, defines);
+    worked = say_shader_compile_geometry(variant, src);
+    free(src);
+  }
+
+  if (!worked)
+    return false;
+
+  say_shader_apply_vertex_type(variant, shader->vtype);
+  return say_shader_link(variant);
+}
+
+/* Variants are kept up to date with the code of their shader */
+static bool say_shader_rebuild_variants(say_shader *shader) {
+  bool worked = true;
+
+  for (size_t i = 0; i < say_array_get_size(shader->variants); i++) {
+    say_shader_variant *variant = say_array_get(shader->variants, i);
+    if (!say_shader_build_variant(variant->shader, shader, variant->defines))
+      worked = false;
   }
-  else
-    say_shader_find_locations(shader);
 
   return worked;
 }
 
+static bool say_shader_is_key_char(char c, bool first) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' ||
+    (!first && c >= '0' && c <= '9');
+}
+
+/* Keys are defined as macros, and must thus be valid identifiers */
+static bool say_shader_is_valid_key(const char *key) {
+  if (!say_shader_is_key_char(*key, true))
+    return false;
+
+  for (key++; *key; key++) {
+    if (!say_shader_is_key_char(*key, false))
+      return false;
+  }
+
+  return true;
+}
+
+static char *say_shader_make_defines(const char **keys, size_t count) {
+  size_t size = 1;
+  for (size_t i = 0; i < count; i++) {
+    if (!say_shader_is_valid_key(keys[i])) {
+      say_error_set("invalid shader variant key");
+      return NULL;
+    }
+
+    size += strlen("#define \n") + strlen(keys[i]);
+  }
+
+  char *defines = malloc(size);
+  defines[0] = '\0';
+
+  for (size_t i = 0; i < count; i++) {
+    strcat(defines, "#define ");
+    strcat(defines, keys[i]);
+    strcat(defines, "\n");
+  }
+
+  return defines;
+}
+
+say_shader *say_shader_get_variant(say_shader *shader, const char **keys,
+                                   size_t count) {
+  char *defines = say_shader_make_defines(keys, count);
+  if (!defines)
+    return NULL;
+
+  if (!shader->variants) {
+    shader->variants = say_array_create(sizeof(say_shader_variant), NULL,
+                                        NULL);
+  }
+
+  for (size_t i = 0; i < say_array_get_size(shader->variants); i++) {
+    say_shader_variant *variant = say_array_get(shader->variants, i);
+    if (strcmp(variant->defines, defines) == 0) {
+      free(defines);
+      return variant->shader;
+    }
+  }
+
+  say_shader *built = say_shader_create();
+  if (!say_shader_build_variant(built, shader, defines)) {
+    say_shader_free(built);
+    free(defines);
+    return NULL;
+  }
+
+  say_shader_variant variant = {defines, built};
+  say_array_push(shader->variants, &variant);
+
+  return built;
+}
+
+static void say_shader_set_int_loc(say_shader *shader, int loc, int val);
+
 void say_shader_set_matrix(say_shader *shader, const char *name,
                            say_matrix *matrix) {
-  say_shader_bind(shader);
-  GLint location = glGetUniformLocationARB(shader->program, name);
-  glUniformMatrix4fvARB(location, 1, GL_FALSE, matrix->content);
+  say_shader_set_matrix_loc(shader, say_shader_locate(shader, name), matrix);
 }
 
 void say_shader_set_current_texture(say_shader *shader, const char *name) {
-  say_shader_bind(shader);
-  GLint location = glGetUniformLocationARB(shader->program, name);
-  glUniform1iARB(location, 0);
+  say_shader_set_current_texture_loc(shader, say_shader_locate(shader, name));
 }
 
 void say_shader_set_int(say_shader *shader, const char *name, int val) {
-  say_shader_bind(shader);
-  GLint location = glGetUniformLocationARB(shader->program, name);
-  glUniform1iARB(location, val);
+  say_shader_set_int_loc(shader, say_shader_locate(shader, name), val);
 }
 
+/*
+ * The shader is bound even if the value didn't change: drawables rely on this
+ * to draw using it.
+ */
 void say_shader_set_matrix_id(say_shader *shader, say_attr_loc_id id,
-                              say_matrix *matrix) {
-  say_shader_bind(shader);
-  glUniformMatrix4fvARB(shader->locations[id], 1, GL_FALSE, matrix->content);
-}
+                              say_matrix *matrix, say_render_ctx *ctx) {
+  if (!say_shader_bind_ctx(shader, ctx))
+    return;
 
-void say_shader_set_current_texture_id(say_shader *shader, say_attr_loc_id id) {
-  say_shader_bind(shader);
-  glUniform1iARB(shader->locations[id], 0);
+  GLint loc = shader->locations[id];
+  if (say_uniform_cache_update_matrix(shader->uniforms, loc, matrix->version))
+    glUniformMatrix4fvARB(loc, 1, GL_FALSE, matrix->content);
 }
 
-void say_shader_set_int_id(say_shader *shader, say_attr_loc_id id, int val) {
-  say_shader_bind(shader);
-  glUniform1iARB(shader->locations[id], val);
+void say_shader_set_projection(say_shader *shader, say_matrix *matrix,
+                               say_render_ctx *ctx) {
+  if (shader->blocks & SAY_SHADER_TARGET_BLOCK)
+    say_shader_bind_ctx(shader, ctx);
+  else
+    say_shader_set_matrix_id(shader, SAY_PROJECTION_LOC_ID, matrix, ctx);
 }
 
-void say_shader_bind(say_shader *shader) {
-  say_context_ensure();
-  say_shader_make_current(shader->program);
+void say_shader_set_model_view(say_shader *shader, say_matrix *matrix,
+                               say_render_ctx *ctx) {
+  if (shader->blocks & SAY_SHADER_DRAWABLE_BLOCK) {
+    if (!say_shader_bind_ctx(shader, ctx))
+      return;
+
+    say_uniform_stream_bind_matrix(say_uniform_stream_get(),
+                                   SAY_DRAWABLE_BLOCK_BINDING, matrix, ctx);
+  }
+  else
+    say_shader_set_matrix_id(shader, SAY_MODEL_VIEW_LOC_ID, matrix, ctx);
 }
 
-int say_shader_locate(say_shader *shader, const char *name) {
-  return glGetUniformLocationARB(shader->program, name);
+void say_shader_set_current_texture_id(say_shader *shader, say_attr_loc_id id,
+                                       say_render_ctx *ctx) {
+  say_shader_set_int_id(shader, id, 0, ctx);
 }
 
-void say_shader_set_vector2_loc(say_shader *shader, int loc, say_vector2 val) {
-  say_shader_bind(shader);
-  glUniform2fARB(loc, val.x, val.y);
+void say_shader_set_int_id(say_shader *shader, say_attr_loc_id id, int val,
+                           say_render_ctx *ctx) {
+  if (!say_shader_bind_ctx(shader, ctx))
+    return;
+
+  GLint loc = shader->locations[id];
+  if (say_uniform_cache_update_int(shader->uniforms, loc, val))
+    glUniform1iARB(loc, val);
 }
 
-void say_shader_set_vector3_loc(say_shader *shader, int loc, say_vector3 val) {
-  say_shader_bind(shader);
-  glUniform3fARB(loc, val.x, val.y, val.z);
+/* Errors of programs built asynchronously are only checked once they're used */
+static bool say_shader_is_usable(say_shader *shader) {
+  if (shader->status == SAY_SHADER_PENDING)
+    say_shader_wait(shader);
+
+  if (shader->status != SAY_SHADER_LINKED) {
+    say_error_set(shader->error);
+    return false;
+  }
+
+  return true;
 }
 
-void say_shader_set_color_loc(say_shader *shader, int loc, say_color val) {
-  say_shader_bind(shader);
-  float arg[4] = {val.r / 255.0, val.g / 255.0, val.b / 255.0, val.a / 255.0};
-  glUniform4fvARB(loc, 1, arg);
+bool say_shader_bind(say_shader *shader) {
+  say_context_ensure();
+
+  if (!say_shader_is_usable(shader))
+    return false;
+
+  say_gl_use_program(shader->program);
+  return true;
 }
 
-void say_shader_set_matrix_loc(say_shader *shader, int loc, say_matrix *val) {
-  say_shader_bind(shader);
-  glUniformMatrix4fvARB(loc, 1, GL_FALSE, val->content);
+bool say_shader_bind_ctx(say_shader *shader, say_render_ctx *ctx) {
+  if (!say_shader_is_usable(shader))
+    return false;
+
+  say_gl_state_use_program(ctx->gl, shader->program);
+  return true;
 }
 
-void say_shader_set_float_loc(say_shader *shader, int loc, float val) {
-  say_shader_bind(shader);
-  glUniform1fARB(loc, val);
+int say_shader_locate(say_shader *shader, const char *name) {
+  if (shader->status == SAY_SHADER_PENDING)
+    say_shader_wait(shader);
+
+  GLint loc;
+  if (!say_uniform_cache_get_location(shader->uniforms, name, &loc)) {
+    say_context_ensure();
+
+    loc = glGetUniformLocationARB(shader->program, name);
+    say_uniform_cache_set_location(shader->uniforms, name, loc);
+  }
+
+  return loc;
 }
 
-void say_shader_set_floats_loc(say_shader *shader, int loc, size_t count,
-                               float *val) {
-  say_shader_bind(shader);
+/*
+ * Uniforms are only sent to GL when their value changed. Values are compared
+ * to the ones last set through any shader using the same program.
+ */
+static void say_shader_set_floats(say_shader *shader, int loc, size_t count,
+                                  const float *val) {
+  if (!say_uniform_cache_update_floats(shader->uniforms, loc, count, val))
+    return;
+
+  if (!say_shader_bind(shader))
+    return;
 
   switch (count) {
   case 1:
@@ -359,17 +1043,52 @@ void say_shader_set_floats_loc(say_shader *shader, int loc, size_t count,
   }
 }
 
+static void say_shader_set_int_loc(say_shader *shader, int loc, int val) {
+  if (say_uniform_cache_update_int(shader->uniforms, loc, val)) {
+    if (say_shader_bind(shader))
+      glUniform1iARB(loc, val);
+  }
+}
+
+void say_shader_set_vector2_loc(say_shader *shader, int loc, say_vector2 val) {
+  float arg[2] = {val.x, val.y};
+  say_shader_set_floats(shader, loc, 2, arg);
+}
+
+void say_shader_set_vector3_loc(say_shader *shader, int loc, say_vector3 val) {
+  float arg[3] = {val.x, val.y, val.z};
+  say_shader_set_floats(shader, loc, 3, arg);
+}
+
+void say_shader_set_color_loc(say_shader *shader, int loc, say_color val) {
+  float arg[4] = {val.r / 255.0, val.g / 255.0, val.b / 255.0, val.a / 255.0};
+  say_shader_set_floats(shader, loc, 4, arg);
+}
+
+void say_shader_set_matrix_loc(say_shader *shader, int loc, say_matrix *val) {
+  if (say_uniform_cache_update_matrix(shader->uniforms, loc, val->version)) {
+    if (say_shader_bind(shader))
+      glUniformMatrix4fvARB(loc, 1, GL_FALSE, val->content);
+  }
+}
+
+void say_shader_set_float_loc(say_shader *shader, int loc, float val) {
+  say_shader_set_floats(shader, loc, 1, &val);
+}
+
+void say_shader_set_floats_loc(say_shader *shader, int loc, size_t count,
+                               float *val) {
+  say_shader_set_floats(shader, loc, count, val);
+}
+
 void say_shader_set_image_loc(say_shader *shader, int loc, say_image *val) {
-  say_shader_bind(shader);
-  glUniform1iARB(loc, val->texture);
+  say_shader_set_int_loc(shader, loc, say_image_get_texture(val));
 }
 
 void say_shader_set_current_texture_loc(say_shader *shader, int loc) {
-  say_shader_bind(shader);
-  glUniform1iARB(loc, 0);
+  say_shader_set_int_loc(shader, loc, 0);
 }
 
 void say_shader_set_bool_loc(say_shader *shader, int loc, uint8_t val) {
-  say_shader_bind(shader);
-  glUniform1iARB(loc, val);
+  say_shader_set_int_loc(shader, loc, val);
 }
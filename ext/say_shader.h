@@ -4,6 +4,9 @@
 #include "say_basic_type.h"
 #include "say_matrix.h"
 #include "say_image.h"
+#include "say_context.h"
+#include "say_uniform_cache.h"
+#include "say_array.h"
 
 typedef enum {
   SAY_POS_ID = 0,
@@ -25,6 +28,26 @@ typedef enum {
 
 #define SAY_FRAG_COLOR           "out_FragColor"
 
+/*
+ * Uniform blocks matrices are read from when uniform buffers are available.
+ * The target's block contains in_Projection, and the drawable's block
+ * in_ModelView.
+ */
+#define SAY_TARGET_BLOCK           "in_TargetBlock"
+#define SAY_DRAWABLE_BLOCK         "in_DrawableBlock"
+
+#define SAY_TARGET_BLOCK_BINDING   0
+#define SAY_DRAWABLE_BLOCK_BINDING 1
+
+#define SAY_SHADER_TARGET_BLOCK    (1 << 0)
+#define SAY_SHADER_DRAWABLE_BLOCK  (1 << 1)
+
+/* Features the default program can be specialized for */
+#define SAY_SHADER_TEXTURED      (1 << 0)
+#define SAY_SHADER_ALPHA_ONLY    (1 << 1)
+
+#define SAY_SHADER_FEATURE_COUNT 4
+
 typedef enum {
   SAY_PROJECTION_LOC_ID = 0,
   SAY_MODEL_VIEW_LOC_ID,
@@ -35,6 +58,13 @@ typedef enum {
   SAY_LOC_ID_COUNT
 } say_attr_loc_id;
 
+typedef enum {
+  SAY_SHADER_LINKED = 0,
+  SAY_SHADER_PENDING,
+  SAY_SHADER_COMPILE_FAILED,
+  SAY_SHADER_LINK_FAILED
+} say_shader_status;
+
 typedef struct {
   GLuint program;
 
@@ -43,13 +73,77 @@ typedef struct {
   GLuint geometry_shader;
 
   GLint locations[SAY_LOC_ID_COUNT];
+
+  /* Uniform blocks used by the program (SAY_SHADER_*_BLOCK) */
+  uint8_t blocks;
+
+  /* Shared by every shader using the same program */
+  say_uniform_cache *uniforms;
+
+  /*
+   * Shaders start out using the default program, which is shared by all of
+   * them. They get their own program the first time their code is changed.
+   */
+  bool shared;
+
+  /* Code last compiled and vertex type, from which variants are built */
+  char *frag_src, *vertex_src, *geometry_src;
+  size_t vtype;
+
+  /* say_shader_variant, created when first requested */
+  say_array *variants;
+
+  say_shader_status status;
+  char *error; /* Why the last build failed, reported when binding */
+
+  /* Key of the program in the disk cache, set by say_shader_build */
+  uint64_t cache_key;
+
+  /*
+   * stale is true if the program was loaded from the cache, and its shader
+   * objects must be compiled before it is linked again. unchecked is true
+   * until errors of a pending build have been looked up.
+   */
+  bool stale, unchecked;
 } say_shader;
 
+/* The shader's code compiled with some macros defined */
+typedef struct {
+  char *defines;
+  say_shader *shader;
+} say_shader_variant;
+
 bool say_shader_is_geometry_available();
 
+/* True if GLSL 1.40 and ARB_uniform_buffer_object are available */
+bool say_shader_uses_uniform_blocks();
+
 say_shader *say_shader_create();
 void say_shader_free(say_shader *shader);
 
+bool say_shader_is_shared(say_shader *shader);
+
+/*
+ * Default program specialized for the given features. Textured drawables use
+ * the alpha of the texture only if SAY_SHADER_ALPHA_ONLY is set too, and the
+ * color of their vertices otherwise; other drawables only use vertex colors.
+ */
+say_shader *say_shader_get_default_variant(uint8_t features);
+
+/*
+ * Returns the shader compiled with each key #defined, building it the first
+ * time. Variants belong to the shader, and are recompiled when it is linked.
+ */
+say_shader *say_shader_get_variant(say_shader *shader, const char **keys,
+                                   size_t count);
+
+/* Time spent compiling and linking programs, in seconds */
+double say_shader_get_compile_time();
+size_t say_shader_get_link_count();
+
+/* Amount of uniform uploads skipped because the value didn't change */
+size_t say_shader_get_elided_upload_count();
+
 void say_shader_enable_new_glsl();
 void say_shader_force_old();
 
@@ -63,15 +157,46 @@ void say_shader_apply_vertex_type(say_shader *shader, size_t vtype);
 
 int say_shader_link(say_shader *shader);
 
+/*
+ * Compiles and links the shader from the given code. Stages whose code is NULL
+ * keep their previous code. The program is loaded from the disk cache instead
+ * when possible, and stored there once linked.
+ *
+ * Unless async is true, waits for the driver and returns the status of the
+ * program. Otherwise, SAY_SHADER_PENDING is returned, and errors are only
+ * checked once the shader is bound, located, or waited for.
+ */
+say_shader_status say_shader_build(say_shader *shader, const char *vertex,
+                                   const char *frag, const char *geometry,
+                                   bool async);
+
+/* True if waiting for the shader wouldn't block (as far as can be told) */
+bool say_shader_is_ready(say_shader *shader);
+
+say_shader_status say_shader_wait(say_shader *shader);
+say_shader_status say_shader_get_status(say_shader *shader);
+
 void say_shader_set_matrix(say_shader *shader, const char *name,
                            say_matrix *matrix);
 void say_shader_set_current_texture(say_shader *shader, const char *name);
 void say_shader_set_int(say_shader *shader, const char *name, int val);
 
+/* Used while drawing, with the context the target was bound to */
 void say_shader_set_matrix_id(say_shader *shader, say_attr_loc_id id,
-                              say_matrix *matrix);
-void say_shader_set_current_texture_id(say_shader *shader, say_attr_loc_id id);
-void say_shader_set_int_id(say_shader *shader, say_attr_loc_id id, int val);
+                              say_matrix *matrix, say_render_ctx *ctx);
+void say_shader_set_current_texture_id(say_shader *shader, say_attr_loc_id id,
+                                       say_render_ctx *ctx);
+void say_shader_set_int_id(say_shader *shader, say_attr_loc_id id, int val,
+                           say_render_ctx *ctx);
+
+/*
+ * Use the uniform blocks instead of the in_Projection and in_ModelView
+ * uniforms if the program has them. The shader is bound in both cases.
+ */
+void say_shader_set_projection(say_shader *shader, say_matrix *matrix,
+                               say_render_ctx *ctx);
+void say_shader_set_model_view(say_shader *shader, say_matrix *matrix,
+                               say_render_ctx *ctx);
 
 int say_shader_locate(say_shader *shader, const char *name);
 
@@ -86,6 +211,11 @@ void say_shader_set_image_loc(say_shader *shader, int loc, say_image *val);
 void say_shader_set_current_texture_loc(say_shader *shader, int loc);
 void say_shader_set_bool_loc(say_shader *shader, int loc, uint8_t val);
 
-void say_shader_bind(say_shader *shader);
+/*
+ * Programs whose build failed are not bound, so that nothing gets drawn with
+ * them: false is returned and the build error is set instead.
+ */
+bool say_shader_bind(say_shader *shader);
+bool say_shader_bind_ctx(say_shader *shader, say_render_ctx *ctx);
 
 #endif
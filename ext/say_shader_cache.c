@@ -0,0 +1,191 @@
+#include "say.h"
+
+#define SAY_SHADER_CACHE_MAGIC "SAYPROG1"
+
+static char *say_shader_cache_dir = NULL;
+static size_t say_shader_cache_hits = 0;
+
+typedef struct {
+  char magic[8];
+  uint32_t format;
+  uint32_t length;
+} say_shader_cache_header;
+
+void say_shader_cache_set_dir(const char *dir) {
+  free(say_shader_cache_dir);
+  say_shader_cache_dir = dir ? say_strdup(dir) : NULL;
+}
+
+const char *say_shader_cache_get_dir() {
+  return say_shader_cache_dir;
+}
+
+bool say_shader_cache_is_available() {
+  if (!say_shader_cache_dir)
+    return false;
+
+#ifdef GL_ARB_get_program_binary
+  say_context_ensure();
+  if (!__GLEW_ARB_get_program_binary)
+    return false;
+
+  /* Some drivers expose the extension without supporting any format */
+  GLint format_count = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+
+  return format_count > 0;
+#else
+  return false;
+#endif
+}
+
+static uint64_t say_shader_cache_hash(uint64_t hash, const char *str) {
+  if (!str)
+    str = "";
+
+  /* Include the terminating null byte, so that sources can't run together */
+  do {
+    hash ^= (uint8_t)*str;
+    hash *= 1099511628211ull;
+  } while (*(str++));
+
+  return hash;
+}
+
+uint64_t say_shader_cache_key(const char **sources, size_t count) {
+  uint64_t hash = 14695981039346656037ull;
+
+  for (size_t i = 0; i < count; i++)
+    hash = say_shader_cache_hash(hash, sources[i]);
+
+  /* Binaries can only be loaded by the driver that created them */
+  hash = say_shader_cache_hash(hash, (const char*)glGetString(GL_VENDOR));
+  hash = say_shader_cache_hash(hash, (const char*)glGetString(GL_RENDERER));
+  hash = say_shader_cache_hash(hash, (const char*)glGetString(GL_VERSION));
+
+  return hash;
+}
+
+static char *say_shader_cache_path(uint64_t key, const char *suffix) {
+  size_t size = strlen(say_shader_cache_dir) + strlen(suffix) + 20;
+  char *path = malloc(size);
+
+  snprintf(path, size, "%s/%016llx.%s", say_shader_cache_dir,
+           (unsigned long long)key, suffix);
+
+  return path;
+}
+
+void say_shader_cache_prepare(GLuint program) {
+#ifdef GL_ARB_get_program_binary
+  if (say_shader_cache_is_available())
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+}
+
+bool say_shader_cache_load(uint64_t key, GLuint program) {
+#ifdef GL_ARB_get_program_binary
+  if (!say_shader_cache_is_available())
+    return false;
+
+  char *path = say_shader_cache_path(key, "bin");
+  FILE *file = fopen(path, "rb");
+  free(path);
+
+  if (!file)
+    return false;
+
+  /* The length stored in the header can't be trusted if the file is damaged */
+  long file_size = -1;
+  if (fseek(file, 0, SEEK_END) == 0) {
+    file_size = ftell(file);
+    rewind(file);
+  }
+
+  say_shader_cache_header header;
+  void *binary = NULL;
+
+  bool loaded =
+    file_size >= (long)sizeof(header) &&
+    fread(&header, sizeof(header), 1, file) == 1 &&
+    memcmp(header.magic, SAY_SHADER_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+    header.length != 0 &&
+    header.length == (unsigned long)file_size - sizeof(header) &&
+    (binary = malloc(header.length)) &&
+    fread(binary, header.length, 1, file) == 1;
+
+  fclose(file);
+
+  if (loaded) {
+    say_shader_cache_prepare(program);
+    glProgramBinary(program, header.format, binary, header.length);
+
+    /* Fails if the driver was updated since the binary was saved */
+    GLint worked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &worked);
+    loaded = worked;
+  }
+
+  free(binary);
+
+  if (loaded)
+    say_shader_cache_hits++;
+
+  return loaded;
+#else
+  return false;
+#endif
+}
+
+void say_shader_cache_store(uint64_t key, GLuint program) {
+#ifdef GL_ARB_get_program_binary
+  if (!say_shader_cache_is_available())
+    return;
+
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+
+  void *binary = malloc(length);
+
+  GLenum format = 0;
+  glGetProgramBinary(program, length, &length, &format, binary);
+
+  say_shader_cache_header header;
+  memcpy(header.magic, SAY_SHADER_CACHE_MAGIC, sizeof(header.magic));
+  header.format = format;
+  header.length = length;
+
+  /*
+   * Written under another name first, so that other processes never read an
+   * incomplete file. That name is unique to this process, so that several of
+   * them can store the same program at once.
+   */
+  char tmp_suffix[32];
+  snprintf(tmp_suffix, sizeof(tmp_suffix), "%ld.tmp", (long)getpid());
+
+  char *tmp_path = say_shader_cache_path(key, tmp_suffix);
+  char *path     = say_shader_cache_path(key, "bin");
+
+  FILE *file = fopen(tmp_path, "wb");
+  if (file) {
+    bool written =
+      fwrite(&header, sizeof(header), 1, file) == 1 &&
+      fwrite(binary, length, 1, file) == 1;
+
+    if (fclose(file) == 0 && written)
+      rename(tmp_path, path);
+    else
+      remove(tmp_path);
+  }
+
+  free(tmp_path);
+  free(path);
+  free(binary);
+#endif
+}
+
+size_t say_shader_cache_get_hit_count() {
+  return say_shader_cache_hits;
+}
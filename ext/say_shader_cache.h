@@ -0,0 +1,31 @@
+#ifndef SAY_SHADER_CACHE_H_
+#define SAY_SHADER_CACHE_H_
+
+#include "say_basic_type.h"
+
+/*
+ * Linked programs, stored on disk so that they don't need to be compiled again
+ * the next time the same code is used with the same driver. Programs are
+ * looked up using a hash of their sources and of the OpenGL renderer.
+ */
+
+/* Disables the cache if dir is NULL */
+void say_shader_cache_set_dir(const char *dir);
+const char *say_shader_cache_get_dir();
+
+/* True if a directory is set and the driver can retrieve program binaries */
+bool say_shader_cache_is_available();
+
+/* Sources can be NULL, e.g. for stages a program doesn't have */
+uint64_t say_shader_cache_key(const char **sources, size_t count);
+
+/* Must be called before linking a program that will be stored */
+void say_shader_cache_prepare(GLuint program);
+
+/* Returns true if the program was loaded from the cache and can be used */
+bool say_shader_cache_load(uint64_t key, GLuint program);
+void say_shader_cache_store(uint64_t key, GLuint program);
+
+size_t say_shader_cache_get_hit_count();
+
+#endif
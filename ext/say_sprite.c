@@ -79,7 +79,7 @@ static void say_sprite_draw(void *data, size_t first, size_t index,
   }
 
   say_image_bind(sprite->image);
-  glDrawArrays(GL_TRIANGLE_FAN, first, 4);
+  say_draw_arrays(GL_TRIANGLE_FAN, first, 4);
 }
 
 say_sprite *say_sprite_create() {
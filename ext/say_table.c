@@ -70,7 +70,7 @@ void say_table_set(say_table *table, uint32_t id, void *value) {
   say_table_resize(table);
 
   table->pairs[old_size].key   = id;
-  table->pairs[old_size].value = NULL;
+  table->pairs[old_size].value = value;
 }
 
 void say_table_del(say_table *table, uint32_t id) {
@@ -3,25 +3,31 @@
 static say_target *say_current_target = NULL;
 static say_context *say_target_last_context = NULL;
 
-static void say_target_update_states(say_target *target) {
+static void say_target_update_states(say_target *target,
+                                     say_render_ctx *ctx) {
   if (target->up_to_date) {
     target->up_to_date = 0;
-    say_renderer_reset_states(target->renderer);
+    say_renderer_reset_states(target->renderer, ctx);
   }
 
   if (!target->view_up_to_date ||
       say_view_has_changed(target->view)) {
     say_view_apply(target->view, target->renderer->shader,
-                   target->size);
+                   target->size, ctx);
     target->view_up_to_date = 1;
   }
+
+  say_renderer_set_projection(target->renderer,
+                              say_view_get_matrix(target->view));
+  say_renderer_bind_block(target->renderer, ctx);
 }
 
-say_target *say_target_create() {
+static say_target *say_target_alloc() {
   say_target *target = (say_target*)malloc(sizeof(say_target));
 
   target->context  = say_thread_variable_create((say_destructor)say_context_free);
-  target->renderer = say_renderer_create();
+  target->renderer = NULL;
+  target->raster   = NULL;
   target->view     = say_view_create();
 
   target->up_to_date         = 1;
@@ -31,12 +37,68 @@ say_target *say_target_create() {
   target->context_proc = NULL;
   target->bind_hook    = NULL;
 
+  for (size_t i = 0; i < SAY_TARGET_READBACK_COUNT; i++) {
+    target->readbacks[i].pbo      = 0;
+    target->readbacks[i].fence    = NULL;
+    target->readbacks[i].filename = NULL;
+  }
+
+  target->readback_start = 0;
+  target->readback_count = 0;
+
+  target->writers      = NULL;
+  target->writer_mutex = NULL;
+
+  return target;
+}
+
+say_target *say_target_create() {
+  say_target *target = say_target_alloc();
+  target->renderer = say_renderer_create();
+
+  return target;
+}
+
+say_target *say_target_create_software() {
+  say_target *target = say_target_alloc();
+  target->raster = say_raster_create();
+
   return target;
 }
 
+void say_target_set_raster_image(say_target *target, say_image *img) {
+  say_raster_set_image(target->raster, img);
+}
+
+bool say_target_is_software(say_target *target) {
+  return target->raster != NULL;
+}
+
+/* Mirrors say_view_apply, which truncates the viewport to integers */
+static void say_target_update_raster(say_target *target) {
+  say_rect vp = say_view_get_viewport(target->view);
+  say_vector2 size = target->size;
+
+  say_rect rect = say_make_rect((GLint)(vp.x * size.x),
+                                (GLint)(size.y - (vp.y + vp.h) * size.y),
+                                (GLint)(vp.w * size.x),
+                                (GLint)(vp.h * size.y));
+
+  say_raster_set_view(target->raster, say_view_get_matrix(target->view),
+                      rect);
+}
+
+static void say_target_free_reads(say_target *target);
+
 void say_target_free(say_target *target) {
+  say_target_free_reads(target);
+
   say_view_free(target->view);
-  say_renderer_free(target->renderer);
+
+  if (target->renderer)
+    say_renderer_free(target->renderer);
+  if (target->raster)
+    say_raster_free(target->raster);
 
   say_thread_variable_free(target->context);
 
@@ -79,7 +141,9 @@ say_context *say_target_get_context(say_target *target) {
     }
   }
   else {
-    say_context_ensure();
+    if (!say_context_ensure())
+      return NULL;
+
     return say_context_current();
   }
 }
@@ -92,10 +156,14 @@ void say_target_set_custom_data(say_target *target, void *data) {
   target->data = data;
 }
 
-int say_target_make_current(say_target *target) {
+/* Makes the target current, storing the context it is drawn on in ctx */
+static int say_target_make_current_ctx(say_target *target,
+                                       say_render_ctx *ctx) {
   say_context *context = say_target_get_context(target);
 
   if (context) {
+    *ctx = say_render_ctx_for(context);
+
     say_context *current = say_context_current();
 
     if (current == say_target_last_context &&
@@ -106,10 +174,15 @@ int say_target_make_current(say_target *target) {
 
     target->view_up_to_date = 0;
 
-    say_context_make_current(context);
+    if (!say_context_make_current(context))
+      return 0;
+
     if (target->bind_hook)
       target->bind_hook(target->data);
 
+    /* The default program is shared, other targets may have set its uniforms */
+    say_renderer_reset_states(target->renderer, ctx);
+
     say_current_target      = target;
     say_target_last_context = context;
 
@@ -119,6 +192,21 @@ int say_target_make_current(say_target *target) {
     return 0;
 }
 
+int say_target_make_current(say_target *target) {
+  /* Software targets don't need any context */
+  if (target->raster) {
+    say_current_target = target;
+    return 1;
+  }
+
+  say_render_ctx ctx;
+  return say_target_make_current_ctx(target, &ctx);
+}
+
+say_target *say_target_get_current() {
+  return say_current_target;
+}
+
 void say_target_set_size(say_target *target, say_vector2 size) {
   target->size = size;
   target->view_up_to_date = 0;
@@ -147,6 +235,9 @@ say_view *say_target_get_default_view(say_target *target) {
 }
 
 say_shader *say_target_get_shader(say_target *target) {
+  if (!target->renderer)
+    return NULL;
+
   return say_renderer_get_shader(target->renderer);
 }
 
@@ -170,6 +261,11 @@ say_rect say_target_get_viewport_for(say_target *target, say_rect rect) {
 }
 
 void say_target_clear(say_target *target, say_color color) {
+  if (target->raster) {
+    say_raster_clear(target->raster, color);
+    return;
+  }
+
   if (!say_target_make_current(target))
     return;
 
@@ -179,31 +275,75 @@ void say_target_clear(say_target *target, say_color color) {
 }
 
 void say_target_draw(say_target *target, say_drawable *drawable) {
-  if (!say_target_make_current(target))
+  if (target->raster) {
+    say_target_update_raster(target);
+    say_raster_draw(target->raster, drawable);
+    say_raster_flush(target->raster);
     return;
+  }
 
-  if (drawable->shader) {
-    say_shader_set_matrix_id(drawable->shader,
-                             SAY_PROJECTION_LOC_ID,
-                             say_view_get_matrix(target->view));
+  say_render_ctx ctx;
+  if (!say_target_make_current_ctx(target, &ctx))
+    return;
+
+  say_shader *custom = say_drawable_get_custom_shader(drawable);
+  if (custom) {
+    say_shader_set_projection(custom, say_view_get_matrix(target->view), &ctx);
   }
 
-  say_target_update_states(target);
-  say_renderer_push(target->renderer, drawable);
+  say_target_update_states(target, &ctx);
+  say_renderer_push(target->renderer, drawable, &ctx);
 }
 
 void say_target_draw_buffer(say_target *target,
                             say_buffer_renderer *buf) {
-  if (!say_target_make_current(target))
+  /* Drawables are rasterized from their own vertices, in a single batch */
+  if (target->raster) {
+    say_target_update_raster(target);
+
+    for (size_t i = 0; i < say_array_get_size(buf->drawables); i++) {
+      say_drawable **drawable = say_array_get(buf->drawables, i);
+      say_raster_draw(target->raster, *drawable);
+    }
+
+    say_raster_flush(target->raster);
+    return;
+  }
+
+  say_render_ctx ctx;
+  if (!say_target_make_current_ctx(target, &ctx))
     return;
 
   buf->matrix = say_view_get_matrix(target->view);
 
-  say_target_update_states(target);
-  say_renderer_push_buffer(target->renderer, buf);
+  say_target_update_states(target, &ctx);
+  say_renderer_push_buffer(target->renderer, buf, &ctx);
+}
+
+/*
+ * Rows of the image of a software target are those of the framebuffer, which
+ * are read from the bottom, like glReadPixels does.
+ */
+static say_color *say_target_raster_row(say_target *target, size_t y) {
+  say_image *img = say_raster_get_image(target->raster);
+  if (!img || y >= say_image_get_height(img))
+    return NULL;
+
+  size_t row = say_image_get_height(img) - y - 1;
+  return &say_image_get_buffer(img)[row * say_image_get_width(img)];
 }
 
 say_color say_target_get(say_target *target, size_t x, size_t y) {
+  if (target->raster) {
+    say_image *img = say_raster_get_image(target->raster);
+    say_color *row = say_target_raster_row(target, y);
+
+    if (!row || x >= say_image_get_width(img))
+      return say_make_color(0, 0, 0, 0);
+
+    return row[x];
+  }
+
   if (!say_target_make_current(target))
     return say_make_color(0, 0, 0, 0);
 
@@ -214,6 +354,18 @@ say_color say_target_get(say_target *target, size_t x, size_t y) {
   return col;
 }
 
+/*
+ * Say keeps pixels from top to bottom, but GL reads from bottom to top. Rows are
+ * flipped while they are copied to the image.
+ */
+static void say_target_copy_flipped(say_color *dst, const say_color *src,
+                                    size_t w, size_t h) {
+  size_t mem_size = sizeof(say_color) * w;
+
+  for (size_t i = 0; i < h; i++)
+    memcpy(&dst[w * i], &src[w * (h - i - 1)], mem_size);
+}
+
 say_image *say_target_get_rect(say_target *target, size_t x, size_t y,
                                size_t w, size_t h) {
   if (!say_target_make_current(target))
@@ -225,27 +377,28 @@ say_image *say_target_get_rect(say_target *target, size_t x, size_t y,
     return NULL;
   }
 
-  /* TODO: use PBOs for this? */
-  glReadPixels(x, (GLint)target->size.y - (GLint)y - (GLint)h, w, h, GL_RGBA,
-               GL_UNSIGNED_BYTE, say_image_get_buffer(image));
-
-  /*
-   * Say keeps pixels from top to bottom, but GL reads from bottom to top. Flip
-   * pixels manually.
-   */
+  if (target->raster) {
+    say_image *src = say_raster_get_image(target->raster);
+    say_color *dst = say_image_get_buffer(image);
 
-  size_t mem_size = sizeof(say_color) * w;
+    for (size_t i = 0; i < h; i++) {
+      say_color *row = say_target_raster_row(target, y + i);
 
-  say_color *temp_line = malloc(mem_size);
-  say_color *buffer    = say_image_get_buffer(image);
+      if (row && x + w <= say_image_get_width(src))
+        memcpy(&dst[i * w], &row[x], sizeof(say_color) * w);
+      else
+        memset(&dst[i * w], 0, sizeof(say_color) * w);
+    }
 
-  for (size_t i = 0; i <= h / 2; i++) {
-    memcpy(temp_line, &buffer[w * i], mem_size);
-    memcpy(&buffer[w * i], &buffer[w * (h - i - 1)], mem_size);
-    memcpy(&buffer[w * (h - i - 1)], temp_line, mem_size);
+    return image;
   }
 
-  free(temp_line);
+  say_color *pixels = malloc(sizeof(say_color) * w * h);
+  glReadPixels(x, (GLint)target->size.y - (GLint)y - (GLint)h, w, h, GL_RGBA,
+               GL_UNSIGNED_BYTE, pixels);
+
+  say_target_copy_flipped(say_image_get_buffer(image), pixels, w, h);
+  free(pixels);
 
   return image;
 }
@@ -255,10 +408,272 @@ say_image *say_target_to_image(say_target *target) {
 }
 
 void say_target_update(say_target *target) {
-  say_context *context = say_target_get_context(target);
-  if (context) {
-    say_context_update(context);
+  if (!target->raster) {
+    say_context *context = say_target_get_context(target);
+    if (context) {
+      say_context_update(context);
+    }
   }
 
   target->up_to_date = 1;
+
+  say_target_poll_reads(target, false);
+}
+
+/*
+ * Asynchronous reads copy pixels to a pixel pack buffer, which is only mapped
+ * once the fence inserted after glReadPixels has been signaled. Images that
+ * must be saved as PNG are then encoded by a worker thread.
+ */
+
+typedef struct {
+  say_thread *thread;
+  say_mutex  *mutex;
+
+  say_image *img;
+  char *filename;
+
+  say_readback_proc proc;
+  void *data;
+
+  bool done;
+} say_target_writer;
+
+static void *say_target_writer_run(void *data) {
+  say_target_writer *writer = data;
+
+  say_image_write_png(writer->img, writer->filename);
+
+  say_mutex_lock(writer->mutex);
+  writer->done = true;
+  say_mutex_unlock(writer->mutex);
+
+  return NULL;
+}
+
+static void say_target_finish_read(say_target *target, say_image *img,
+                                   const char *filename,
+                                   say_readback_proc proc, void *data) {
+  if (!filename) {
+    if (proc)
+      proc(data, img);
+    else
+      say_image_free(img);
+
+    return;
+  }
+
+  if (!target->writers) {
+    target->writers = say_array_create(sizeof(say_target_writer*), NULL, NULL);
+    target->writer_mutex = say_mutex_create();
+  }
+
+  say_target_writer *writer = malloc(sizeof(say_target_writer));
+
+  writer->mutex    = target->writer_mutex;
+  writer->img      = img;
+  writer->filename = malloc(strlen(filename) + 1);
+  writer->proc     = proc;
+  writer->data     = data;
+  writer->done     = false;
+
+  strcpy(writer->filename, filename);
+
+  say_array_push(target->writers, &writer);
+  writer->thread = say_thread_create(writer, say_target_writer_run);
+}
+
+static bool say_target_readback_is_ready(say_target_readback *read,
+                                         bool wait) {
+  if (wait) {
+    while (glClientWaitSync(read->fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                            1000000000) == GL_TIMEOUT_EXPIRED);
+    return true;
+  }
+
+  GLint status = GL_UNSIGNALED;
+  glGetSynciv(read->fence, GL_SYNC_STATUS, sizeof(status), NULL, &status);
+
+  return status == GL_SIGNALED;
+}
+
+/* Returns false if the oldest read isn't complete yet */
+static bool say_target_complete_read(say_target *target, bool wait) {
+  say_target_readback *read = &target->readbacks[target->readback_start];
+
+  if (!say_target_readback_is_ready(read, wait))
+    return false;
+
+  glDeleteSync(read->fence);
+  read->fence = NULL;
+
+  say_image *img = say_image_create();
+  say_image_create_with_size(img, read->w, read->h);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, read->pbo);
+  say_color *pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+  if (pixels) {
+    say_target_copy_flipped(say_image_get_buffer(img), pixels,
+                            read->w, read->h);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  /* The slot is released before calling back, which may not return */
+  char *filename         = read->filename;
+  say_readback_proc proc = read->proc;
+  void *data             = read->data;
+
+  read->filename = NULL;
+
+  target->readback_start = (target->readback_start + 1) %
+    SAY_TARGET_READBACK_COUNT;
+  target->readback_count--;
+
+  say_target_finish_read(target, img, filename, proc, data);
+
+  if (filename)
+    free(filename);
+
+  return true;
+}
+
+bool say_target_read_async(say_target *target, size_t x, size_t y,
+                           size_t w, size_t h, const char *filename,
+                           say_readback_proc proc, void *data) {
+  if (!say_target_make_current(target))
+    return false;
+
+  if (w == 0 || h == 0) {
+    say_error_set("can't read an empty rect");
+    return false;
+  }
+
+  /* Software targets are read right away, only files are written later */
+  if (target->raster ||
+      !__GLEW_ARB_pixel_buffer_object || !__GLEW_ARB_sync) {
+    say_image *img = say_target_get_rect(target, x, y, w, h);
+    if (!img)
+      return false;
+
+    say_target_finish_read(target, img, filename, proc, data);
+    return true;
+  }
+
+  /* When every buffer is in use, wait for the oldest one */
+  if (target->readback_count == SAY_TARGET_READBACK_COUNT)
+    say_target_complete_read(target, true);
+
+  size_t index = (target->readback_start + target->readback_count) %
+    SAY_TARGET_READBACK_COUNT;
+  say_target_readback *read = &target->readbacks[index];
+
+  if (!read->pbo)
+    glGenBuffers(1, &read->pbo);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, read->pbo);
+  glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(say_color) * w * h, NULL,
+               GL_STREAM_READ);
+  glReadPixels(x, (GLint)target->size.y - (GLint)y - (GLint)h, w, h, GL_RGBA,
+               GL_UNSIGNED_BYTE, NULL);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  read->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  read->w    = w;
+  read->h    = h;
+  read->proc = proc;
+  read->data = data;
+
+  if (filename) {
+    read->filename = malloc(strlen(filename) + 1);
+    strcpy(read->filename, filename);
+  }
+  else
+    read->filename = NULL;
+
+  target->readback_count++;
+
+  return true;
+}
+
+static void say_target_poll_writers(say_target *target, bool wait) {
+  if (!target->writers)
+    return;
+
+  for (size_t i = 0; i < say_array_get_size(target->writers);) {
+    say_target_writer *writer =
+      *(say_target_writer**)say_array_get(target->writers, i);
+
+    say_mutex_lock(writer->mutex);
+    bool done = writer->done;
+    say_mutex_unlock(writer->mutex);
+
+    if (!done && !wait) {
+      i++;
+      continue;
+    }
+
+    say_thread_join(writer->thread);
+    say_thread_free(writer->thread);
+
+    say_array_delete(target->writers, i);
+
+    say_image *img         = writer->img;
+    say_readback_proc proc = writer->proc;
+    void *data             = writer->data;
+
+    free(writer->filename);
+    free(writer);
+
+    if (proc)
+      proc(data, img);
+    else
+      say_image_free(img);
+  }
+}
+
+void say_target_poll_reads(say_target *target, bool wait) {
+  if (target->readback_count != 0 && say_target_make_current(target)) {
+    while (target->readback_count != 0 &&
+           say_target_complete_read(target, wait));
+  }
+
+  say_target_poll_writers(target, wait);
+}
+
+/* Pending reads are dropped, but files being written are completed */
+static void say_target_free_reads(say_target *target) {
+  if (target->readbacks[0].pbo && say_target_make_current(target)) {
+    for (size_t i = 0; i < SAY_TARGET_READBACK_COUNT; i++) {
+      say_target_readback *read = &target->readbacks[i];
+
+      if (read->fence)
+        glDeleteSync(read->fence);
+      if (read->pbo)
+        glDeleteBuffers(1, &read->pbo);
+    }
+  }
+
+  for (size_t i = 0; i < SAY_TARGET_READBACK_COUNT; i++) {
+    if (target->readbacks[i].filename)
+      free(target->readbacks[i].filename);
+  }
+
+  if (target->writers) {
+    for (size_t i = 0; i < say_array_get_size(target->writers); i++) {
+      say_target_writer *writer =
+        *(say_target_writer**)say_array_get(target->writers, i);
+
+      say_thread_join(writer->thread);
+      say_thread_free(writer->thread);
+
+      say_image_free(writer->img);
+      free(writer->filename);
+      free(writer);
+    }
+
+    say_array_free(target->writers);
+    say_mutex_free(target->writer_mutex);
+  }
 }
@@ -4,11 +4,29 @@
 #include "say_context.h"
 #include "say_renderer.h"
 #include "say_view.h"
+#include "say_raster.h"
 #include "say_thread.h"
 
 typedef say_context *(*say_context_proc)(void *data);
 typedef void (*say_bind_hook)(void *data);
 
+/* Takes ownership of the image */
+typedef void (*say_readback_proc)(void *data, say_image *img);
+
+#define SAY_TARGET_READBACK_COUNT 3
+
+typedef struct {
+  GLuint pbo;
+  GLsync fence;
+
+  size_t w, h;
+
+  char *filename; /* PNG written by a worker thread when non-NULL */
+
+  say_readback_proc proc;
+  void *data;
+} say_target_readback;
+
 typedef struct {
   say_thread_variable *context;
   say_context_proc context_proc;
@@ -20,14 +38,28 @@ typedef struct {
 
   say_renderer *renderer;
 
+  /* Used instead of the renderer by targets drawn in software */
+  say_raster *raster;
+
   say_view *view;
   say_vector2 size;
 
   uint8_t up_to_date;
   uint8_t view_up_to_date;
+
+  say_target_readback readbacks[SAY_TARGET_READBACK_COUNT];
+  size_t readback_start, readback_count;
+
+  say_array *writers;
+  say_mutex *writer_mutex;
 } say_target;
 
 say_target *say_target_create();
+
+/* Draws on the image set with say_target_set_raster_image, without OpenGL */
+say_target *say_target_create_software();
+void say_target_set_raster_image(say_target *target, say_image *img);
+bool say_target_is_software(say_target *target);
 void say_target_free(say_target *target);
 
 void say_target_set_context_proc(say_target *target, say_context_proc proc);
@@ -51,6 +83,7 @@ say_rect say_target_get_clip(say_target *target);
 say_rect say_target_get_viewport_for(say_target *target, say_rect rect);
 
 int say_target_make_current(say_target *target);
+say_target *say_target_get_current();
 
 void say_target_clear(say_target *target, say_color color);
 void say_target_draw(say_target *target, say_drawable *drawable);
@@ -62,6 +95,11 @@ say_image *say_target_get_rect(say_target *target, size_t x, size_t y,
                                size_t w, size_t h);
 say_image *say_target_to_image(say_target *target);
 
+bool say_target_read_async(say_target *target, size_t x, size_t y,
+                           size_t w, size_t h, const char *filename,
+                           say_readback_proc proc, void *data);
+void say_target_poll_reads(say_target *target, bool wait);
+
 void say_target_update(say_target *target);
 
 #endif
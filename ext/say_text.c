@@ -1,5 +1,29 @@
 #include "say.h"
 
+/*
+ * Outlines are drawn by stamping the glyphs in 8 directions around their
+ * actual position.
+ */
+#define SAY_TEXT_OUTLINE_COPIES 8
+
+static const float say_text_outline_dirs[SAY_TEXT_OUTLINE_COPIES][2] = {
+  {-1, 0}, {1, 0}, {0, -1}, {0, 1},
+  {-0.70710678, -0.70710678}, {0.70710678, -0.70710678},
+  {-0.70710678, +0.70710678}, {0.70710678, +0.70710678}
+};
+
+static size_t say_text_get_layer_count(say_text *text) {
+  size_t count = 1;
+
+  if (text->style & SAY_TEXT_SHADOWED)
+    count += 1;
+
+  if (text->style & SAY_TEXT_OUTLINED)
+    count += SAY_TEXT_OUTLINE_COPIES;
+
+  return count;
+}
+
 static void say_text_update_rect(say_text *text) {
   if (!text->font) {
     text->rect_size.x = 0;
@@ -11,6 +35,10 @@ static void say_text_update_rect(say_text *text) {
 
   uint8_t is_bold = (text->style & SAY_TEXT_BOLD) != 0;
 
+  /* Missing glyphs are all rasterized at once, possibly in parallel */
+  say_font_load_glyphs(text->font, text->string, text->str_length,
+                       text->size, is_bold);
+
   float line_height = say_font_get_line_height(text->font, text->size);
   float space_width = say_font_get_glyph(text->font, L' ', text->size,
                                          is_bold)->offset;
@@ -51,6 +79,8 @@ static void say_text_update_rect(say_text *text) {
                                             is_bold);
       current_width += say_font_get_kerning(text->font, previous, current, text->size);
       current_width += glyph->offset;
+
+      previous = current;
     }
   }
 
@@ -91,13 +121,58 @@ static void say_text_compute_vertex_count(say_text *text) {
     line_count = 0;
   }
 
-  say_drawable_set_vertex_count(text->drawable, (count + line_count) * 4);
-  say_drawable_set_index_count(text->drawable, (count + line_count) * 6);
+  /*
+   * Shadow and outline are copies of the whole text (underline included), so
+   * that styled text is still drawn in a single call.
+   */
+  size_t layer_count = say_text_get_layer_count(text);
+  text->layer_vertex_count = (count + line_count) * 4;
+
+  say_drawable_set_vertex_count(text->drawable,
+                                (count + line_count) * 4 * layer_count);
+  say_drawable_set_index_count(text->drawable,
+                               (count + line_count) * 6 * layer_count);
+}
+
+static void say_text_fill_layer(say_vertex *dst, say_vertex *src, size_t count,
+                                say_vector2 offset, say_color color) {
+  for (size_t i = 0; i < count; i++) {
+    dst[i].pos = say_make_vector2(src[i].pos.x + offset.x,
+                                  src[i].pos.y + offset.y);
+    dst[i].col = color;
+    dst[i].tex = src[i].tex;
+  }
+}
+
+static void say_text_fill_effects(say_text *text, say_vertex *vertices) {
+  size_t count = text->layer_vertex_count;
+  say_vertex *main_layer =
+    vertices + (say_text_get_layer_count(text) - 1) * count;
+
+  if (text->style & SAY_TEXT_SHADOWED) {
+    say_text_fill_layer(vertices, main_layer, count,
+                        text->shadow_offset, text->shadow_color);
+    vertices += count;
+  }
+
+  if (text->style & SAY_TEXT_OUTLINED) {
+    for (size_t i = 0; i < SAY_TEXT_OUTLINE_COPIES; i++) {
+      say_vector2 offset =
+        say_make_vector2(say_text_outline_dirs[i][0] * text->outline_width,
+                         say_text_outline_dirs[i][1] * text->outline_width);
+      say_text_fill_layer(vertices, main_layer, count,
+                          offset, text->outline_color);
+      vertices += count;
+    }
+  }
 }
 
 static void say_text_fill_vertices(void *data, void *vertices_ptr) {
   say_text   *text     = (say_text*)data;
-  say_vertex *vertices = (say_vertex*)vertices_ptr;
+
+  /* The text itself is drawn last, on top of its effects */
+  say_vertex *vertices = (say_vertex*)vertices_ptr +
+    (say_text_get_layer_count(text) - 1) * text->layer_vertex_count;
 
   if (!text->font)
     return;
@@ -112,6 +187,7 @@ static void say_text_fill_vertices(void *data, void *vertices_ptr) {
 
   /* Updating the rect may cause the image to change size */
   text->last_img_size = say_image_get_size(img);
+  text->font_generation = say_font_get_generation(text->font);
 
   uint8_t is_bold       = (text->style & SAY_TEXT_BOLD) != 0;
   uint8_t is_underlined = (text->style & SAY_TEXT_UNDERLINED) != 0;
@@ -219,6 +295,7 @@ static void say_text_fill_vertices(void *data, void *vertices_ptr) {
       ver_id += 4;
 
       x += glyph->offset;
+      previous = current;
     }
   }
 
@@ -247,6 +324,8 @@ static void say_text_fill_vertices(void *data, void *vertices_ptr) {
 
     under_id += 4;
   }
+
+  say_text_fill_effects(text, (say_vertex*)vertices_ptr);
 }
 
 static void say_text_draw(void *data, size_t first, size_t index,
@@ -261,6 +340,16 @@ static void say_text_draw(void *data, size_t first, size_t index,
   if (!img)
     return;
 
+  /*
+   * Glyphs loaded in the background replace placeholders: the text must be
+   * laid out again once they are available.
+   */
+  say_font_update(text->font);
+  if (say_font_get_generation(text->font) != text->font_generation) {
+    text->rect_updated = 0;
+    say_drawable_set_changed(text->drawable);
+  }
+
   /*
    * Following condition is true when the font image has been resized because of
    * new characters that have been loaded.
@@ -278,8 +367,8 @@ static void say_text_draw(void *data, size_t first, size_t index,
   }
   else {
     say_image_bind(img);
-    glDrawElements(GL_TRIANGLES, say_drawable_get_index_count(text->drawable),
-                   GL_UNSIGNED_INT, (void*)(index * sizeof(GLuint)));
+    say_draw_elements(GL_TRIANGLES,
+                      say_drawable_get_index_count(text->drawable), index);
   }
 }
 
@@ -304,6 +393,7 @@ say_text *say_text_create() {
   text->drawable = say_drawable_create(0);
   say_drawable_set_custom_data(text->drawable, text);
   say_drawable_set_textured(text->drawable, 1);
+  say_drawable_set_alpha_only(text->drawable, true);
   say_drawable_set_fill_proc(text->drawable, say_text_fill_vertices);
   say_drawable_set_index_fill_proc(text->drawable, say_text_fill_indices);
   say_drawable_set_render_proc(text->drawable, say_text_draw);
@@ -314,9 +404,16 @@ say_text *say_text_create() {
   text->str_length       = 0;
   text->style            = 0;
   text->color            = say_make_color(255, 255, 255, 255);
+  text->shadow_offset    = say_make_vector2(2, 2);
+  text->shadow_color     = say_make_color(0, 0, 0, 255);
+  text->outline_width    = 1;
+  text->outline_color    = say_make_color(0, 0, 0, 255);
   text->rect_size        = say_make_vector2(0, 0);
   text->rect_updated     = 1;
   text->underline_vertex = 0;
+  text->font_generation  = 0;
+
+  text->layer_vertex_count = 0;
 
   return text;
 }
@@ -341,12 +438,19 @@ void say_text_copy(say_text *text, say_text *src) {
 
   text->color = src->color;
 
+  text->shadow_offset = src->shadow_offset;
+  text->shadow_color  = src->shadow_color;
+  text->outline_width = src->outline_width;
+  text->outline_color = src->outline_color;
+
   text->rect_size    = src->rect_size;
   text->rect_updated = src->rect_updated;
 
-  text->last_img_size = src->last_img_size;
+  text->last_img_size   = src->last_img_size;
+  text->font_generation = src->font_generation;
 
-  text->underline_vertex = src->underline_vertex;
+  text->underline_vertex   = src->underline_vertex;
+  text->layer_vertex_count = src->layer_vertex_count;
 }
 
 uint32_t *say_text_get_string(say_text *text) {
@@ -422,6 +526,54 @@ void say_text_set_color(say_text *text, say_color col) {
   say_drawable_set_changed(text->drawable);
 }
 
+say_vector2 say_text_get_shadow_offset(say_text *text) {
+  return text->shadow_offset;
+}
+
+void say_text_set_shadow_offset(say_text *text, say_vector2 offset) {
+  if (say_vector2_eq(offset, text->shadow_offset))
+    return;
+
+  text->shadow_offset = offset;
+  say_drawable_set_changed(text->drawable);
+}
+
+say_color say_text_get_shadow_color(say_text *text) {
+  return text->shadow_color;
+}
+
+void say_text_set_shadow_color(say_text *text, say_color col) {
+  if (say_color_eq(col, text->shadow_color))
+    return;
+
+  text->shadow_color = col;
+  say_drawable_set_changed(text->drawable);
+}
+
+float say_text_get_outline_width(say_text *text) {
+  return text->outline_width;
+}
+
+void say_text_set_outline_width(say_text *text, float width) {
+  if (width == text->outline_width)
+    return;
+
+  text->outline_width = width;
+  say_drawable_set_changed(text->drawable);
+}
+
+say_color say_text_get_outline_color(say_text *text) {
+  return text->outline_color;
+}
+
+void say_text_set_outline_color(say_text *text, say_color col) {
+  if (say_color_eq(col, text->outline_color))
+    return;
+
+  text->outline_color = col;
+  say_drawable_set_changed(text->drawable);
+}
+
 say_rect say_text_get_rect(say_text *text) {
   if (!text->rect_updated)
     say_text_update_rect(text);
@@ -430,11 +582,30 @@ say_rect say_text_get_rect(say_text *text) {
   say_vector2 scale = say_drawable_get_scale(text->drawable);
   say_vector2 size  = text->rect_size;
 
+  /* Effects are copies of the text, drawn around it */
+  float min_x = 0, min_y = 0, max_x = 0, max_y = 0;
+
+  if (text->style & SAY_TEXT_SHADOWED) {
+    min_x = fminf(min_x, text->shadow_offset.x);
+    min_y = fminf(min_y, text->shadow_offset.y);
+    max_x = fmaxf(max_x, text->shadow_offset.x);
+    max_y = fmaxf(max_y, text->shadow_offset.y);
+  }
+
+  if (text->style & SAY_TEXT_OUTLINED) {
+    float width = fabsf(text->outline_width);
+
+    min_x = fminf(min_x, -width);
+    min_y = fminf(min_y, -width);
+    max_x = fmaxf(max_x, width);
+    max_y = fmaxf(max_y, width);
+  }
+
   say_rect rect = (say_rect){
-    pos.x,
-    pos.y,
-    size.x * scale.x,
-    size.y * scale.y
+    pos.x + min_x * scale.x,
+    pos.y + min_y * scale.y,
+    (size.x + max_x - min_x) * scale.x,
+    (size.y + max_y - min_y) * scale.y
   };
 
   return rect;
@@ -8,6 +8,8 @@
 #define SAY_TEXT_BOLD       0x1
 #define SAY_TEXT_ITALIC     0x2
 #define SAY_TEXT_UNDERLINED 0x4
+#define SAY_TEXT_SHADOWED   0x8
+#define SAY_TEXT_OUTLINED   0x10
 
 typedef struct {
   say_drawable *drawable;
@@ -22,12 +24,20 @@ typedef struct {
 
   say_color color;
 
+  say_vector2 shadow_offset;
+  say_color   shadow_color;
+
+  float     outline_width;
+  say_color outline_color;
+
   say_vector2 rect_size;
   uint8_t rect_updated;
 
   say_vector2 last_img_size;
+  uint32_t    font_generation;
 
   size_t underline_vertex;
+  size_t layer_vertex_count;
 } say_text;
 
 say_text *say_text_create();
@@ -51,6 +61,18 @@ void say_text_set_style(say_text *text, size_t style);
 say_color say_text_get_color(say_text *text);
 void say_text_set_color(say_text *text, say_color col);
 
+say_vector2 say_text_get_shadow_offset(say_text *text);
+void say_text_set_shadow_offset(say_text *text, say_vector2 offset);
+
+say_color say_text_get_shadow_color(say_text *text);
+void say_text_set_shadow_color(say_text *text, say_color col);
+
+float say_text_get_outline_width(say_text *text);
+void say_text_set_outline_width(say_text *text, float width);
+
+say_color say_text_get_outline_color(say_text *text);
+void say_text_set_outline_color(say_text *text, say_color col);
+
 say_rect say_text_get_rect(say_text *text);
 
 #endif /* SAY_TEXT_H_ */
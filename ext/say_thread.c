@@ -28,6 +28,52 @@ void say_thread_free(say_thread *th) {
 void say_thread_join(say_thread *th) {
   WaitForSingleObject(th->th, INFINITE);
 }
+
+size_t say_thread_get_cpu_count() {
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+
+  return info.dwNumberOfProcessors;
+}
+
+say_mutex *say_mutex_create() {
+  say_mutex *mutex = malloc(sizeof(say_mutex));
+  InitializeCriticalSection(&mutex->section);
+
+  return mutex;
+}
+
+void say_mutex_free(say_mutex *mutex) {
+  DeleteCriticalSection(&mutex->section);
+  free(mutex);
+}
+
+void say_mutex_lock(say_mutex *mutex) {
+  EnterCriticalSection(&mutex->section);
+}
+
+void say_mutex_unlock(say_mutex *mutex) {
+  LeaveCriticalSection(&mutex->section);
+}
+
+say_cond *say_cond_create() {
+  say_cond *cond = malloc(sizeof(say_cond));
+  InitializeConditionVariable(&cond->cond);
+
+  return cond;
+}
+
+void say_cond_free(say_cond *cond) {
+  free(cond);
+}
+
+void say_cond_wait(say_cond *cond, say_mutex *mutex) {
+  SleepConditionVariableCS(&cond->cond, &mutex->section, INFINITE);
+}
+
+void say_cond_signal(say_cond *cond) {
+  WakeConditionVariable(&cond->cond);
+}
 #else
 say_thread *say_thread_create(void *data, say_thread_func func) {
   say_thread *th = malloc(sizeof(say_thread));
@@ -43,4 +89,49 @@ void say_thread_free(say_thread *th) {
 void say_thread_join(say_thread *th) {
   pthread_join(th->th, NULL);
 }
+
+size_t say_thread_get_cpu_count() {
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? count : 1;
+}
+
+say_mutex *say_mutex_create() {
+  say_mutex *mutex = malloc(sizeof(say_mutex));
+  pthread_mutex_init(&mutex->mutex, NULL);
+
+  return mutex;
+}
+
+void say_mutex_free(say_mutex *mutex) {
+  pthread_mutex_destroy(&mutex->mutex);
+  free(mutex);
+}
+
+void say_mutex_lock(say_mutex *mutex) {
+  pthread_mutex_lock(&mutex->mutex);
+}
+
+void say_mutex_unlock(say_mutex *mutex) {
+  pthread_mutex_unlock(&mutex->mutex);
+}
+
+say_cond *say_cond_create() {
+  say_cond *cond = malloc(sizeof(say_cond));
+  pthread_cond_init(&cond->cond, NULL);
+
+  return cond;
+}
+
+void say_cond_free(say_cond *cond) {
+  pthread_cond_destroy(&cond->cond);
+  free(cond);
+}
+
+void say_cond_wait(say_cond *cond, say_mutex *mutex) {
+  pthread_cond_wait(&cond->cond, &mutex->mutex);
+}
+
+void say_cond_signal(say_cond *cond) {
+  pthread_cond_signal(&cond->cond);
+}
 #endif
\ No newline at end of file
@@ -5,6 +5,23 @@
 
 typedef void *(*say_thread_func)(void *data);
 
+/*
+ * Compiler-provided thread local storage, which is much cheaper to access than
+ * say_thread_variable. Not defined when unavailable.
+ */
+#if defined(__clang__)
+# if __has_feature(tls) || __has_feature(c_thread_local)
+#  define SAY_THREAD_LOCAL __thread
+# endif
+#elif defined(__GNUC__)
+# define SAY_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+# define SAY_THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && \
+  !defined(__STDC_NO_THREADS__)
+# define SAY_THREAD_LOCAL _Thread_local
+#endif
+
 #ifdef SAY_WIN
 typedef struct {
   DWORD key;
@@ -15,6 +32,14 @@ typedef struct {
   say_thread_func func;
   void *data;
   } say_thread;
+
+typedef struct {
+  CRITICAL_SECTION section;
+} say_mutex;
+
+typedef struct {
+  CONDITION_VARIABLE cond;
+} say_cond;
 #else
 typedef struct {
   pthread_key_t key;
@@ -23,6 +48,14 @@ typedef struct {
 typedef struct {
   pthread_t th;
 } say_thread;
+
+typedef struct {
+  pthread_mutex_t mutex;
+} say_mutex;
+
+typedef struct {
+  pthread_cond_t cond;
+} say_cond;
 #endif
 
 say_thread_variable *say_thread_variable_create(say_destructor destructor);
@@ -36,4 +69,18 @@ void say_thread_free(say_thread *th);
 
 void say_thread_join(say_thread *th);
 
+size_t say_thread_get_cpu_count();
+
+say_mutex *say_mutex_create();
+void say_mutex_free(say_mutex *mutex);
+
+void say_mutex_lock(say_mutex *mutex);
+void say_mutex_unlock(say_mutex *mutex);
+
+say_cond *say_cond_create();
+void say_cond_free(say_cond *cond);
+
+void say_cond_wait(say_cond *cond, say_mutex *mutex);
+void say_cond_signal(say_cond *cond);
+
 #endif
@@ -0,0 +1,658 @@
+#include "say.h"
+
+#include <sys/stat.h>
+
+/*
+ * A tiled image is split in square tiles, each of which gets its own texture
+ * only while it is near the view. Every tile has a quad in the vertex buffer,
+ * but only the visible ones are drawn. Tiles that haven't been drawn recently
+ * are evicted when the resident ones would exceed the memory budget.
+ *
+ * stb_image can't decode part of a file, so files are decoded once and their
+ * tiles written to a cache next to them. Tiles are then read from that cache
+ * when they are needed. Like the compressed texture cache, it is only used
+ * while the size and modification time of the source match.
+ */
+
+#define SAY_TILE_CACHE_MAGIC   0x54594153 /* "SAYT" */
+#define SAY_TILE_CACHE_VERSION 1
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t tile_size;
+  uint32_t width, height;
+  uint64_t source_size;
+  int64_t  source_mtime;
+} say_tile_cache_header;
+
+/*
+ * Tiles remember the frame in which they were last drawn. Frames are counted
+ * globally, so that drawing an image several times (e.g. in several views)
+ * during the same frame doesn't make its tiles look older.
+ */
+static size_t say_tiled_image_frame = 0;
+
+static size_t say_tiled_image_tile_bytes(say_tiled_image *tiled) {
+  return sizeof(say_color) * tiled->tile_size * tiled->tile_size;
+}
+
+static say_rect say_tiled_image_tile_rect(say_tiled_image *tiled,
+                                          size_t x, size_t y) {
+  size_t tx = x * tiled->tile_size, ty = y * tiled->tile_size;
+
+  size_t w = tiled->width  - tx < tiled->tile_size ?
+    tiled->width  - tx : tiled->tile_size;
+  size_t h = tiled->height - ty < tiled->tile_size ?
+    tiled->height - ty : tiled->tile_size;
+
+  return say_make_rect(tx, ty, w, h);
+}
+
+static void say_tiled_image_fill_vertices(void *data, void *vertices_ptr) {
+  say_tiled_image *tiled = (say_tiled_image*)data;
+  say_vertex *vertices   = (say_vertex*)vertices_ptr;
+
+  for (size_t y = 0; y < tiled->tiles_y; y++) {
+    for (size_t x = 0; x < tiled->tiles_x; x++) {
+      say_rect rect = say_tiled_image_tile_rect(tiled, x, y);
+
+      vertices[0].pos = say_make_vector2(rect.x,          rect.y);
+      vertices[1].pos = say_make_vector2(rect.x + rect.w, rect.y);
+      vertices[2].pos = say_make_vector2(rect.x + rect.w, rect.y + rect.h);
+      vertices[3].pos = say_make_vector2(rect.x,          rect.y + rect.h);
+
+      /* Tile textures are exactly as large as the tile */
+      vertices[0].tex = say_make_vector2(0, 0);
+      vertices[1].tex = say_make_vector2(1, 0);
+      vertices[2].tex = say_make_vector2(1, 1);
+      vertices[3].tex = say_make_vector2(0, 1);
+
+      for (size_t i = 0; i < 4; i++)
+        vertices[i].col = tiled->color;
+
+      vertices += 4;
+    }
+  }
+}
+
+/*
+ * Finds the tiles covered by the clip space of the current target, extended by
+ * margin tiles in every direction. Drawables are only translated, rotated and
+ * scaled in 2D, so clip coordinates are an affine function of the position in
+ * the image, which can be inverted to find the corners of the view.
+ */
+static bool say_tiled_image_get_range(say_tiled_image *tiled, size_t margin,
+                                      size_t *x0, size_t *y0,
+                                      size_t *x1, size_t *y1) {
+  *x0 = *y0 = 0;
+  *x1 = tiled->tiles_x;
+  *y1 = tiled->tiles_y;
+
+  say_target *target = say_target_get_current();
+  if (!target)
+    return true;
+
+  say_matrix *model = say_drawable_get_matrix(tiled->drawable);
+  say_matrix *proj  = say_view_get_matrix(say_target_get_view(target));
+
+  say_vector3 p[3] = {
+    say_make_vector3(0, 0, 0), say_make_vector3(1, 0, 0),
+    say_make_vector3(0, 1, 0)
+  };
+
+  for (size_t i = 0; i < 3; i++)
+    p[i] = say_matrix_transform(proj, say_matrix_transform(model, p[i]));
+
+  float ex_x = p[1].x - p[0].x, ex_y = p[1].y - p[0].y;
+  float ey_x = p[2].x - p[0].x, ey_y = p[2].y - p[0].y;
+
+  float det = ex_x * ey_y - ex_y * ey_x;
+  if (det == 0)
+    return false;
+
+  float min_x = INFINITY, min_y = INFINITY;
+  float max_x = -INFINITY, max_y = -INFINITY;
+
+  static const float corners[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+  for (size_t i = 0; i < 4; i++) {
+    float dx = corners[i][0] - p[0].x, dy = corners[i][1] - p[0].y;
+
+    float x = (dx * ey_y - dy * ey_x) / det;
+    float y = (ex_x * dy - ex_y * dx) / det;
+
+    if (x < min_x) min_x = x;
+    if (x > max_x) max_x = x;
+    if (y < min_y) min_y = y;
+    if (y > max_y) max_y = y;
+  }
+
+  if (max_x < 0 || max_y < 0 ||
+      min_x >= tiled->width || min_y >= tiled->height)
+    return false;
+
+  float size = tiled->tile_size;
+
+  long first_x = floorf(min_x / size) - (long)margin;
+  long first_y = floorf(min_y / size) - (long)margin;
+  long last_x  = floorf(max_x / size) + 1 + (long)margin;
+  long last_y  = floorf(max_y / size) + 1 + (long)margin;
+
+  *x0 = first_x < 0 ? 0 : first_x;
+  *y0 = first_y < 0 ? 0 : first_y;
+  *x1 = last_x > (long)tiled->tiles_x ? tiled->tiles_x : (size_t)last_x;
+  *y1 = last_y > (long)tiled->tiles_y ? tiled->tiles_y : (size_t)last_y;
+
+  return true;
+}
+
+static void say_tiled_image_evict(say_tiled_image *tiled, size_t slot) {
+  size_t index = *(size_t*)say_array_get(tiled->resident, slot);
+  say_tile *tile = &tiled->tiles[index];
+
+  tiled->resident_bytes -= sizeof(say_color) *
+    say_image_get_width(tile->image) * say_image_get_height(tile->image);
+
+  say_image_free(tile->image);
+  tile->image = NULL;
+
+  /* Order doesn't matter, move the last index to the freed slot */
+  size_t last = say_array_get_size(tiled->resident) - 1;
+  if (slot != last) {
+    *(size_t*)say_array_get(tiled->resident, slot) =
+      *(size_t*)say_array_get(tiled->resident, last);
+  }
+  say_array_resize(tiled->resident, last);
+
+  tiled->eviction_count++;
+}
+
+/*
+ * Evicts the least recently used tiles until bytes more fit in the budget.
+ * Tiles used during the current frame are never evicted, so this returns false
+ * if there isn't enough room without them.
+ */
+static bool say_tiled_image_make_room(say_tiled_image *tiled, size_t bytes) {
+  while (tiled->resident_bytes + bytes > tiled->budget) {
+    size_t oldest = SIZE_MAX, oldest_frame = say_tiled_image_frame;
+
+    for (size_t i = 0; i < say_array_get_size(tiled->resident); i++) {
+      size_t index = *(size_t*)say_array_get(tiled->resident, i);
+      size_t used  = tiled->tiles[index].last_used;
+
+      if (used < oldest_frame) {
+        oldest       = i;
+        oldest_frame = used;
+      }
+    }
+
+    if (oldest == SIZE_MAX)
+      return false;
+
+    say_tiled_image_evict(tiled, oldest);
+  }
+
+  return true;
+}
+
+static bool say_tiled_image_read_tile(say_tiled_image *tiled, say_rect rect,
+                                      size_t index, say_color *pixels) {
+  size_t w = rect.w, h = rect.h;
+
+  if (tiled->file) {
+    /* Tiles are stored padded to the full tile size */
+    size_t count = tiled->tile_size * tiled->tile_size;
+    off_t offset = sizeof(say_tile_cache_header) +
+      (off_t)index * say_tiled_image_tile_bytes(tiled);
+
+    say_color *tile = malloc(sizeof(say_color) * count);
+
+    if (fseeko(tiled->file, offset, SEEK_SET) != 0 ||
+        fread(tile, sizeof(say_color), count, tiled->file) != count) {
+      free(tile);
+      return false;
+    }
+
+    for (size_t y = 0; y < h; y++) {
+      memcpy(&pixels[y * w], &tile[y * tiled->tile_size],
+             sizeof(say_color) * w);
+    }
+
+    free(tile);
+  }
+  else {
+    say_color *src = say_image_get_buffer(tiled->source);
+    size_t stride  = say_image_get_width(tiled->source);
+
+    src += (size_t)rect.y * stride + (size_t)rect.x;
+    for (size_t y = 0; y < h; y++)
+      memcpy(&pixels[y * w], &src[y * stride], sizeof(say_color) * w);
+  }
+
+  return true;
+}
+
+static bool say_tiled_image_load_tile(say_tiled_image *tiled,
+                                      size_t x, size_t y) {
+  size_t index   = y * tiled->tiles_x + x;
+  say_tile *tile = &tiled->tiles[index];
+
+  say_rect rect = say_tiled_image_tile_rect(tiled, x, y);
+  size_t bytes  = sizeof(say_color) * (size_t)rect.w * (size_t)rect.h;
+
+  say_tiled_image_make_room(tiled, bytes);
+
+  say_image *img = say_image_create();
+  say_image_set_keep_pixels(img, false);
+
+  if (!say_image_create_with_size(img, rect.w, rect.h) ||
+      !say_tiled_image_read_tile(tiled, rect, index,
+                                 say_image_get_buffer(img))) {
+    say_image_free(img);
+    return false;
+  }
+
+  /* Uploads the pixels right away, which also drops the CPU copy */
+  say_image_bind(img);
+
+  tile->image = img;
+  say_array_push(tiled->resident, &index);
+
+  tiled->resident_bytes += bytes;
+  tiled->load_count++;
+
+  return true;
+}
+
+static void say_tiled_image_draw(void *data, size_t first, size_t index,
+                                 say_shader *shader) {
+  say_tiled_image *tiled = (say_tiled_image*)data;
+
+  tiled->visible_count = 0;
+
+  size_t x0, y0, x1, y1;
+  if (!tiled->tiles ||
+      !say_tiled_image_get_range(tiled, 0, &x0, &y0, &x1, &y1))
+    return;
+
+  for (size_t y = y0; y < y1; y++) {
+    for (size_t x = x0; x < x1; x++) {
+      say_tile *tile = &tiled->tiles[y * tiled->tiles_x + x];
+
+      if (!tile->image && !say_tiled_image_load_tile(tiled, x, y))
+        continue;
+
+      tile->last_used = say_tiled_image_frame;
+      tiled->visible_count++;
+
+      say_image_bind(tile->image);
+      say_draw_arrays(GL_TRIANGLE_FAN, first + 4 * (y * tiled->tiles_x + x),
+                      4);
+    }
+  }
+
+  if (tiled->margin == 0 ||
+      !say_tiled_image_get_range(tiled, tiled->margin, &x0, &y0, &x1, &y1))
+    return;
+
+  /*
+   * Tiles around the view are kept resident, and at most one missing tile is
+   * loaded per frame so that scrolling doesn't stall on many uploads at once.
+   */
+  bool loaded = tiled->prefetch_frame == say_tiled_image_frame;
+  for (size_t y = y0; y < y1; y++) {
+    for (size_t x = x0; x < x1; x++) {
+      say_tile *tile = &tiled->tiles[y * tiled->tiles_x + x];
+
+      if (tile->image)
+        tile->last_used = say_tiled_image_frame;
+      else if (!loaded) {
+        say_rect rect = say_tiled_image_tile_rect(tiled, x, y);
+        size_t bytes  = sizeof(say_color) * (size_t)rect.w * (size_t)rect.h;
+
+        if (say_tiled_image_make_room(tiled, bytes) &&
+            say_tiled_image_load_tile(tiled, x, y)) {
+          tile->last_used = say_tiled_image_frame;
+        }
+
+        tiled->prefetch_frame = say_tiled_image_frame;
+        loaded = true;
+      }
+    }
+  }
+}
+
+say_tiled_image *say_tiled_image_create() {
+  say_tiled_image *tiled = malloc(sizeof(say_tiled_image));
+
+  tiled->drawable = say_drawable_create(0);
+  say_drawable_set_custom_data(tiled->drawable, tiled);
+  say_drawable_set_textured(tiled->drawable, 1);
+  say_drawable_set_fill_proc(tiled->drawable, say_tiled_image_fill_vertices);
+  say_drawable_set_render_proc(tiled->drawable, say_tiled_image_draw);
+
+  tiled->width = tiled->height = 0;
+  tiled->tile_size = SAY_TILED_IMAGE_DEFAULT_TILE_SIZE;
+  tiled->tiles_x = tiled->tiles_y = 0;
+
+  tiled->tiles    = NULL;
+  tiled->resident = say_array_create(sizeof(size_t), NULL, NULL);
+
+  tiled->file   = NULL;
+  tiled->source = NULL;
+
+  tiled->color = say_make_color(255, 255, 255, 255);
+
+  tiled->budget         = SAY_TILED_IMAGE_DEFAULT_BUDGET;
+  tiled->resident_bytes = 0;
+  tiled->margin         = 1;
+
+  tiled->prefetch_frame = SIZE_MAX;
+  tiled->visible_count  = 0;
+  tiled->load_count     = 0;
+  tiled->eviction_count = 0;
+
+  return tiled;
+}
+
+static void say_tiled_image_clear(say_tiled_image *tiled) {
+  say_tiled_image_evict_all(tiled);
+
+  if (tiled->tiles) {
+    free(tiled->tiles);
+    tiled->tiles = NULL;
+  }
+
+  if (tiled->file) {
+    fclose(tiled->file);
+    tiled->file = NULL;
+  }
+
+  if (tiled->source) {
+    say_image_free(tiled->source);
+    tiled->source = NULL;
+  }
+}
+
+void say_tiled_image_free(say_tiled_image *tiled) {
+  say_tiled_image_clear(tiled);
+
+  say_array_free(tiled->resident);
+  say_drawable_free(tiled->drawable);
+  free(tiled);
+}
+
+/* Every tile must fit in a texture */
+static bool say_tiled_image_check_tile_size(size_t tile_size) {
+  if (tile_size == 0) {
+    say_error_set("tile size must be positive");
+    return false;
+  }
+
+  size_t max = say_image_get_max_texture_size();
+  if (max != 0 && tile_size > max) {
+    say_error_set("tile size is larger than the maximum texture size");
+    return false;
+  }
+
+  return true;
+}
+
+static bool say_tiled_image_check_size(size_t w, size_t h) {
+  if (w == 0 || h == 0) {
+    say_error_set("can't create empty tiled image");
+    return false;
+  }
+
+  return true;
+}
+
+/*
+ * Replaces the tiles of the image. Only called once the new content was
+ * loaded, so that failing to load leaves the image unchanged.
+ */
+static void say_tiled_image_setup(say_tiled_image *tiled, size_t w, size_t h,
+                                  size_t tile_size, FILE *file,
+                                  say_image *source) {
+  say_tiled_image_clear(tiled);
+
+  tiled->file   = file;
+  tiled->source = source;
+
+  tiled->width     = w;
+  tiled->height    = h;
+  tiled->tile_size = tile_size;
+  tiled->tiles_x   = (w + tile_size - 1) / tile_size;
+  tiled->tiles_y   = (h + tile_size - 1) / tile_size;
+
+  size_t count = tiled->tiles_x * tiled->tiles_y;
+  tiled->tiles = malloc(sizeof(say_tile) * count);
+
+  for (size_t i = 0; i < count; i++) {
+    tiled->tiles[i].image     = NULL;
+    tiled->tiles[i].last_used = 0;
+  }
+
+  say_drawable_set_vertex_count(tiled->drawable, 4 * count);
+  say_drawable_set_changed(tiled->drawable);
+}
+
+static FILE *say_tile_cache_open(const char *path, size_t tile_size,
+                                 struct stat *source,
+                                 say_tile_cache_header *header) {
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return NULL;
+
+  if (fread(header, sizeof(*header), 1, file) != 1 ||
+      header->magic != SAY_TILE_CACHE_MAGIC ||
+      header->version != SAY_TILE_CACHE_VERSION ||
+      header->tile_size != (uint32_t)tile_size ||
+      header->width == 0 || header->height == 0 ||
+      header->source_size != (uint64_t)source->st_size ||
+      header->source_mtime != (int64_t)source->st_mtime) {
+    fclose(file);
+    return NULL;
+  }
+
+  return file;
+}
+
+static bool say_tile_cache_write(const char *path, say_image *img,
+                                 size_t tile_size, struct stat *source) {
+  FILE *file = fopen(path, "wb");
+  if (!file)
+    return false;
+
+  size_t w = say_image_get_width(img), h = say_image_get_height(img);
+
+  say_tile_cache_header header = {
+    SAY_TILE_CACHE_MAGIC, SAY_TILE_CACHE_VERSION, tile_size, w, h,
+    source->st_size, source->st_mtime
+  };
+
+  say_color *pixels = say_image_get_buffer(img);
+  say_color *tile   = calloc(tile_size * tile_size, sizeof(say_color));
+
+  bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+
+  for (size_t ty = 0; success && ty < h; ty += tile_size) {
+    for (size_t tx = 0; success && tx < w; tx += tile_size) {
+      size_t tw = w - tx < tile_size ? w - tx : tile_size;
+      size_t th = h - ty < tile_size ? h - ty : tile_size;
+
+      for (size_t y = 0; y < th; y++) {
+        memcpy(&tile[y * tile_size], &pixels[(ty + y) * w + tx],
+               sizeof(say_color) * tw);
+      }
+
+      success = fwrite(tile, sizeof(say_color), tile_size * tile_size,
+                       file) == tile_size * tile_size;
+    }
+  }
+
+  free(tile);
+
+  if (fclose(file) != 0 || !success) {
+    remove(path);
+    return false;
+  }
+
+  return true;
+}
+
+bool say_tiled_image_load_file(say_tiled_image *tiled, const char *filename,
+                               size_t tile_size) {
+  if (!say_tiled_image_check_tile_size(tile_size))
+    return false;
+
+  struct stat source;
+  if (stat(filename, &source) != 0) {
+    say_error_set("could not open image file");
+    return false;
+  }
+
+  char *path = malloc(strlen(filename) + 32);
+  sprintf(path, "%s.tiles%zu", filename, tile_size);
+
+  say_tile_cache_header header;
+  FILE *file = say_tile_cache_open(path, tile_size, &source, &header);
+
+  if (!file) {
+    say_image *img = say_image_create();
+    if (!say_image_load_file(img, filename)) {
+      say_image_free(img);
+      free(path);
+
+      say_error_set("could not load image file");
+      return false;
+    }
+
+    if (say_tile_cache_write(path, img, tile_size, &source))
+      file = say_tile_cache_open(path, tile_size, &source, &header);
+
+    if (!file) {
+      /* The cache can't be written, keep the decoded image instead */
+      free(path);
+
+      size_t w = say_image_get_width(img), h = say_image_get_height(img);
+      if (!say_tiled_image_check_size(w, h)) {
+        say_image_free(img);
+        return false;
+      }
+
+      say_tiled_image_setup(tiled, w, h, tile_size, NULL, img);
+      return true;
+    }
+
+    say_image_free(img);
+  }
+
+  free(path);
+
+  say_tiled_image_setup(tiled, header.width, header.height, tile_size, file,
+                        NULL);
+  return true;
+}
+
+bool say_tiled_image_load_image(say_tiled_image *tiled, say_image *img,
+                                size_t tile_size) {
+  size_t w = say_image_get_width(img), h = say_image_get_height(img);
+  if (!say_tiled_image_check_tile_size(tile_size) ||
+      !say_tiled_image_check_size(w, h))
+    return false;
+
+  /* Copied so that the image can change or be freed afterward */
+  say_image *source = say_image_create();
+  say_image_load_raw(source, w, h, say_image_get_buffer(img));
+
+  say_tiled_image_setup(tiled, w, h, tile_size, NULL, source);
+  return true;
+}
+
+size_t say_tiled_image_get_width(say_tiled_image *tiled) {
+  return tiled->width;
+}
+
+size_t say_tiled_image_get_height(say_tiled_image *tiled) {
+  return tiled->height;
+}
+
+size_t say_tiled_image_get_tile_size(say_tiled_image *tiled) {
+  return tiled->tile_size;
+}
+
+say_vector2 say_tiled_image_get_tile_count(say_tiled_image *tiled) {
+  return say_make_vector2(tiled->tiles_x, tiled->tiles_y);
+}
+
+say_color say_tiled_image_get_color(say_tiled_image *tiled) {
+  return tiled->color;
+}
+
+void say_tiled_image_set_color(say_tiled_image *tiled, say_color color) {
+  if (say_color_eq(color, tiled->color))
+    return;
+
+  tiled->color = color;
+  say_drawable_set_changed(tiled->drawable);
+}
+
+size_t say_tiled_image_get_budget(say_tiled_image *tiled) {
+  return tiled->budget;
+}
+
+void say_tiled_image_set_budget(say_tiled_image *tiled, size_t budget) {
+  tiled->budget = budget;
+}
+
+size_t say_tiled_image_get_margin(say_tiled_image *tiled) {
+  return tiled->margin;
+}
+
+void say_tiled_image_set_margin(say_tiled_image *tiled, size_t margin) {
+  tiled->margin = margin;
+}
+
+bool say_tiled_image_is_resident(say_tiled_image *tiled, size_t x, size_t y) {
+  if (x >= tiled->tiles_x || y >= tiled->tiles_y)
+    return false;
+
+  return tiled->tiles[y * tiled->tiles_x + x].image != NULL;
+}
+
+size_t say_tiled_image_get_resident_count(say_tiled_image *tiled) {
+  return say_array_get_size(tiled->resident);
+}
+
+size_t say_tiled_image_get_resident_bytes(say_tiled_image *tiled) {
+  return tiled->resident_bytes;
+}
+
+size_t say_tiled_image_get_visible_count(say_tiled_image *tiled) {
+  return tiled->visible_count;
+}
+
+size_t say_tiled_image_get_load_count(say_tiled_image *tiled) {
+  return tiled->load_count;
+}
+
+size_t say_tiled_image_get_eviction_count(say_tiled_image *tiled) {
+  return tiled->eviction_count;
+}
+
+void say_tiled_image_evict_all(say_tiled_image *tiled) {
+  if (say_array_get_size(tiled->resident) != 0)
+    say_context_ensure();
+
+  while (say_array_get_size(tiled->resident) != 0)
+    say_tiled_image_evict(tiled, 0);
+}
+
+size_t say_tiled_image_get_frame() {
+  return say_tiled_image_frame;
+}
+
+void say_tiled_image_end_frame() {
+  say_tiled_image_frame++;
+}
@@ -0,0 +1,75 @@
+#ifndef SAY_TILED_IMAGE_H_
+#define SAY_TILED_IMAGE_H_
+
+#include "say_drawable.h"
+#include "say_image.h"
+
+#define SAY_TILED_IMAGE_DEFAULT_TILE_SIZE 256
+#define SAY_TILED_IMAGE_DEFAULT_BUDGET    (64 * 1024 * 1024)
+
+typedef struct {
+  say_image *image; /* NULL while the tile isn't resident */
+  size_t last_used; /* Frame in which the tile was last drawn */
+} say_tile;
+
+typedef struct {
+  say_drawable *drawable;
+
+  size_t width, height;
+  size_t tile_size;
+  size_t tiles_x, tiles_y;
+
+  say_tile *tiles;
+  say_array *resident; /* Indices of the tiles that have a texture */
+
+  /* Tiles are read either from a tile cache file or from an image */
+  FILE *file;
+  say_image *source;
+
+  say_color color;
+
+  size_t budget;
+  size_t resident_bytes;
+  size_t margin;
+
+  size_t prefetch_frame; /* Frame in which a margin tile was last loaded */
+  size_t visible_count;
+  size_t load_count;
+  size_t eviction_count;
+} say_tiled_image;
+
+say_tiled_image *say_tiled_image_create();
+void say_tiled_image_free(say_tiled_image *tiled);
+
+bool say_tiled_image_load_file(say_tiled_image *tiled, const char *filename,
+                               size_t tile_size);
+bool say_tiled_image_load_image(say_tiled_image *tiled, say_image *img,
+                                size_t tile_size);
+
+size_t say_tiled_image_get_width(say_tiled_image *tiled);
+size_t say_tiled_image_get_height(say_tiled_image *tiled);
+size_t say_tiled_image_get_tile_size(say_tiled_image *tiled);
+say_vector2 say_tiled_image_get_tile_count(say_tiled_image *tiled);
+
+say_color say_tiled_image_get_color(say_tiled_image *tiled);
+void say_tiled_image_set_color(say_tiled_image *tiled, say_color color);
+
+size_t say_tiled_image_get_budget(say_tiled_image *tiled);
+void say_tiled_image_set_budget(say_tiled_image *tiled, size_t budget);
+
+size_t say_tiled_image_get_margin(say_tiled_image *tiled);
+void say_tiled_image_set_margin(say_tiled_image *tiled, size_t margin);
+
+bool say_tiled_image_is_resident(say_tiled_image *tiled, size_t x, size_t y);
+size_t say_tiled_image_get_resident_count(say_tiled_image *tiled);
+size_t say_tiled_image_get_resident_bytes(say_tiled_image *tiled);
+size_t say_tiled_image_get_visible_count(say_tiled_image *tiled);
+size_t say_tiled_image_get_load_count(say_tiled_image *tiled);
+size_t say_tiled_image_get_eviction_count(say_tiled_image *tiled);
+
+void say_tiled_image_evict_all(say_tiled_image *tiled);
+
+size_t say_tiled_image_get_frame();
+void say_tiled_image_end_frame();
+
+#endif
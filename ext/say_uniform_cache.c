@@ -0,0 +1,185 @@
+#include "say.h"
+
+static size_t say_uniform_elided_count = 0;
+static size_t say_uniform_upload_count = 0;
+
+static uint32_t say_uniform_hash(const char *name) {
+  uint32_t hash = 2166136261u;
+  for (; *name; name++) {
+    hash ^= (uint8_t)*name;
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+say_uniform_cache *say_uniform_cache_create() {
+  say_uniform_cache *cache = malloc(sizeof(say_uniform_cache));
+
+  cache->names         = NULL;
+  cache->name_capacity = 0;
+  cache->name_count    = 0;
+
+  cache->values = say_array_create(sizeof(say_uniform_value), NULL, NULL);
+
+  return cache;
+}
+
+void say_uniform_cache_clear(say_uniform_cache *cache) {
+  for (size_t i = 0; i < cache->name_capacity; i++) {
+    if (cache->names[i].name) {
+      free(cache->names[i].name);
+      cache->names[i].name = NULL;
+    }
+  }
+
+  cache->name_count = 0;
+  say_array_resize(cache->values, 0);
+}
+
+void say_uniform_cache_free(say_uniform_cache *cache) {
+  say_uniform_cache_clear(cache);
+
+  free(cache->names);
+  say_array_free(cache->values);
+  free(cache);
+}
+
+/* Open addressing, so the capacity is always a power of two */
+static say_uniform_name *say_uniform_cache_find(say_uniform_cache *cache,
+                                                const char *name,
+                                                uint32_t hash) {
+  size_t mask = cache->name_capacity - 1;
+
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    say_uniform_name *entry = &cache->names[i];
+
+    if (!entry->name ||
+        (entry->hash == hash && strcmp(entry->name, name) == 0))
+      return entry;
+  }
+}
+
+bool say_uniform_cache_get_location(say_uniform_cache *cache,
+                                    const char *name, GLint *loc) {
+  if (cache->name_count == 0)
+    return false;
+
+  say_uniform_name *entry = say_uniform_cache_find(cache, name,
+                                                   say_uniform_hash(name));
+  if (!entry->name)
+    return false;
+
+  *loc = entry->loc;
+  return true;
+}
+
+static void say_uniform_cache_grow(say_uniform_cache *cache) {
+  say_uniform_name *old_names = cache->names;
+  size_t old_capacity = cache->name_capacity;
+
+  cache->name_capacity = old_capacity ? old_capacity * 2 : 16;
+  cache->names = calloc(cache->name_capacity, sizeof(say_uniform_name));
+
+  for (size_t i = 0; i < old_capacity; i++) {
+    if (old_names[i].name) {
+      *say_uniform_cache_find(cache, old_names[i].name, old_names[i].hash) =
+        old_names[i];
+    }
+  }
+
+  free(old_names);
+}
+
+void say_uniform_cache_set_location(say_uniform_cache *cache,
+                                    const char *name, GLint loc) {
+  if ((cache->name_count + 1) * 4 > cache->name_capacity * 3)
+    say_uniform_cache_grow(cache);
+
+  uint32_t hash = say_uniform_hash(name);
+  say_uniform_name *entry = say_uniform_cache_find(cache, name, hash);
+
+  if (!entry->name) {
+    entry->name = say_strdup(name);
+    entry->hash = hash;
+    cache->name_count++;
+  }
+
+  entry->loc = loc;
+}
+
+/* Programs only have a few uniforms, a linear search is enough */
+static say_uniform_value *say_uniform_cache_value(say_uniform_cache *cache,
+                                                  GLint loc) {
+  size_t size = say_array_get_size(cache->values);
+  for (size_t i = 0; i < size; i++) {
+    say_uniform_value *value = say_array_get(cache->values, i);
+    if (value->loc == loc)
+      return value;
+  }
+
+  say_uniform_value value;
+  value.loc  = loc;
+  value.kind = SAY_UNIFORM_UNSET;
+
+  say_array_push(cache->values, &value);
+  return say_array_get(cache->values, size);
+}
+
+static bool say_uniform_cache_changed(bool changed) {
+  if (changed)
+    say_uniform_upload_count++;
+  else
+    say_uniform_elided_count++;
+
+  return changed;
+}
+
+bool say_uniform_cache_update_int(say_uniform_cache *cache, GLint loc,
+                                  int val) {
+  say_uniform_value *value = say_uniform_cache_value(cache, loc);
+
+  if (value->kind == SAY_UNIFORM_INT && value->val.i == val)
+    return say_uniform_cache_changed(false);
+
+  value->kind  = SAY_UNIFORM_INT;
+  value->val.i = val;
+
+  return say_uniform_cache_changed(true);
+}
+
+bool say_uniform_cache_update_floats(say_uniform_cache *cache, GLint loc,
+                                     size_t count, const float *val) {
+  say_uniform_value *value = say_uniform_cache_value(cache, loc);
+
+  if (value->kind == SAY_UNIFORM_FLOATS && value->count == count &&
+      memcmp(value->val.f, val, sizeof(float) * count) == 0)
+    return say_uniform_cache_changed(false);
+
+  value->kind  = SAY_UNIFORM_FLOATS;
+  value->count = count;
+  memcpy(value->val.f, val, sizeof(float) * count);
+
+  return say_uniform_cache_changed(true);
+}
+
+bool say_uniform_cache_update_matrix(say_uniform_cache *cache, GLint loc,
+                                     uint64_t version) {
+  say_uniform_value *value = say_uniform_cache_value(cache, loc);
+
+  if (value->kind == SAY_UNIFORM_MATRIX && value->val.version == version)
+    return say_uniform_cache_changed(false);
+
+  value->kind        = SAY_UNIFORM_MATRIX;
+  value->val.version = version;
+
+  return say_uniform_cache_changed(true);
+}
+
+size_t say_uniform_cache_get_elided_count() {
+  return say_uniform_elided_count;
+}
+
+size_t say_uniform_cache_get_upload_count() {
+  return say_uniform_upload_count;
+}
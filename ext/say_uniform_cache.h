@@ -0,0 +1,69 @@
+#ifndef SAY_UNIFORM_CACHE_H_
+#define SAY_UNIFORM_CACHE_H_
+
+#include "say_basic_type.h"
+#include "say_array.h"
+
+typedef enum {
+  SAY_UNIFORM_UNSET = 0,
+  SAY_UNIFORM_INT,
+  SAY_UNIFORM_FLOATS,
+  SAY_UNIFORM_MATRIX
+} say_uniform_kind;
+
+/* Value last uploaded to a uniform */
+typedef struct {
+  GLint loc;
+  say_uniform_kind kind;
+  size_t count;
+
+  union {
+    int i;
+    float f[4];
+    uint64_t version;
+  } val;
+} say_uniform_value;
+
+typedef struct {
+  char *name;
+  uint32_t hash;
+  GLint loc;
+} say_uniform_name;
+
+/*
+ * Locations of the uniforms of a program, looked up by name, and the values
+ * they were last set to. Programs reset their uniforms when linked, and so
+ * must the cache.
+ */
+typedef struct {
+  say_uniform_name *names;
+  size_t name_capacity, name_count;
+
+  say_array *values;
+} say_uniform_cache;
+
+say_uniform_cache *say_uniform_cache_create();
+void say_uniform_cache_free(say_uniform_cache *cache);
+
+void say_uniform_cache_clear(say_uniform_cache *cache);
+
+/* Returns false if the location of name isn't known yet */
+bool say_uniform_cache_get_location(say_uniform_cache *cache,
+                                    const char *name, GLint *loc);
+void say_uniform_cache_set_location(say_uniform_cache *cache,
+                                    const char *name, GLint loc);
+
+/*
+ * Each of those returns true, and remembers the new value, if it is different
+ * from the one last set.
+ */
+bool say_uniform_cache_update_int(say_uniform_cache *cache, GLint loc, int val);
+bool say_uniform_cache_update_floats(say_uniform_cache *cache, GLint loc,
+                                     size_t count, const float *val);
+bool say_uniform_cache_update_matrix(say_uniform_cache *cache, GLint loc,
+                                     uint64_t version);
+
+size_t say_uniform_cache_get_elided_count();
+size_t say_uniform_cache_get_upload_count();
+
+#endif
@@ -0,0 +1,144 @@
+#include "say.h"
+
+#define SAY_UNIFORM_STREAM_SIZE   (64 * 1024)
+#define SAY_UNIFORM_MATRIX_SIZE   (16 * sizeof(float))
+
+static say_uniform_stream *say_uniform_stream_shared = NULL;
+
+bool say_uniform_stream_is_available() {
+  return say_shader_uses_uniform_blocks();
+}
+
+static say_uniform_stream *say_uniform_stream_create() {
+  say_uniform_stream *stream = malloc(sizeof(say_uniform_stream));
+
+  /* Each range must start at a multiple of the alignment */
+  GLint alignment = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  if (alignment < 1)
+    alignment = 1;
+
+  stream->stride = ((SAY_UNIFORM_MATRIX_SIZE + alignment - 1) / alignment) *
+    alignment;
+
+  stream->capacity = SAY_UNIFORM_STREAM_SIZE;
+  stream->offset   = 0;
+
+  glGenBuffers(1, &stream->ubo);
+  say_gl_state_bind_ubo(say_gl_state_current(), stream->ubo);
+  glBufferData(GL_UNIFORM_BUFFER, stream->capacity, NULL, GL_STREAM_DRAW);
+
+  stream->last_matrix = NULL;
+  stream->last_version = 0;
+  stream->last_offset  = 0;
+
+  stream->batch  = say_array_create(sizeof(say_uniform_slot), NULL, NULL);
+  stream->cursor = 0;
+
+  return stream;
+}
+
+say_uniform_stream *say_uniform_stream_get() {
+  if (!say_uniform_stream_shared) {
+    say_context_ensure();
+    say_uniform_stream_shared = say_uniform_stream_create();
+  }
+
+  return say_uniform_stream_shared;
+}
+
+/*
+ * Returns the offset at which size bytes can be written. The storage of the
+ * buffer is replaced when they don't fit, so draws still using the previous
+ * data don't need to be waited for.
+ */
+static size_t say_uniform_stream_reserve(say_uniform_stream *stream,
+                                         size_t size, say_render_ctx *ctx) {
+  say_gl_state_bind_ubo(ctx->gl, stream->ubo);
+
+  if (stream->offset + size > stream->capacity) {
+    while (stream->capacity < size)
+      stream->capacity *= 2;
+
+    glBufferData(GL_UNIFORM_BUFFER, stream->capacity, NULL, GL_STREAM_DRAW);
+
+    stream->offset      = 0;
+    stream->last_matrix = NULL;
+
+    /* The matrices of the current batch are gone */
+    say_uniform_stream_end_batch(stream);
+  }
+
+  size_t offset = stream->offset;
+  stream->offset += size;
+
+  return offset;
+}
+
+void say_uniform_stream_begin_batch(say_uniform_stream *stream,
+                                    say_matrix **matrices, size_t count,
+                                    say_render_ctx *ctx) {
+  say_uniform_stream_end_batch(stream);
+  if (count == 0)
+    return;
+
+  size_t offset = say_uniform_stream_reserve(stream, count * stream->stride,
+                                             ctx);
+  say_array_resize(stream->batch, count);
+
+  uint8_t *data = calloc(count, stream->stride);
+  for (size_t i = 0; i < count; i++) {
+    memcpy(data + i * stream->stride, matrices[i]->content,
+           SAY_UNIFORM_MATRIX_SIZE);
+
+    say_uniform_slot *slot = say_array_get(stream->batch, i);
+    slot->matrix = matrices[i];
+    slot->offset = offset + i * stream->stride;
+  }
+
+  glBufferSubData(GL_UNIFORM_BUFFER, offset, count * stream->stride, data);
+  free(data);
+}
+
+void say_uniform_stream_end_batch(say_uniform_stream *stream) {
+  say_array_resize(stream->batch, 0);
+  stream->cursor = 0;
+}
+
+void say_uniform_stream_bind_matrix(say_uniform_stream *stream, GLuint index,
+                                    say_matrix *matrix, say_render_ctx *ctx) {
+  size_t offset;
+
+  /*
+   * Draws may skip some of the matrices of the batch, e.g. if their shader
+   * doesn't use uniform blocks, but they are never reordered.
+   */
+  say_uniform_slot *slot = NULL;
+  for (size_t i = stream->cursor; i < say_array_get_size(stream->batch); i++) {
+    say_uniform_slot *it = say_array_get(stream->batch, i);
+    if (it->matrix == matrix) {
+      slot = it;
+      stream->cursor = i + 1;
+      break;
+    }
+  }
+
+  if (slot)
+    offset = slot->offset;
+  else if (stream->last_matrix == matrix &&
+           stream->last_version == matrix->version) {
+    offset = stream->last_offset;
+  }
+  else {
+    offset = say_uniform_stream_reserve(stream, stream->stride, ctx);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, SAY_UNIFORM_MATRIX_SIZE,
+                    matrix->content);
+
+    stream->last_matrix  = matrix;
+    stream->last_version = matrix->version;
+    stream->last_offset  = offset;
+  }
+
+  say_gl_state_bind_ubo_range(ctx->gl, index, stream->ubo, offset,
+                              SAY_UNIFORM_MATRIX_SIZE);
+}
@@ -0,0 +1,56 @@
+#ifndef SAY_UNIFORM_STREAM_H_
+#define SAY_UNIFORM_STREAM_H_
+
+#include "say_basic_type.h"
+#include "say_array.h"
+#include "say_matrix.h"
+#include "say_context.h"
+
+typedef struct {
+  say_matrix *matrix;
+  size_t offset;
+} say_uniform_slot;
+
+/*
+ * Uniform buffer matrices are written to one after the other, so that each
+ * draw can use a different range of it. When it is full, its storage is
+ * orphaned instead of waiting for draws that still use it.
+ */
+typedef struct {
+  GLuint ubo;
+  size_t capacity, offset;
+  size_t stride;
+
+  /* Last matrix written, reused if it didn't change since */
+  say_matrix *last_matrix;
+  uint64_t last_version;
+  size_t last_offset;
+
+  /* Matrices written ahead of a batch of draws, in the order they are used */
+  say_array *batch;
+  size_t cursor;
+} say_uniform_stream;
+
+/*
+ * True if uniform blocks can be used: this requires ARB_uniform_buffer_object
+ * and GLSL 1.40 shaders.
+ */
+bool say_uniform_stream_is_available();
+
+/* The stream shared by every context */
+say_uniform_stream *say_uniform_stream_get();
+
+/*
+ * Writes all of the matrices at once. Binding them in the same order
+ * afterwards doesn't need to upload anything.
+ */
+void say_uniform_stream_begin_batch(say_uniform_stream *stream,
+                                    say_matrix **matrices, size_t count,
+                                    say_render_ctx *ctx);
+void say_uniform_stream_end_batch(say_uniform_stream *stream);
+
+/* Binds a range of the stream containing matrix to a uniform block binding */
+void say_uniform_stream_bind_matrix(say_uniform_stream *stream, GLuint index,
+                                    say_matrix *matrix, say_render_ctx *ctx);
+
+#endif
@@ -137,9 +137,9 @@ uint8_t say_view_has_changed(say_view *view) {
   return view->has_changed;
 }
 
-void say_view_apply(say_view *view, say_shader *shader, say_vector2 size) {
-  say_shader_set_matrix_id(shader, SAY_PROJECTION_LOC_ID,
-                           say_view_get_matrix(view));
+void say_view_apply(say_view *view, say_shader *shader, say_vector2 size,
+                    say_render_ctx *ctx) {
+  say_shader_set_projection(shader, say_view_get_matrix(view), ctx);
 
   glViewport(view->viewport.x * size.x,
              size.y - (view->viewport.y + view->viewport.h) * size.y,
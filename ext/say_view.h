@@ -39,6 +39,7 @@ say_matrix *say_view_get_matrix(say_view *view);
 void say_view_set_matrix(say_view *view, say_matrix *matrix);
 
 uint8_t say_view_has_changed(say_view *view);
-void say_view_apply(say_view *view, say_shader *shader, say_vector2 size);
+void say_view_apply(say_view *view, say_shader *shader, say_vector2 size,
+                    say_render_ctx *ctx);
 
 #endif
@@ -42,6 +42,10 @@ void say_imp_context_free(say_imp_context ctxt) {
   free(ctxt);
 }
 
+bool say_imp_context_headless_available() {
+  return false;
+}
+
 say_imp_context say_imp_context_create() {
   return say_imp_context_create_shared(NULL);
 }
@@ -82,8 +86,8 @@ say_imp_context  say_imp_context_create_for_window(say_imp_context shared,
   return ctxt;  
 }
 
-void say_imp_context_make_current(say_imp_context ctxt) {
-  wglMakeCurrent(ctxt->device, ctxt->context);
+bool say_imp_context_make_current(say_imp_context ctxt) {
+  return wglMakeCurrent(ctxt->device, ctxt->context) != FALSE;
 }
 
 void say_imp_context_update(say_imp_context ctxt) {
@@ -23,6 +23,7 @@ say_window *say_window_create() {
   say_input_reset(&win->input);
 
   win->show_cursor = true;
+  win->capture     = NULL;
 
   win->win = say_imp_window_create();
   
@@ -31,6 +32,10 @@ say_window *say_window_create() {
 
 void say_window_free(say_window *win) {
   say_window_close(win);
+
+  if (win->capture)
+    say_capture_free(win->capture);
+
   say_target_free(win->target);
 
   say_imp_window_free(win->win);
@@ -45,6 +50,11 @@ int say_window_open(say_window *win, size_t w, size_t h, const char *title,
     return 0;
   }
 
+  if (say_context_is_headless()) {
+    say_error_set("windows can't be opened in headless mode");
+    return 0;
+  }
+
   win->show_cursor = true;
   
   if (!say_imp_window_open(win->win, title, w, h, style))
@@ -63,6 +73,8 @@ int say_window_open(say_window *win, size_t w, size_t h, const char *title,
 }
 
 void say_window_close(say_window *win) {
+  say_window_stop_capture(win);
+
   say_target_set_context_proc(win->target, NULL);
   say_input_reset(&win->input);
 
@@ -70,7 +82,14 @@ void say_window_close(say_window *win) {
 }
 
 void say_window_update(say_window *win) {
+  /* The back buffer is read before it is swapped */
+  if (win->capture)
+    say_capture_frame(win->capture);
+
   say_target_update(win->target);
+  say_image_end_frame();
+  say_image_target_end_frame();
+  say_tiled_image_end_frame();
 }
 
 void say_window_hide_cursor(say_window *win) {
@@ -153,3 +172,27 @@ void say_window_wait_event(say_window *win, say_event *ev) {
 say_input *say_window_get_input(say_window *win) {
   return &win->input;
 }
+
+bool say_window_start_capture(say_window *win, const char *path,
+                              say_capture_format format, size_t fps) {
+  if (win->capture) {
+    say_capture_free(win->capture);
+    win->capture = NULL;
+  }
+
+  if (!say_target_make_current(win->target))
+    return false;
+
+  win->capture = say_capture_create(win->target, path, format, fps);
+  return win->capture != NULL;
+}
+
+/* The capture is kept, so that its frame counts can still be read */
+void say_window_stop_capture(say_window *win) {
+  if (win->capture)
+    say_capture_stop(win->capture);
+}
+
+say_capture *say_window_get_capture(say_window *win) {
+  return win->capture;
+}
@@ -4,6 +4,7 @@
 #include "say_target.h"
 #include "say_event.h"
 #include "say_image.h"
+#include "say_capture.h"
 
 #define SAY_WINDOW_RESIZABLE  0x1
 #define SAY_WINDOW_NO_FRAME   0x2
@@ -15,6 +16,8 @@ typedef struct say_window {
 
   bool show_cursor;
 
+  say_capture *capture;
+
   say_imp_window win;
 } say_window;
 
@@ -40,4 +43,9 @@ void say_window_wait_event(say_window *win, say_event *ev);
 
 say_input *say_window_get_input(say_window *win);
 
+bool say_window_start_capture(say_window *win, const char *path,
+                              say_capture_format format, size_t fps);
+void say_window_stop_capture(say_window *win);
+say_capture *say_window_get_capture(say_window *win);
+
 #endif
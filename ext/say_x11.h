@@ -9,6 +9,11 @@
 
 #include <GL/glx.h>
 
+#ifdef HAVE_EGL
+# include <EGL/egl.h>
+# include <EGL/eglext.h>
+#endif
+
 typedef struct say_x11_window {
   Display *dis;
   Window win;
@@ -38,4 +43,12 @@ typedef struct say_x11_context {
   Window   win;
 
   bool should_free_window;
+
+  /* Headless contexts are created using EGL and don't need an X server */
+  bool headless;
+
+#ifdef HAVE_EGL
+  EGLContext egl_context;
+  EGLSurface surface;
+#endif
 } say_x11_context;
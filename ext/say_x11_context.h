@@ -1,12 +1,162 @@
 #include "say.h"
 
+#ifdef HAVE_EGL
+static EGLDisplay say_egl_display = EGL_NO_DISPLAY;
+static EGLConfig  say_egl_config;
+static bool       say_egl_surfaceless = false;
+
+static bool say_egl_has_extension(const char *list, const char *name) {
+  if (!list)
+    return false;
+
+  size_t len = strlen(name);
+  for (const char *it = strstr(list, name); it; it = strstr(it + len, name)) {
+    if ((it == list || it[-1] == ' ') && (it[len] == ' ' || it[len] == '\0'))
+      return true;
+  }
+
+  return false;
+}
+
+/*
+ * Mesa's surfaceless platform doesn't need any display server nor device.
+ * Other implementations get their default display, which is still enough for
+ * pbuffers.
+ */
+static EGLDisplay say_egl_get_display() {
+  const char *client = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+#if defined(EGL_EXT_platform_base) && defined(EGL_MESA_platform_surfaceless)
+  if (say_egl_has_extension(client, "EGL_MESA_platform_surfaceless")) {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+      (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+      eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+    if (get_platform_display) {
+      EGLDisplay dis = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                                            EGL_DEFAULT_DISPLAY, NULL);
+      if (dis != EGL_NO_DISPLAY)
+        return dis;
+    }
+  }
+#else
+  (void)client;
+#endif
+
+  return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+static bool say_egl_init() {
+  if (say_egl_display != EGL_NO_DISPLAY)
+    return true;
+
+  EGLDisplay dis = say_egl_get_display();
+  if (dis == EGL_NO_DISPLAY || !eglInitialize(dis, NULL, NULL))
+    return false;
+
+  if (!eglBindAPI(EGL_OPENGL_API)) {
+    eglTerminate(dis);
+    return false;
+  }
+
+  static const EGLint config_attribs[] = {
+    EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+    EGL_RED_SIZE,        8,
+    EGL_GREEN_SIZE,      8,
+    EGL_BLUE_SIZE,       8,
+    EGL_ALPHA_SIZE,      8,
+    EGL_DEPTH_SIZE,      24,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_NONE
+  };
+
+  EGLint count = 0;
+  if (!eglChooseConfig(dis, config_attribs, &say_egl_config, 1, &count) ||
+      count < 1) {
+    eglTerminate(dis);
+    return false;
+  }
+
+  say_egl_surfaceless =
+    say_egl_has_extension(eglQueryString(dis, EGL_EXTENSIONS),
+                          "EGL_KHR_surfaceless_context");
+
+  say_egl_display = dis;
+  return true;
+}
+
+static say_imp_context say_egl_context_create(say_imp_context shared) {
+  if (!say_egl_init()) {
+    say_error_set("could not initialize EGL");
+    return NULL;
+  }
+
+  say_x11_context *context = malloc(sizeof(say_x11_context));
+
+  context->dis = NULL;
+  context->win = 0;
+  context->context = NULL;
+
+  context->should_free_window = false;
+  context->headless = true;
+
+  /* Contexts only ever render to framebuffer objects */
+  context->surface = EGL_NO_SURFACE;
+  if (!say_egl_surfaceless) {
+    static const EGLint pbuffer_attribs[] = {
+      EGL_WIDTH,  1,
+      EGL_HEIGHT, 1,
+      EGL_NONE
+    };
+
+    context->surface = eglCreatePbufferSurface(say_egl_display,
+                                               say_egl_config,
+                                               pbuffer_attribs);
+    if (context->surface == EGL_NO_SURFACE) {
+      say_error_set("could not create EGL pbuffer surface");
+      free(context);
+      return NULL;
+    }
+  }
+
+  EGLContext egl_shared = shared ? shared->egl_context : EGL_NO_CONTEXT;
+  context->egl_context = eglCreateContext(say_egl_display, say_egl_config,
+                                          egl_shared, NULL);
+  if (context->egl_context == EGL_NO_CONTEXT) {
+    say_error_set("could not create EGL context");
+
+    if (context->surface != EGL_NO_SURFACE)
+      eglDestroySurface(say_egl_display, context->surface);
+    free(context);
+
+    return NULL;
+  }
+
+  return context;
+}
+#endif
+
+bool say_imp_context_headless_available() {
+#ifdef HAVE_EGL
+  return say_egl_init();
+#else
+  return false;
+#endif
+}
+
 say_imp_context say_imp_context_create() {
   return  say_imp_context_create_shared(NULL);
 }
 
 say_imp_context say_imp_context_create_shared(say_imp_context shared) {
+#ifdef HAVE_EGL
+  if (say_context_is_headless())
+    return say_egl_context_create(shared);
+#endif
+
   say_x11_context *context = malloc(sizeof(say_x11_context));
 
+  context->headless = false;
   context->dis = XOpenDisplay(NULL);
 
   int screen = DefaultScreen(context->dis);
@@ -62,6 +212,7 @@ say_imp_context  say_imp_context_create_for_window(say_imp_context shared,
   context->win = window->win;
 
   context->should_free_window = 0;
+  context->headless = false;
 
   context->context = glXCreateNewContext(window->dis, window->config,
                                          GLX_RGBA_TYPE, shared->context, True);
@@ -70,6 +221,24 @@ say_imp_context  say_imp_context_create_for_window(say_imp_context shared,
 }
 
 void say_imp_context_free(say_imp_context context) {
+#ifdef HAVE_EGL
+  if (context->headless) {
+    if (eglGetCurrentContext() == context->egl_context) {
+      eglMakeCurrent(say_egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                     EGL_NO_CONTEXT);
+    }
+
+    if (context->egl_context != EGL_NO_CONTEXT)
+      eglDestroyContext(say_egl_display, context->egl_context);
+
+    if (context->surface != EGL_NO_SURFACE)
+      eglDestroySurface(say_egl_display, context->surface);
+
+    free(context);
+    return;
+  }
+#endif
+
   if (context->context) {
     if (glXGetCurrentContext() == context->context)
       glXMakeCurrent(context->dis, None, NULL);
@@ -85,11 +254,22 @@ void say_imp_context_free(say_imp_context context) {
   }
 }
 
-void say_imp_context_make_current(say_imp_context context) {
-  glXMakeCurrent(context->dis, context->win, context->context);
+bool say_imp_context_make_current(say_imp_context context) {
+#ifdef HAVE_EGL
+  if (context->headless) {
+    return eglMakeCurrent(say_egl_display, context->surface, context->surface,
+                          context->egl_context) == EGL_TRUE;
+  }
+#endif
+
+  return glXMakeCurrent(context->dis, context->win, context->context);
 }
 
 void say_imp_context_update(say_imp_context context) {
+  /* Nothing to present without a window */
+  if (context->headless)
+    return;
+
   if (context->win)
     glXSwapBuffers(context->dis, context->win);
 }
@@ -40,6 +40,44 @@ VALUE ray_shader_use_old(VALUE self) {
   return Qnil;
 }
 
+/*
+  @return [Float] Time spent compiling and linking shaders since the program
+    started, in seconds. The default shader is only compiled once, however many
+    targets are created.
+*/
+static
+VALUE ray_shader_s_compile_time(VALUE self) {
+  return rb_float_new(say_shader_get_compile_time());
+}
+
+/* @return [Integer] Amount of shader programs linked since the program started */
+static
+VALUE ray_shader_s_link_count(VALUE self) {
+  return ULONG2NUM(say_shader_get_link_count());
+}
+
+/*
+  @return [Integer] Amount of times setting a uniform didn't require to send it
+    to OpenGL, because it already had that value.
+*/
+static
+VALUE ray_shader_s_elided_upload_count(VALUE self) {
+  return ULONG2NUM(say_shader_get_elided_upload_count());
+}
+
+/*
+  @return [true, false] True if projection and model-view matrices are read
+    from uniform buffers, which requires GLSL 1.40 and
+    ARB_uniform_buffer_object. Shaders can use them by declaring the
+    in_TargetBlock and in_DrawableBlock uniform blocks (see the default vertex
+    shader); shaders using the in_Projection and in_ModelView uniforms keep
+    working either way.
+*/
+static
+VALUE ray_shader_s_uniform_blocks(VALUE self) {
+  return say_shader_uses_uniform_blocks() ? Qtrue : Qfalse;
+}
+
 /*
  * @return [true, falsue] True if geometry shaders are available
  */
@@ -116,6 +154,131 @@ VALUE ray_shader_link(VALUE self) {
   return Qnil;
 }
 
+/* Raises the exception matching a failed status */
+static
+void ray_shader_check_status(say_shader_status status) {
+  if (status == SAY_SHADER_COMPILE_FAILED) {
+    rb_raise(rb_path2class("Ray::Shader::CompileError"), "%s",
+             say_error_get_last());
+  }
+  else if (status == SAY_SHADER_LINK_FAILED) {
+    rb_raise(rb_path2class("Ray::Shader::LinkError"), "%s",
+             say_error_get_last());
+  }
+}
+
+/*
+  @overload build(vertex, frag, geometry, async)
+    Compiles and links the shader, loading it from the cache directory if
+    possible. Stages whose code is nil keep their previous code.
+*/
+static
+VALUE ray_shader_build(VALUE self, VALUE vertex, VALUE frag, VALUE geometry,
+                       VALUE async) {
+  say_shader_status status =
+    say_shader_build(ray_rb2shader(self),
+                     NIL_P(vertex) ? NULL : StringValueCStr(vertex),
+                     NIL_P(frag) ? NULL : StringValueCStr(frag),
+                     NIL_P(geometry) ? NULL : StringValueCStr(geometry),
+                     RTEST(async));
+  ray_shader_check_status(status);
+
+  return self;
+}
+
+/*
+  @return [true, false] True if the shader has been built, or if waiting for
+    it wouldn't block. This can only be known when the driver supports
+    KHR_parallel_shader_compile; it is otherwise always true.
+*/
+static
+VALUE ray_shader_is_ready(VALUE self) {
+  return say_shader_is_ready(ray_rb2shader(self)) ? Qtrue : Qfalse;
+}
+
+/*
+  Waits for the shader to be compiled and linked. This is done automatically
+  when the shader is first used.
+
+  @raise [Ray::Shader::CompileError, Ray::Shader::LinkError] If building the
+    shader failed.
+*/
+static
+VALUE ray_shader_wait(VALUE self) {
+  ray_shader_check_status(say_shader_wait(ray_rb2shader(self)));
+  return self;
+}
+
+/*
+  @return [String, nil] Directory where linked programs are stored, or nil if
+    they aren't.
+*/
+static
+VALUE ray_shader_s_cache_dir(VALUE self) {
+  const char *dir = say_shader_cache_get_dir();
+  return dir ? rb_str_new2(dir) : Qnil;
+}
+
+/*
+  @overload cache_dir=(dir)
+    Sets the directory where linked programs are stored, so they can be loaded
+    instead of compiled the next time the same code is used. The directory must
+    exist.
+
+    @param [String, nil] dir Directory to use, or nil to disable the cache.
+*/
+static
+VALUE ray_shader_s_set_cache_dir(VALUE self, VALUE dir) {
+  say_shader_cache_set_dir(NIL_P(dir) ? NULL : StringValueCStr(dir));
+  return dir;
+}
+
+/*
+  @return [true, false] True if a cache directory is set, and the driver
+    supports ARB_get_program_binary.
+*/
+static
+VALUE ray_shader_s_cache_available(VALUE self) {
+  return say_shader_cache_is_available() ? Qtrue : Qfalse;
+}
+
+/* @return [Integer] Amount of programs loaded from the cache directory */
+static
+VALUE ray_shader_s_cache_hits(VALUE self) {
+  return ULONG2NUM(say_shader_cache_get_hit_count());
+}
+
+/*
+  @overload variant(*keys)
+    Returns the shader compiled with each key defined as a macro, so that
+    features can be enabled with #ifdef instead of uniforms checked for each
+    vertex and fragment. The variant is compiled the first time it is
+    requested, and again whenever this shader is linked.
+
+    @param [Array<String, Symbol>] keys Names of the macros to define
+    @return [Ray::Shader] The variant of the shader
+
+    @example
+      shader.compile :frag => "shadow.glsl"
+      soft_shadows = shader.variant :SOFT, :BLUR
+*/
+static
+VALUE ray_shader_variant(int argc, VALUE *argv, VALUE self) {
+  const char **keys = ALLOCA_N(const char*, argc);
+
+  for (int i = 0; i < argc; i++)
+    keys[i] = rb_id2name(rb_to_id(argv[i]));
+
+  say_shader *variant = say_shader_get_variant(ray_rb2shader(self), keys, argc);
+
+  if (!variant) {
+    rb_raise(rb_path2class("Ray::Shader::CompileError"), "%s",
+             say_error_get_last());
+  }
+
+  return ray_shader2rb(variant, self);
+}
+
 /*
   @overload apply_vertex(klass)
     Sets the vertex layout to use. It is required to link the vertex again for
@@ -151,10 +314,18 @@ VALUE ray_shader_locate(VALUE self, VALUE attr) {
     return Qnil;
 }
 
-/* Binds the shader program */
+/*
+  Binds the shader program
+
+  @raise [Ray::Shader::CompileError, Ray::Shader::LinkError] If building the
+    shader failed.
+*/
 static
 VALUE ray_shader_bind(VALUE self) {
-  say_shader_bind(ray_rb2shader(self));
+  say_shader *shader = ray_rb2shader(self);
+  if (!say_shader_bind(shader))
+    ray_shader_check_status(say_shader_get_status(shader));
+
   return Qnil;
 }
 
@@ -274,6 +445,22 @@ void Init_ray_shader() {
   rb_define_singleton_method(ray_cShader, "use_old!", ray_shader_use_old, 0);
   rb_define_singleton_method(ray_cShader, "geometry_available?",
                              ray_shader_geometry_available, 0);
+  rb_define_singleton_method(ray_cShader, "uniform_blocks?",
+                             ray_shader_s_uniform_blocks, 0);
+  rb_define_singleton_method(ray_cShader, "compile_time",
+                             ray_shader_s_compile_time, 0);
+  rb_define_singleton_method(ray_cShader, "link_count",
+                             ray_shader_s_link_count, 0);
+  rb_define_singleton_method(ray_cShader, "cache_dir",
+                             ray_shader_s_cache_dir, 0);
+  rb_define_singleton_method(ray_cShader, "cache_dir=",
+                             ray_shader_s_set_cache_dir, 1);
+  rb_define_singleton_method(ray_cShader, "cache_available?",
+                             ray_shader_s_cache_available, 0);
+  rb_define_singleton_method(ray_cShader, "cache_hits",
+                             ray_shader_s_cache_hits, 0);
+  rb_define_singleton_method(ray_cShader, "elided_upload_count",
+                             ray_shader_s_elided_upload_count, 0);
 
   rb_define_method(ray_cShader, "compile_frag", ray_shader_compile_frag, 1);
   rb_define_method(ray_cShader, "compile_vertex", ray_shader_compile_vertex, 1);
@@ -283,6 +470,10 @@ void Init_ray_shader() {
                    0);
 
   rb_define_method(ray_cShader, "link", ray_shader_link, 0);
+  rb_define_private_method(ray_cShader, "build", ray_shader_build, 4);
+  rb_define_method(ray_cShader, "ready?", ray_shader_is_ready, 0);
+  rb_define_method(ray_cShader, "wait", ray_shader_wait, 0);
+  rb_define_method(ray_cShader, "variant", ray_shader_variant, -1);
 
   rb_define_method(ray_cShader, "apply_vertex", ray_shader_apply_vertex, 1);
 
@@ -48,7 +48,11 @@ VALUE ray_target_default_view(VALUE self) {
 
 static
 VALUE ray_target_shader(VALUE self) {
-  return ray_shader2rb(say_target_get_shader(ray_rb2target(self)), self);
+  say_shader *shader = say_target_get_shader(ray_rb2target(self));
+  if (!shader)
+    rb_raise(rb_eRuntimeError, "targets drawn in software have no shader");
+
+  return ray_shader2rb(shader, self);
 }
 
 /* @return [Ray::Rect] Part of the target that's used by the view */
@@ -160,6 +164,55 @@ VALUE ray_target_to_image(VALUE self) {
                           image);
 }
 
+static
+void ray_target_read_done(void *data, say_image *img) {
+  VALUE request = (VALUE)data;
+  VALUE self    = rb_ary_entry(request, 0);
+  VALUE block   = rb_ary_entry(request, 1);
+
+  rb_ary_delete(rb_iv_get(self, "@read_requests"), request);
+
+  VALUE image = Data_Wrap_Struct(rb_path2class("Ray::Image"), NULL,
+                                 say_image_free, img);
+  if (!NIL_P(block))
+    rb_funcall(block, RAY_METH("call"), 1, image);
+}
+
+/* @see Ray::Target#read_async */
+static
+VALUE ray_target_read_async_basic(VALUE self, VALUE rect, VALUE filename,
+                                  VALUE block) {
+  say_rect c_rect = ray_convert_to_rect(rect);
+
+  VALUE requests = rb_iv_get(self, "@read_requests");
+  if (NIL_P(requests))
+    rb_iv_set(self, "@read_requests", requests = rb_ary_new());
+
+  VALUE request = rb_ary_new3(2, self, block);
+  rb_ary_push(requests, request);
+
+  const char *c_filename = NIL_P(filename) ? NULL : StringValueCStr(filename);
+
+  if (!say_target_read_async(ray_rb2target(self),
+                             c_rect.x, c_rect.y, c_rect.w, c_rect.h,
+                             c_filename, ray_target_read_done,
+                             (void*)request)) {
+    rb_ary_delete(requests, request);
+    rb_raise(rb_eRuntimeError, "%s", say_error_get_last());
+  }
+
+  return self;
+}
+
+/*
+  Waits for every pending asynchronous read to complete, calling their blocks.
+*/
+static
+VALUE ray_target_finish_reads(VALUE self) {
+  say_target_poll_reads(ray_rb2target(self), true);
+  return self;
+}
+
 void Init_ray_target() {
   ray_cTarget = rb_define_class_under(ray_mRay, "Target", rb_cObject);
 
@@ -181,4 +234,8 @@ void Init_ray_target() {
   rb_define_method(ray_cTarget, "[]", ray_target_get, 2);
   rb_define_method(ray_cTarget, "rect", ray_target_rect, 1);
   rb_define_method(ray_cTarget, "to_image", ray_target_to_image, 0);
+
+  rb_define_private_method(ray_cTarget, "read_async_basic",
+                           ray_target_read_async_basic, 3);
+  rb_define_method(ray_cTarget, "finish_reads", ray_target_finish_reads, 0);
 }
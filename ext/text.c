@@ -123,6 +123,78 @@ VALUE ray_text_set_color(VALUE self, VALUE val) {
   return val;
 }
 
+/*
+  @return [Vector2] Offset of the shadow drawn when the Shadowed style is set
+*/
+static
+VALUE ray_text_shadow_offset(VALUE self) {
+  return ray_vector2_to_rb(say_text_get_shadow_offset(ray_rb2text(self)));
+}
+
+/*
+  @overload shadow_offset=(val)
+    @param [Vector2, #to_vector2] val New shadow offset
+*/
+static
+VALUE ray_text_set_shadow_offset(VALUE self, VALUE val) {
+  say_text_set_shadow_offset(ray_rb2text(self), ray_convert_to_vector2(val));
+  return val;
+}
+
+/*
+  @return [Color] Color of the shadow
+*/
+static
+VALUE ray_text_shadow_color(VALUE self) {
+  return ray_col2rb(say_text_get_shadow_color(ray_rb2text(self)));
+}
+
+/*
+  @overload shadow_color=(val)
+    @param [Color] val New shadow color
+*/
+static
+VALUE ray_text_set_shadow_color(VALUE self, VALUE val) {
+  say_text_set_shadow_color(ray_rb2text(self), ray_rb2col(val));
+  return val;
+}
+
+/*
+  @return [Float] Width of the outline drawn when the Outlined style is set
+*/
+static
+VALUE ray_text_outline_width(VALUE self) {
+  return rb_float_new(say_text_get_outline_width(ray_rb2text(self)));
+}
+
+/*
+  @overload outline_width=(val)
+    @param [Float] val New outline width, in pixels
+*/
+static
+VALUE ray_text_set_outline_width(VALUE self, VALUE val) {
+  say_text_set_outline_width(ray_rb2text(self), NUM2DBL(val));
+  return val;
+}
+
+/*
+  @return [Color] Color of the outline
+*/
+static
+VALUE ray_text_outline_color(VALUE self) {
+  return ray_col2rb(say_text_get_outline_color(ray_rb2text(self)));
+}
+
+/*
+  @overload outline_color=(val)
+    @param [Color] val New outline color
+*/
+static
+VALUE ray_text_set_outline_color(VALUE self, VALUE val) {
+  say_text_set_outline_color(ray_rb2text(self), ray_rb2col(val));
+  return val;
+}
+
 /*
   @return [Rect] Rect occupied by the text
 */
@@ -153,10 +225,24 @@ void Init_ray_text() {
   rb_define_method(ray_cText, "color", ray_text_color, 0);
   rb_define_method(ray_cText, "color=", ray_text_set_color, 1);
 
+  rb_define_method(ray_cText, "shadow_offset", ray_text_shadow_offset, 0);
+  rb_define_method(ray_cText, "shadow_offset=", ray_text_set_shadow_offset, 1);
+
+  rb_define_method(ray_cText, "shadow_color", ray_text_shadow_color, 0);
+  rb_define_method(ray_cText, "shadow_color=", ray_text_set_shadow_color, 1);
+
+  rb_define_method(ray_cText, "outline_width", ray_text_outline_width, 0);
+  rb_define_method(ray_cText, "outline_width=", ray_text_set_outline_width, 1);
+
+  rb_define_method(ray_cText, "outline_color", ray_text_outline_color, 0);
+  rb_define_method(ray_cText, "outline_color=", ray_text_set_outline_color, 1);
+
   rb_define_method(ray_cText, "rect", ray_text_rect, 0);
 
   rb_define_const(ray_cText, "Normal", INT2FIX(SAY_TEXT_NORMAL));
   rb_define_const(ray_cText, "Bold", INT2FIX(SAY_TEXT_BOLD));
   rb_define_const(ray_cText, "Italic", INT2FIX(SAY_TEXT_ITALIC));
   rb_define_const(ray_cText, "Underlined", INT2FIX(SAY_TEXT_UNDERLINED));
+  rb_define_const(ray_cText, "Shadowed", INT2FIX(SAY_TEXT_SHADOWED));
+  rb_define_const(ray_cText, "Outlined", INT2FIX(SAY_TEXT_OUTLINED));
 }
@@ -0,0 +1,288 @@
+#include "ray.h"
+
+VALUE ray_cTiledImage = Qnil;
+
+say_tiled_image *ray_rb2tiled_image(VALUE obj) {
+  if (!RAY_IS_A(obj, rb_path2class("Ray::TiledImage"))) {
+    rb_raise(rb_eTypeError, "Can't convert %s into Ray::TiledImage",
+             RAY_OBJ_CLASSNAME(obj));
+  }
+
+  say_tiled_image *tiled;
+  Data_Get_Struct(obj, say_tiled_image, tiled);
+
+  return tiled;
+}
+
+/* NUM2ULONG would accept negative sizes, wrapping them around */
+static
+size_t ray_rb2tile_size(VALUE tile_size) {
+  long size = NUM2LONG(tile_size);
+  if (size <= 0) {
+    rb_raise(rb_eArgError, "tile size must be positive (got %ld)", size);
+  }
+
+  return size;
+}
+
+static
+VALUE ray_tiled_image_alloc(VALUE self) {
+  say_tiled_image *tiled = say_tiled_image_create();
+  return Data_Wrap_Struct(self, NULL, say_tiled_image_free, tiled);
+}
+
+/*
+  @overload load_file(filename, tile_size)
+    Splits an image file in tiles. The file is decoded once, and its tiles are
+    cached in filename.tilesN (N being the tile size) so they can be read one
+    by one.
+
+    @param [String] filename Name of the image file
+    @param [Integer] tile_size Width and height of a tile, at most
+      Ray::Image.max_texture_size
+*/
+static
+VALUE ray_tiled_image_load_file(VALUE self, VALUE filename, VALUE tile_size) {
+  if (!say_tiled_image_load_file(ray_rb2tiled_image(self),
+                                 StringValuePtr(filename),
+                                 ray_rb2tile_size(tile_size))) {
+    rb_raise(rb_eRuntimeError, "%s", say_error_get_last());
+  }
+
+  return self;
+}
+
+/*
+  @overload load_image(img, tile_size)
+    Splits an image in tiles. The pixels of the image are copied.
+
+    @param [Ray::Image] img Image to split
+    @param [Integer] tile_size Width and height of a tile, at most
+      Ray::Image.max_texture_size
+*/
+static
+VALUE ray_tiled_image_load_image(VALUE self, VALUE img, VALUE tile_size) {
+  if (!say_tiled_image_load_image(ray_rb2tiled_image(self), ray_rb2image(img),
+                                  ray_rb2tile_size(tile_size))) {
+    rb_raise(rb_eRuntimeError, "%s", say_error_get_last());
+  }
+
+  return self;
+}
+
+/* @return [Integer] Width of the whole image */
+static
+VALUE ray_tiled_image_width(VALUE self) {
+  return ULONG2NUM(say_tiled_image_get_width(ray_rb2tiled_image(self)));
+}
+
+/* @return [Integer] Height of the whole image */
+static
+VALUE ray_tiled_image_height(VALUE self) {
+  return ULONG2NUM(say_tiled_image_get_height(ray_rb2tiled_image(self)));
+}
+
+/* @return [Integer] Width and height of a tile */
+static
+VALUE ray_tiled_image_tile_size(VALUE self) {
+  return ULONG2NUM(say_tiled_image_get_tile_size(ray_rb2tiled_image(self)));
+}
+
+/* @return [Ray::Vector2] Amount of tiles on each axis */
+static
+VALUE ray_tiled_image_tile_count(VALUE self) {
+  return ray_vector2_to_rb(say_tiled_image_get_tile_count(
+                             ray_rb2tiled_image(self)));
+}
+
+/*
+  @overload color=(col)
+    @param [Ray::Color] col Color the pixels of the image are multiplied by
+*/
+static
+VALUE ray_tiled_image_set_color(VALUE self, VALUE color) {
+  say_tiled_image_set_color(ray_rb2tiled_image(self), ray_rb2col(color));
+  return color;
+}
+
+/*
+  @return [Ray::Color]
+  @see #color=
+*/
+static
+VALUE ray_tiled_image_color(VALUE self) {
+  return ray_col2rb(say_tiled_image_get_color(ray_rb2tiled_image(self)));
+}
+
+/*
+  @overload budget=(bytes)
+    Sets the amount of texture memory resident tiles may use. Least recently
+    drawn tiles are evicted to stay below it. Tiles that are visible are always
+    loaded, even if that exceeds the budget.
+
+    @param [Integer] bytes Memory budget, in bytes
+*/
+static
+VALUE ray_tiled_image_set_budget(VALUE self, VALUE budget) {
+  say_tiled_image_set_budget(ray_rb2tiled_image(self), NUM2ULONG(budget));
+  return budget;
+}
+
+/*
+  @return [Integer]
+  @see #budget=
+*/
+static
+VALUE ray_tiled_image_budget(VALUE self) {
+  return ULONG2NUM(say_tiled_image_get_budget(ray_rb2tiled_image(self)));
+}
+
+/*
+  @overload margin=(tiles)
+    Sets how many tiles around the visible ones are loaded ahead of time, one
+    per frame, when they fit in the budget.
+
+    @param [Integer] tiles Width of the margin, in tiles
+*/
+static
+VALUE ray_tiled_image_set_margin(VALUE self, VALUE margin) {
+  say_tiled_image_set_margin(ray_rb2tiled_image(self), NUM2ULONG(margin));
+  return margin;
+}
+
+/*
+  @return [Integer]
+  @see #margin=
+*/
+static
+VALUE ray_tiled_image_margin(VALUE self) {
+  return ULONG2NUM(say_tiled_image_get_margin(ray_rb2tiled_image(self)));
+}
+
+/*
+  @overload resident?(x, y)
+    @param [Integer] x Column of the tile
+    @param [Integer] y Row of the tile
+    @return [true, false] True if the tile has a texture
+*/
+static
+VALUE ray_tiled_image_is_resident(VALUE self, VALUE x, VALUE y) {
+  return say_tiled_image_is_resident(ray_rb2tiled_image(self),
+                                     NUM2ULONG(x), NUM2ULONG(y)) ?
+    Qtrue : Qfalse;
+}
+
+/* @return [Integer] Amount of tiles that have a texture */
+static
+VALUE ray_tiled_image_resident_count(VALUE self) {
+  return ULONG2NUM(say_tiled_image_get_resident_count(
+                     ray_rb2tiled_image(self)));
+}
+
+/* @return [Integer] Texture memory used by resident tiles, in bytes */
+static
+VALUE ray_tiled_image_resident_bytes(VALUE self) {
+  return ULONG2NUM(say_tiled_image_get_resident_bytes(
+                     ray_rb2tiled_image(self)));
+}
+
+/* @return [Integer] Amount of tiles drawn the last time the image was drawn */
+static
+VALUE ray_tiled_image_visible_count(VALUE self) {
+  return ULONG2NUM(say_tiled_image_get_visible_count(
+                     ray_rb2tiled_image(self)));
+}
+
+/* @return [Integer] Amount of tiles loaded since the image was created */
+static
+VALUE ray_tiled_image_load_count(VALUE self) {
+  return ULONG2NUM(say_tiled_image_get_load_count(ray_rb2tiled_image(self)));
+}
+
+/* @return [Integer] Amount of tiles evicted since the image was created */
+static
+VALUE ray_tiled_image_eviction_count(VALUE self) {
+  return ULONG2NUM(say_tiled_image_get_eviction_count(
+                     ray_rb2tiled_image(self)));
+}
+
+/* Releases the texture of every tile. They are loaded again when drawn. */
+static
+VALUE ray_tiled_image_evict_all(VALUE self) {
+  say_tiled_image_evict_all(ray_rb2tiled_image(self));
+  return self;
+}
+
+/*
+  @return [Integer] Amount of frames that were ended
+  @see end_frame
+*/
+static
+VALUE ray_tiled_image_frame(VALUE self) {
+  return ULONG2NUM(say_tiled_image_get_frame());
+}
+
+/*
+  Marks the end of a frame. Tiles drawn during the current frame are never
+  evicted, and margin tiles are loaded one per frame.
+
+  This is done by Ray::Window#update. It only needs to be called when drawing
+  on image targets without updating any window.
+*/
+static
+VALUE ray_tiled_image_end_frame(VALUE self) {
+  say_tiled_image_end_frame();
+  return Qnil;
+}
+
+/*
+  Document-class: Ray::TiledImage
+
+  A tiled image is a drawable showing an image split in square tiles. Only the
+  tiles around the view have a texture, which allows to draw images larger than
+  the maximum texture size, or than the available texture memory.
+*/
+void Init_ray_tiled_image() {
+  ray_cTiledImage = rb_define_class_under(ray_mRay, "TiledImage",
+                                          ray_cDrawable);
+  rb_define_alloc_func(ray_cTiledImage, ray_tiled_image_alloc);
+
+  rb_define_private_method(ray_cTiledImage, "load_file",
+                           ray_tiled_image_load_file, 2);
+  rb_define_private_method(ray_cTiledImage, "load_image",
+                           ray_tiled_image_load_image, 2);
+
+  rb_define_singleton_method(ray_cTiledImage, "frame",
+                             ray_tiled_image_frame, 0);
+  rb_define_singleton_method(ray_cTiledImage, "end_frame",
+                             ray_tiled_image_end_frame, 0);
+
+  rb_define_method(ray_cTiledImage, "width", ray_tiled_image_width, 0);
+  rb_define_method(ray_cTiledImage, "height", ray_tiled_image_height, 0);
+  rb_define_method(ray_cTiledImage, "tile_size", ray_tiled_image_tile_size, 0);
+  rb_define_method(ray_cTiledImage, "tile_count",
+                   ray_tiled_image_tile_count, 0);
+
+  rb_define_method(ray_cTiledImage, "color=", ray_tiled_image_set_color, 1);
+  rb_define_method(ray_cTiledImage, "color", ray_tiled_image_color, 0);
+
+  rb_define_method(ray_cTiledImage, "budget=", ray_tiled_image_set_budget, 1);
+  rb_define_method(ray_cTiledImage, "budget", ray_tiled_image_budget, 0);
+  rb_define_method(ray_cTiledImage, "margin=", ray_tiled_image_set_margin, 1);
+  rb_define_method(ray_cTiledImage, "margin", ray_tiled_image_margin, 0);
+
+  rb_define_method(ray_cTiledImage, "resident?",
+                   ray_tiled_image_is_resident, 2);
+  rb_define_method(ray_cTiledImage, "resident_count",
+                   ray_tiled_image_resident_count, 0);
+  rb_define_method(ray_cTiledImage, "resident_bytes",
+                   ray_tiled_image_resident_bytes, 0);
+  rb_define_method(ray_cTiledImage, "visible_count",
+                   ray_tiled_image_visible_count, 0);
+  rb_define_method(ray_cTiledImage, "load_count",
+                   ray_tiled_image_load_count, 0);
+  rb_define_method(ray_cTiledImage, "eviction_count",
+                   ray_tiled_image_eviction_count, 0);
+  rb_define_method(ray_cTiledImage, "evict_all",
+                   ray_tiled_image_evict_all, 0);
+}
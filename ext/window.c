@@ -154,6 +154,103 @@ VALUE ray_window_wait_event(VALUE self, VALUE ev) {
   return ev;
 }
 
+/*
+  @overload start_capture(path, opts = {})
+    Starts recording every frame shown by the window. Pixels are read
+    asynchronously and written by another thread, so that recording doesn't
+    slow the game down. If that thread can't keep up, frames are dropped
+    instead (see #dropped_frames).
+
+    @param [String] path File to write the frames to. With :png_sequence,
+      it is a prefix frame numbers are appended to (e.g. "shots/frame" gives
+      shots/frame000000.png, shots/frame000001.png, ...).
+
+    @option opts [Symbol] :format (:y4m) One of :y4m (YUV 4:4:4 stream, can be
+      read by most video encoders), :raw_rgba (raw RGBA pixels, top to
+      bottom), or :png_sequence (one PNG per frame).
+    @option opts [Integer] :fps (60) Frame rate written in the y4m header
+*/
+static
+VALUE ray_window_start_capture(int argc, VALUE *argv, VALUE self) {
+  VALUE path = Qnil, opts = Qnil;
+  rb_scan_args(argc, argv, "11", &path, &opts);
+
+  say_capture_format format = SAY_CAPTURE_Y4M;
+  size_t fps = 60;
+
+  if (!NIL_P(opts)) {
+    VALUE rb_format = rb_hash_aref(opts, RAY_SYM("format"));
+
+    if (rb_format == RAY_SYM("raw_rgba"))
+      format = SAY_CAPTURE_RAW_RGBA;
+    else if (rb_format == RAY_SYM("png_sequence"))
+      format = SAY_CAPTURE_PNG_SEQUENCE;
+    else if (!NIL_P(rb_format) && rb_format != RAY_SYM("y4m")) {
+      rb_raise(rb_eArgError, "unknown capture format: %s",
+               RSTRING_PTR(rb_inspect(rb_format)));
+    }
+
+    VALUE rb_fps = rb_hash_aref(opts, RAY_SYM("fps"));
+    if (!NIL_P(rb_fps))
+      fps = NUM2ULONG(rb_fps);
+  }
+
+  if (!say_window_start_capture(ray_rb2window(self), StringValueCStr(path),
+                                format, fps)) {
+    rb_raise(rb_eRuntimeError, "%s", say_error_get_last());
+  }
+
+  return self;
+}
+
+/*
+  Stops recording, waiting for every captured frame to be written.
+*/
+static
+VALUE ray_window_stop_capture(VALUE self) {
+  say_window_stop_capture(ray_rb2window(self));
+  return self;
+}
+
+/* @return [true, false] True if frames are being recorded */
+static
+VALUE ray_window_is_capturing(VALUE self) {
+  say_capture *capture = say_window_get_capture(ray_rb2window(self));
+  return capture && say_capture_is_running(capture) ? Qtrue : Qfalse;
+}
+
+/*
+  Frame counts are kept once recording stops, until another recording is
+  started.
+
+  @return [Integer] Amount of frames captured since recording started
+*/
+static
+VALUE ray_window_captured_frames(VALUE self) {
+  say_capture *capture = say_window_get_capture(ray_rb2window(self));
+  return ULONG2NUM(capture ? say_capture_get_frame_count(capture) : 0);
+}
+
+/*
+  @return [Integer] Amount of captured frames that were not written because
+    the writer thread was late.
+*/
+static
+VALUE ray_window_dropped_frames(VALUE self) {
+  say_capture *capture = say_window_get_capture(ray_rb2window(self));
+  return ULONG2NUM(capture ? say_capture_get_dropped_count(capture) : 0);
+}
+
+/*
+  @return [Integer] Amount of captured frames that were written to the file.
+    Once recording stops, this is every frame that wasn't dropped.
+*/
+static
+VALUE ray_window_written_frames(VALUE self) {
+  say_capture *capture = say_window_get_capture(ray_rb2window(self));
+  return ULONG2NUM(capture ? say_capture_get_written_count(capture) : 0);
+}
+
 /* @return [Ray::Input] The input used by this object */
 static
 VALUE ray_window_input(VALUE self) {
@@ -180,4 +277,14 @@ void Init_ray_window() {
   rb_define_method(ray_cWindow, "wait_event", ray_window_wait_event, 1);
 
   rb_define_method(ray_cWindow, "input", ray_window_input, 0);
+
+  rb_define_method(ray_cWindow, "start_capture", ray_window_start_capture, -1);
+  rb_define_method(ray_cWindow, "stop_capture", ray_window_stop_capture, 0);
+  rb_define_method(ray_cWindow, "capturing?", ray_window_is_capturing, 0);
+  rb_define_method(ray_cWindow, "captured_frames", ray_window_captured_frames,
+                   0);
+  rb_define_method(ray_cWindow, "dropped_frames", ray_window_dropped_frames,
+                   0);
+  rb_define_method(ray_cWindow, "written_frames", ray_window_written_frames,
+                   0);
 }
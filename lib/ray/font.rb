@@ -4,5 +4,39 @@ module Ray
 
     extend Ray::ResourceSet
     add_set(/^(.*)$/) { |filename| new(filename) }
+
+    # Rasterizes a font for a known set of characters, and saves it as a
+    # bitmap font which can be loaded without going through FreeType.
+    #
+    # @param [String, Ray::Font] source Font to rasterize
+    # @param [String] dest Descriptor of the bitmap font (e.g. "arial.fnt")
+    # @param [Array<Integer>] sizes Character sizes to rasterize
+    # @param [String] chars Characters to rasterize
+    # @option opts :bold (false) Whether bold glyphs should be stored too
+    #
+    # @return [Ray::Font] The source font
+    def self.bake(source, dest, sizes, chars, opts = {})
+      font = source.is_a?(Ray::Font) ? source : new(source)
+
+      sizes.each do |size|
+        font.preload(size, chars)
+        font.preload(size, chars, :bold => true) if opts[:bold]
+      end
+
+      font.write_bitmap dest
+      font
+    end
+
+    # Loads glyphs ahead of time, so that they won't need to be rasterized
+    # while drawing.
+    #
+    # @param [Integer] size Character size
+    # @param [String] string Characters to load
+    # @option opts :bold (false) True to load bold glyphs
+    def preload(size, string, opts = {})
+      enc = string.respond_to?(:encoding) ? string.encoding.to_s : "UTF-8"
+      preload_basic(size, internal_string(string, enc), opts[:bold])
+      self
+    end
   end
 end
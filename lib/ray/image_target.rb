@@ -8,5 +8,37 @@ module Ray
         yield self
       end
     end
+
+    # Obtains a target from the pool. Targets are kept in the pool after they
+    # are released, so that temporary targets (e.g. for blur passes) can be
+    # used every frame without creating framebuffers and textures again.
+    #
+    # The target always starts with its default view and with its image
+    # cleared to transparent (Ray::Color.none), even when it was used before.
+    #
+    # @param [Integer] width Width of the image
+    # @param [Integer] height Height of the image
+    # @option opts [true, false] :depth (true) False if the target doesn't need
+    #   a depth buffer. Depth buffers are shared between targets of the same
+    #   size.
+    #
+    # @yield [target] If a block is given, the target is released once it
+    #   returns.
+    # @yieldparam [Ray::ImageTarget] target
+    #
+    # @return [Ray::ImageTarget, Object] The target, or the value returned by
+    #   the block.
+    def self.acquire(width, height, opts = {})
+      depth  = opts.has_key?(:depth) ? opts[:depth] : true
+      target = acquire_target(width, height, depth)
+
+      return target unless block_given?
+
+      begin
+        yield target
+      ensure
+        target.release
+      end
+    end
   end
 end
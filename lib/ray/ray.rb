@@ -43,6 +43,7 @@ require 'ray/event'
 require 'ray/drawable'
 require 'ray/polygon'
 require 'ray/sprite'
+require 'ray/tiled_image'
 require 'ray/text'
 require 'ray/turtle'
 
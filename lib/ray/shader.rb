@@ -6,6 +6,15 @@ module Ray
       end
     end
 
+    # Creates a shader without waiting for it to be compiled and linked. Errors
+    # are raised when the shader is first used, or by {#wait}.
+    #
+    # @param opts (see compile)
+    # @return [Ray::Shader]
+    def self.compile_async(opts)
+      new.compile(opts.merge(:async => true))
+    end
+
     # @param opts (see compile)
     def initialize(opts = nil)
       @locations = {}
@@ -17,8 +26,11 @@ module Ray
     # @option opts [String, #read] :vertex A vertex shader (filename, or io)
     # @option opts [String, #read] :frag A fragment shader (filename, or io)
     # @option opts [String, #read] :geometry A geometry shader (filename, or io)
+    # @option opts [true, false] :async If true, doesn't wait for the driver to
+    #   compile the shader (see {Ray::Shader.compile_async}).
     #
-    # Compiles the shader.
+    # Compiles the shader. If {Ray::Shader.cache_dir} is set, the linked program
+    # is loaded from there when the same code was already compiled.
     def compile(opts)
       [:vertex, :frag, :geometry].each do |type|
         if opts[type]
@@ -30,11 +42,7 @@ module Ray
         end
       end
 
-      compile_vertex(opts[:vertex]) if opts[:vertex]
-      compile_frag(opts[:frag]) if opts[:frag]
-      compile_geometry(opts[:geometry]) if opts[:geometry]
-
-      link
+      build(opts[:vertex], opts[:frag], opts[:geometry], opts[:async])
 
       @locations.clear
       @images.clear
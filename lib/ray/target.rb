@@ -5,6 +5,19 @@ module Ray
       @shader ||= simple_shader # must always remain the same object
     end
 
+    # Reads pixels without waiting for the GPU to finish rendering. The block
+    # is called by a later call to #update (or #finish_reads) once they are
+    # available.
+    #
+    # @param [Ray::Rect, Array<Integer>] rect Rect to read
+    # @option opts [String] :png File to save the pixels to. Encoding happens
+    #   on another thread, and the block is only called once it is done.
+    #
+    # @yieldparam [Ray::Image] image Image containing the pixels of the rect
+    def read_async(rect = [0, 0, *size], opts = {}, &block)
+      read_async_basic(rect, opts[:png], block)
+    end
+
     # @param [Ray::View] view A new view
     # @yield a block where the view has been changed
     def with_view(view)
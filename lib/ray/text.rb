@@ -14,6 +14,12 @@ module Ray
     # @option opts :color (Ray::Color.white) The color used to draw the text
     # @option opts :font [Ray::Font, String] (Ray::Font.default) Font used to draw
     # @option opts :shader [Ray::Shader] (nil) Shader
+    # @option opts :shadow_offset ((2, 2)) Offset of the shadow, drawn when
+    #   the :shadowed style is used.
+    # @option opts :shadow_color (Ray::Color.black) Color of the shadow
+    # @option opts :outline_width (1) Width of the outline, drawn when the
+    #   :outlined style is used.
+    # @option opts :outline_color (Ray::Color.black) Color of the outline
     def initialize(string, opts = {})
       opts = {
         :encoding => string.respond_to?(:encoding) ? string.encoding : "utf-8",
@@ -35,13 +41,19 @@ module Ray
       self.color  = opts[:color]
       self.shader = opts[:shader]
 
+      self.shadow_offset = opts[:shadow_offset] if opts[:shadow_offset]
+      self.shadow_color  = opts[:shadow_color]  if opts[:shadow_color]
+      self.outline_width = opts[:outline_width] if opts[:outline_width]
+      self.outline_color = opts[:outline_color] if opts[:outline_color]
+
       if font = opts[:font]
         self.font = font.is_a?(String) ? Ray::FontSet[font] : font
       end
     end
 
     # @param [Integer, Array<Symbol>] style Flags for the font style.
-    #  Valid symbols are :normal, :italic, :bold, and :underline.
+    #  Valid symbols are :normal, :italic, :bold, :underlined, :shadowed, and
+    #  :outlined.
     def style=(style)
       set_basic_style parse_style(style)
     end
@@ -109,6 +121,8 @@ module Ray
                  when :italic     then Italic
                  when :bold       then Bold
                  when :underlined then Underlined
+                 when :shadowed   then Shadowed
+                 when :outlined   then Outlined
                  else
                    raise ArgumentError, "Unknown style #{e.inspect}"
                  end
@@ -0,0 +1,65 @@
+module Ray
+  class TiledImage < Drawable
+    # Creates a tiled image.
+    #
+    # @param [String, Ray::Image] src The file to load the image from, or an
+    #   image to split.
+    # @option opts [Integer] :tile_size (256) Width and height of each tile
+    # @option opts [Integer] :budget (64 MiB) Texture memory resident tiles may
+    #   use, in bytes.
+    # @option opts [Integer] :margin (1) Amount of tiles around the view that
+    #   are loaded ahead of time.
+    # @option opts [Ray::Vector2, #to_vector2] :at ((0, 0)) Position of the image
+    # @option opts [Float] :angle (0) Angle of the image, in degrees
+    # @option opts [Ray::Vector2] :zoom ((1, 1)) Zoom level
+    # @option opts [Ray::Vector2] :scale Alias for :zoom
+    # @option opts [Ray::Color] :color (Ray::Color.white) Color used, multiplying
+    #   each pixel of the image.
+    # @option opts [Ray::Vector2] :origin ((0, 0)) The origin of transformations
+    # @option opts :shader [Ray::Shader] (nil) Shader
+    def initialize(src, opts = {})
+      opts = {
+        :tile_size => 256,
+        :budget    => 64 * 1024 * 1024,
+        :margin    => 1,
+        :at        => Ray::Vector2[0, 0],
+        :angle     => 0,
+        :zoom      => Ray::Vector2[1, 1],
+        :color     => Ray::Color.white,
+        :origin    => Ray::Vector2[0, 0]
+      }.merge(opts)
+
+      if src.is_a? Ray::Image
+        load_image(src, opts[:tile_size])
+      else
+        load_file(src.to_str, opts[:tile_size])
+      end
+
+      self.budget = opts[:budget]
+      self.margin = opts[:margin]
+      self.pos    = opts[:at]
+      self.angle  = opts[:angle]
+      self.scale  = opts[:scale] || opts[:zoom]
+      self.color  = opts[:color]
+      self.origin = opts[:origin]
+      self.shader = opts[:shader]
+    end
+
+    # @return [Ray::Vector2] Size of the whole image
+    def size
+      Ray::Vector2[width, height]
+    end
+
+    # @return [Ray::Rect] The rect where this image will be drawn, taking
+    #   position and scale in account.
+    def rect
+      pos   = self.pos
+      scale = self.scale
+
+      Ray::Rect.new(pos.x, pos.y, width * scale.w, height * scale.h)
+    end
+
+    alias w width
+    alias h height
+  end
+end
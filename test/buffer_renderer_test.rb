@@ -35,4 +35,29 @@ context "a buffer renderer" do
   }.raises_kind_of Exception
 end
 
+context "a buffer renderer drawn on an image target" do
+  setup do
+    target = Ray::ImageTarget.new Ray::Image.new([20, 10])
+    target.clear Ray::Color.black
+
+    green = Ray::Polygon.rectangle([0, 0, 10, 10], Ray::Color.green)
+    green.pos = [10, 0]
+
+    buffer = Ray::BufferRenderer.new :static, Ray::Vertex
+    buffer << Ray::Polygon.rectangle([0, 0, 10, 10], Ray::Color.red)
+    buffer << green
+    buffer.update
+
+    target.draw buffer
+    target.update
+
+    target
+  end
+
+  # Each drawable is moved by its own matrix, even when they are uploaded at
+  # once to a uniform buffer.
+  asserts(:[], 5, 5).equals Ray::Color.red
+  asserts(:[], 15, 5).equals Ray::Color.green
+end if Ray::ImageTarget.available?
+
 run_tests if __FILE__ == $0
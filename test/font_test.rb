@@ -18,6 +18,185 @@ context Ray::Font do
   asserts("creating a font from an invalid IO object") {
     open(path_of("aqua.png"), "rb") { |io| topic.new(io) }
   }.raises_kind_of RuntimeError
+
+  context "loaded twice from the same file" do
+    setup do
+      2.times.map { topic.new(path_of("VeraMono.ttf")) }
+    end
+
+    asserts("line height") { topic.last.line_height(12) }.equals {
+      topic.first.line_height(12)
+    }
+  end
+
+  context "sharing its face with a font a bitmap font was loaded into" do
+    setup do
+      fonts = 2.times.map { topic.new(path_of("VeraMono.ttf")) }
+      fonts.last.load_bitmap(path_of("bitmap_font.fnt"))
+      fonts
+    end
+
+    asserts("line height") { topic.last.line_height(12) }.equals 40
+    denies("line height") { topic.first.line_height(12) }.equals 40
+  end
+
+  context "loaded from a bitmap font" do
+    setup { topic.new(path_of("bitmap_font.fnt")) }
+
+    asserts(:line_height, 12).equals 40
+
+    asserts(:glyph_advance, 12, "A".ord).equals 9
+    asserts(:glyph_advance, 12, "V".ord).equals 8
+
+    asserts(:glyph_rect, 12, "A".ord).equals Ray::Rect.new(2, 3, 5, 7)
+    asserts(:glyph_rect, 12, "V".ord).equals Ray::Rect.new(8, 3, 6, 7)
+
+    asserts(:kerning, 12, "A".ord, "V".ord).equals(-2)
+    asserts(:kerning, 12, "V".ord, "A".ord).equals 0
+
+    asserts("width of a kerned pair") {
+      Ray::Text.new("AV", :font => topic, :size => 12).rect.width
+    }.equals 9 + 8 - 2
+
+    asserts("width of a pair without kerning") {
+      Ray::Text.new("VA", :font => topic, :size => 12).rect.width
+    }.equals 8 + 9
+  end
+
+  context "failing to load a bitmap font" do
+    setup do
+      fonts = 2.times.map { topic.new(path_of("VeraMono.ttf")) }
+      line_height = fonts.first.line_height(12)
+
+      error = begin
+                fonts.last.load_bitmap(path_of("broken_bitmap_font.fnt"))
+                nil
+              rescue RuntimeError => e
+                e
+              end
+
+      [fonts, line_height, error]
+    end
+
+    asserts("error") { topic[2] }.kind_of RuntimeError
+
+    asserts("line height") { topic[0].last.line_height(12) }.equals {
+      topic[1]
+    }
+
+    asserts("glyph advance") {
+      topic[0].last.glyph_advance(12, "A".ord)
+    }.equals { topic[0].first.glyph_advance(12, "A".ord) }
+  end
+
+  context "with a cache size" do
+    hookup { topic.cache_size = 1024 * 1024 }
+    teardown { Ray::Font.cache_size = 0 }
+
+    asserts(:cache_size).equals 1024 * 1024
+    denies("line height") { topic.default.line_height(12) }.equals 0
+  end
+
+  context "with several workers" do
+    setup do
+      topic.worker_count = 4
+
+      string = ("a".."z").to_a.join + ("A".."Z").to_a.join
+      font   = topic.new(path_of("VeraMono.ttf"))
+
+      [Ray::Text.new(string, :font => font, :size => 13).rect.width,
+       Ray::Text.new("a", :font => font, :size => 13).rect.width * 52]
+    end
+
+    teardown { Ray::Font.worker_count = 0 }
+
+    asserts("text width") { topic.first }.equals { topic.last }
+  end
+
+  context "loading glyphs asynchronously" do
+    setup do
+      topic.async_loading = true
+
+      string = ("a".."z").to_a.join + ("A".."Z").to_a.join
+      font   = topic.new(path_of("VeraMono.ttf"))
+
+      advance = Ray::Text.new("a", :font => font, :size => 17).rect.width
+      text    = Ray::Text.new(string, :font => font, :size => 17)
+
+      [advance, text.rect.width, text]
+    end
+
+    teardown { Ray::Font.async_loading = false }
+
+    asserts("text width with placeholders") { topic[1] }.equals {
+      topic[0] + 51 * (17 / 2)
+    }
+
+    asserts("text width once glyphs are loaded") {
+      advance, _, text = topic
+      target = Ray::ImageTarget.new Ray::Image.new([32, 32])
+
+      500.times do
+        target.draw text
+        target.update
+
+        break if text.rect.width == advance * 52
+        sleep 0.01
+      end
+
+      text.rect.width
+    }.equals { topic[0] * 52 }
+  end
+
+  context "drawing placeholders" do
+    setup do
+      topic.async_loading = true
+      topic.placeholders  = true
+
+      string = ("a".."z").to_a.join + ("A".."Z").to_a.join
+      font   = topic.new(path_of("VeraMono.ttf"))
+      text   = Ray::Text.new(string, :font => font, :size => 19)
+
+      target = Ray::ImageTarget.new Ray::Image.new([64, 32])
+      target.clear Ray::Color.none
+      target.draw text
+      target.update
+
+      target
+    end
+
+    teardown do
+      Ray::Font.async_loading = false
+      Ray::Font.placeholders  = false
+    end
+
+    asserts("drawn pixels") {
+      (0...64).any? { |x| (0...32).any? { |y| topic[x, y].a == 255 } }
+    }
+  end
+
+  context "baked into a bitmap font" do
+    setup do
+      require 'tmpdir'
+
+      dest = File.join(Dir.tmpdir, "ray_vera_mono.fnt")
+      topic.bake(path_of("VeraMono.ttf"), dest, [12], "Hello world!")
+
+      [topic.new(path_of("VeraMono.ttf")), topic.new(dest)]
+    end
+
+    asserts("line height") { topic.last.line_height(12) }.equals {
+      topic.first.line_height(12)
+    }
+
+    asserts("line height of a size that wasn't baked") {
+      topic.last.line_height(20)
+    }.equals 0
+  end
+
+  asserts("loading a non-existing bitmap font") {
+    topic.new(path_of("doesnt_exist.fnt"))
+  }.raises_kind_of RuntimeError
 end
 
 run_tests if __FILE__ == $0
@@ -14,6 +14,233 @@ context "an image target" do
 
     asserts("color of image") { img[0, 0] }.equals Ray::Color.red
   end
+
+  context "with prefetch enabled after draw & update" do
+    hookup do
+      topic.prefetch = true
+      topic.clear Ray::Color.blue
+      topic.update
+    end
+
+    teardown { topic.prefetch = false }
+
+    asserts :prefetch?
+    asserts("color of image") { img[0, 0] }.equals Ray::Color.blue
+  end
+
+  context "drawn several times" do
+    setup do
+      other = Ray::ImageTarget.new Ray::Image.new([10, 10])
+
+      before = Ray::GL.context_switch_count
+      3.times do
+        topic.clear Ray::Color.green
+        topic.update
+        other.clear Ray::Color.green
+        other.update
+      end
+
+      Ray::GL.context_switch_count - before
+    end
+
+    asserts("context switches") { topic }.equals 0
+    asserts("color of image") { img[0, 0] }.equals Ray::Color.green
+  end
+
+  context "drawing the same sprite twice" do
+    setup do
+      sprite = Ray::Sprite.new Ray::Image.new([4, 4])
+      topic.draw sprite
+
+      Ray::GL.reset_bind_counts
+      topic.draw sprite
+
+      Ray::GL.redundant_bind_count
+    end
+
+    asserts("redundant binds avoided") { topic > 0 }
+  end
+
+  context "binding the same image twice" do
+    setup do
+      image = Ray::Image.new [4, 4]
+      image.bind
+
+      Ray::GL.reset_bind_counts
+      image.bind
+
+      [Ray::GL.bind_count, Ray::GL.redundant_bind_count]
+    end
+
+    asserts("bind count") { topic.first }.equals 0
+    asserts("redundant bind count") { topic.last }.equals 1
+  end
+
+  context "after an asynchronous read" do
+    setup do
+      target = topic
+      target.clear Ray::Color.green
+
+      result = nil
+      target.read_async([0, 0, 10, 5]) { |image| result = image }
+      target.finish_reads
+
+      result
+    end
+
+    asserts(:size).equals Ray::Vector2[10, 5]
+    asserts(:[], 0, 0).equals Ray::Color.green
+  end
 end if Ray::ImageTarget.available?
 
+context "a pooled image target" do
+  setup { Ray::ImageTarget.acquire(16, 8, :depth => false) }
+
+  asserts(:pooled?)
+  denies(:depth?)
+  asserts(:size).equals Ray::Vector2[16, 8]
+  asserts("image size") { topic.image.size }.equals Ray::Vector2[16, 8]
+
+  asserts("its pixels") {
+    (0...16).map { |x| (0...8).map { |y| topic[x, y] } }.flatten.uniq
+  }.equals [Ray::Color.none]
+
+  asserts("changing its image") {
+    topic.image = Ray::Image.new([1, 1])
+  }.raises RuntimeError
+
+  context "released" do
+    setup do
+      image = topic.image
+      topic.release
+      image
+    end
+
+    asserts("reusing its image") { topic[0, 0] }.raises RuntimeError
+
+    asserts("acquired again") {
+      Ray::ImageTarget.acquire(16, 8, :depth => false) do |target|
+        target.image.size
+      end
+    }.equals Ray::Vector2[16, 8]
+
+    asserts("clearing the pool frees released targets") {
+      before = Ray::ImageTarget.pool_size
+      Ray::ImageTarget.clear_pool
+      Ray::ImageTarget.pool_size < before
+    }
+  end
+
+  context "reused after being drawn on" do
+    setup do
+      topic.view = Ray::View.new([1, 1], [2, 2])
+      topic.clear Ray::Color.red
+      topic.update
+      topic.release
+
+      Ray::ImageTarget.acquire(16, 8, :depth => false)
+    end
+
+    teardown { topic.release }
+
+    asserts("view") { topic.view == topic.default_view }
+    asserts(:[], 0, 0).equals Ray::Color.none
+    denies(:prefetch?)
+  end
+
+  asserts("pool size while its image is still in use") {
+    before = Ray::ImageTarget.pool_size
+
+    image = Ray::ImageTarget.acquire(24, 24, :depth => false).image
+    GC.start
+
+    Ray::ImageTarget.acquire(24, 24, :depth => false).release
+    image.size
+
+    Ray::ImageTarget.pool_size - before
+  }.equals 2
+end
+
+context "an image target drawn in software" do
+  setup do
+    old_backend = Ray.backend
+    Ray.backend = :software
+
+    target = Ray::ImageTarget.new Ray::Image.new([20, 20])
+    Ray.backend = old_backend
+
+    target
+  end
+
+  asserts(:shader).raises RuntimeError
+
+  context "after drawing a rectangle" do
+    hookup do
+      topic.clear Ray::Color.blue
+      topic.draw Ray::Polygon.rectangle([5, 5, 10, 10], Ray::Color.red)
+      topic.update
+    end
+
+    asserts("color inside the rect") { topic.image[5, 5] }.equals Ray::Color.red
+    asserts("color at its last pixel") {
+      topic.image[14, 14]
+    }.equals Ray::Color.red
+
+    asserts("color right of the rect") {
+      topic.image[15, 5]
+    }.equals Ray::Color.blue
+
+    asserts("color below the rect") {
+      topic.image[5, 15]
+    }.equals Ray::Color.blue
+  end
+
+  context "after drawing a translucent sprite" do
+    hookup do
+      img = Ray::Image.new [4, 4]
+      img.fill_rect [0, 0, 4, 4], Ray::Color.white
+
+      sprite = Ray::Sprite.new img
+      sprite.color = Ray::Color.new(255, 0, 0, 128)
+
+      topic.clear Ray::Color.new(0, 0, 255, 255)
+      topic.draw sprite
+      topic.update
+    end
+
+    asserts("blended color") {
+      topic.image[1, 1]
+    }.equals Ray::Color.new(128, 0, 127, 191)
+
+    asserts("color outside the sprite") {
+      topic.image[4, 4]
+    }.equals Ray::Color.new(0, 0, 255, 255)
+  end
+end
+
+context "the headless mode" do
+  setup { Ray::ImageTarget.new Ray::Image.new([10, 10]) }
+
+  asserts("setting it to its current value") {
+    Ray.headless = Ray.headless?
+  }.equals { Ray.headless? }
+
+  asserts("changing it once contexts exist") {
+    Ray.headless = !Ray.headless?
+  }.raises RuntimeError
+
+  context "when enabled" do
+    setup do
+      topic.clear Ray::Color.red
+      topic.update
+      topic.image
+    end
+
+    asserts("color of image") { topic[0, 0] }.equals Ray::Color.red
+    asserts("opening a window") {
+      Ray::Window.new.open("headless", [10, 10])
+    }.raises RuntimeError
+  end if Ray.headless?
+end
+
 run_tests if __FILE__ == $0
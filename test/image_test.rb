@@ -58,6 +58,315 @@ context "an image created from a size" do
     hookup { topic.smooth = true }
     asserts :smooth?
   end
+
+  context "after changing a few pixels" do
+    setup do
+      topic.bind
+      before = Ray::Image.total_uploaded_bytes
+
+      topic[10, 10] = Ray::Color.red
+      topic[11, 10] = Ray::Color.red
+      topic[40, 100] = Ray::Color.red
+      topic.bind
+
+      Ray::Image.total_uploaded_bytes - before
+    end
+
+    asserts("uploaded bytes") { topic }.equals 3 * 4
+  end
+end
+
+context "an image without its pixels" do
+  setup do
+    img = Ray::Image.new [2, 2]
+    img[0, 0] = Ray::Color.red
+    img[1, 1] = Ray::Color.blue
+    img.discard_pixels!
+    img
+  end
+
+  denies :has_pixels?
+
+  asserts(:[], 0, 0).equals Ray::Color.red
+  asserts(:[], 1, 1).equals Ray::Color.blue
+end
+
+context "a compressed image" do
+  setup do
+    img = Ray::Image.new [8, 8]
+    img.map! { Ray::Color.red }
+    img.compress :dxt1
+  end
+
+  asserts(:format).equals :dxt1
+  asserts(:[], 0, 0).equals Ray::Color.red
+
+  context "after being modified" do
+    hookup { topic[1, 1] = Ray::Color.green }
+
+    asserts(:format).equals :rgba8
+    asserts(:[], 1, 1).equals Ray::Color.green
+  end
+end if Ray::Image.compression_supported?(:dxt1)
+
+context "an image loaded compressed" do
+  require 'tmpdir'
+  require 'fileutils'
+
+  dir    = File.join(Dir.tmpdir, "ray_compressed_image")
+  source = File.join(dir, "aqua.png")
+  cache  = "#{source}.dxt1"
+  points = [[0, 0], [10, 40], [25, 25], [49, 49]]
+
+  setup do
+    FileUtils.mkdir_p dir
+    FileUtils.cp path_of("aqua.png"), source
+    FileUtils.rm_rf cache
+
+    Ray::Image.load_compressed(source, :dxt1)
+  end
+
+  teardown { FileUtils.rm_rf dir }
+
+  expected_pixels = lambda do
+    img = Ray::Image.new path_of("aqua.png")
+    img.compress :dxt1
+    points.map { |x, y| img[x, y] }
+  end
+
+  asserts(:format).equals :dxt1
+  asserts(:size).equals Ray::Vector2[50, 50]
+
+  asserts("cache file header") { File.binread(cache, 4) }.equals "SAYC"
+
+  asserts("pixels") { points.map { |x, y| topic[x, y] } }.equals {
+    expected_pixels.call
+  }
+
+  context "loaded again" do
+    setup do
+      File.utime(Time.at(0), Time.at(0), cache)
+      Ray::Image.load_compressed(source, :dxt1)
+    end
+
+    asserts("cache file modification time") {
+      File.mtime(cache)
+    }.equals Time.at(0)
+
+    # Read from the cache, without decoding the source
+    denies :has_pixels?
+
+    asserts(:format).equals :dxt1
+    asserts(:size).equals Ray::Vector2[50, 50]
+
+    asserts("pixels") { points.map { |x, y| topic[x, y] } }.equals {
+      expected_pixels.call
+    }
+  end
+
+  context "loaded again after its source changed" do
+    setup do
+      File.utime(Time.at(0), Time.at(0), cache)
+      File.utime(Time.at(86400), Time.at(86400), source)
+
+      Ray::Image.load_compressed(source, :dxt1)
+    end
+
+    denies("cache file modification time") {
+      File.mtime(cache)
+    }.equals Time.at(0)
+
+    asserts("pixels") { points.map { |x, y| topic[x, y] } }.equals {
+      expected_pixels.call
+    }
+  end
+end if Ray::Image.compression_supported?(:dxt1)
+
+context "an image edited in bulk" do
+  setup do
+    img = Ray::Image.new [4, 2]
+    img.fill_rect [0, 0, 4, 2], Ray::Color.red
+    img.fill_rect [2, 0, 2, 2], Ray::Color.blue
+    img
+  end
+
+  asserts(:[], 1, 1).equals Ray::Color.red
+  asserts(:[], 2, 0).equals Ray::Color.blue
+
+  asserts("packed pixels") { topic.to_packed.bytes.first(8) }.equals(
+    [255, 0, 0, 255, 255, 0, 0, 255])
+
+  asserts("image loaded from packed pixels") {
+    Ray::Image.from_packed(topic.to_packed, topic.size)[3, 1]
+  }.equals Ray::Color.blue
+
+  context "after blitting a transparent image" do
+    hookup do
+      src = Ray::Image.new [1, 1]
+      src[0, 0] = Ray::Color.new(0, 255, 0, 0)
+      topic.blit src, [0, 0]
+    end
+
+    asserts(:[], 0, 0).equals Ray::Color.red
+  end
+
+  context "after blitting without blending" do
+    hookup do
+      src = Ray::Image.new [1, 1]
+      src[0, 0] = Ray::Color.new(0, 255, 0, 0)
+      topic.blit src, [0, 0], :blend => false
+    end
+
+    asserts(:[], 0, 0).equals Ray::Color.new(0, 255, 0, 0)
+  end
+
+  context "after a color matrix" do
+    hookup do
+      topic.color_matrix! [[0, 0, 1, 0, 0],
+                           [0, 1, 0, 0, 0],
+                           [1, 0, 0, 0, 0],
+                           [0, 0, 0, 1, 0]]
+    end
+
+    asserts(:[], 0, 0).equals Ray::Color.blue
+    asserts(:[], 2, 0).equals Ray::Color.red
+  end
+
+  context "after being rotated" do
+    hookup { topic.rotate90! }
+
+    asserts(:size).equals Ray::Vector2[2, 4]
+    asserts(:[], 0, 0).equals Ray::Color.red
+    asserts(:[], 0, 3).equals Ray::Color.blue
+  end
+
+  context "after being flipped" do
+    hookup { topic.flip_x! }
+
+    asserts(:[], 0, 0).equals Ray::Color.blue
+    asserts(:[], 3, 1).equals Ray::Color.red
+  end
+
+  context "scaled down" do
+    setup { topic.scale [2, 1], :box }
+
+    asserts(:size).equals Ray::Vector2[2, 1]
+    asserts(:[], 0, 0).equals Ray::Color.red
+    asserts(:[], 1, 0).equals Ray::Color.blue
+  end
+
+  context "after grayscale" do
+    hookup { topic.grayscale! }
+    asserts(:[], 0, 0).equals Ray::Color.new(77, 77, 77)
+  end
+end
+
+# Per-pixel reference for the bulk operations, rounding like they do
+module ImageReference
+  module_function
+
+  def div255(x)
+    x += 128
+    (x + (x >> 8)) >> 8
+  end
+
+  def pixels(w, h, seed)
+    (0...(w * h * 4)).map { |i| (i * 37 + seed * 101 + (i >> 2) * 13) % 256 }
+  end
+
+  def blend(dst, src)
+    dst.each_slice(4).zip(src.each_slice(4)).flat_map do |d, s|
+      a = s[3]
+      (0..2).map { |i| div255(s[i] * a + d[i] * (255 - a)) } +
+        [div255(255 * a + d[3] * (255 - a))]
+    end
+  end
+
+  def premultiply(pixels)
+    pixels.each_slice(4).flat_map do |p|
+      p[0, 3].map { |c| div255(c * p[3]) } + [p[3]]
+    end
+  end
+
+  def unpremultiply(pixels)
+    pixels.each_slice(4).flat_map do |p|
+      a = p[3]
+      next p if a == 0 || a == 255
+      p[0, 3].map { |c| [(c * 255 + a / 2) / a, 255].min } + [a]
+    end
+  end
+end
+
+# Wide rows go through the vectorized loops, large images through the threads
+[[7, 3], [512, 512]].each do |w, h|
+  context "a #{w}x#{h} image edited in bulk" do
+    setup do
+      [ImageReference.pixels(w, h, 1), ImageReference.pixels(w, h, 2)]
+    end
+
+    asserts("blended pixels") {
+      dst, src = topic
+      img = Ray::Image.from_packed(dst.pack("C*"), [w, h])
+      img.blit Ray::Image.from_packed(src.pack("C*"), [w, h]), [0, 0]
+      img.to_packed.unpack("C*") == ImageReference.blend(dst, src)
+    }
+
+    asserts("copied pixels") {
+      dst, src = topic
+      img = Ray::Image.from_packed(dst.pack("C*"), [w, h])
+      img.blit Ray::Image.from_packed(src.pack("C*"), [w, h]), [0, 0],
+        :blend => false
+      img.to_packed.unpack("C*") == src
+    }
+
+    asserts("premultiplied pixels") {
+      img = Ray::Image.from_packed(topic.first.pack("C*"), [w, h])
+      img.premultiply!
+      img.to_packed.unpack("C*") == ImageReference.premultiply(topic.first)
+    }
+
+    asserts("unpremultiplied pixels") {
+      img = Ray::Image.from_packed(topic.first.pack("C*"), [w, h])
+      img.unpremultiply!
+      img.to_packed.unpack("C*") == ImageReference.unpremultiply(topic.first)
+    }
+  end
+end
+
+context "an image premultiplied" do
+  setup do
+    img = Ray::Image.new [2, 1]
+    img[0, 0] = Ray::Color.new(255, 128, 0, 128)
+    img[1, 0] = Ray::Color.new(10, 20, 30, 0)
+    img.premultiply!
+    img
+  end
+
+  asserts(:[], 0, 0).equals Ray::Color.new(128, 64, 0, 128)
+  asserts(:[], 1, 0).equals Ray::Color.new(0, 0, 0, 0)
+
+  context "and unpremultiplied" do
+    hookup { topic.unpremultiply! }
+    asserts(:[], 0, 0).equals Ray::Color.new(255, 128, 0, 128)
+  end
+end
+
+context "an image created from packed pixels" do
+  asserts("with a negative size") {
+    Ray::Image.from_packed("", [-1, 1])
+  }.raises_kind_of ArgumentError
+
+  asserts("with a fractional size") {
+    Ray::Image.from_packed("\0" * 8, [1.5, 1])
+  }.raises_kind_of ArgumentError
+
+  asserts("with an overflowing size") {
+    Ray::Image.from_packed("", [2 ** 40, 2 ** 40])
+  }.raises_kind_of ArgumentError
+
+  asserts("scaled to an empty size") {
+    Ray::Image.new([2, 2]).scale [0, 2]
+  }.raises_kind_of ArgumentError
 end
 
 context "an image copy" do
@@ -99,4 +408,45 @@ context "an image copy" do
   end
 end
 
+# Other tests already created a context, so this is done in a new process
+context "an image edited before any context exists" do
+  setup do
+    require 'rbconfig'
+
+    script = <<-eof
+      require 'ray'
+
+      img = Ray::Image.new [4, 4]
+      img.fill_rect [0, 0, 4, 4], Ray::Color.red
+      (1..2).each { |x| (1..2).each { |y| img[x, y] = Ray::Color.green } }
+
+      colors = [img[0, 0], img[1, 1]]
+
+      target = Ray::ImageTarget.new Ray::Image.new([4, 4])
+      target.clear Ray::Color.none
+      target.draw Ray::Sprite.new(img)
+      target.update
+
+      colors += [target[0, 0], target[1, 1], target[2, 2], target[3, 3]]
+      puts colors.map { |c| [c.r, c.g, c.b, c.a].join(",") }.join(" ")
+    eof
+
+    dirs = %w[ext lib].map do |dir|
+      File.expand_path(File.join(File.dirname(__FILE__), "..", dir))
+    end
+
+    args = [RbConfig.ruby] + dirs.map { |dir| "-I#{dir}" } + ["-e", script]
+    IO.popen(args, &:read).split.map do |color|
+      Ray::Color.new(*color.split(",").map(&:to_i))
+    end
+  end
+
+  asserts("its pixels") { topic[0, 2] }.equals [Ray::Color.red,
+                                                Ray::Color.green]
+
+  asserts("pixels drawn with it") { topic[2, 4] }.equals [
+    Ray::Color.red, Ray::Color.green, Ray::Color.green, Ray::Color.red
+  ]
+end
+
 run_tests if __FILE__ == $0
@@ -1,4 +1,6 @@
 require File.expand_path(File.dirname(__FILE__)) + '/helpers.rb'
+require 'tmpdir'
+require 'fileutils'
 
 Ray::Shader.use_old!
 
@@ -53,6 +55,152 @@ context "a shader" do
 
     asserts(:[]=, :foo, 3).raises_kind_of Ray::Shader::NoUniformError
   end
+
+  context "setting the same uniform value twice" do
+    hookup do
+      topic.compile :vertex => StringIO.new(<<-vert), :frag => StringIO.new(<<-frag)
+        #version 110
+        uniform vec4 pos;
+        void main() {
+          gl_Position = pos;
+        }
+      vert
+        #version 110
+        void main() {
+          gl_FragColor = vec4(1, 1, 1, 1);
+        }
+      frag
+    end
+
+    asserts("elided uploads") {
+      topic[:pos] = [0.5, 0.5, 0.5, 1]
+      before = Ray::Shader.elided_upload_count
+      topic[:pos] = [0.5, 0.5, 0.5, 1]
+      Ray::Shader.elided_upload_count - before
+    }.equals 1
+  end
+
+  context "with variants" do
+    hookup do
+      topic.compile :vertex => StringIO.new(<<-vert), :frag => StringIO.new(<<-frag)
+        #version 110
+        void main() {
+          gl_Position = vec4(0, 0, 0, 1);
+        }
+      vert
+        #version 110
+        #ifdef TINTED
+        uniform vec4 tint;
+        #endif
+        void main() {
+        #ifdef TINTED
+          gl_FragColor = tint;
+        #else
+          gl_FragColor = vec4(1, 1, 1, 1);
+        #endif
+        }
+      frag
+    end
+
+    denies(:locate, :tint)
+    asserts("variant's uniform") { topic.variant(:TINTED).locate(:tint) }
+
+    asserts("requesting a variant again") {
+      topic.variant(:TINTED)
+      before = Ray::Shader.link_count
+      topic.variant(:TINTED)
+      Ray::Shader.link_count - before
+    }.equals 0
+
+    asserts(:variant, "2D").raises_kind_of Ray::Shader::CompileError
+  end
+end
+
+context "a shader compiled asynchronously" do
+  setup do
+    Ray::Shader.compile_async(:frag => StringIO.new("foo"))
+  end
+
+  asserts(:wait).raises_kind_of Ray::Shader::CompileError
+  asserts(:bind).raises_kind_of Ray::Shader::CompileError
+
+  asserts("color of a pixel drawn with it") {
+    target = Ray::ImageTarget.new Ray::Image.new([4, 4])
+    target.clear Ray::Color.blue
+
+    polygon = Ray::Polygon.rectangle([0, 0, 4, 4], Ray::Color.red)
+    polygon.shader = topic
+
+    target.draw polygon
+    target.update
+
+    target[1, 1]
+  }.equals Ray::Color.blue
+end
+
+context "a shader cache directory" do
+  setup do
+    dir = Dir.mktmpdir
+    Ray::Shader.cache_dir = dir
+
+    frag = "#version 110\nvoid main() { gl_FragColor = vec4(1, 0, 0, 1); }\n"
+    Ray::Shader.new(:frag => StringIO.new(frag))
+
+    expected = Ray::Shader.cache_available? ? 1 : 0
+
+    before = Ray::Shader.cache_hits
+    Ray::Shader.new(:frag => StringIO.new(frag))
+    hits = Ray::Shader.cache_hits - before
+
+    Ray::Shader.cache_dir = nil
+    FileUtils.rm_rf dir
+
+    hits == expected
+  end
+
+  asserts("programs loaded when the driver allows it") { topic }
+end
+
+context "a damaged shader cache" do
+  setup do
+    dir = Dir.mktmpdir
+    Ray::Shader.cache_dir = dir
+
+    frag = "#version 110\nvoid main() { gl_FragColor = vec4(0, 1, 0, 1); }\n"
+    Ray::Shader.new(:frag => StringIO.new(frag))
+
+    # Length of the binary, right after the magic number and the format
+    Dir[File.join(dir, "*.bin")].each do |file|
+      data = File.binread(file)
+      data[12, 4] = [0xffffffff].pack("L")
+      File.binwrite(file, data)
+    end
+
+    before = Ray::Shader.cache_hits
+    Ray::Shader.new(:frag => StringIO.new(frag))
+    hits = Ray::Shader.cache_hits - before
+
+    Ray::Shader.cache_dir = nil
+    FileUtils.rm_rf dir
+
+    hits
+  end
+
+  asserts("programs loaded from it") { topic }.equals 0
+end
+
+context "creating image targets" do
+  setup do
+    Ray::ImageTarget.new Ray::Image.new([4, 4]) # default program compiled
+
+    before = Ray::Shader.link_count
+    5.times { Ray::ImageTarget.new Ray::Image.new([4, 4]) }
+
+    Ray::Shader.link_count - before
+  end
+
+  asserts("programs linked") { topic }.equals 0
+  asserts("compile time") { Ray::Shader.compile_time > 0 }
 end
 
 run_tests if __FILE__ == $0
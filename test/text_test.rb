@@ -9,6 +9,10 @@ context "a text" do
   asserts(:style).equals Ray::Text::Normal
   asserts(:size).equals 12
   asserts(:color).equals Ray::Color.white
+  asserts(:alpha_only?)
+
+  # 11 glyphs, a quad each
+  asserts(:vertex_count).equals 11 * 4
 
   context "after changing style" do
     hookup { topic.style = [:bold, :italic] }
@@ -35,6 +39,66 @@ context "a text" do
     end
   end
 
+  context "with shadow and outline" do
+    hookup do
+      topic.style         = [:shadowed, :outlined]
+      topic.shadow_offset = [3, 4]
+      topic.shadow_color  = Ray::Color.red
+      topic.outline_width = 2
+      topic.outline_color = Ray::Color.blue
+    end
+
+    asserts(:style).equals Ray::Text::Shadowed | Ray::Text::Outlined
+    asserts(:shadow_offset).equals Ray::Vector2[3, 4]
+    asserts(:shadow_color).equals Ray::Color.red
+    asserts(:outline_width).equals 2
+    asserts(:outline_color).equals Ray::Color.blue
+
+    # The text, its shadow, and 8 outline copies in the same buffer
+    asserts(:vertex_count).equals 11 * 4 * 10
+
+    asserts("rect") { topic.rect }.equals {
+      plain = Ray::Text.new("Hello world!").rect
+      Ray::Rect.new(-2, -2, plain.w + 2 + 3, plain.h + 2 + 4)
+    }
+
+    context "copied" do
+      setup { topic.dup }
+
+      asserts(:shadow_offset).equals Ray::Vector2[3, 4]
+      asserts(:shadow_color).equals Ray::Color.red
+      asserts(:outline_width).equals 2
+      asserts(:outline_color).equals Ray::Color.blue
+    end
+  end
+
+  context "drawn with a shadow" do
+    setup do
+      text = Ray::Text.new("l", :size => 30, :style => [:shadowed],
+                           :shadow_offset => [40, 0],
+                           :shadow_color  => Ray::Color.red)
+
+      target = Ray::ImageTarget.new Ray::Image.new([80, 40])
+      target.clear Ray::Color.none
+      target.draw text
+      target.update
+
+      [text, target]
+    end
+
+    asserts(:vertex_count) { topic.first.vertex_count }.equals 4 * 2
+
+    asserts("a pixel has the shadow color") {
+      target = topic.last
+      (40...80).any? { |x| (0...40).any? { |y| target[x, y] == Ray::Color.red } }
+    }
+
+    denies("the shadow is drawn over the text") {
+      target = topic.last
+      (0...40).any? { |x| (0...40).any? { |y| target[x, y] == Ray::Color.red } }
+    }
+  end
+
   context "after changing character size" do
     hookup { topic.size = 30 }
     asserts(:size).equals 30
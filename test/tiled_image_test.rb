@@ -0,0 +1,190 @@
+require File.expand_path(File.dirname(__FILE__)) + '/helpers.rb'
+
+context "a tiled image" do
+  img = Ray::Image.new [128, 96]
+  img.map_with_pos! { |col, x, y| Ray::Color.new(x, y, 0) }
+
+  setup { Ray::TiledImage.new(img, :tile_size => 32) }
+
+  asserts(:size).equals Ray::Vector2[128, 96]
+  asserts(:tile_size).equals 32
+  asserts(:tile_count).equals Ray::Vector2[4, 3]
+  asserts(:rect).equals Ray::Rect.new(0, 0, 128, 96)
+
+  asserts(:resident_count).equals 0
+
+  context "drawn on a smaller target" do
+    target_img = Ray::Image.new [40, 40]
+
+    hookup do
+      topic.margin = 0
+
+      target = Ray::ImageTarget.new target_img
+      target.clear Ray::Color.none
+      target.draw topic
+      target.update
+    end
+
+    asserts(:visible_count).equals 4
+    asserts(:resident_count).equals 4
+
+    asserts("a visible tile is resident") { topic.resident?(1, 1) }
+    denies("a tile outside of the view is resident") { topic.resident?(3, 2) }
+
+    asserts("color of the target") {
+      target_img[35, 5]
+    }.equals Ray::Color.new(35, 5, 0)
+  end
+
+  context "with a small budget" do
+    hookup do
+      topic.margin = 0
+      topic.budget = 4 * 32 * 32 * 4
+
+      target = Ray::ImageTarget.new Ray::Image.new([40, 40])
+      target.draw topic
+      Ray::TiledImage.end_frame
+
+      topic.pos = [-64, -32]
+      target.draw topic
+    end
+
+    asserts(:resident_count).equals 4
+    asserts(:eviction_count).equals 4
+  end
+
+  context "with a small budget, drawn twice during the same frame" do
+    hookup do
+      topic.margin = 0
+      topic.budget = 4 * 32 * 32 * 4
+
+      target = Ray::ImageTarget.new Ray::Image.new([40, 40])
+      target.draw topic
+
+      topic.pos = [-64, -32]
+      target.draw topic
+    end
+
+    asserts(:resident_count).equals 8
+    asserts(:eviction_count).equals 0
+  end
+
+  asserts("loading with a negative tile size") {
+    Ray::TiledImage.new(img, :tile_size => -32)
+  }.raises_kind_of ArgumentError
+
+  asserts("loading with tiles larger than a texture") {
+    Ray::TiledImage.new(img, :tile_size => Ray::Image.max_texture_size + 1)
+  }.raises_kind_of RuntimeError
+
+  context "after failing to load another image" do
+    hookup do
+      begin
+        topic.send(:load_file, path_of("doesnt_exist.png"), 32)
+      rescue RuntimeError
+      end
+
+      begin
+        topic.send(:load_image, Ray::Image.allocate, 32)
+      rescue RuntimeError
+      end
+    end
+
+    asserts(:size).equals Ray::Vector2[128, 96]
+    asserts(:tile_count).equals Ray::Vector2[4, 3]
+  end
+
+  asserts("frame after ending one") {
+    frame = Ray::TiledImage.frame
+    Ray::TiledImage.end_frame
+    Ray::TiledImage.frame - frame
+  }.equals 1
+end
+
+context "a tiled image loaded from a file" do
+  require 'tmpdir'
+  require 'fileutils'
+
+  dir    = File.join(Dir.tmpdir, "ray_tiled_image")
+  source = File.join(dir, "aqua.png")
+  cache  = "#{source}.tiles32"
+  points = [[0, 0], [31, 31], [32, 32], [40, 10], [49, 49]]
+
+  setup do
+    FileUtils.mkdir_p dir
+    FileUtils.cp path_of("aqua.png"), source
+    FileUtils.rm_rf cache
+
+    Ray::TiledImage.new(source, :tile_size => 32, :margin => 0)
+  end
+
+  teardown { FileUtils.rm_rf dir }
+
+  drawn_pixels = lambda do |tiled|
+    target = Ray::ImageTarget.new Ray::Image.new([50, 50])
+    target.clear Ray::Color.none
+    target.draw tiled
+    target.update
+
+    points.map { |x, y| target[x, y] }
+  end
+
+  expected_pixels = lambda do
+    img = Ray::Image.new path_of("aqua.png")
+    points.map { |x, y| img[x, y] }
+  end
+
+  asserts(:size).equals Ray::Vector2[50, 50]
+  asserts(:tile_count).equals Ray::Vector2[2, 2]
+
+  asserts("cache file header") { File.binread(cache, 4) }.equals "SAYT"
+
+  asserts("drawn pixels") { drawn_pixels.call(topic) }.equals {
+    expected_pixels.call
+  }
+
+  context "loaded again" do
+    setup do
+      File.utime(Time.at(0), Time.at(0), cache)
+      Ray::TiledImage.new(source, :tile_size => 32, :margin => 0)
+    end
+
+    asserts("cache file modification time") {
+      File.mtime(cache)
+    }.equals Time.at(0)
+
+    asserts("drawn pixels") { drawn_pixels.call(topic) }.equals {
+      expected_pixels.call
+    }
+  end
+
+  context "loaded again after its source changed" do
+    setup do
+      File.utime(Time.at(0), Time.at(0), cache)
+      File.utime(Time.at(86400), Time.at(86400), source)
+
+      Ray::TiledImage.new(source, :tile_size => 32, :margin => 0)
+    end
+
+    denies("cache file modification time") {
+      File.mtime(cache)
+    }.equals Time.at(0)
+  end
+
+  context "loaded when its cache can't be written" do
+    setup do
+      File.delete cache
+      Dir.mkdir cache
+
+      Ray::TiledImage.new(source, :tile_size => 32, :margin => 0)
+    end
+
+    asserts(:size).equals Ray::Vector2[50, 50]
+
+    asserts("drawn pixels") { drawn_pixels.call(topic) }.equals {
+      expected_pixels.call
+    }
+  end
+end
+
+run_tests if __FILE__ == $0
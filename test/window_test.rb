@@ -0,0 +1,73 @@
+require File.expand_path(File.dirname(__FILE__)) + '/helpers.rb'
+
+require 'tmpdir'
+
+context "a window" do
+  setup do
+    win = Ray::Window.new
+    win.open "test", [64, 32]
+  end
+
+  teardown { topic.close }
+
+  asserts("capturing with an unknown format") {
+    topic.start_capture(File.join(Dir.tmpdir, "ray_capture.gif"),
+                        :format => :gif)
+  }.raises ArgumentError
+
+  denies(:capturing?)
+
+  context "captured to a y4m file" do
+    setup do
+      path = File.join(Dir.tmpdir, "ray_capture.y4m")
+
+      topic.start_capture(path, :fps => 30)
+      5.times do
+        topic.clear Ray::Color.red
+        topic.update
+      end
+
+      # Frames of a different size can't be part of the stream
+      topic.resize [32, 32]
+
+      deadline = Time.now + 2
+      until topic.size == Ray::Vector2[32, 32] || Time.now > deadline
+        topic.each_event { }
+        sleep 0.01
+      end
+
+      2.times do
+        topic.clear Ray::Color.red
+        topic.update
+      end
+
+      topic.stop_capture
+
+      content = File.open(path, "rb") { |io| io.read }
+      File.delete path
+
+      [topic, content]
+    end
+
+    denies("capturing?") { topic.first.capturing? }
+
+    asserts("captured frames") { topic.first.captured_frames }.equals 7
+    asserts("dropped frames") { topic.first.dropped_frames >= 2 }
+    denies("written frames") { topic.first.written_frames }.equals 0
+
+    asserts("written and dropped frames") {
+      topic.first.written_frames + topic.first.dropped_frames
+    }.equals 7
+
+    asserts("header") {
+      topic.last[/\A[^\n]*\n/]
+    }.equals "YUV4MPEG2 W64 H32 F30:1 Ip A1:1 C444\n"
+
+    asserts("file size") { topic.last.bytesize }.equals {
+      "YUV4MPEG2 W64 H32 F30:1 Ip A1:1 C444\n".bytesize +
+        topic.first.written_frames * ("FRAME\n".bytesize + 3 * 64 * 32)
+    }
+  end
+end
+
+run_tests if __FILE__ == $0